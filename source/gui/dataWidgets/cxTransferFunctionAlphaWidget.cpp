@@ -14,7 +14,6 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <limits.h>
 #include <vtkImageData.h>
 #include <vtkPointData.h>
-#include <vtkImageAccumulate.h>
 #include <QPainter>
 #include <QPen>
 #include <QColor>
@@ -263,20 +262,21 @@ void TransferFunctionAlphaWidget::paintHistogram(QPainter& painter)
 	// Draw histogram
 	// with log compression
 
-	vtkImageAccumulatePtr histogram = mImage->getHistogram();
-	int histogramSize = histogram->GetComponentExtent()[1] -
-						histogram->GetComponentExtent()[0];
+	ImageStatisticsPtr statistics = mImage->getStatistics();
+	int histogramSize = mImage->getRange();
 
 	painter.setPen(QColor(140, 140, 210));
 
-	double numElementsInBinWithMostElements = log(histogram->GetOutput()->GetPointData()->GetScalars()->GetRange()[1]+1);
+	double numElementsInBinWithMostElements = log(statistics->getHistogramMaxCount()+1);
 	double barHeightMult = (this->height() - mBorder*2) / numElementsInBinWithMostElements;
 
 	double posMult = (this->width() - mBorder*2) / double(histogramSize);
-	for (int i = mImage->getMin(); i <= mImage->getMax(); i++)
+	const std::vector<int>& histogram = statistics->getHistogram();
+	for (unsigned i = 0; i < histogram.size(); i++)
 	{
-		int x = int(std::lround(((i- mImage->getMin()) * posMult))); //Offset with min value
-		int y = int(std::lround(log(double(static_cast<int*>(histogram->GetOutput()->GetScalarPointer(i - mImage->getMin(), 0, 0))[0]+1)) * barHeightMult));
+		double intensity = statistics->getHistogramOrigin() + i*statistics->getHistogramBinWidth();
+		int x = int(std::lround(((intensity - mImage->getMin()) * posMult))); //Offset with min value
+		int y = int(std::lround(log(double(histogram[i]+1)) * barHeightMult));
 	  if (y > 0)
 	  {
 		painter.drawLine(x + mBorder, height() - mBorder,
@@ -26,6 +26,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxImageDataContainer.h"
 #include "cxRecordSession.h"
 #include "cxUsReconstructionFileMaker.h"
+#include "cxSettings.h"
 //#include "cxFileManagerServiceProxy.h"
 //#include "cxLogicManager.h"
 
@@ -57,6 +58,23 @@ void USSavingRecorder::set_rMpr(Transform3D rMpr)
 	m_rMpr = rMpr;
 }
 
+namespace
+{
+VideoRecorderSaveThread::QueueSettings getRecordingQueueSettings()
+{
+	VideoRecorderSaveThread::QueueSettings retval;
+	retval.mMaxQueueSize = settings()->value("Ultrasound/recordingQueueSize", 256).toInt();
+	QString policy = settings()->value("Ultrasound/recordingQueuePolicy", "spill").toString();
+	if (policy == "block")
+		retval.mPolicy = VideoRecorderSaveThread::qpBLOCK;
+	else if (policy == "drop")
+		retval.mPolicy = VideoRecorderSaveThread::qpDROP;
+	else
+		retval.mPolicy = VideoRecorderSaveThread::qpSPILL_TO_DISK;
+	return retval;
+}
+} // namespace
+
 void USSavingRecorder::startRecord(RecordSessionPtr session, ToolPtr tool, ToolPtr reference, std::vector<VideoSourcePtr> video, FileManagerServicePtr filemanager)
 {
 	this->clearRecording(); // clear previous data if any
@@ -70,15 +88,17 @@ void USSavingRecorder::startRecord(RecordSessionPtr session, ToolPtr tool, ToolP
 
 	for (unsigned i=0; i<video.size(); ++i)
 	{
+		// record in the final format, allowing the cached frames to be linked into the session
 		SavingVideoRecorderPtr videoRecorder;
 		videoRecorder.reset(new SavingVideoRecorder(
 								 video[i],
 								 cacheFolder,
 								 QString("%1_%2").arg(session->getDescription()).arg(video[i]->getUid()),
-								 false, // no compression when saving to cache
+								 settings()->value("Ultrasound/CompressAcquisition", true).toBool(),
 								 mDoWriteColor,
 								filemanager
 								));
+		videoRecorder->setQueueSettings(getRecordingQueueSettings());
 		videoRecorder->startRecord();
 		mVideoRecorder.push_back(videoRecorder);
 	}
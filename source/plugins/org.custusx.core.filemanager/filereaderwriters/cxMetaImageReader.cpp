@@ -14,11 +14,13 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QDir>
 #include "cxTypeConversions.h"
 #include <vtkMetaImageReader.h>
-#include <vtkMetaImageWriter.h>
 #include <vtkImageChangeInformation.h>
 #include <vtkImageData.h>
 #include "cxErrorObserver.h"
 #include "cxCustomMetaImage.h"
+#include "cxMetaImageIO.h"
+#include "cxEnumConversion.h"
+#include "cxSettings.h"
 #include "cxImage.h"
 #include "cxLogger.h"
 #include "cxRegistrationTransform.h"
@@ -29,7 +31,23 @@ namespace cx {
 
 vtkImageDataPtr MetaImageReader::loadVtkImageData(QString filename)
 {
-	//load the image from file
+	MetaImageHeader header;
+	header.read(filename);
+	return this->loadVtkImageData(header);
+}
+
+vtkImageDataPtr MetaImageReader::loadVtkImageData(const MetaImageHeader& header)
+{
+	if (MetaImageIO::canRead(header))
+	{
+		vtkImageDataPtr raw = MetaImageIO().read(header);
+		if (raw)
+			raw->SetOrigin(0, 0, 0);
+		return raw;
+	}
+
+	// layouts not handled by MetaImageIO
+	QString filename = header.getFilename();
 	vtkMetaImageReaderPtr reader = vtkMetaImageReaderPtr::New();
 	reader->SetFileName(cstring_cast(filename));
 	reader->ReleaseDataFlagOn();
@@ -74,26 +92,25 @@ bool MetaImageReader::readInto(ImagePtr image, QString filename)
 	if (!image)
 		return false;
 
-	CustomMetaImagePtr customReader = CustomMetaImage::create(filename);
-	Transform3D rMd = customReader->readTransform();
+	MetaImageHeader header;
+	header.read(filename);
 
-	vtkImageDataPtr raw = this->loadVtkImageData(filename);
+	vtkImageDataPtr raw = this->loadVtkImageData(header);
 	if(!raw)
 		return false;
 
 	image->setVtkImageData(raw);
-//	ImagePtr image(new Image(uid, raw));
 
 	//  RegistrationTransform regTrans(rMd, QFileInfo(filename).lastModified(), "From MHD file");
 	//  image->get_rMd_History()->addRegistration(regTrans);
-	image->get_rMd_History()->setRegistration(rMd);
-	image->setModality(customReader->readModality());
-	image->setImageType(customReader->readImageType());
+	image->get_rMd_History()->setRegistration(header.getTransform());
+	image->setModality(convertToModality(header.getValue("Modality")));
+	image->setImageType(convertToImageSubType(header.getValue("ImageType3")));
 
 	bool ok1 = true;
 	bool ok2 = true;
-	double level = customReader->readKey("WindowLevel").toDouble(&ok1);
-	double window = customReader->readKey("WindowWidth").toDouble(&ok2);
+	double level = header.getValue("WindowLevel").toDouble(&ok1);
+	double window = header.getValue("WindowWidth").toDouble(&ok2);
 
 	if (ok1 && ok2)
 	{
@@ -116,34 +133,9 @@ std::vector<DataPtr> MetaImageReader::read(const QString &filename)
 	std::vector<DataPtr> retval;
 
 	ImagePtr image = boost::dynamic_pointer_cast<Image>(this->createData(Image::getTypeName(), filename));
-
-	CustomMetaImagePtr customReader = CustomMetaImage::create(filename);
-	Transform3D rMd = customReader->readTransform();
-
-	vtkImageDataPtr raw = this->loadVtkImageData(filename);
-	if(!raw)
+	if (!this->readInto(image, filename))
 		return retval;
 
-	image->setVtkImageData(raw);
-//	ImagePtr image(new Image(uid, raw));
-
-	//  RegistrationTransform regTrans(rMd, QFileInfo(filename).lastModified(), "From MHD file");
-	//  image->get_rMd_History()->addRegistration(regTrans);
-	image->get_rMd_History()->setRegistration(rMd);
-	image->setModality(customReader->readModality());
-	image->setImageType(customReader->readImageType());
-
-	bool ok1 = true;
-	bool ok2 = true;
-	double level = customReader->readKey("WindowLevel").toDouble(&ok1);
-	double window = customReader->readKey("WindowWidth").toDouble(&ok2);
-
-	if (ok1 && ok2)
-	{
-		image->setInitialWindowLevel(window, level);
-		image->resetTransferFunctions();
-	}
-
 	retval.push_back(image);
 	return retval;
 
@@ -162,27 +154,18 @@ void MetaImageReader::write(DataPtr data, const QString& filename)
 		CX_LOG_ERROR() << "MetaImageReader::write: cxImage has no VtkImageData";
 		return;
 	}
-	vtkMetaImageWriterPtr writer = vtkMetaImageWriterPtr::New();
-	writer->SetInputData(image->getBaseVtkImageData());
-	writer->SetFileDimensionality(3);
-	writer->SetFileName(cstring_cast(filename));
-	QDir().mkpath(QFileInfo(filename).path());
-
-//	std::cout << "SAVING MHD COMPRESSED " << filename << std::endl;
-//	writer->SetCompression(true);
-	writer->SetCompression(false);
-//	writer->Update(); // caused writing of (null).0 files - not necessary
-	writer->Write();
-
-	writer = 0;
-
-	CustomMetaImagePtr customReader = CustomMetaImage::create(filename);
-	customReader->setTransform(image->get_rMd());
-	customReader->setModality(image->getModality());
-	customReader->setImageType(image->getImageType());
-	customReader->setKey("WindowLevel", qstring_cast(image->getInitialWindowLevel()));
-	customReader->setKey("WindowWidth", qstring_cast(image->getInitialWindowWidth()));
-	customReader->setKey("Creator", QString("CustusX_%1").arg(CustusX_VERSION_STRING));
+
+	MetaImageHeader header = MetaImageIO::createHeader(image->getBaseVtkImageData());
+	header.setTransform(image->get_rMd());
+	header.setValue("Modality", enum2string(image->getModality()));
+	header.setValue("ImageType3", enum2string(image->getImageType()));
+	header.setValue("WindowLevel", qstring_cast(image->getInitialWindowLevel()));
+	header.setValue("WindowWidth", qstring_cast(image->getInitialWindowWidth()));
+	header.setValue("Creator", QString("CustusX_%1").arg(CustusX_VERSION_STRING));
+
+	MetaImageIO writer;
+	writer.setCompression(settings()->value("compressMetaImages").toBool());
+	writer.write(image->getBaseVtkImageData(), filename, header);
 }
 
 }
@@ -15,6 +15,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxFileReaderWriterService.h"
 #include "org_custusx_core_filemanager_Export.h"
 #include <QFileInfo>
+#include "cxMetaImageHeader.h"
 
 class ctkPluginContext;
 
@@ -37,6 +38,7 @@ public:
 	virtual DataPtr read(const QString& uid, const QString& filename);
 	std::vector<DataPtr> read(const QString &filename);
 	virtual vtkImageDataPtr loadVtkImageData(QString filename);
+	vtkImageDataPtr loadVtkImageData(const MetaImageHeader& header);
 
 	QString canWriteDataType() const;
 	bool canWrite(const QString &type, const QString &filename) const;
@@ -13,10 +13,9 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxMesh.h"
 #include <ctkPluginContext.h>
-#include "cxErrorObserver.h"
-#include <vtkXMLPolyDataReader.h>
-#include "cxTypeConversions.h"
-#include <vtkPolyData.h>
+#include <QFileInfo>
+#include "cxMeshIO.h"
+#include "cxLogger.h"
 
 namespace cx {
 
@@ -52,14 +51,18 @@ std::vector<DataPtr> XMLPolyDataMeshReader::read(const QString &filename)
 
 vtkPolyDataPtr XMLPolyDataMeshReader::loadVtkPolyData(QString fileName)
 {
-	vtkXMLPolyDataReaderPtr reader = vtkXMLPolyDataReaderPtr::New();
-	reader->SetFileName(cstring_cast(fileName));
-
-	if (!ErrorObserver::checkedRead(reader, fileName))
-		return vtkPolyDataPtr();
+	return MeshIO().read(fileName);
+}
 
-	vtkPolyDataPtr polyData = reader->GetOutput();
-	return polyData;
+void XMLPolyDataMeshReader::write(DataPtr data, const QString &filename)
+{
+	MeshPtr mesh = boost::dynamic_pointer_cast<Mesh>(data);
+	if(!mesh)
+	{
+		reportError("Could not cast data to mesh");
+		return;
+	}
+	MeshIO().write(mesh->getVtkPolyData(), filename);
 }
 
 DataPtr XMLPolyDataMeshReader::read(const QString& uid, const QString& filename)
@@ -75,7 +78,7 @@ QString XMLPolyDataMeshReader::canReadDataType() const
 }
 
 XMLPolyDataMeshReader::XMLPolyDataMeshReader(PatientModelServicePtr patientModelService) :
-	FileReaderWriterImplService("XMLPolyDataMeshReader", Mesh::getTypeName(), "", "vtp", patientModelService)
+	FileReaderWriterImplService("XMLPolyDataMeshReader", Mesh::getTypeName(), Mesh::getTypeName(), "vtp", patientModelService)
 {
 }
 
@@ -89,10 +92,10 @@ bool XMLPolyDataMeshReader::canRead(const QString &type, const QString &filename
 
 QString cx::XMLPolyDataMeshReader::canWriteDataType() const
 {
-	return "";
+	return Mesh::getTypeName();
 }
 
 bool cx::XMLPolyDataMeshReader::canWrite(const QString &type, const QString &filename) const
 {
-	return false;
+	return this->canWriteInternal(type, filename);
 }
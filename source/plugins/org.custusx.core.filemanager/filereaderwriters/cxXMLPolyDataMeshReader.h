@@ -20,8 +20,9 @@ class ctkPluginContext;
 namespace cx
 {
 
-/**\brief Reader for .vtp files.
+/**\brief Reader and writer for .vtp files.
  *
+ * Meshes are written binary and block compressed, see MeshIO.
  */
 class org_custusx_core_filemanager_EXPORT XMLPolyDataMeshReader: public FileReaderWriterImplService
 {
@@ -40,7 +41,7 @@ public:
 	bool readInto(MeshPtr mesh, QString filename);
 	std::vector<DataPtr> read(const QString &filename);
 
-	void write(DataPtr data, const QString &filename) {}
+	void write(DataPtr data, const QString &filename);
 	QString canWriteDataType() const;
 	bool canWrite(const QString &type, const QString &filename) const;
 
@@ -40,6 +40,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxActiveData.h"
 #include "cxFileManagerService.h"
 #include "cxEnumConversion.h"
+#include "cxMeshIO.h"
+#include <QtConcurrent/QtConcurrentRun>
 
 
 namespace cx
@@ -364,6 +366,7 @@ void DataManagerImpl::parseXml(QDomNode& dataManagerNode, QString rootPath)
 	// All images must be created from the DataManager, so the image nodes are parsed here
 	std::map<DataPtr, QDomNode> datanodes;
 
+	this->startMeshDecoding(dataManagerNode, rootPath);
 	QDomNode child = dataManagerNode.firstChild();
 	for (; !child.isNull(); child = child.nextSibling())
 	{
@@ -374,6 +377,9 @@ void DataManagerImpl::parseXml(QDomNode& dataManagerNode, QString rootPath)
 				datanodes[data] = child.toElement();
 		}
 	}
+	for (std::map<QString, QFuture<vtkPolyDataPtr> >::iterator iter = mMeshDecoding.begin(); iter != mMeshDecoding.end(); ++iter)
+		iter->second.waitForFinished();
+	mMeshDecoding.clear();
 
 	// parse xml data separately: we want to first load all data
 	// because there might be interdependencies (cx::DistanceMetric)
@@ -429,7 +435,13 @@ DataPtr DataManagerImpl::loadData(QDomElement node, QString rootPath)
 		reportWarning(QString("Unknown type: %1 for file %2").arg(type).arg(absolutePath));
 		return DataPtr();
 	}
-	bool loaded = data->load(absolutePath, mFileManagerService);
+	bool loaded = false;
+	MeshPtr mesh = boost::dynamic_pointer_cast<Mesh>(data);
+	std::map<QString, QFuture<vtkPolyDataPtr> >::iterator decoded = mMeshDecoding.find(absolutePath);
+	if (mesh && (decoded != mMeshDecoding.end()))
+		loaded = mesh->load(absolutePath, decoded->second.result());
+	else
+		loaded = data->load(absolutePath, mFileManagerService);
 
 	if (!loaded)
 	{
@@ -478,6 +490,36 @@ QString DataManagerImpl::findPath(QDomElement node)
 	return path;
 }
 
+namespace
+{
+vtkPolyDataPtr decodeMesh(QString filename)
+{
+	return MeshIO().read(filename);
+}
+}
+
+/** Start reading all .vtp meshes in the session on worker threads.
+ *  loadData() picks up the results, so that large meshes are decoded
+ *  in parallel with the loading of other data. The vtk parsing of the
+ *  meshes is serialized by the global vtk mutex.
+ */
+void DataManagerImpl::startMeshDecoding(QDomNode dataManagerNode, QString rootPath)
+{
+	mMeshDecoding.clear();
+	QDomElement node = dataManagerNode.firstChildElement("data");
+	for (; !node.isNull(); node = node.nextSiblingElement("data"))
+	{
+		if (node.attribute("type") != Mesh::getTypeName())
+			continue;
+		QString absolutePath = this->findAbsolutePath(this->findRelativePath(node, rootPath), rootPath);
+		if (QFileInfo(absolutePath).suffix().compare("vtp", Qt::CaseInsensitive) != 0)
+			continue;
+		if (mMeshDecoding.count(absolutePath) || !QFileInfo(absolutePath).exists())
+			continue;
+		mMeshDecoding[absolutePath] = QtConcurrent::run(decodeMesh, absolutePath);
+	}
+}
+
 QString DataManagerImpl::findAbsolutePath(QDir relativePath, QString rootPath)
 {
 	QString absolutePath = relativePath.path();
@@ -588,7 +630,7 @@ void DataManagerImpl::deleteFiles(DataPtr data, QString basePath)
 	{
 		files << QDir(basePath).absoluteFilePath(data->getFilename());
 		if (image)
-			files <<  changeExtension(files[0], "raw");
+			files <<  changeExtension(files[0], "raw") << changeExtension(files[0], "zraw");
 	}
 
 	for (int i=0; i<files.size(); ++i)
@@ -25,6 +25,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxMesh.h"
 #include "cxDataManager.h"
 #include <QFileInfo>
+#include <QFuture>
 #include "boost/scoped_ptr.hpp"
 #include "cxPatientModelService.h"
 
@@ -131,6 +132,8 @@ private:
 	QDir findRelativePath(QDomElement node, QString rootPath);
 	QString findPath(QDomElement node);
 	QString findAbsolutePath(QDir relativePath, QString rootPath);
+	void startMeshDecoding(QDomNode dataManagerNode, QString rootPath);
+	std::map<QString, QFuture<vtkPolyDataPtr> > mMeshDecoding; ///< .vtp meshes decoded on worker threads during parseXml(), keyed on absolute path
 private slots:
 	void settingsChangedSlot(QString key);
 };
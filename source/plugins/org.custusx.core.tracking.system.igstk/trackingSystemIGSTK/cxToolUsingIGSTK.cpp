@@ -117,6 +117,7 @@ Transform3D ToolUsingIGSTK::getCalibration_sMt() const
 void ToolUsingIGSTK::setCalibration_sMt(Transform3D calibration)
 {
 	mTool->updateCalibration(calibration);
+	emit toolTransformAndTimestamp(this->get_prMt(), this->getTimestamp()); // the sensor space moved relative to the tool
 }
 
 QString ToolUsingIGSTK::getCalibrationFileName() const
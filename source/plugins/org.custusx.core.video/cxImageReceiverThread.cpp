@@ -16,6 +16,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxStreamer.h"
 #include "cxStreamerService.h"
 #include "cxDirectlyLinkedSender.h"
+#include "cxVideoStageTelemetry.h"
 #include "cxLogger.h"
 #include "cxProfile.h"
 
@@ -24,7 +25,8 @@ namespace cx
 
 ImageReceiverThread::ImageReceiverThread(StreamerServicePtr streamerInterface, QObject* parent) :
 		QObject(parent),
-		mStreamerInterface(streamerInterface)
+		mStreamerInterface(streamerInterface),
+		mTelemetry(VideoStageTelemetry::create("ImageReceiverThread"))
 {
 	this->setObjectName("imagereceiver worker");
 }
@@ -75,6 +77,11 @@ void ImageReceiverThread::shutdown()
 		mSender.reset();
 	}
 
+	QMutexLocker sentry(&mImageMutex);
+	mTelemetry->frameDropped(int(mMutexedImageMessageQueue.size()));
+	mMutexedImageMessageQueue.clear();
+	sentry.unlock();
+
 	emit finished();
 }
 
@@ -102,7 +109,8 @@ void ImageReceiverThread::addImageToQueue(ImagePtr imgMsg)
 //        mStreamSynchronizer.syncToCurrentTime(imgMsg);
 
 	QMutexLocker sentry(&mImageMutex);
-	mMutexedImageMessageQueue.push_back(imgMsg);
+	QueuedImage queued = { imgMsg, VideoStageTelemetry::now() };
+	mMutexedImageMessageQueue.push_back(queued);
 	sentry.unlock();
 
 	emit imageReceived(); // emit signal outside lock, catch possibly in another thread
@@ -121,10 +129,11 @@ ImagePtr ImageReceiverThread::getLastImageMessage()
 	QMutexLocker sentry(&mImageMutex);
 	if (mMutexedImageMessageQueue.empty())
 		return ImagePtr();
-	ImagePtr retval = mMutexedImageMessageQueue.front();
+	QueuedImage retval = mMutexedImageMessageQueue.front();
 	mMutexedImageMessageQueue.pop_front();
+	mTelemetry->frameReceived(VideoStageTelemetry::now() - retval.mQueuedTime);
 
-	return retval;
+	return retval.mImage;
 }
 
 ProbeDefinitionPtr ImageReceiverThread::getLastSonixStatusMessage()
@@ -30,6 +30,7 @@ typedef boost::shared_ptr<class Streamer> StreamerPtr;
 typedef boost::shared_ptr<class StreamerService> StreamerServicePtr;
 typedef boost::shared_ptr<class DirectlyLinkedSender> DirectlyLinkedSenderPtr;
 typedef boost::shared_ptr<class ProbeDefinition> ProbeDefinitionPtr;
+typedef boost::shared_ptr<class VideoStageTelemetry> VideoStageTelemetryPtr;
 
 /**
  * \file
@@ -60,6 +61,7 @@ public:
 	virtual ImagePtr getLastImageMessage(); // threadsafe, Threadsafe retrieval of last image message.
 	virtual ProbeDefinitionPtr getLastSonixStatusMessage(); // threadsafe,Threadsafe retrieval of last status message.
 	virtual QString hostDescription() const; // threadsafe
+	VideoStageTelemetryPtr getTelemetry() { return mTelemetry; } ///< age is time waited in the queue
 
 public slots:
 	void initialize(); // not threadsafe, call via postevent
@@ -94,7 +96,12 @@ private:
 	std::map<QString, cx::CyclicActionLoggerPtr> mFPSTimer;
 	QMutex mImageMutex;
 	QMutex mSonixStatusMutex;
-	std::list<ImagePtr> mMutexedImageMessageQueue;
+	struct QueuedImage
+	{
+		ImagePtr mImage;
+		double mQueuedTime;
+	};
+	std::list<QueuedImage> mMutexedImageMessageQueue;
 	std::list<ProbeDefinitionPtr> mMutexedSonixStatusMessageQueue;
 
 //    StreamedTimestampSynchronizer mStreamSynchronizer;
@@ -102,6 +109,7 @@ private:
 	StreamerServicePtr mStreamerInterface;
 	StreamerPtr mImageStreamer;
 	DirectlyLinkedSenderPtr mSender;
+	VideoStageTelemetryPtr mTelemetry;
 
 };
 
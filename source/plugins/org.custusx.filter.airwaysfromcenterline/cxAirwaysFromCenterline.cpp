@@ -24,6 +24,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxLogger.h"
 #include <vtkImageResample.h>
 #include <vtkImageConnectivityFilter.h>
+#include "cxParallelFor.h"
+#include "cxUtilHelpers.h"
 
 typedef vtkSmartPointer<class vtkCardinalSpline> vtkCardinalSplinePtr;
 
@@ -106,10 +108,30 @@ vtkImageDataPtr AirwaysFromCenterline::getFilteredSegmentedVolume()
 	AirwaysFromCenterline::generateTubes makes artificial airway tubes around the input centerline. The radius
 	of the tubes is decided by the generation number, based on Weibel's model of airways. In contradiction to the model,
 	it is set a lower boundary for the tube radius (2 mm) making the peripheral airways larger than in reality,
-	which makes it possible to virtually navigate inside the tubes. The airways are generated by adding a sphere to
-	a volume (image) at each point along every branch. The output is a surface model generated from the volume.
+	which makes it possible to virtually navigate inside the tubes. The airways are generated by adding a capsule to
+	a volume (image) between each pair of consecutive points along every branch, or optionally a sphere at each point.
+	The output is a surface model generated from the volume.
 */
 vtkPolyDataPtr AirwaysFromCenterline::generateTubes(double staticRadius, bool mergeWithOriginalAirways) // if staticRadius == 0, radius is retrieved from branch generation number
+{
+	this->generateTubesVolume(staticRadius, mergeWithOriginalAirways);
+
+	//create contour from image
+	vtkPolyDataPtr rawContour = ContourFilter::execute(
+				mFilteredSegmentedVolumePtr,
+			1, //treshold
+			false, // reduce resolution
+			true, // smoothing
+			true, // keep topology
+			0, // target decimation
+			30, // number of iterations smoothing
+			0.10 // band pass smoothing
+	);
+
+	return rawContour;
+}
+
+vtkImageDataPtr AirwaysFromCenterline::generateTubesVolume(double staticRadius, bool mergeWithOriginalAirways)
 {
 	mMergeWithOriginalAirways = mergeWithOriginalAirways;
 
@@ -128,24 +150,15 @@ vtkPolyDataPtr AirwaysFromCenterline::generateTubes(double staticRadius, bool me
 	else
 		mFilteredSegmentedVolumePtr = this->initializeEmptyAirwaysVolume();
 
-	addSpheresAlongCenterlines(staticRadius);
+	if (mSweptTubes)
+		addSweptTubesAlongCenterlines(staticRadius);
+	else
+		addSpheresAlongCenterlines(staticRadius);
 
 	if(mMergeWithOriginalAirways)
 		removeIslandsFromImage();
 
-	//create contour from image
-	vtkPolyDataPtr rawContour = ContourFilter::execute(
-				mFilteredSegmentedVolumePtr,
-			1, //treshold
-			false, // reduce resolution
-			true, // smoothing
-			true, // keep topology
-			0, // target decimation
-			30, // number of iterations smoothing
-			0.10 // band pass smoothing
-	);
-
-	return rawContour;
+	return mFilteredSegmentedVolumePtr;
 }
 
 vtkImageDataPtr AirwaysFromCenterline::initializeEmptyAirwaysVolume()
@@ -234,37 +247,159 @@ vtkImageDataPtr AirwaysFromCenterline::initializeAirwaysVolumeFromOriginalSegmen
 }
 
 
+double AirwaysFromCenterline::getBranchRadius(BranchPtr branch, double staticRadius) const
+{
+	double radius = staticRadius;
+	if (similar(staticRadius, 0))
+	{
+		radius = branch->findBranchRadius();
+		if (mMergeWithOriginalAirways)
+			radius = radius/2;
+	}
+	return radius;
+}
+
 void AirwaysFromCenterline::addSpheresAlongCenterlines(double staticRadius)
 {
 	std::vector<BranchPtr> branches = mBranchListPtr->getBranches();
+	Transform3D dMr = m_rMd.inverse();
 
 	for (int i = 0; i < branches.size(); i++)
 	{
 		Eigen::MatrixXd positions = branches[i]->getPositions();
-		vtkPointsPtr pointsPtr = vtkPointsPtr::New();
 		int numberOfPositionsInBranch = positions.cols();
-		pointsPtr->SetNumberOfPoints(numberOfPositionsInBranch);
-
-		double radius = staticRadius;
-		if (similar(staticRadius, 0))
-		{
-			radius = branches[i]->findBranchRadius();
-			if (mMergeWithOriginalAirways)
-				radius = radius/2;
-		}
+		double radius = this->getBranchRadius(branches[i], staticRadius);
 
 		for (int j = 0; j < numberOfPositionsInBranch; j++)
 		{
-			positions.block(0 , j , 3 , 1) = m_rMd.inverse().coord(positions.block(0 , j , 3 , 1)); //transfrom from r to d
+			Vector3D position_d = dMr.coord(Vector3D(positions.col(j))); //transfrom from r to d
 			double spherePos_d[3];
-			spherePos_d[0] = positions(0,j);
-			spherePos_d[1] = positions(1,j);
-			spherePos_d[2] = positions(2,j);
+			spherePos_d[0] = position_d[0];
+			spherePos_d[1] = position_d[1];
+			spherePos_d[2] = position_d[2];
 			addSphereToImage(spherePos_d, radius);
 		}
 	}
 }
 
+namespace
+{
+/** Segment from a to b, with radius interpolated linearly from ra to rb.
+ */
+struct Capsule
+{
+	Vector3D a;
+	Vector3D b;
+	double ra;
+	double rb;
+	Eigen::Array3i lower; ///< voxel bounding box
+	Eigen::Array3i upper;
+};
+
+/** Set all voxels with centers inside any of the capsules to value.
+ *  The volume is split into z slabs processed in parallel. Each voxel
+ *  is written by one slab only, thus the result is deterministic.
+ */
+void rasterizeCapsules(vtkImageDataPtr image, std::vector<Capsule> capsules, unsigned char value)
+{
+	int* dim = image->GetDimensions();
+	Vector3D spacing(image->GetSpacing());
+	Vector3D origin(image->GetOrigin());
+	unsigned char* data = static_cast<unsigned char*>(image->GetScalarPointer());
+
+	for (unsigned i=0; i<capsules.size(); ++i)
+	{
+		Capsule& c = capsules[i];
+		double r = std::max(c.ra, c.rb);
+		for (int k=0; k<3; ++k)
+		{
+			double minPos = std::min(c.a[k], c.b[k]) - r;
+			double maxPos = std::max(c.a[k], c.b[k]) + r;
+			c.lower[k] = std::max(int(std::floor((minPos - origin[k]) / spacing[k])), 0);
+			c.upper[k] = std::min(int(std::ceil((maxPos - origin[k]) / spacing[k])), dim[k]-1);
+		}
+	}
+
+	parallelForRange(0, dim[2], [&](int zBegin, int zEnd)
+	{
+		for (unsigned i=0; i<capsules.size(); ++i)
+		{
+			const Capsule& c = capsules[i];
+			int z0 = std::max(c.lower[2], zBegin);
+			int z1 = std::min(c.upper[2], zEnd-1);
+			if (z0 > z1)
+				continue;
+
+			Vector3D ab = c.b - c.a;
+			double abab = ab.squaredNorm();
+			for (int z = z0; z <= z1; ++z)
+				for (int y = c.lower[1]; y <= c.upper[1]; ++y)
+				{
+					unsigned char* row = data + (vtkIdType(z)*dim[1] + y)*dim[0];
+					Vector3D q(0, origin[1] + y*spacing[1], origin[2] + z*spacing[2]);
+					for (int x = c.lower[0]; x <= c.upper[0]; ++x)
+					{
+						q[0] = origin[0] + x*spacing[0];
+						Vector3D aq = q - c.a;
+						double t = (abab > 0) ? constrainValue(aq.dot(ab) / abab, 0.0, 1.0) : 0.0;
+						double r = c.ra + t*(c.rb - c.ra);
+						if ((aq - t*ab).squaredNorm() < r*r)
+							row[x] = value;
+					}
+				}
+		}
+	}, 1);
+}
+}
+
+/** Voxelize each branch as a chain of capsules between consecutive
+ *  positions. This closes the gaps between the spheres of
+ *  addSpheresAlongCenterlines(), and visits each voxel once per capsule
+ *  instead of once per overlapping sphere.
+ *
+ *  Each branch is joined to the closest position of its parent by a
+ *  capsule tapering from the parent radius to the branch radius.
+ */
+void AirwaysFromCenterline::addSweptTubesAlongCenterlines(double staticRadius)
+{
+	std::vector<BranchPtr> branches = mBranchListPtr->getBranches();
+	Transform3D dMr = m_rMd.inverse();
+
+	std::vector<Capsule> capsules;
+	for (int i = 0; i < branches.size(); i++)
+	{
+		Eigen::MatrixXd positions = branches[i]->getPositions();
+		double radius = this->getBranchRadius(branches[i], staticRadius);
+
+		Capsule capsule;
+		capsule.ra = radius;
+		capsule.rb = radius;
+
+		BranchPtr parent = branches[i]->getParentBranch();
+		if (parent && positions.cols() > 0 && parent->getPositions().cols() > 0)
+		{
+			std::pair<int, double> closest = findDistanceToLine(positions.col(0), parent->getPositions());
+			Capsule joint;
+			joint.a = dMr.coord(Vector3D(parent->getPositions().col(closest.first)));
+			joint.b = dMr.coord(Vector3D(positions.col(0)));
+			joint.ra = this->getBranchRadius(parent, staticRadius);
+			joint.rb = radius;
+			capsules.push_back(joint);
+		}
+
+		for (int j = 0; j < positions.cols(); j++)
+		{
+			Vector3D position_d = dMr.coord(Vector3D(positions.col(j)));
+			capsule.a = (j == 0) ? position_d : capsule.b;
+			capsule.b = position_d;
+			if ((j > 0) || (positions.cols() == 1))
+				capsules.push_back(capsule);
+		}
+	}
+
+	rasterizeCapsules(mFilteredSegmentedVolumePtr, capsules, 1);
+}
+
 void AirwaysFromCenterline::addSphereToImage(double position[3], double radius)
 {
 	int value = 1;
@@ -282,20 +417,23 @@ void AirwaysFromCenterline::addSphereToImage(double position[3], double radius)
 					mDim[i]-1);
 	}
 
-	for (int x = sphereBoundingBoxIndex[0]; x<=sphereBoundingBoxIndex[1]; x++)
+	int* dim = mFilteredSegmentedVolumePtr->GetDimensions();
+	unsigned char* data = static_cast<unsigned char*>(mFilteredSegmentedVolumePtr->GetScalarPointer());
+
+	for (int z = sphereBoundingBoxIndex[4]; z<=sphereBoundingBoxIndex[5]; z++)
 		for (int y = sphereBoundingBoxIndex[2]; y<=sphereBoundingBoxIndex[3]; y++)
-			for (int z = sphereBoundingBoxIndex[4]; z<=sphereBoundingBoxIndex[5]; z++)
+		{
+			unsigned char* row = data + (vtkIdType(z)*dim[1] + y)*dim[0];
+			for (int x = sphereBoundingBoxIndex[0]; x<=sphereBoundingBoxIndex[1]; x++)
 			{
 				double distanceFromCenter = sqrt((x-centerIndex[0])*mSpacing[0]*(x-centerIndex[0])*mSpacing[0] +
 												 (y-centerIndex[1])*mSpacing[1]*(y-centerIndex[1])*mSpacing[1] +
 												 (z-centerIndex[2])*mSpacing[2]*(z-centerIndex[2])*mSpacing[2]);
 
 				if (distanceFromCenter < radius)
-				{
-						unsigned char* dataPtrImage = static_cast<unsigned char*>(mFilteredSegmentedVolumePtr->GetScalarPointer(x,y,z));
-						dataPtrImage[0] = value;
-				}
+					row[x] = value;
 			}
+		}
 }
 
 void AirwaysFromCenterline::removeIslandsFromImage()
@@ -36,6 +36,8 @@ public:
 	BranchListPtr getBranchList();
 	vtkImageDataPtr getFilteredSegmentedVolume();
 	vtkPolyDataPtr generateTubes(double staticRadius = 0, bool mergeWithOriginalAirways = false);
+	vtkImageDataPtr generateTubesVolume(double staticRadius = 0, bool mergeWithOriginalAirways = false); ///< the binary volume contoured by generateTubes()
+	void setSweptTubes(bool on) { mSweptTubes = on; } ///< rasterize branches as swept capsules (default), or as spheres at each position
 	vtkImageDataPtr initializeEmptyAirwaysVolume();
 	vtkImageDataPtr initializeAirwaysVolumeFromOriginalSegmentation();
 	void smoothAllBranchesForVB();
@@ -45,6 +47,8 @@ public:
 private:
 	void addSpheresAlongCenterlines(double staticRadius = 0);
 	void addSphereToImage(double position[3], double radius);
+	void addSweptTubesAlongCenterlines(double staticRadius = 0);
+	double getBranchRadius(BranchPtr branch, double staticRadius) const;
 	void removeIslandsFromImage();
 
 	Eigen::MatrixXd mCLpoints;
@@ -60,6 +64,7 @@ private:
 	double mAirwaysVolumeSpacing;
 	bool mBloodVessel = false;
 	bool mMergeWithOriginalAirways = false;
+	bool mSweptTubes = true;
 	Transform3D m_rMd = Transform3D::Identity();
 
 };
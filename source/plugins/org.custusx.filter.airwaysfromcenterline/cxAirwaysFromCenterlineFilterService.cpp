@@ -132,7 +132,7 @@ bool AirwaysFromCenterlineFilter::execute()
 	if (!mesh)
 		return false;
 
-	vtkPolyDataPtr centerline_r = mesh->getTransformedPolyDataCopy(mesh->get_rMd());
+	vtkPolyDataPtr centerline_r = mesh->getTransformedPolyData(mesh->get_rMd());
 
 	mAirwaysFromCenterline->processCenterline(centerline_r);
 
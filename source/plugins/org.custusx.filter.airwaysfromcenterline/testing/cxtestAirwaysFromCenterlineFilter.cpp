@@ -17,13 +17,147 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxAirwaysFromCenterline.h"
 #include "cxtestSessionStorageTestFixture.h"
 #include "cxVisServices.h"
+#include "cxBranch.h"
+#include "cxBranchList.h"
+#include "cxVector3D.h"
 #include <vtkImageData.h>
 #include <vtkPolyData.h>
+#include <QElapsedTimer>
 
 typedef boost::shared_ptr<class cx::AirwaysFromCenterline> AirwaysFromCenterlinePtr;
 
 namespace cxtest {
 
+namespace
+{
+/** Add a branch with densely sampled positions from start along direction,
+ *  and recursively two child branches from its end.
+ */
+void addSyntheticBranch(cx::BranchListPtr branchList, cx::BranchPtr parent, cx::Vector3D start, cx::Vector3D direction, double length, int generations)
+{
+	int numberOfPositions = std::max(2, int(length/0.2));
+	Eigen::MatrixXd positions(3, numberOfPositions);
+	for (int i=0; i<numberOfPositions; ++i)
+		positions.col(i) = start + direction * length * i / (numberOfPositions-1);
+
+	cx::BranchPtr branch(new cx::Branch());
+	branch->setPositions(positions);
+	if (parent)
+	{
+		branch->setParentBranch(parent);
+		parent->addChildBranch(branch);
+	}
+	branchList->addBranch(branch);
+
+	if (generations <= 1)
+		return;
+
+	cx::Vector3D end = positions.col(numberOfPositions-1);
+	cx::Vector3D axis = cx::Vector3D(direction.cross(cx::Vector3D(0, 1, 0.3))).normalized();
+	for (int side=-1; side<=1; side+=2)
+	{
+		cx::Vector3D childDirection = Eigen::AngleAxisd(side*0.5, axis) * direction;
+		addSyntheticBranch(branchList, branch, end, childDirection, length*0.8, generations-1);
+	}
+}
+
+cx::BranchListPtr createSyntheticBranchTree(int generations)
+{
+	cx::BranchListPtr branchList(new cx::BranchList());
+	addSyntheticBranch(branchList, cx::BranchPtr(), cx::Vector3D(0, 0, 0), cx::Vector3D(0, 0, -1), 40, generations);
+	return branchList;
+}
+
+int countNonZeroVoxels(vtkImageDataPtr image)
+{
+	unsigned char* data = static_cast<unsigned char*>(image->GetScalarPointer());
+	int count = 0;
+	for (vtkIdType i=0; i<image->GetNumberOfPoints(); ++i)
+		if (data[i])
+			++count;
+	return count;
+}
+
+vtkImageDataPtr generateTubesVolume(cx::BranchListPtr branchList, bool sweptTubes, double* seconds = NULL)
+{
+	AirwaysFromCenterlinePtr airwaysFromCenterline(new cx::AirwaysFromCenterline());
+	airwaysFromCenterline->setBranches(branchList);
+	airwaysFromCenterline->setSweptTubes(sweptTubes);
+
+	QElapsedTimer timer;
+	timer.start();
+	vtkImageDataPtr volume = airwaysFromCenterline->generateTubesVolume();
+	if (seconds)
+		*seconds = timer.elapsed()/1000.0;
+	return volume;
+}
+}
+
+TEST_CASE("AirwaysFromCenterline: Swept tubes cover the spheres and are deterministic", "[unit][org.custusx.filter.airwaysfromcenterline]")
+{
+	cx::BranchListPtr branchList = createSyntheticBranchTree(3);
+
+	vtkImageDataPtr spheres = generateTubesVolume(branchList, false);
+	vtkImageDataPtr tubes = generateTubesVolume(branchList, true);
+	vtkImageDataPtr tubesAgain = generateTubesVolume(branchList, true);
+
+	REQUIRE(tubes->GetNumberOfPoints() == spheres->GetNumberOfPoints());
+	int sphereVoxels = countNonZeroVoxels(spheres);
+	int tubeVoxels = countNonZeroVoxels(tubes);
+	CHECK(sphereVoxels > 0);
+	CHECK(tubeVoxels >= sphereVoxels*0.99);
+	CHECK(tubeVoxels <= sphereVoxels*1.10);
+
+	REQUIRE(tubesAgain->GetNumberOfPoints() == tubes->GetNumberOfPoints());
+	CHECK(memcmp(tubes->GetScalarPointer(), tubesAgain->GetScalarPointer(), tubes->GetNumberOfPoints()) == 0);
+}
+
+TEST_CASE("AirwaysFromCenterline: Swept tubes and spheres agree voxel by voxel on a straight branch", "[unit][org.custusx.filter.airwaysfromcenterline]")
+{
+	cx::BranchListPtr branchList = createSyntheticBranchTree(1);
+
+	vtkImageDataPtr spheres = generateTubesVolume(branchList, false);
+	vtkImageDataPtr tubes = generateTubesVolume(branchList, true);
+	REQUIRE(tubes->GetNumberOfPoints() == spheres->GetNumberOfPoints());
+
+	unsigned char* sphereData = static_cast<unsigned char*>(spheres->GetScalarPointer());
+	unsigned char* tubeData = static_cast<unsigned char*>(tubes->GetScalarPointer());
+	int sphereVoxels = 0;
+	int tubeVoxels = 0;
+	int sphereOnly = 0;
+	int tubeOnly = 0;
+	for (vtkIdType i=0; i<spheres->GetNumberOfPoints(); ++i)
+	{
+		sphereVoxels += sphereData[i] ? 1 : 0;
+		tubeVoxels += tubeData[i] ? 1 : 0;
+		if (sphereData[i] && !tubeData[i])
+			++sphereOnly;
+		if (tubeData[i] && !sphereData[i])
+			++tubeOnly;
+	}
+
+	// the spheres are centered on the closest voxel, thus differ by up to half a voxel at the surface
+	INFO("sphere voxels " << sphereVoxels << ", only in spheres " << sphereOnly << ", tube voxels " << tubeVoxels << ", only in tubes " << tubeOnly);
+	REQUIRE(sphereVoxels > 0);
+	CHECK(sphereOnly < sphereVoxels*0.03);
+	CHECK(tubeOnly < tubeVoxels*0.05);
+}
+
+TEST_CASE("AirwaysFromCenterline: Speed of swept tubes versus sphere stamping", "[speed][org.custusx.filter.airwaysfromcenterline]")
+{
+	cx::BranchListPtr branchList = createSyntheticBranchTree(6);
+
+	double sphereSeconds = 0;
+	double tubeSeconds = 0;
+	generateTubesVolume(branchList, false, &sphereSeconds);
+	generateTubesVolume(branchList, true, &tubeSeconds);
+
+	std::cout << "AirwaysFromCenterline rasterization of " << branchList->getBranches().size() << " branches: "
+			  << "spheres " << sphereSeconds << "s, "
+			  << "swept tubes " << tubeSeconds << "s" << std::endl;
+	CHECK(tubeSeconds < sphereSeconds);
+}
+
 
 TEST_CASE("AirwaysFromCenterline: execute", "[integration][org.custusx.filter.airwaysfromcenterline]")
 {
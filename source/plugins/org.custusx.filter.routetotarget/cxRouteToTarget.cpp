@@ -19,6 +19,11 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QList>
+#include <cmath>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
+#include "cxParallelFor.h"
+#include "cxUtilHelpers.h"
 
 #define PI 3.1415926535897
 
@@ -55,7 +60,7 @@ void RouteToTarget::processCenterline(MeshPtr mesh)
 	if (mBranchListPtr)
 		mBranchListPtr->deleteAllBranches();
 
-	vtkPolyDataPtr centerline_r = mesh->getTransformedPolyDataCopy(mesh->get_rMd());
+	vtkPolyDataPtr centerline_r = mesh->getTransformedPolyData(mesh->get_rMd());
 
 	mCLpoints = getCenterlinePositions(centerline_r);
 
@@ -79,6 +84,16 @@ BranchListPtr RouteToTarget::getBranchList()
 	return mBranchListPtr;
 }
 
+void RouteToTarget::setBloodVesselBranchList(BranchListPtr branchList)
+{
+	mBloodVesselBranchListPtr = branchList;
+}
+
+BranchListPtr RouteToTarget::getBloodVesselBranchList()
+{
+	return mBloodVesselBranchListPtr;
+}
+
 void RouteToTarget::processBloodVesselCenterline(Eigen::MatrixXd positions)
 {
 	if (mBloodVesselBranchListPtr)
@@ -296,7 +311,7 @@ vtkPolyDataPtr RouteToTarget::findRouteToTargetAlongBloodVesselCenterlines(MeshP
 {
 	vtkPolyDataPtr retval;
 
-	vtkPolyDataPtr BVcenterline_r = bloodVesselCenterlineMesh->getTransformedPolyDataCopy(bloodVesselCenterlineMesh->get_rMd());
+	vtkPolyDataPtr BVcenterline_r = bloodVesselCenterlineMesh->getTransformedPolyData(bloodVesselCenterlineMesh->get_rMd());
 	Eigen::MatrixXd BVCLpoints_r = getCenterlinePositions(BVcenterline_r);
 	mConnectedPointsInBVCL = findClosestBloodVesselSegments(BVCLpoints_r , mCLpoints, targetPoint->getCoordinate());
 
@@ -496,7 +511,7 @@ double RouteToTarget::getTracheaLength()
 
 std::vector< Eigen::Vector3d > RouteToTarget::getRoutePositions(MeshPtr route)
 {
-	vtkPolyDataPtr centerline_r = route->getTransformedPolyDataCopy(route->get_rMd());
+	vtkPolyDataPtr centerline_r = route->getTransformedPolyData(route->get_rMd());
 
 	std::vector< Eigen::Vector3d > routePositions;
 
@@ -528,85 +543,223 @@ double RouteToTarget::calculateRouteLength(std::vector< Eigen::Vector3d > route)
 	return routeLenght;
 }
 
-void RouteToTarget::setBloodVesselRadius()
+namespace
 {
-	std::vector<BranchPtr> branches = mBloodVesselBranchListPtr->getBranches();
+const double distanceTransformInfinity = 1.0E20;
 
-	for (int i = 0; i < branches.size(); i++)
+/** Squared distance transform of one line: f[q] is replaced by
+ *  min_p ((q-p)*spacing)^2 + f[p].
+ *  Felzenszwalb & Huttenlocher: Distance Transforms of Sampled Functions.
+ */
+void distanceTransformLine(float* f, int n, double spacing, std::vector<double>& d, std::vector<int>& v, std::vector<double>& z)
+{
+	d.assign(f, f+n);
+	v.resize(n);
+	z.resize(n+1);
+
+	int k = 0;
+	v[0] = 0;
+	z[0] = -distanceTransformInfinity;
+	z[1] = distanceTransformInfinity;
+	for (int q=1; q<n; ++q)
+	{
+		double s = 0;
+		while (true)
 		{
-			Eigen::MatrixXd positions = branches[i]->getPositions();
-			Eigen::MatrixXd orientations = branches[i]->getOrientations();
-			Eigen::VectorXd radius(positions.cols());
+			double qs = q*spacing;
+			double vs = v[k]*spacing;
+			s = ((d[q] + qs*qs) - (d[v[k]] + vs*vs)) / (2*(qs - vs));
+			if ((s > z[k]) || (k == 0))
+				break;
+			--k;
+		}
+		if (s <= z[k])
+			s = z[k]; // k==0: the new parabola is below the first everywhere
+		++k;
+		v[k] = q;
+		z[k] = s;
+		z[k+1] = distanceTransformInfinity;
+	}
+
+	k = 0;
+	for (int q=0; q<n; ++q)
+	{
+		while (z[k+1] < q*spacing)
+			++k;
+		double delta = (q - v[k])*spacing;
+		f[q] = std::min(delta*delta + d[v[k]], distanceTransformInfinity);
+	}
+}
 
-			for (int j = 0; j < positions.cols(); j++)
+/** Euclidean distance from each vessel voxel to the closest voxel outside
+ *  the vessel, in mm, computed for a box around the centerline.
+ *
+ *  Voxels with the max value of the segmentation are inside the vessel.
+ *  Distances are capped at the margin added around the centerline,
+ *  as the closest outside voxel may lie outside the box beyond that.
+ */
+class VesselDistanceMap
+{
+public:
+	VesselDistanceMap(vtkImageDataPtr image, Eigen::Array3i lower, Eigen::Array3i upper, double maxDistance) :
+		mLower(lower),
+		mDim(upper - lower + 1),
+		mMaxDistance(maxDistance)
+	{
+		image->GetSpacing(mSpacing);
+		image->GetOrigin(mOrigin);
+		int* dim = image->GetDimensions();
+		vtkDataArray* scalars = image->GetPointData()->GetScalars();
+		double maxValue = image->GetScalarRange()[1];
+		const float inf = distanceTransformInfinity;
+
+		mDistance.resize(mDim.prod());
+		int sliceSize = mDim[0]*mDim[1];
+		parallelFor(0, mDim[2], [&](int z)
+		{
+			for (int y=0; y<mDim[1]; ++y)
 			{
-				radius(j) = calculateBloodVesselRadius(positions.col(j), orientations.col(j));
+				vtkIdType source = (vtkIdType(z+mLower[2])*dim[1] + (y+mLower[1]))*dim[0] + mLower[0];
+				float* target = &mDistance[z*sliceSize + y*mDim[0]];
+				for (int x=0; x<mDim[0]; ++x)
+					target[x] = (scalars->GetComponent(source+x, 0) < maxValue) ? 0 : inf;
 			}
+		}, 1);
 
-			branches[i]->setRadius(radius);
+		// separable passes along x, y and z
+		this->transformLines(mDim[1]*mDim[2], mDim[0], 1, mSpacing[0], [this](int i) { return i*mDim[0]; });
+		this->transformLines(mDim[0]*mDim[2], mDim[1], mDim[0], mSpacing[1], [this, sliceSize](int i) { return (i/mDim[0])*sliceSize + i%mDim[0]; });
+		this->transformLines(mDim[0]*mDim[1], mDim[2], sliceSize, mSpacing[2], [](int i) { return i; });
+
+		parallelFor(0, int(mDistance.size()), [this](int i)
+		{
+			mDistance[i] = std::min(std::sqrt(mDistance[i]), float(mMaxDistance));
+		}, 1<<16);
+	}
+
+	/** Trilinear lookup of the distance at position_d, given in data space.
+	 */
+	double getDistance(Vector3D position_d) const
+	{
+		Vector3D index;
+		for (int i=0; i<3; ++i)
+			index[i] = constrainValue((position_d[i]-mOrigin[i])/mSpacing[i] - mLower[i], 0.0, double(mDim[i]-1));
+
+		Eigen::Array3i i0;
+		Eigen::Array3i i1;
+		Vector3D t;
+		for (int i=0; i<3; ++i)
+		{
+			i0[i] = std::floor(index[i]);
+			i1[i] = std::min(i0[i]+1, mDim[i]-1);
+			t[i] = index[i] - i0[i];
+		}
+
+		double retval = 0;
+		for (int corner=0; corner<8; ++corner)
+		{
+			Eigen::Array3i voxel;
+			double weight = 1;
+			for (int i=0; i<3; ++i)
+			{
+				bool upper = corner & (1<<i);
+				voxel[i] = upper ? i1[i] : i0[i];
+				weight *= upper ? t[i] : 1-t[i];
+			}
+			retval += weight * mDistance[(voxel[2]*mDim[1] + voxel[1])*mDim[0] + voxel[0]];
 		}
+		return retval;
+	}
 
+private:
+	template<class LINESTART>
+	void transformLines(int lines, int length, int stride, double spacing, LINESTART lineStart)
+	{
+		parallelForRange(0, lines, [&](int begin, int end)
+		{
+			std::vector<double> d;
+			std::vector<int> v;
+			std::vector<double> z;
+			std::vector<float> line(length);
+			for (int i=begin; i<end; ++i)
+			{
+				float* start = &mDistance[lineStart(i)];
+				for (int j=0; j<length; ++j)
+					line[j] = start[j*stride];
+				distanceTransformLine(line.data(), length, spacing, d, v, z);
+				for (int j=0; j<length; ++j)
+					start[j*stride] = line[j];
+			}
+		}, 64);
+	}
+
+	Eigen::Array3i mLower;
+	Eigen::Array3i mDim;
+	double mSpacing[3];
+	double mOrigin[3];
+	double mMaxDistance;
+	std::vector<float> mDistance;
+};
 }
 
-double RouteToTarget::calculateBloodVesselRadius(Eigen::Vector3d position, Eigen::Vector3d orientation)
+/** Set the radius of all blood vessel branches from a distance transform of the
+ *  segmentation: The radius at each centerline position is the distance to the
+ *  closest voxel outside the vessel, less half a voxel to place the edge between
+ *  the voxels.
+ */
+void RouteToTarget::setBloodVesselRadius()
 {
-	double radius = 0;
+	std::vector<BranchPtr> branches = mBloodVesselBranchListPtr->getBranches();
+	if (branches.empty())
+		return;
+
 	if (!mBloodVesselVolume)
-		return radius;
+	{
+		for (int i = 0; i < branches.size(); i++)
+			branches[i]->setRadius(Eigen::VectorXd::Zero(branches[i]->getPositions().cols()));
+		return;
+	}
 
 	vtkImageDataPtr bloodVesselImage = mBloodVesselVolume->getBaseVtkImageData();
+	Transform3D dMr = mBloodVesselVolume->get_rMd().inverse();
 	int* dim = bloodVesselImage->GetDimensions();
 	double* spacing = bloodVesselImage->GetSpacing();
-	Transform3D dMr = mBloodVesselVolume->get_rMd().inverse();
-	Eigen::Vector3d position_r = dMr.coord(position);
-	int x = (int) boost::math::round( position_r[0]/spacing[0] );
-	int y = (int) boost::math::round( position_r[1]/spacing[1] );
-	int z = (int) boost::math::round( position_r[2]/spacing[2] );
-	Eigen::Vector3i indexVector;
-	indexVector(0) = x;
-	indexVector(1) = y;
-	indexVector(2) = z;
-
-	Eigen::MatrixXd maxRadius(3,2);
-	Eigen::Vector3d perpendicularX = orientation.cross(Eigen::Vector3d::UnitX());
-	maxRadius(0,0) = findDistanceToSegmentationEdge(bloodVesselImage, indexVector, perpendicularX, dim, spacing, 1);
-	maxRadius(0,1) = findDistanceToSegmentationEdge(bloodVesselImage, indexVector, perpendicularX, dim, spacing, -1);
-	Eigen::Vector3d perpendicularY = orientation.cross(Eigen::Vector3d::UnitY());
-	maxRadius(1,0) = findDistanceToSegmentationEdge(bloodVesselImage, indexVector, perpendicularY, dim, spacing, 1);
-	maxRadius(1,1) = findDistanceToSegmentationEdge(bloodVesselImage, indexVector, perpendicularY, dim, spacing, -1);
-	Eigen::Vector3d perpendicularZ = orientation.cross(Eigen::Vector3d::UnitZ());
-	maxRadius(2,0) = findDistanceToSegmentationEdge(bloodVesselImage, indexVector, perpendicularZ, dim, spacing, 1);
-	maxRadius(2,1) = findDistanceToSegmentationEdge(bloodVesselImage, indexVector, perpendicularZ, dim, spacing, -1);
-
-	radius = maxRadius.rowwise().mean().minCoeff();
-
-	if (std::isnan(radius))
-		radius = 0;
-
-	return radius;
-}
-
-double RouteToTarget::findDistanceToSegmentationEdge(vtkImageDataPtr bloodVesselImage, Eigen::Vector3i indexVector, Eigen::Vector3d perpendicularVector, int* dim, double* spacing, int direction)
-{
-	double retval;
-	double maxValue = bloodVesselImage->GetScalarRange()[1];
-	for (int radiusVoxels=1; radiusVoxels<30; radiusVoxels++)
+	double* origin = bloodVesselImage->GetOrigin();
+
+	// the part of the volume within the search margin of the centerline
+	const int marginVoxels = 30;
+	Eigen::Array3i lower(dim[0]-1, dim[1]-1, dim[2]-1);
+	Eigen::Array3i upper(0, 0, 0);
+	for (int i = 0; i < branches.size(); i++)
 	{
-		if (perpendicularVector.sum() != 0)
+		Eigen::MatrixXd positions = branches[i]->getPositions();
+		for (int j = 0; j < positions.cols(); j++)
 		{
-			Eigen::Vector3d searchDirection =  perpendicularVector.normalized() * radiusVoxels;
-			int xIndex = std::max(std::min(indexVector(0) + direction * (int) std::round(searchDirection(0)), dim[0]-1), 0);
-			int yIndex = std::max(std::min(indexVector(1) + direction * (int) std::round(searchDirection(1)), dim[1]-1), 0);
-			int zIndex = std::max(std::min(indexVector(2) + direction * (int) std::round(searchDirection(2)), dim[2]-1), 0);
-			if (bloodVesselImage->GetScalarComponentAsDouble(xIndex, yIndex, zIndex, 0) < maxValue)
+			Vector3D position_d = dMr.coord(positions.col(j));
+			for (int k = 0; k < 3; k++)
 			{
-				searchDirection =  perpendicularVector.normalized() * (radiusVoxels-1);
-				retval = std::sqrt( std::pow(searchDirection(0)*spacing[0],2) + std::pow(searchDirection(1)*spacing[1],2) + std::pow(searchDirection(2)*spacing[2],2) );
-				break;
+				int index = (int) boost::math::round((position_d[k]-origin[k])/spacing[k]);
+				lower[k] = std::min(lower[k], index - marginVoxels);
+				upper[k] = std::max(upper[k], index + marginVoxels);
 			}
 		}
 	}
-	return retval;
+	lower = lower.max(Eigen::Array3i::Zero());
+	upper = upper.min(Eigen::Array3i(dim[0]-1, dim[1]-1, dim[2]-1));
+	if ((upper < lower).any())
+		lower = upper = Eigen::Array3i::Zero();
+
+	double minSpacing = std::min(spacing[0], std::min(spacing[1], spacing[2]));
+	VesselDistanceMap distanceMap(bloodVesselImage, lower, upper, marginVoxels*minSpacing);
+
+	parallelFor(0, int(branches.size()), [&](int i)
+	{
+		Eigen::MatrixXd positions = branches[i]->getPositions();
+		Eigen::VectorXd radius(positions.cols());
+		for (int j = 0; j < positions.cols(); j++)
+			radius(j) = std::max(0.0, distanceMap.getDistance(dMr.coord(positions.col(j))) - minSpacing/2);
+		branches[i]->setRadius(radius);
+	}, 1);
 }
 
 std::vector< Eigen::Vector3d > RouteToTarget::getRoutePositions(bool extendedRoute)
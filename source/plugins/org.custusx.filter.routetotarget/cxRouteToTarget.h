@@ -25,6 +25,8 @@ public:
 	void processCenterline(MeshPtr mesh);
 	void setBranchList(BranchListPtr branchList);
 	BranchListPtr getBranchList();
+	void setBloodVesselBranchList(BranchListPtr branchList);
+	BranchListPtr getBloodVesselBranchList();
 	void processBloodVesselCenterline(Eigen::MatrixXd positions);
 	void findClosestPointInBranches(Vector3D targetCoordinate_r);
 	void findClosestPointInBloodVesselBranches(Vector3D targetCoordinate_r);
@@ -42,8 +44,6 @@ public:
 	void addRouteInformationToFile(VisServicesPtr services);
 	static double calculateRouteLength(std::vector< Eigen::Vector3d > route);
 	void setBloodVesselRadius();
-	double calculateBloodVesselRadius(Eigen::Vector3d position, Eigen::Vector3d orientation);
-	double findDistanceToSegmentationEdge(vtkImageDataPtr bloodVesselImage, Eigen::Vector3i indexVector, Eigen::Vector3d perpendicularVector, int* dim, double* spacing, int direction);
 	void makeMarianaCenterlineFile(QString filename);
 	QJsonArray makeMarianaCenterlineJSON();
 	std::vector< Eigen::Vector3d > getRoutePositions(bool extendedRoute = true);
@@ -0,0 +1,7 @@
+#include "cxtestUtilities.h"
+#include "cxtest_org_custusx_filter_routetotarget_export.h"
+
+namespace
+{
+EXPORT_DUMMY_CLASS_FOR_LINKING_ON_WINDOWS_IN_LIB_WITHOUT_EXPORTED_CLASS(CXTEST_ORG_CUSTUSX_FILTER_ROUTETOTARGET_EXPORT)
+}
@@ -0,0 +1,120 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include "cxRouteToTarget.h"
+#include "cxImage.h"
+#include "cxBranch.h"
+#include "cxBranchList.h"
+#include "cxVolumeHelpers.h"
+#include "cxVector3D.h"
+#include <vtkImageData.h>
+
+namespace cxtest
+{
+
+namespace
+{
+/** A binary volume with value 1 inside a cylinder along z through center_d,
+ *  and 0 outside.
+ */
+cx::ImagePtr createCylinderImage(Eigen::Array3i dim, double spacing, cx::Vector3D center_d, double radius)
+{
+	vtkImageDataPtr raw = cx::generateVtkImageData(dim, cx::Vector3D(spacing, spacing, spacing), 0);
+	unsigned char* data = static_cast<unsigned char*>(raw->GetScalarPointer());
+	for (int z=0; z<dim[2]; ++z)
+		for (int y=0; y<dim[1]; ++y)
+			for (int x=0; x<dim[0]; ++x)
+			{
+				double dx = x*spacing - center_d[0];
+				double dy = y*spacing - center_d[1];
+				data[(z*dim[1] + y)*dim[0] + x] = (dx*dx + dy*dy <= radius*radius) ? 1 : 0;
+			}
+	raw->Modified();
+	return cx::ImagePtr(new cx::Image("cylinder", raw));
+}
+
+/** A branch of positions parallel to the cylinder axis, one in each slice.
+ */
+cx::BranchPtr createAxialBranch(cx::Vector3D start_d, int slices, double spacing)
+{
+	Eigen::MatrixXd positions(3, slices);
+	for (int z=0; z<slices; ++z)
+		positions.col(z) = start_d + cx::Vector3D(0, 0, z*spacing);
+	cx::BranchPtr branch(new cx::Branch());
+	branch->setPositions(positions);
+	return branch;
+}
+
+Eigen::VectorXd calculateRadius(cx::ImagePtr image, std::vector<cx::BranchPtr> branches)
+{
+	cx::BranchListPtr branchList(new cx::BranchList());
+	for (unsigned i=0; i<branches.size(); ++i)
+		branchList->addBranch(branches[i]);
+
+	cx::RouteToTarget routeToTarget;
+	routeToTarget.setBloodVesselVolume(image);
+	routeToTarget.setBloodVesselBranchList(branchList);
+	routeToTarget.setBloodVesselRadius();
+	return branches[0]->getRadius();
+}
+} // namespace
+
+TEST_CASE("RouteToTarget: Blood vessel radius of a synthetic cylinder", "[unit][org.custusx.filter.routetotarget]")
+{
+	double spacing = 0.5;
+	double radius = 5;
+	Eigen::Array3i dim(64, 64, 60);
+	cx::Vector3D center_d(32*spacing, 32*spacing, 0);
+	cx::ImagePtr image = createCylinderImage(dim, spacing, center_d, radius);
+
+	// the centerline runs to the first and last slice, where the image clips the search box
+	Eigen::VectorXd result = calculateRadius(image, std::vector<cx::BranchPtr>(1, createAxialBranch(center_d, dim[2], spacing)));
+
+	REQUIRE(result.size() == dim[2]);
+	for (int i=0; i<result.size(); ++i)
+	{
+		INFO("position " << i << ", radius " << result[i]);
+		CHECK(std::abs(result[i] - radius) <= spacing);
+	}
+}
+
+TEST_CASE("RouteToTarget: Blood vessel radius is capped at the search margin", "[unit][org.custusx.filter.routetotarget]")
+{
+	double spacing = 0.5;
+	double radius = 25;
+	Eigen::Array3i dim(120, 120, 20);
+	cx::Vector3D center_d(60*spacing, 60*spacing, 0);
+	cx::ImagePtr image = createCylinderImage(dim, spacing, center_d, radius);
+
+	// a centerline 3 mm from the wall has its edge within the margin
+	double wallDistance = 3;
+	std::vector<cx::BranchPtr> branches;
+	branches.push_back(createAxialBranch(center_d, dim[2], spacing));
+	branches.push_back(createAxialBranch(center_d + cx::Vector3D(radius-wallDistance, 0, 0), dim[2], spacing));
+	calculateRadius(image, branches);
+
+	// the margin of 30 voxels caps the distance on the axis, less the half voxel for the edge
+	double cap = 30*spacing - spacing/2;
+	Eigen::VectorXd axis = branches[0]->getRadius();
+	Eigen::VectorXd nearWall = branches[1]->getRadius();
+	REQUIRE(axis.size() == dim[2]);
+	REQUIRE(nearWall.size() == dim[2]);
+	for (int i=0; i<dim[2]; ++i)
+	{
+		INFO("position " << i << ", radius " << axis[i] << " on axis, " << nearWall[i] << " near wall");
+		CHECK(axis[i] <= cap + 1.0E-6);
+		CHECK(axis[i] >= cap - spacing);
+		CHECK(std::abs(nearWall[i] - wallDistance) <= spacing);
+	}
+}
+
+} // namespace cxtest
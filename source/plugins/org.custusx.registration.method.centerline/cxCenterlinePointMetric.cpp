@@ -0,0 +1,125 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#include "cxCenterlinePointMetric.h"
+
+#include <cmath>
+
+namespace cx
+{
+
+void CenterlinePointMetric::Initialize()
+{
+	Superclass::Initialize();
+
+	mMovingPoints.clear();
+	MovingPointSetType::PointsContainer::ConstIterator moving = m_MovingPointSet->GetPoints()->Begin();
+	for (; moving != m_MovingPointSet->GetPoints()->End(); ++moving)
+	{
+		const MovingPointSetType::PointType& p = moving.Value();
+		mMovingPoints.push_back(Vector3D(p[0], p[1], p[2]));
+	}
+
+	if (!mTree)
+	{
+		std::vector<Vector3D> fixedPoints;
+		FixedPointSetType::PointsContainer::ConstIterator fixed = m_FixedPointSet->GetPoints()->Begin();
+		for (; fixed != m_FixedPointSet->GetPoints()->End(); ++fixed)
+		{
+			const FixedPointSetType::PointType& p = fixed.Value();
+			fixedPoints.push_back(Vector3D(p[0], p[1], p[2]));
+		}
+		mTree = KdTree::create(fixedPoints);
+	}
+
+	if (!mTree->size())
+		itkExceptionMacro(<< "No fixed points");
+}
+
+unsigned int CenterlinePointMetric::GetNumberOfValues() const
+{
+	return static_cast<unsigned int>(mMovingPoints.size());
+}
+
+void CenterlinePointMetric::transformMovingPoints(const TransformParametersType& parameters, std::vector<Vector3D>* points) const
+{
+	m_Transform->SetParameters(parameters);
+	points->resize(mMovingPoints.size());
+	for (unsigned i=0; i<mMovingPoints.size(); ++i)
+	{
+		TransformType::InputPointType p;
+		p[0] = mMovingPoints[i][0];
+		p[1] = mMovingPoints[i][1];
+		p[2] = mMovingPoints[i][2];
+		TransformType::OutputPointType q = m_Transform->TransformPoint(p);
+		(*points)[i] = Vector3D(q[0], q[1], q[2]);
+	}
+}
+
+CenterlinePointMetric::MeasureType CenterlinePointMetric::GetValue(const TransformParametersType& parameters) const
+{
+	MeasureType value;
+	std::vector<Vector3D> points;
+	std::vector<int> indices;
+	std::vector<double> distancesSquared;
+
+	this->transformMovingPoints(parameters, &points);
+	mTree->findClosestPoints(points, &indices, &distancesSquared);
+
+	value.SetSize(points.size());
+	for (unsigned i=0; i<points.size(); ++i)
+		value[i] = std::sqrt(distancesSquared[i]);
+	return value;
+}
+
+void CenterlinePointMetric::GetDerivative(const TransformParametersType& parameters, DerivativeType& derivative) const
+{
+	MeasureType value;
+	this->GetValueAndDerivative(parameters, value, derivative);
+}
+
+/** Value and derivative from a single closest point search.
+ *  The derivative has one row per transform parameter, one column per moving point.
+ */
+void CenterlinePointMetric::GetValueAndDerivative(const TransformParametersType& parameters, MeasureType& value, DerivativeType& derivative) const
+{
+	std::vector<Vector3D> points;
+	std::vector<int> indices;
+	std::vector<double> distancesSquared;
+
+	this->transformMovingPoints(parameters, &points);
+	mTree->findClosestPoints(points, &indices, &distancesSquared);
+
+	unsigned numberOfParameters = m_Transform->GetNumberOfParameters();
+	value.SetSize(points.size());
+	derivative.SetSize(numberOfParameters, points.size());
+	derivative.Fill(0);
+
+	TransformType::JacobianType jacobian;
+	for (unsigned i=0; i<points.size(); ++i)
+	{
+		double distance = std::sqrt(distancesSquared[i]);
+		value[i] = distance;
+		if (distance <= 0)
+			continue; // derivative undefined on a fixed point, leave as zero
+
+		Vector3D direction = (points[i] - mTree->getPoint(indices[i])) / distance;
+		TransformType::InputPointType p;
+		p[0] = mMovingPoints[i][0];
+		p[1] = mMovingPoints[i][1];
+		p[2] = mMovingPoints[i][2];
+		m_Transform->ComputeJacobianWithRespectToParameters(p, jacobian);
+
+		for (unsigned j=0; j<numberOfParameters; ++j)
+			derivative(j, i) = direction[0]*jacobian(0, j) + direction[1]*jacobian(1, j) + direction[2]*jacobian(2, j);
+	}
+}
+
+} // namespace cx
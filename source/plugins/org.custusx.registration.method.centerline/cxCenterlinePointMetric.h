@@ -0,0 +1,79 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXCENTERLINEPOINTMETRIC_H_
+#define CXCENTERLINEPOINTMETRIC_H_
+
+#include "org_custusx_registration_method_centerline_Export.h"
+
+#include <vector>
+#include <itkPointSet.h>
+#include <itkPointSetToPointSetMetric.h>
+#include "cxKdTree.h"
+
+namespace cx
+{
+
+/** \brief Closest point distance from moving to fixed centerline points, with analytic derivative.
+ *
+ * Drop-in replacement for itk::EuclideanDistancePointMetric: one value per
+ * moving point, the distance from the transformed point to the closest fixed
+ * point. The fixed points are put in a KdTree once, in Initialize(), and the
+ * tree can be shared between metrics running concurrently on the same fixed
+ * points, see setFixedTree().
+ *
+ * The derivative of each distance is the unit vector from the closest fixed
+ * point, times the transform jacobian. This lets the optimizer use
+ * GetValueAndDerivative() with one closest point search per iteration, in
+ * place of one search per parameter for finite differences.
+ *
+ * \ingroup org_custusx_registration_method_centerline
+ */
+class org_custusx_registration_method_centerline_EXPORT CenterlinePointMetric :
+		public itk::PointSetToPointSetMetric<itk::PointSet<float, 3>, itk::PointSet<float, 3> >
+{
+public:
+	typedef CenterlinePointMetric Self;
+	typedef itk::PointSetToPointSetMetric<itk::PointSet<float, 3>, itk::PointSet<float, 3> > Superclass;
+	typedef itk::SmartPointer<Self> Pointer;
+	typedef itk::SmartPointer<const Self> ConstPointer;
+
+	itkNewMacro(Self);
+	itkTypeMacro(CenterlinePointMetric, PointSetToPointSetMetric);
+
+	typedef Superclass::MeasureType MeasureType;
+	typedef Superclass::DerivativeType DerivativeType;
+	typedef Superclass::TransformParametersType TransformParametersType;
+
+	/** Use a prebuilt tree of the fixed points instead of building one in Initialize().
+	 */
+	void setFixedTree(KdTreePtr tree) { mTree = tree; }
+	KdTreePtr getFixedTree() const { return mTree; }
+
+	virtual void Initialize() override;
+	virtual unsigned int GetNumberOfValues() const override;
+	virtual MeasureType GetValue(const TransformParametersType& parameters) const override;
+	virtual void GetDerivative(const TransformParametersType& parameters, DerivativeType& derivative) const override;
+	virtual void GetValueAndDerivative(const TransformParametersType& parameters, MeasureType& value, DerivativeType& derivative) const override;
+
+protected:
+	CenterlinePointMetric() {}
+	virtual ~CenterlinePointMetric() {}
+
+private:
+	void transformMovingPoints(const TransformParametersType& parameters, std::vector<Vector3D>* points) const;
+
+	KdTreePtr mTree;
+	std::vector<Vector3D> mMovingPoints;
+};
+
+} // namespace cx
+
+#endif /* CXCENTERLINEPOINTMETRIC_H_ */
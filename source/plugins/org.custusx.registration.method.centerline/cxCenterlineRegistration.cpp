@@ -19,6 +19,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxTransform3D.h"
 #include "cxVector3D.h"
 #include "cxLogger.h"
+#include "cxParallelFor.h"
+#include <algorithm>
+#include <limits>
+#include <random>
 #include <boost/math/special_functions/fpclassify.hpp> // isnan
 #include "vtkCardinalSpline.h"
 
@@ -28,37 +32,19 @@ namespace cx
 {
 
 
-CenterlineRegistration::CenterlineRegistration()
+CenterlineRegistration::CenterlineRegistration() :
+    mMovingCenter(0,0,0),
+    mScales(TransformType::ParametersDimension),
+    mNumberOfStarts(1),
+    mMaxRotation(0.2),
+    mMaxTranslation(10),
+    mResultTransform(Transform3D::Identity()),
+    mMeanDistance(0),
+    mRegistrationUpdated(false)
 {
     mFixedPointSet = PointSetType::New();
     mMovingPointSet = PointSetType::New();
-    mRegistration = RegistrationType::New();
-    mTransform = TransformType::New();
-    MetricType::Pointer         metric = MetricType::New();
-    mOptimizer = OptimizerType::New();
-    mOptimizer->SetUseCostFunctionGradient(false);
-    OptimizerType::ScalesType   scales(mTransform->GetNumberOfParameters());
-
-    unsigned long   numberOfIterations = 2000;
-    double          gradientTolerance = 1e-4;
-    double          valueTolerance = 1e-4;
-    double          epsilonFunction = 1e-5;
-
     UpdateScales(true,true,true,true,true,true);
-    mOptimizer->SetNumberOfIterations(numberOfIterations);
-    mOptimizer->SetValueTolerance(valueTolerance);
-    mOptimizer->SetGradientTolerance(gradientTolerance);
-    mOptimizer->SetEpsilonFunction(epsilonFunction);
-
-    // Initialize transform
-    mTransform->SetIdentity();
-    mRegistration->SetInitialTransformParameters(mTransform->GetParameters());
-
-    // Setup framework
-    mRegistration->SetMetric(metric);
-    mRegistration->SetOptimizer(mOptimizer);
-    mRegistration->SetTransform(mTransform);
-
 }
 
 
@@ -77,7 +63,7 @@ vtkPointsPtr convertTovtkPoints(Eigen::MatrixXd positions)
 void CenterlineRegistration::UpdateScales(bool xRot, bool yRot, bool zRot, bool xTrans, bool yTrans, bool zTrans)
 {
 
-    OptimizerType::ScalesType   scales(mTransform->GetNumberOfParameters());
+    OptimizerType::ScalesType   scales(TransformType::ParametersDimension);
     const double translationScale = 40.0;    // dynamic range of translations
     const double rotationScale = 0.3;    // dynamic range of rotations
 
@@ -106,11 +92,9 @@ void CenterlineRegistration::UpdateScales(bool xRot, bool yRot, bool zRot, bool
     else
         scales[5] = 1e50;
 
-    mOptimizer->SetScales(scales);
-    mRegistration->SetOptimizer(mOptimizer);
+    mScales = scales;
 
     std::cout << "Update scales: "
-              << mRegistration->GetOptimizer()->GetScales()
               << scales
               << std::endl;
 
@@ -226,11 +210,13 @@ void   CenterlineRegistration::SetFixedPoints(vtkPointsPtr vtkPoints)
         itkPoints->InsertElement(n,point);
     }
     mFixedPointSet->SetPoints(itkPoints);
+    mFixedTree = KdTree::create(vtkPoints);
 }
 
 void CenterlineRegistration::SetMovingPoints(vtkPointsPtr vtkPoints)
 {
     mMovingPointSet->Initialize();
+    mMovingCenter = Vector3D(0,0,0);
     PointsContainerPtr  itkPoints = PointsContainer::New();
     PointType   point;
 
@@ -243,19 +229,87 @@ void CenterlineRegistration::SetMovingPoints(vtkPointsPtr vtkPoints)
         point[1] = temp_Point[1];
         point[2] = temp_Point[2];
         itkPoints->InsertElement(n,point);
+        mMovingCenter += vPoint;
     }
     mMovingPointSet->SetPoints(itkPoints);
+    if (vtkPoints->GetNumberOfPoints())
+        mMovingCenter /= vtkPoints->GetNumberOfPoints();
 }
 
-Transform3D CenterlineRegistration::FullRegisterMoving(Transform3D init_transform)
+void CenterlineRegistration::setMultiStart(int numberOfStarts, double maxRotation, double maxTranslation)
+{
+    mNumberOfStarts = std::max(1, numberOfStarts);
+    mMaxRotation = maxRotation;
+    mMaxTranslation = maxTranslation;
+}
+
+/** Return the initial transform followed by mNumberOfStarts-1 perturbations of it.
+  * Rotations are about the center of the moving points, and are skipped if
+  * any rotation is disabled, as the Euler angles are coupled.
+  */
+std::vector<Transform3D> CenterlineRegistration::createInitialTransforms(Transform3D init_transform) const
+{
+    std::vector<Transform3D> retval;
+    retval.push_back(init_transform);
+
+    bool useRotation = (mScales[0] < 1e49) && (mScales[1] < 1e49) && (mScales[2] < 1e49);
+    Vector3D center = init_transform.coord(mMovingCenter);
+
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<double> uniform(-1, 1);
+    for (int i=1; i<mNumberOfStarts; ++i)
+    {
+        Vector3D axis(uniform(generator), uniform(generator), uniform(generator));
+        double angle = useRotation ? uniform(generator)*mMaxRotation : 0;
+        if (axis.norm() < 1e-6)
+            axis = Vector3D(0,0,1);
+
+        Vector3D translation;
+        for (int j=0; j<3; ++j)
+            translation[j] = (mScales[3+j] < 1e49) ? uniform(generator)*mMaxTranslation : 0;
+
+        Transform3D perturbation = Transform3D::Identity();
+        perturbation.linear() = Eigen::AngleAxisd(angle, axis.normalized()).toRotationMatrix();
+        perturbation = createTransformTranslate(center + translation) * perturbation * createTransformTranslate(-center);
+        retval.push_back(perturbation * init_transform);
+    }
+    return retval;
+}
+
+/** Run one registration from init_transform, using its own transform, metric
+  * and optimizer. Thread safe, the point sets and fixed tree are only read.
+  */
+Transform3D CenterlineRegistration::registerFrom(Transform3D init_transform, double* meanDistance) const
 {
-    mRegistration->SetFixedPointSet(mFixedPointSet);
-    mRegistration->SetMovingPointSet(mMovingPointSet);
+    TransformType::Pointer transform = TransformType::New();
+    MetricType::Pointer metric = MetricType::New();
+    metric->setFixedTree(mFixedTree);
+
+    unsigned long   numberOfIterations = 2000;
+    double          gradientTolerance = 1e-4;
+    double          valueTolerance = 1e-4;
+    double          epsilonFunction = 1e-5;
+
+    OptimizerType::Pointer optimizer = OptimizerType::New();
+    optimizer->SetUseCostFunctionGradient(true);
+    optimizer->SetScales(mScales);
+    optimizer->SetNumberOfIterations(numberOfIterations);
+    optimizer->SetValueTolerance(valueTolerance);
+    optimizer->SetGradientTolerance(gradientTolerance);
+    optimizer->SetEpsilonFunction(epsilonFunction);
+
+    RegistrationType::Pointer registration = RegistrationType::New();
+    registration->SetMetric(metric);
+    registration->SetOptimizer(optimizer);
+    registration->SetTransform(transform);
+    registration->SetFixedPointSet(mFixedPointSet);
+    registration->SetMovingPointSet(mMovingPointSet);
 
     typedef itk::Matrix<double,3,3>     MatrixType;
     typedef TransformType::OffsetType   TranslateVector;
     MatrixType                          initMatrix;
     TranslateVector                     initTranslation;
+    TransformType::InputPointType       center;
 
     // Set initial rotation
     for(int i=0; i<3; i++)
@@ -269,36 +323,70 @@ Transform3D CenterlineRegistration::FullRegisterMoving(Transform3D init_transfor
     initTranslation[1] = init_transform(1,3);
     initTranslation[2] = init_transform(2,3);
 
-    mTransform->SetMatrix(initMatrix, 1e-5);
-    mTransform->SetTranslation(initTranslation);
+    // Rotate about the moving points, decoupling rotation from translation
+    center[0] = mMovingCenter[0];
+    center[1] = mMovingCenter[1];
+    center[2] = mMovingCenter[2];
+
+    transform->SetCenter(center);
+    transform->SetMatrix(initMatrix, 1e-5);
+    transform->SetOffset(initTranslation);
 
-    mRegistration->SetInitialTransformParameters(mTransform->GetParameters());
+    registration->SetInitialTransformParameters(transform->GetParameters());
 
     try
     {
-        mRegistration->Update();
+        registration->Update();
     }
     catch (itk::ExceptionObject &exp)
     {
         std::cout << "CenterlineRegMethod - Exception caught ! " << std::endl;
         std::cout << exp << std::endl;
+        *meanDistance = std::numeric_limits<double>::max();
+        return init_transform;
     }
 
     RegistrationType::ParametersType finalParameters =
-            mRegistration->GetLastTransformParameters();
+            registration->GetLastTransformParameters();
+    transform->SetParameters(finalParameters);
 
-    TransformType::MatrixType regMatrix = mTransform->GetMatrix();
+    MetricType::MeasureType distances = metric->GetValue(finalParameters);
+    *meanDistance = distances.size() ? distances.mean() : 0;
 
+    Transform3D retval = Transform3D::Identity();
+    TransformType::MatrixType regMatrix = transform->GetMatrix();
+    TransformType::OffsetType regOffset = transform->GetOffset();
     for(int i=0; i<3; i++)
-        for(int j=0;j<3;j++) {
-            double element = regMatrix(i,j);
-            mResultTransform(i,j) = element;
-        }
+    {
+        for(int j=0;j<3;j++)
+            retval(i,j) = regMatrix(i,j);
+        retval(i,3) = regOffset[i];
+    }
+    return retval;
+}
+
+Transform3D CenterlineRegistration::FullRegisterMoving(Transform3D init_transform)
+{
+    std::vector<Transform3D> initTransforms = this->createInitialTransforms(init_transform);
+    std::vector<Transform3D> results(initTransforms.size());
+    std::vector<double> meanDistances(initTransforms.size());
+
+    const CenterlineRegistration* self = this;
+    const Transform3D* inputs = initTransforms.data();
+    Transform3D* outputs = results.data();
+    double* distances = meanDistances.data();
+    parallelFor(0, int(initTransforms.size()), [=](int i)
+    {
+        outputs[i] = self->registerFrom(inputs[i], &distances[i]);
+    }, 1);
 
-    mResultTransform(0,3) = finalParameters(3);
-    mResultTransform(1,3) = finalParameters(4);
-    mResultTransform(2,3) = finalParameters(5);
+    int best = std::min_element(meanDistances.begin(), meanDistances.end()) - meanDistances.begin();
+    if (initTransforms.size() > 1)
+        report(QString("Centerline registration: best of %1 initial poses is #%2, mean distance %3 mm (initial pose: %4 mm)")
+               .arg(initTransforms.size()).arg(best).arg(meanDistances[best], 0, 'f', 2).arg(meanDistances[0], 0, 'f', 2));
 
+    mResultTransform = results[best];
+    mMeanDistance = meanDistances[best];
     mRegistrationUpdated = true;
 
     return Transform3D(mResultTransform);
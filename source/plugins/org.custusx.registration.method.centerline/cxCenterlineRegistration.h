@@ -24,10 +24,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkLandmarkTransform.h>
 
 #include <itkEuler3DTransform.h>
-#include <itkEuclideanDistancePointMetric.h>
 #include <itkLevenbergMarquardtOptimizer.h>
 #include <itkPointSetToPointSetRegistrationMethod.h>
 #include <itkPointSet.h>
+#include "cxCenterlinePointMetric.h"
 
 
 typedef std::vector< Eigen::Matrix4d > M4Vector;
@@ -41,6 +41,18 @@ typedef vtkSmartPointer<vtkDoubleArray>             vtkDoubleArrayPtr;
 typedef vtkSmartPointer<vtkPoints>                  vtkPointsPtr;
 typedef vtkSmartPointer<vtkPolyData>                vtkPolyDataPtr;
 
+/** Rigid registration of tracked positions (moving) to a centerline (fixed).
+ *
+ * Minimizes the distance from each moving point to the closest fixed point
+ * with Levenberg-Marquardt, using the analytic derivative of
+ * CenterlinePointMetric. The fixed points are put in a KdTree once, when set.
+ *
+ * FullRegisterMoving() can run from several initial poses concurrently: the
+ * given one, plus poses perturbed by random rotations about the center of
+ * the moving points and random translations, see setMultiStart(). The
+ * result with the lowest mean distance is kept. The perturbations are
+ * deterministic, and do not touch parameters disabled in UpdateScales().
+ */
 class org_custusx_registration_method_centerline_EXPORT CenterlineRegistration
 {
 
@@ -51,10 +63,7 @@ public:
     typedef PointSetType::PointsContainerPointer        PointsContainerPtr;
     typedef PointsContainer::Iterator                   PointsIterator;
 
-    typedef itk::EuclideanDistancePointMetric<
-                                      PointSetType,
-                                      PointSetType>
-                                                        MetricType;
+    typedef CenterlinePointMetric                       MetricType;
     typedef itk::Euler3DTransform< double >             TransformType;
     typedef itk::LevenbergMarquardtOptimizer            OptimizerType;
 
@@ -68,20 +77,32 @@ public:
     void SetFixedPoints(vtkPointsPtr points);
     void SetMovingPoints(vtkPointsPtr points);
     Transform3D FullRegisterMoving(Transform3D init_transform);
+    /** Set the number of initial poses run by FullRegisterMoving(), and the max
+      * perturbation from the given pose: rotation in radians, translation in mm.
+      */
+    void setMultiStart(int numberOfStarts, double maxRotation = 0.2, double maxTranslation = 10);
+    double getMeanDistance() const { return mMeanDistance; } ///< mean distance in mm after the last FullRegisterMoving()
     vtkPointsPtr processCenterline(vtkPolyDataPtr centerline, Transform3D rMd);
     vtkPointsPtr ConvertTrackingDataToVTK(TimedTransformMap trackingData_prMt, Transform3D rMpr);
     Transform3D runCenterlineRegistration(vtkPolyDataPtr centerline, Transform3D rMd, TimedTransformMap trackingData_prMt, Transform3D old_rMpr );
     virtual ~CenterlineRegistration();
 
 private:
+    std::vector<Transform3D> createInitialTransforms(Transform3D init_transform) const;
+    Transform3D registerFrom(Transform3D init_transform, double* meanDistance) const;
+
     PointSetType::Pointer mFixedPointSet;
     PointSetType::Pointer mMovingPointSet;
+    KdTreePtr mFixedTree;
+    Vector3D mMovingCenter;
 
-    RegistrationType::Pointer mRegistration;
-    TransformType::Pointer mTransform;
+    OptimizerType::ScalesType mScales;
+    int mNumberOfStarts;
+    double mMaxRotation;
+    double mMaxTranslation;
     Transform3D mResultTransform;
+    double mMeanDistance;
     bool mRegistrationUpdated;
-    OptimizerType::Pointer mOptimizer;
 
 };
 
@@ -96,6 +96,7 @@ void CenterlineRegistrationWidget::setup()
     this->selectXrotation(mOptions.getElement());
     this->selectYrotation(mOptions.getElement());
     this->selectZrotation(mOptions.getElement());
+    this->createNumberOfStarts(mOptions.getElement());
 
 	mVerticalLayout->addWidget(mRecordTrackingWidget);
     mVerticalLayout->addWidget(new CheckBoxWidget(this, mUseXtranslation));
@@ -104,6 +105,7 @@ void CenterlineRegistrationWidget::setup()
     mVerticalLayout->addWidget(new CheckBoxWidget(this, mUseXrotation));
     mVerticalLayout->addWidget(new CheckBoxWidget(this, mUseYrotation));
     mVerticalLayout->addWidget(new CheckBoxWidget(this, mUseZrotation));
+    mVerticalLayout->addWidget(createDataWidget(mServices->view(), mServices->patient(), this, mNumberOfStarts));
 	mVerticalLayout->addWidget(mRegisterButton);
 
 	mVerticalLayout->addStretch();
@@ -135,6 +137,7 @@ void CenterlineRegistrationWidget::registerSlot()
     mCenterlineRegistration->UpdateScales(
                 mUseXrotation->getValue(), mUseYrotation->getValue(), mUseZrotation->getValue(),
                 mUseXtranslation->getValue(), mUseYtranslation->getValue(), mUseZtranslation->getValue());
+    mCenterlineRegistration->setMultiStart(int(mNumberOfStarts->getValue()));
 
 	Transform3D old_rMpr = mServices->patient()->get_rMpr();//input to registrationAlgorithm
 
@@ -206,7 +209,12 @@ void CenterlineRegistrationWidget::selectZrotation(QDomElement root)
                                                                                 root);
 }
 
-
+void CenterlineRegistrationWidget::createNumberOfStarts(QDomElement root)
+{
+    mNumberOfStarts = DoubleProperty::initialize("Initial poses:", "",
+                                                 "Number of perturbed initial poses registered concurrently, the best result is kept", 1, DoubleRange(1, 32, 1), 0,
+                                                 root);
+}
 
 void CenterlineRegistrationWidget::clearDataOnNewPatient()
 {
@@ -70,6 +70,7 @@ private:
     BoolPropertyPtr mUseXrotation;
     BoolPropertyPtr mUseYrotation;
     BoolPropertyPtr mUseZrotation;
+    DoublePropertyPtr mNumberOfStarts;
 
 	XmlOptionFile mOptions;
 	MeshPtr mMesh;
@@ -88,6 +89,7 @@ private:
     void selectXrotation(QDomElement root);
     void selectYrotation(QDomElement root);
     void selectZrotation(QDomElement root);
+    void createNumberOfStarts(QDomElement root);
 
 };
 
@@ -17,12 +17,149 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxCenterlineRegistration.h"
 #include "cxtestSessionStorageTestFixture.h"
 #include "cxVisServices.h"
+#include "cxCenterlinePointMetric.h"
+#include <cmath>
+#include <vtkPoints.h>
 
 typedef boost::shared_ptr<cx::CenterlineRegistration> CenterlineRegistrationPtr;
 
 
 namespace cxtest {
 
+namespace
+{
+/** A curved main branch with a side branch, sampled every 0.5 mm.
+  */
+std::vector<cx::Vector3D> createBranchedCenterline()
+{
+    std::vector<cx::Vector3D> retval;
+    for (double t=0; t<=100; t+=0.5)
+        retval.push_back(cx::Vector3D(t, 0.004*t*t, 8*sin(t/20)));
+    for (double t=0.5; t<=40; t+=0.5)
+        retval.push_back(cx::Vector3D(50+0.6*t, 10+0.8*t, 8*sin(2.5)-0.2*t));
+    return retval;
+}
+
+vtkPointsPtr toVtkPoints(const std::vector<cx::Vector3D>& points)
+{
+    vtkPointsPtr retval = vtkPointsPtr::New();
+    for (unsigned i=0; i<points.size(); ++i)
+        retval->InsertNextPoint(points[i].data());
+    return retval;
+}
+
+cx::CenterlineRegistration::PointSetType::Pointer toPointSet(const std::vector<cx::Vector3D>& points)
+{
+    cx::CenterlineRegistration::PointSetType::Pointer retval = cx::CenterlineRegistration::PointSetType::New();
+    cx::CenterlineRegistration::PointsContainerPtr container = cx::CenterlineRegistration::PointsContainer::New();
+    for (unsigned i=0; i<points.size(); ++i)
+    {
+        cx::CenterlineRegistration::PointType p;
+        p[0] = points[i][0];
+        p[1] = points[i][1];
+        p[2] = points[i][2];
+        container->InsertElement(i, p);
+    }
+    retval->SetPoints(container);
+    return retval;
+}
+
+/** Tool positions along both branches, moved by the inverse of rMpr.
+  */
+std::vector<cx::Vector3D> createMovingPoints(const std::vector<cx::Vector3D>& centerline, cx::Transform3D rMpr)
+{
+    std::vector<cx::Vector3D> retval;
+    for (unsigned i=10; i<centerline.size(); i+=7)
+        retval.push_back(rMpr.inverse().coord(centerline[i]));
+    return retval;
+}
+
+double meanDistance(const std::vector<cx::Vector3D>& points, cx::Transform3D T, const std::vector<cx::Vector3D>& target)
+{
+    double sum = 0;
+    for (unsigned i=0; i<points.size(); ++i)
+        sum += (T.coord(points[i]) - target[i]).norm();
+    return sum / points.size();
+}
+}
+
+TEST_CASE("CenterlinePointMetric: Analytic derivative matches finite differences", "[unit][org.custusx.registration.method.centerline]")
+{
+    std::vector<cx::Vector3D> fixed = createBranchedCenterline();
+    cx::Transform3D rMpr = cx::createTransformTranslate(cx::Vector3D(3, -2, 1)) * cx::createTransformRotateZ(0.05);
+    std::vector<cx::Vector3D> moving = createMovingPoints(fixed, rMpr);
+
+    cx::CenterlineRegistration::TransformType::Pointer transform = cx::CenterlineRegistration::TransformType::New();
+    cx::CenterlinePointMetric::Pointer metric = cx::CenterlinePointMetric::New();
+    metric->SetFixedPointSet(toPointSet(fixed));
+    metric->SetMovingPointSet(toPointSet(moving));
+    metric->SetTransform(transform);
+    metric->Initialize();
+    REQUIRE(metric->GetNumberOfValues() == moving.size());
+
+    cx::CenterlineRegistration::TransformType::ParametersType parameters(6);
+    parameters[0] = 0.01;
+    parameters[1] = -0.02;
+    parameters[2] = 0.03;
+    parameters[3] = 0.7;
+    parameters[4] = -0.4;
+    parameters[5] = 0.3;
+
+    cx::CenterlinePointMetric::MeasureType value;
+    cx::CenterlinePointMetric::DerivativeType derivative;
+    metric->GetValueAndDerivative(parameters, value, derivative);
+    REQUIRE(derivative.rows() == 6);
+    REQUIRE(derivative.cols() == moving.size());
+
+    double step = 1E-6;
+    for (unsigned j=0; j<6; ++j)
+    {
+        cx::CenterlineRegistration::TransformType::ParametersType plus = parameters;
+        cx::CenterlineRegistration::TransformType::ParametersType minus = parameters;
+        plus[j] += step;
+        minus[j] -= step;
+        cx::CenterlinePointMetric::MeasureType valuePlus = metric->GetValue(plus);
+        cx::CenterlinePointMetric::MeasureType valueMinus = metric->GetValue(minus);
+        for (unsigned i=0; i<moving.size(); ++i)
+        {
+            double numeric = (valuePlus[i] - valueMinus[i]) / (2*step);
+            INFO("parameter " << j << ", point " << i);
+            CHECK(derivative(j, i) == Approx(numeric).margin(1E-3));
+        }
+    }
+}
+
+TEST_CASE("CenterlineRegistration: Multiple initial poses recover a poorly aligned path", "[unit][org.custusx.registration.method.centerline]")
+{
+    std::vector<cx::Vector3D> fixed = createBranchedCenterline();
+    cx::Transform3D rMpr = cx::createTransformTranslate(cx::Vector3D(12, -9, 6))
+            * cx::createTransformRotateZ(0.25) * cx::createTransformRotateX(-0.15);
+    std::vector<cx::Vector3D> moving = createMovingPoints(fixed, rMpr);
+    std::vector<cx::Vector3D> target;
+    for (unsigned i=0; i<moving.size(); ++i)
+        target.push_back(rMpr.coord(moving[i]));
+
+    cx::CenterlineRegistration registration;
+    registration.SetFixedPoints(toVtkPoints(fixed));
+    registration.SetMovingPoints(toVtkPoints(moving));
+
+    cx::Transform3D single = registration.FullRegisterMoving(cx::Transform3D::Identity());
+    double singleDistance = registration.getMeanDistance();
+
+    registration.setMultiStart(16, 0.3, 15);
+    cx::Transform3D best = registration.FullRegisterMoving(cx::Transform3D::Identity());
+    double bestDistance = registration.getMeanDistance();
+
+    CHECK(bestDistance <= singleDistance);
+    CHECK(bestDistance < 0.3);
+    CHECK(meanDistance(moving, best, target) < 1.0);
+    CHECK(meanDistance(moving, best, target) <= meanDistance(moving, single, target) + 1E-6);
+
+    // deterministic
+    cx::Transform3D again = registration.FullRegisterMoving(cx::Transform3D::Identity());
+    CHECK(cx::similar(again, best));
+}
+
 
 // This test just use two random centerlines and register them to each other.
 // The test only verifies that the code is running without crashing, and that all objects are created.
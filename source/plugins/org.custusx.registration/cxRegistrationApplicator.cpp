@@ -43,16 +43,16 @@ void RegistrationApplicator::updateRegistration(QDateTime oldTime, RegistrationT
 {
 	bool silent = delta_pre_rMd.mTemp;
   FrameForest forest(mSource);
-  QDomNode moving = forest.getNode(delta_pre_rMd.mMoving);
+  QString moving = forest.getNode(delta_pre_rMd.mMoving);
   DataPtr movingData = mSource[delta_pre_rMd.mMoving];
-  QDomNode fixed = forest.getNode(delta_pre_rMd.mFixed);
+  QString fixed = forest.getNode(delta_pre_rMd.mFixed);
 
   // if no parent, assume this is an operation on the moving image, thus set fixed to its parent.
   if (delta_pre_rMd.mFixed == "")
   {
 	  fixed = forest.getNode(movingData->getParentSpace());
   }
-  QDomNode movingBase = forest.getOldestAncestorNotCommonToRef(moving, fixed);
+  QString movingBase = forest.getOldestAncestorNotCommonToRef(moving, fixed);
 
   std::vector<DataPtr> allMovingData = forest.getDataFromDescendantsAndSelf(movingBase);
 
@@ -76,8 +76,7 @@ void RegistrationApplicator::updateRegistration(QDateTime oldTime, RegistrationT
   {
 	// connect the target to the master's ancestor, i.e. replace targetBase with masterAncestor:
 
-	QDomNode fixedAncestor = forest.getOldestAncestor(fixed);
-	QString fixedAncestorUid = fixedAncestor.toElement().tagName();
+	QString fixedAncestorUid = forest.getOldestAncestor(fixed);
 
 	QString newFixedSpace = fixedAncestorUid;
 
@@ -89,7 +88,7 @@ void RegistrationApplicator::updateRegistration(QDateTime oldTime, RegistrationT
 		this->changeParentSpace(oldTime, mSource[fixedAncestorUid], newParentSpace);
 	}
 
-	QString movingBaseUid = movingBase.toElement().tagName();
+	QString movingBaseUid = movingBase;
 	// if movingBaseUid is a data, then move the space above it
 	if (mSource.count(movingBaseUid))
 	{
@@ -64,50 +64,108 @@ void optimizedCoordTransform(Vector3D* p, boost::array<double, 16> tt)
 bool PNNReconstructionMethodService::reconstruct(ProcessedUSInputDataPtr input,
 		vtkImageDataPtr outputData, QDomElement settings)
 {
-	input->validate();
+	std::vector<ProcessedUSInputDataPtr> inputs(1, input);
+	std::vector<vtkImageDataPtr> outputs(1, outputData);
+	return this->reconstructMultiple(inputs, outputs, settings);
+}
+
+bool PNNReconstructionMethodService::reconstructMultiple(std::vector<ProcessedUSInputDataPtr> inputs,
+		std::vector<vtkImageDataPtr> outputData, QDomElement settings)
+{
+	if (inputs.empty() || (inputs.size() != outputData.size()))
+		return false;
 
-	std::vector<TimedPosition> frameInfo = input->getFrames();
+	for (unsigned i=0; i<inputs.size(); ++i)
+		inputs[i]->validate();
+
+	std::vector<TimedPosition> frameInfo = inputs[0]->getFrames();
 	if (frameInfo.empty())
 		return false;
-	if (input->getDimensions()[2]==0)
+	Eigen::Array3i inputDims = inputs[0]->getDimensions();
+	if (inputDims[2]==0)
 		return false;
 
-	vtkImageDataPtr target = outputData;
+	for (unsigned i=1; i<inputs.size(); ++i)
+	{
+		if ((inputs[i]->getDimensions() != inputDims).any() || (inputs[i]->getFrames().size() != frameInfo.size()))
+		{
+			reportError("PNN: Inputs to multiple reconstruction must have equal dimensions and frames.");
+			return false;
+		}
+	}
 
-	Eigen::Array3i inputDims = input->getDimensions();
+	Eigen::Array3i targetDims(outputData[0]->GetDimensions());
+	Vector3D targetSpacing(outputData[0]->GetSpacing());
 
-	Eigen::Array3i targetDims(target->GetDimensions());
-	Vector3D targetSpacing(target->GetSpacing());
+	//Create temporary volumes
+	std::vector<ImagePtr> tempOutputData;
+	for (unsigned i=0; i<outputData.size(); ++i)
+	{
+		vtkImageDataPtr tempOutput = generateVtkImageData(targetDims, targetSpacing, 0);
+		tempOutputData.push_back(ImagePtr(new Image("tempOutput", tempOutput, "tempOutput")));
+	}
 
-	//Create temporary volume
-	vtkImageDataPtr tempOutput = generateVtkImageData(targetDims, targetSpacing, 0);
-	ImagePtr tempOutputData = ImagePtr(new Image("tempOutput", tempOutput, "tempOutput"));
+	this->binPixels(inputs, tempOutputData);
 
-	int* outputDims = tempOutput->GetDimensions();
-	//int* outputDims = target->GetDimensions();
+	// Fill holes
+	for (unsigned i=0; i<outputData.size(); ++i)
+	{
+		this->interpolate(tempOutputData[i], outputData[i], settings);
+		setDeepModified(outputData[i]);
+	}
+
+	return true;
+}
+
+/**Traverse all input pixels once, scattering each pixel of all inputs
+ * into the voxel it hits in the corresponding output.
+ *
+ * The pixel to voxel mapping is computed once and shared by all inputs,
+ * while each input is masked by its own mask.
+ */
+void PNNReconstructionMethodService::binPixels(std::vector<ProcessedUSInputDataPtr> inputs, std::vector<ImagePtr> outputData)
+{
+	std::vector<TimedPosition> frameInfo = inputs[0]->getFrames();
+	Eigen::Array3i inputDims = inputs[0]->getDimensions();
+	vtkImageDataPtr firstOutput = outputData[0]->getBaseVtkImageData();
+	int* outputDims = firstOutput->GetDimensions();
 
 	if (inputDims[2] != static_cast<int> (frameInfo.size()))
 		reportWarning("inputDims[2] != frameInfo.size()" + qstring_cast(inputDims[2]) + " != "
 			+ qstring_cast(frameInfo.size()));
 
-	Vector3D inputSpacing(input->getSpacing());
-	Vector3D outputSpacing(tempOutput->GetSpacing());
+	Vector3D inputSpacing(inputs[0]->getSpacing());
+	Vector3D outputSpacing(firstOutput->GetSpacing());
 
 	//Get raw data pointers
-	unsigned char *outputPointer = static_cast<unsigned char*> (tempOutput->GetScalarPointer());
-	unsigned char* maskPointer = static_cast<unsigned char*> (input->getMask()->GetScalarPointer());
+	std::vector<unsigned char*> outputPointers;
+	for (unsigned i=0; i<outputData.size(); ++i)
+		outputPointers.push_back(static_cast<unsigned char*> (outputData[i]->getBaseVtkImageData()->GetScalarPointer()));
+	std::vector<unsigned char*> maskPointers;
+	for (unsigned i=0; i<inputs.size(); ++i)
+		maskPointers.push_back(static_cast<unsigned char*> (inputs[i]->getMask()->GetScalarPointer()));
+	std::vector<unsigned char*> inputPointers(inputs.size());
+	std::vector<bool> validInputs(inputs.size());
+	int outputCount = outputPointers.size();
 
 	// Traverse all input pixels
 	for (int record = 0; record < inputDims[2]; record++)
 	{
-		unsigned char *inputPointer = input->getFrame(record);
+		for (unsigned i=0; i<inputs.size(); ++i)
+			inputPointers[i] = inputs[i]->getFrame(record);
 		boost::array<double, 16> recordTransform = frameInfo[record].mPos.flatten();
 
 		for (int beam = 0; beam < inputDims[0]; beam++)
 		{
 			for (int sample = 0; sample < inputDims[1]; sample++)
 			{
-				if (!validPixel(beam, sample, inputDims, maskPointer))
+				bool anyValid = false;
+				for (int i = 0; i < outputCount; ++i)
+				{
+					validInputs[i] = validPixel(beam, sample, inputDims, maskPointers[i]);
+					anyValid = anyValid || validInputs[i];
+				}
+				if (!anyValid)
 					continue;
 				Vector3D inputPoint(beam * inputSpacing[0], sample * inputSpacing[1], 0.0);
 				Vector3D outputPoint = inputPoint;
@@ -122,21 +180,22 @@ bool PNNReconstructionMethodService::reconstruct(ProcessedUSInputDataPtr input,
 						* outputDims[1];
 					int inputIndex = beam + sample * inputDims[0];
 
-					// assign the max value found from all frames hitting this voxel. This removes black areas where (some of) multiple sweeps contains shadows.
-					outputPointer[outputIndex] = std::max<unsigned char>(inputPointer[inputIndex], outputPointer[outputIndex]);
-					// set minimum intensity value to 1. This separates "zero intensity" from "no intensity".
-					outputPointer[outputIndex] = std::max<unsigned char>(inputPointer[inputIndex], 1); //
+					for (int i = 0; i < outputCount; ++i)
+					{
+						if (!validInputs[i])
+							continue;
+						unsigned char* outputPointer = outputPointers[i];
+						unsigned char* inputPointer = inputPointers[i];
+						// assign the max value found from all frames hitting this voxel. This removes black areas where (some of) multiple sweeps contains shadows.
+						outputPointer[outputIndex] = std::max<unsigned char>(inputPointer[inputIndex], outputPointer[outputIndex]);
+						// set minimum intensity value to 1. This separates "zero intensity" from "no intensity".
+						outputPointer[outputIndex] = std::max<unsigned char>(inputPointer[inputIndex], 1); //
+					}
 				}//validVoxel
 
 			}//sample
 		}//beam
 	}//record
-
-	// Fill holes
-	this->interpolate(tempOutputData, outputData, settings);
-
-	setDeepModified(outputData);
-	return true;
 }
 
 namespace
@@ -42,6 +42,8 @@ public:
 
 	virtual std::vector<PropertyPtr> getSettings(QDomElement root);
 	virtual bool reconstruct(ProcessedUSInputDataPtr input, vtkImageDataPtr outputData, QDomElement settings);
+	virtual bool reconstructMultiple(std::vector<ProcessedUSInputDataPtr> inputs, std::vector<vtkImageDataPtr> outputData, QDomElement settings);
+	virtual bool canReconstructMultiple() const { return true; }
 
 
 private:
@@ -56,6 +58,7 @@ private:
 		return (x >= 0) && (x < dims[0]) && (y >= 0) && (y < dims[1]) && (z >= 0) && (z < dims[2]);
 	}
 
+	void binPixels(std::vector<ProcessedUSInputDataPtr> inputs, std::vector<ImagePtr> outputData);
 	void interpolate(ImagePtr inputData, vtkImageDataPtr outputData, QDomElement settings);
 	vtkImageDataPtr createMask(vtkImageDataPtr inputData);
 	void fillHole(unsigned char *inputPointer, unsigned char *outputPointer, int x, int y, int z, const Eigen::Array3i& dim, int interpolationSteps);
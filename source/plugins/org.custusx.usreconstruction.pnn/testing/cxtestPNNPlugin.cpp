@@ -18,6 +18,9 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxtestUtilities.h"
 #include "cxLogicManager.h"
 #include "cxFileManagerServiceProxy.h"
+#include "cxtestSyntheticReconstructInput.h"
+#include "cxVolumeHelpers.h"
+#include <vtkImageData.h>
 
 namespace cxtest
 {
@@ -86,6 +89,94 @@ TEST_CASE("ReconstructAlgorithm: PNN on sphere, tilt","[unit][usreconstruction][
 	cx::LogicManager::shutdown();
 }
 
-} // namespace cxtest
+TEST_CASE("ReconstructAlgorithm: PNN multiple outputs equal separate reconstructions","[unit][usreconstruction][synthetic][pnn]")
+{
+	cx::LogicManager::initialize();
+	ctkPluginContext* pluginContext = cx::logicManager()->getPluginContext();
+
+	QDomDocument domdoc;
+	QDomElement settings = domdoc.createElement("pnn");
+
+	SyntheticReconstructInputPtr generator(new SyntheticReconstructInput);
+	generator->setOverallBoundsAndSpacing(100, 5);
+	generator->setSpherePhantom();
+	cx::ProcessedUSInputDataPtr input = generator->generateSynthetic_ProcessedUSInputData(cx::Transform3D::Identity());
+
+	Eigen::Array3i dim(21, 21, 21);
+	cx::Vector3D spacing(5, 5, 5);
+	vtkImageDataPtr single = cx::generateVtkImageData(dim, spacing, 0);
+	std::vector<vtkImageDataPtr> multiple;
+	multiple.push_back(cx::generateVtkImageData(dim, spacing, 0));
+	multiple.push_back(cx::generateVtkImageData(dim, spacing, 0));
+
+	cx::PNNReconstructionMethodService algorithm(pluginContext);
+	CHECK(algorithm.canReconstructMultiple());
+	REQUIRE(algorithm.reconstruct(input, single, settings));
+	REQUIRE(algorithm.reconstructMultiple(std::vector<cx::ProcessedUSInputDataPtr>(2, input), multiple, settings));
+
+	unsigned char* expected = static_cast<unsigned char*>(single->GetScalarPointer());
+	int differences = 0;
+	int nonZero = 0;
+	for (int i=0; i<single->GetNumberOfPoints(); ++i)
+	{
+		for (unsigned j=0; j<multiple.size(); ++j)
+			if (static_cast<unsigned char*>(multiple[j]->GetScalarPointer())[i] != expected[i])
+				++differences;
+		if (expected[i] > 0)
+			++nonZero;
+	}
+	CHECK(differences == 0);
+	CHECK(nonZero > 0);
+
+	cx::LogicManager::shutdown();
+}
 
+TEST_CASE("ReconstructAlgorithm: PNN multiple outputs use the mask of each input","[unit][usreconstruction][synthetic][pnn]")
+{
+	cx::LogicManager::initialize();
+	ctkPluginContext* pluginContext = cx::logicManager()->getPluginContext();
+
+	QDomDocument domdoc;
+	QDomElement settings = domdoc.createElement("pnn");
+
+	SyntheticReconstructInputPtr generator(new SyntheticReconstructInput);
+	generator->setOverallBoundsAndSpacing(100, 5);
+	generator->setSpherePhantom();
+	cx::ProcessedUSInputDataPtr input = generator->generateSynthetic_ProcessedUSInputData(cx::Transform3D::Identity());
+	cx::ProcessedUSInputDataPtr masked = generator->generateSynthetic_ProcessedUSInputData(cx::Transform3D::Identity());
+	vtkImageDataPtr mask = masked->getMask();
+	memset(mask->GetScalarPointer(), 0, mask->GetNumberOfPoints());
+
+	Eigen::Array3i dim(21, 21, 21);
+	cx::Vector3D spacing(5, 5, 5);
+	vtkImageDataPtr single = cx::generateVtkImageData(dim, spacing, 0);
+	std::vector<vtkImageDataPtr> multiple;
+	multiple.push_back(cx::generateVtkImageData(dim, spacing, 0));
+	multiple.push_back(cx::generateVtkImageData(dim, spacing, 0));
+
+	cx::PNNReconstructionMethodService algorithm(pluginContext);
+	REQUIRE(algorithm.reconstruct(input, single, settings));
+	std::vector<cx::ProcessedUSInputDataPtr> inputs;
+	inputs.push_back(input);
+	inputs.push_back(masked);
+	REQUIRE(algorithm.reconstructMultiple(inputs, multiple, settings));
+
+	unsigned char* expected = static_cast<unsigned char*>(single->GetScalarPointer());
+	unsigned char* first = static_cast<unsigned char*>(multiple[0]->GetScalarPointer());
+	unsigned char* second = static_cast<unsigned char*>(multiple[1]->GetScalarPointer());
+	int differences = 0;
+	int maskedVoxels = 0;
+	for (int i=0; i<single->GetNumberOfPoints(); ++i)
+	{
+		if (first[i] != expected[i])
+			++differences;
+		if (second[i] != 0)
+			++maskedVoxels;
+	}
+	CHECK(differences == 0);
+	CHECK(maskedVoxels == 0);
 
+	cx::LogicManager::shutdown();
+}
+
+} // namespace cxtest
@@ -88,6 +88,32 @@ void ReconstructCore::threadedReconstruct()
 	timer.printElapsedSeconds("Reconstruct core time");
 }
 
+void ReconstructCore::threadedReconstructMultiple(std::vector<ReconstructCorePtr> cores)
+{
+	std::vector<ProcessedUSInputDataPtr> inputs;
+	std::vector<vtkImageDataPtr> outputs;
+	for (unsigned i=0; i<cores.size(); ++i)
+	{
+		if (!cores[i]->validInputData())
+			return;
+		CX_ASSERT(cores[i]->mRawOutput);
+		CX_ASSERT(cores[i]->mAlgorithm == cores[0]->mAlgorithm);
+		inputs.push_back(cores[i]->mFileData);
+		outputs.push_back(cores[i]->mRawOutput);
+	}
+	if (cores.empty())
+		return;
+
+	TimeKeeper timer;
+
+	ReconstructCorePtr first = cores[0];
+	bool success = first->mAlgorithm->reconstructMultiple(inputs, outputs, first->mInput.mAlgoSettings);
+	for (unsigned i=0; i<cores.size(); ++i)
+		cores[i]->mSuccess = success;
+
+	timer.printElapsedSeconds(QString("Reconstruct core time, %1 outputs").arg(cores.size()));
+}
+
 /**The reconstruct part that must be done post-rec in the main thread.
  *
  */
@@ -78,8 +78,15 @@ public:
 	void threadedPostReconstruct();
 	ImagePtr getOutput();
 
+	/** Run threadedReconstruct() for all cores in one call to
+	 *  ReconstructionMethodService::reconstructMultiple(), sharing one
+	 *  traversal of the input frames. All cores must use the same algorithm.
+	 */
+	static void threadedReconstructMultiple(std::vector<ReconstructCorePtr> cores);
+
 	// published helper methods, also needed for parameter display outside of reconstruction execution:
 	InputParams getInputParams() { return mInput; }
+	ReconstructionMethodService* getAlgorithm() { return mAlgorithm; }
 
 private:
 	bool validInputData() const;
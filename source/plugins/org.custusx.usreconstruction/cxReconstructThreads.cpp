@@ -100,5 +100,44 @@ void ThreadedTimedReconstructCore::postProcessingSlot()
 	mViewService->autoShowData(mReconstructer->getOutput());
 }
 
+//---------------------------------------------------------
+//---------------------------------------------------------
+//---------------------------------------------------------
+
+
+ThreadedTimedReconstructMultipleCores::ThreadedTimedReconstructMultipleCores(PatientModelServicePtr patientModelService, ViewServicePtr viewService, std::vector<ReconstructCorePtr> cores) :
+	cx::ThreadedTimedAlgorithm<void> ("US Reconstruction", 30),
+	mCores(cores),
+	mPatientModelService(patientModelService),
+	mViewService(viewService)
+{
+	mUseDefaultMessages = false;
+}
+
+ThreadedTimedReconstructMultipleCores::~ThreadedTimedReconstructMultipleCores()
+{
+}
+
+void ThreadedTimedReconstructMultipleCores::preProcessingSlot()
+{
+	for (unsigned i=0; i<mCores.size(); ++i)
+		mCores[i]->threadedPreReconstruct();
+}
+
+void ThreadedTimedReconstructMultipleCores::calculate()
+{
+	ReconstructCore::threadedReconstructMultiple(mCores);
+}
+
+void ThreadedTimedReconstructMultipleCores::postProcessingSlot()
+{
+	for (unsigned i=0; i<mCores.size(); ++i)
+		mCores[i]->threadedPostReconstruct();
+
+	mPatientModelService->autoSave();
+	for (unsigned i=0; i<mCores.size(); ++i)
+		mViewService->autoShowData(mCores[i]->getOutput());
+}
+
 }
 
@@ -34,6 +34,7 @@ typedef boost::shared_ptr<class ReconstructCore> ReconstructCorePtr;
 typedef boost::shared_ptr<class ThreadedTimedReconstructer> ThreadedTimedReconstructerPtr;
 typedef boost::shared_ptr<class ThreadedTimedReconstructPreprocessor> ThreadedTimedReconstructPreprocessorPtr;
 typedef boost::shared_ptr<class ThreadedTimedReconstructCore> ThreadedTimedReconstructCorePtr;
+typedef boost::shared_ptr<class ThreadedTimedReconstructMultipleCores> ThreadedTimedReconstructMultipleCoresPtr;
 
 /**
  * \brief Threading adapter for the reconstruction algorithm.
@@ -105,6 +106,34 @@ private:
 	ViewServicePtr mViewService;
 };
 
+/**
+ * \brief Threading adapter for reconstructing several cores in one pass.
+ *
+ * As ThreadedTimedReconstructCore, but all cores are reconstructed by
+ * ReconstructCore::threadedReconstructMultiple(), sharing one traversal
+ * of the input frames.
+ */
+class org_custusx_usreconstruction_EXPORT ThreadedTimedReconstructMultipleCores: public cx::ThreadedTimedAlgorithm<void>
+{
+Q_OBJECT
+public:
+	static ThreadedTimedReconstructMultipleCoresPtr create(PatientModelServicePtr patientModelService, ViewServicePtr viewService, std::vector<ReconstructCorePtr> cores)
+	{
+		return ThreadedTimedReconstructMultipleCoresPtr(new ThreadedTimedReconstructMultipleCores(patientModelService, viewService, cores));
+	}
+	ThreadedTimedReconstructMultipleCores(PatientModelServicePtr patientModelService, ViewServicePtr viewService, std::vector<ReconstructCorePtr> cores);
+	virtual ~ThreadedTimedReconstructMultipleCores();
+
+private slots:
+	virtual void preProcessingSlot();
+	virtual void postProcessingSlot();
+
+private:
+	virtual void calculate();
+	std::vector<ReconstructCorePtr> mCores;
+	PatientModelServicePtr mPatientModelService;
+	ViewServicePtr mViewService;
+};
 
 /**
  * @}
@@ -43,6 +43,16 @@ bool ReconstructionExecuter::startNonThreadedReconstruction(ReconstructionMethod
 	{
 		mCores[i]->initialize(processedInput[i], preprocessor->getOutputVolumeParams());
 	}
+	if (this->canCoresShareTraversal(mCores))
+	{
+		for (unsigned i=0; i<mCores.size(); ++i)
+			mCores[i]->threadedPreReconstruct();
+		ReconstructCore::threadedReconstructMultiple(mCores);
+		for (unsigned i=0; i<mCores.size(); ++i)
+			mCores[i]->threadedPostReconstruct();
+		return true;
+	}
+
 	for (unsigned i=0; i<mCores.size(); ++i)
 	{
 		mCores[i]->reconstruct();
@@ -105,6 +115,13 @@ cx::CompositeTimedAlgorithmPtr ReconstructionExecuter::assembleReconstructionPip
 	ReconstructPreprocessorPtr preprocessor = this->createPreprocessor(par, fileData);
 	pipeline->append(ThreadedTimedReconstructPreprocessor::create(mPatientModelService, preprocessor, cores));
 
+	if (this->canCoresShareTraversal(cores))
+	{
+		pipeline->append(ThreadedTimedReconstructMultipleCores::create(mPatientModelService, mViewService, cores));
+		reportDebug("Running reconstruction cores in one pass.");
+		return pipeline;
+	}
+
 	cx::CompositeTimedAlgorithmPtr temp = pipeline;
 	if(this->canCoresRunInParallel(cores) && cores.size()>1)
 	{
@@ -131,6 +148,22 @@ bool ReconstructionExecuter::canCoresRunInParallel(std::vector<ReconstructCorePt
 	return parallelizable;
 }
 
+bool ReconstructionExecuter::canCoresShareTraversal(std::vector<ReconstructCorePtr> cores)
+{
+	if (cores.size() < 2)
+		return false;
+
+	ReconstructionMethodService* algorithm = cores.front()->getAlgorithm();
+	if (!algorithm || !algorithm->canReconstructMultiple())
+		return false;
+
+	for (unsigned i=0; i<cores.size(); ++i)
+		if (cores[i]->getAlgorithm() != algorithm)
+			return false;
+
+	return true;
+}
+
 ReconstructPreprocessorPtr ReconstructionExecuter::createPreprocessor(ReconstructCore::InputParams par, USReconstructInputData fileData)
 {
 	ReconstructPreprocessorPtr retval(new ReconstructPreprocessor(mPatientModelService));
@@ -73,6 +73,7 @@ private:
 	ReconstructCorePtr createBModeCore(ReconstructCore::InputParams par, ReconstructionMethodService* algo); ///< core version for B-mode in case of angio recording.
 	cx::CompositeTimedAlgorithmPtr assembleReconstructionPipeline(std::vector<ReconstructCorePtr> cores, ReconstructCore::InputParams par, USReconstructInputData fileData); ///< assembles the different steps that is needed to reconstruct
 	bool canCoresRunInParallel(std::vector<ReconstructCorePtr> cores);
+	bool canCoresShareTraversal(std::vector<ReconstructCorePtr> cores); ///< true if all cores can be reconstructed in one pass over the input
 
 	std::vector<ReconstructCorePtr> mCores;
 	cx::TimedAlgorithmPtr mPipeline;
@@ -17,13 +17,12 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include <vector>
 #include <QObject>
+#include <QDomElement>
 #include <vtkSmartPointer.h>
 #include "cxProperty.h"
 #include  "boost/shared_ptr.hpp"
 
 
-class QDomElement;
-
 #define ReconstructionMethodService_iid "cx::ReconstructionMethodService"
 
 typedef vtkSmartPointer<class vtkImageData> vtkImageDataPtr;
@@ -69,6 +68,31 @@ public:
 	 * \param settings Reference to settings file containing algorithm-specific settings
 	 */
 	virtual bool reconstruct(ProcessedUSInputDataPtr input, vtkImageDataPtr outputData, QDomElement settings) = 0;
+	/**
+	 * Reconstruct several inputs sharing frame positions, such as
+	 * the B-mode and angio parts of one recording, into one output each.
+	 *
+	 * Algorithms returning true from canReconstructMultiple() traverse the
+	 * frames once, computing the output voxel of each input pixel only once
+	 * for all outputs. The default implementation reconstructs each input separately.
+	 *
+	 * \param inputs data to process, all with the same dimensions and frame positions
+	 * \param outputData [Out] One reconstructed volume per input. Memory must be allocated in advance.
+	 * \param settings Reference to settings file containing algorithm-specific settings
+	 */
+	virtual bool reconstructMultiple(std::vector<ProcessedUSInputDataPtr> inputs, std::vector<vtkImageDataPtr> outputData, QDomElement settings)
+	{
+		if (inputs.size() != outputData.size())
+			return false;
+		bool success = true;
+		for (unsigned i=0; i<inputs.size(); ++i)
+			success = this->reconstruct(inputs[i], outputData[i], settings) && success;
+		return success;
+	}
+	/**
+	 * Return true if reconstructMultiple() shares one traversal between the inputs.
+	 */
+	virtual bool canReconstructMultiple() const { return false; }
 };
 
 /**
@@ -64,6 +64,21 @@ Transform3D IGTLinkConversion::decode(igtl::TransformMessage::Pointer msg)
     return retval;
 }
 
+igtl::TransformMessage::Pointer IGTLinkConversion::encode(QString deviceName, Transform3D transform, QDateTime timestamp)
+{
+	igtl::TransformMessage::Pointer retval = igtl::TransformMessage::New();
+	retval->SetDeviceName(cstring_cast(deviceName));
+
+	igtl::Matrix4x4 matrix;
+	for (int r = 0; r < 4; ++r)
+		for (int c = 0; c < 4; ++c)
+			matrix[r][c] = transform(r,c);
+	retval->SetMatrix(matrix);
+
+	IGTLinkConversionBase().encode_timestamp(timestamp, retval);
+	return retval;
+}
+
 //--------------------------------CustusX messages---------------------------------------
 
 IGTLinkUSStatusMessage::Pointer IGTLinkConversion::encode(ProbeDefinitionPtr input)
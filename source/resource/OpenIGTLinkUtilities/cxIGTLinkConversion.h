@@ -24,6 +24,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 //TODO remove
 #include "cxIGTLinkImageMessage.h"
 
+#include <QDateTime>
 #include "cxImage.h"
 #include "cxTransform3D.h"
 #include "cxTool.h"
@@ -48,6 +49,9 @@ public:
     QString decode(igtl::StatusMessage::Pointer msg);
     ImagePtr decode(igtl::ImageMessage::Pointer msg);
 	Transform3D decode(igtl::TransformMessage::Pointer msg);
+	/**
+	  * Encode a tool pose as a TRANSFORM message named after the tool. */
+	igtl::TransformMessage::Pointer encode(QString deviceName, Transform3D transform, QDateTime timestamp);
 
 	/**
       * Encode the input ProbeDefinition into an IGTLink message. */
@@ -22,22 +22,15 @@ namespace cx
  */
 FrameForest::FrameForest(const std::map<QString, DataPtr> &source) : mSource(source)
 {
-//  std::cout << "Forrest doc2:" << std::endl;
-//	DataManager::DataMap allData = mDataManager->getData();
-	mDocument.appendChild(mDocument.createElement("root"));
+	mNodes.reserve(2*source.size());
+	mIndices.reserve(2*source.size());
 
 	for (std::map<QString, DataPtr>::const_iterator iter = source.begin(); iter != source.end(); ++iter)
 	{
 		this->insertFrame(iter->second);
 	}
 
-//  std::cout << "Forrest doc:" << std::endl;
-//  std::cout << mDocument.toString(4) << std::endl;
-}
-
-QDomDocument FrameForest::getDocument()
-{
-	return mDocument;
+	this->buildPreorder();
 }
 
 /** Insert one data in the correct position in the tree
@@ -49,152 +42,207 @@ void FrameForest::insertFrame(DataPtr data)
 	QString parentFrame = data->getParentSpace();
 	QString currentFrame = data->getSpace();
 
-//    if (parentFrame.isEmpty() || currentFrame.isEmpty())
-//    	return;
-
-	QDomNode parentNode = this->getNodeAnyway(parentFrame);
-	QDomNode currentNode = this->getNodeAnyway(currentFrame);
+	int current = this->getIndexAnyway(currentFrame);
 
-	if (parentNode.isNull())
+	if (parentFrame.isEmpty())
 		return;
+	int parent = this->getIndexAnyway(parentFrame);
 
-	// move currentNode to child of parentNode
-	currentNode = currentNode.parentNode().removeChild(currentNode);
-	parentNode.appendChild(currentNode);
-}
-
-/** Given a frame uid, return the QDomNode representing that frame.
- *  Note: Lifetime of retval is controlled by the FrameForest object!
- */
-QDomNode FrameForest::getNode(QString frame)
-{
-	QDomNodeList list = mDocument.elementsByTagName(frame);
-	if (list.isEmpty())
-		return QDomNode();
-	return list.item(0);
-}
-
-/** As getNode(), but create the node if if doesn't exist.
- */
-QDomNode FrameForest::getNodeAnyway(QString frame)
-{
-	QDomNode retval = this->getNode(frame);
-	if (retval.isNull())
+	// refuse to move current below itself
+	for (int node = parent; node >= 0; node = mNodes[node].parent)
 	{
-		retval = mDocument.createElement(frame);
-		mDocument.documentElement().appendChild(retval);
+		if (node == current)
+		{
+			CX_LOG_WARNING() << "FrameForest: Had to break cyclic parent graph at " << currentFrame;
+			return;
+		}
 	}
-	return retval;
+
+	mNodes[current].parent = parent;
 }
 
-/** Return true if ancestor is an ancestor of node
+/** Order all nodes depth first, so that the descendants of each node
+ *  form a contiguous range following it.
  */
-bool FrameForest::isAncestorOf(QDomNode node, QDomNode ancestor)
+void FrameForest::buildPreorder()
 {
-	//std::cout << "isAncestorOf : " << node.toElement().tagName() << "---"  << ancestor.toElement().tagName() << std::endl;
-
-	std::vector<QDomNode> parents;
-
-	while (!this->isRootNode(node))
+	int count = mNodes.size();
+
+	// children as ranges into one array, in insertion order
+	std::vector<int> childBegin(count+1, 0);
+	for (int i=0; i<count; ++i)
+		if (mNodes[i].parent >= 0)
+			++childBegin[mNodes[i].parent+1];
+	for (int i=0; i<count; ++i)
+		childBegin[i+1] += childBegin[i];
+	std::vector<int> children(childBegin[count]);
+	std::vector<int> fill(childBegin.begin(), childBegin.end()-1);
+	for (int i=0; i<count; ++i)
+		if (mNodes[i].parent >= 0)
+			children[fill[mNodes[i].parent]++] = i;
+
+	mPreorder.clear();
+	mPreorder.reserve(count);
+	std::vector<std::pair<int, int> > stack; // node, next child
+	for (int root=0; root<count; ++root)
 	{
-		if (node == ancestor)
-		{
-			//std::cout << "return true" << std::endl;;
-			return true;
-		}
+		if (mNodes[root].parent >= 0)
+			continue;
 
-		if(std::find(parents.begin(), parents.end(), node) != parents.end())
+		mNodes[root].preorderBegin = mPreorder.size();
+		mPreorder.push_back(root);
+		stack.push_back(std::make_pair(root, childBegin[root]));
+		while (!stack.empty())
 		{
-			CX_LOG_WARNING() << "FrameForest::isAncestorOf: Had to break cyclic parent graph";
-			break;
+			int node = stack.back().first;
+			int& next = stack.back().second;
+			if (next == childBegin[node+1])
+			{
+				mNodes[node].preorderEnd = mPreorder.size();
+				stack.pop_back();
+				continue;
+			}
+			int child = children[next++];
+			mNodes[child].preorderBegin = mPreorder.size();
+			mPreorder.push_back(child);
+			stack.push_back(std::make_pair(child, childBegin[child]));
 		}
-		parents.push_back(node);
-
-		node = node.parentNode();
 	}
-	//std::cout << "return false" << std::endl;;
-	return false;
 }
 
-bool FrameForest::isRootNode(QDomNode node)
+int FrameForest::getIndex(QString frame) const
 {
-	return node == mDocument.documentElement();
+	return mIndices.value(frame, -1);
 }
 
-/** Find the oldest ancestor of node.
+/** As getIndex(), but create a root node if it doesn't exist.
  */
-QDomNode FrameForest::getOldestAncestor(QDomNode node)
+int FrameForest::getIndexAnyway(QString frame)
 {
-	if (this->isRootNode(node))
-		return node;
+	int retval = this->getIndex(frame);
+	if (retval < 0)
+	{
+		Node node;
+		node.uid = frame;
+		node.parent = -1;
+		node.preorderBegin = 0;
+		node.preorderEnd = 0;
+		retval = mNodes.size();
+		mNodes.push_back(node);
+		mIndices.insert(frame, retval);
+	}
+	return retval;
+}
 
-	std::vector<QDomNode> parents;
+QString FrameForest::getNode(QString frame) const
+{
+	int index = this->getIndex(frame);
+	if (index < 0)
+		return QString();
+	return mNodes[index].uid;
+}
 
-	while (!this->isRootNode(node.parentNode()))
-	{
-		if(std::find(parents.begin(), parents.end(), node) != parents.end())
-		{
-			CX_LOG_WARNING() << "FrameForest::getOldestAncestor: Had to break cyclic parent graph";
-			break;
-		}
-		parents.push_back(node);
+/** Return true if ancestor is an ancestor of index, or the same node.
+ */
+bool FrameForest::isAncestorOf(int index, int ancestor) const
+{
+	if ((index < 0) || (ancestor < 0))
+		return false;
+	int position = mNodes[index].preorderBegin;
+	return (mNodes[ancestor].preorderBegin <= position) && (position < mNodes[ancestor].preorderEnd);
+}
 
-		node = node.parentNode();
-	}
-	return node;
+int FrameForest::getOldestAncestor(int index) const
+{
+	if (index < 0)
+		return index;
+	while (mNodes[index].parent >= 0)
+		index = mNodes[index].parent;
+	return index;
 }
 
-/** Find the oldest ancestor of child, that is not also an ancestor of ref.
+/** Find the oldest ancestor of frame.
  */
-QDomNode FrameForest::getOldestAncestorNotCommonToRef(QDomNode node, QDomNode ref)
+QString FrameForest::getOldestAncestor(QString frame) const
 {
-	//std::cout << "getOldestAncestorNotCommonToRef " << node.toElement().tagName() << " - " << ref.toElement().tagName() << std::endl;
-	if (this->isAncestorOf(ref, node))
-		return QDomNode();
+	int index = this->getOldestAncestor(this->getIndex(frame));
+	if (index < 0)
+		return QString();
+	return mNodes[index].uid;
+}
 
-	while (!this->isRootNode(node.parentNode()))
+/** Find the oldest ancestor of frame, that is not also an ancestor of ref.
+ */
+QString FrameForest::getOldestAncestorNotCommonToRef(QString frame, QString ref) const
+{
+	int node = this->getIndex(frame);
+	int refNode = this->getIndex(ref);
+	if (node < 0)
+		return QString();
+	if (this->isAncestorOf(refNode, node))
+		return QString();
+
+	while (mNodes[node].parent >= 0)
 	{
-		//std::cout << "getOldestAncestorNotCommonToRef iterate start: " << node.toElement().tagName()  << std::endl;
-		if (this->isAncestorOf(ref, node.parentNode()))
+		if (this->isAncestorOf(refNode, mNodes[node].parent))
 			break;
-		node = node.parentNode();
-		//std::cout << "getOldestAncestorNotCommonToRef iterate stop: " << node.toElement().tagName()  << std::endl;
+		node = mNodes[node].parent;
 	}
-	//std::cout << std::endl;
-	return node;
+	return mNodes[node].uid;
 }
 
-/** Return the node and all its children recursively in one flat vector.
+/** Return the frame and all its children recursively in one flat vector.
  */
-std::vector<QDomNode> FrameForest::getDescendantsAndSelf(QDomNode node)
+std::vector<QString> FrameForest::getDescendantsAndSelf(QString frame) const
 {
-	std::vector<QDomNode> retval;
-	retval.push_back(node);
-
-	for (QDomNode child = node.firstChild(); !child.isNull(); child = child.nextSibling())
-	{
-		std::vector<QDomNode> subnodes = this->getDescendantsAndSelf(child);
-		std::copy(subnodes.begin(), subnodes.end(), back_inserter(retval));
-	}
+	std::vector<QString> retval;
+	int index = this->getIndex(frame);
+	if (index < 0)
+		return retval;
+
+	retval.reserve(mNodes[index].preorderEnd - mNodes[index].preorderBegin);
+	for (int i = mNodes[index].preorderBegin; i < mNodes[index].preorderEnd; ++i)
+		retval.push_back(mNodes[mPreorder[i]].uid);
 	return retval;
 }
 
-/** As getAllNodesFor(QDomNode), but return the nodes as data objects.
+/** As getDescendantsAndSelf(), but return the frames as data objects.
  *  Those frames not representing data are discarded.
  */
-std::vector<DataPtr> FrameForest::getDataFromDescendantsAndSelf(QDomNode node)
+std::vector<DataPtr> FrameForest::getDataFromDescendantsAndSelf(QString frame) const
 {
-	std::vector<QDomNode> nodes = this->getDescendantsAndSelf(node);
 	std::vector<DataPtr> retval;
+	int index = this->getIndex(frame);
+	if (index < 0)
+		return retval;
 
-	for (unsigned i = 0; i < nodes.size(); ++i)
+	for (int i = mNodes[index].preorderBegin; i < mNodes[index].preorderEnd; ++i)
 	{
-		DataPtr data = mSource[nodes[i].toElement().tagName()];
-//		DataPtr data = mDataManager->getData(nodes[i].toElement().tagName());
-		if (data)
-			retval.push_back(data);
+		std::map<QString, DataPtr>::const_iterator data = mSource.find(mNodes[mPreorder[i]].uid);
+		if ((data != mSource.end()) && data->second)
+			retval.push_back(data->second);
 	}
 	return retval;
 }
 
+QDomDocument FrameForest::getDocument() const
+{
+	QDomDocument document;
+	QDomElement root = document.createElement("root");
+	document.appendChild(root);
+
+	for (unsigned i = 0; i < mPreorder.size(); i = mNodes[mPreorder[i]].preorderEnd)
+		this->appendToDocument(document, root, mPreorder[i]);
+	return document;
+}
+
+void FrameForest::appendToDocument(QDomDocument& document, QDomNode parent, int index) const
+{
+	QDomNode node = parent.appendChild(document.createElement(mNodes[index].uid));
+
+	// the children follow index in preorder, each followed by its own descendants
+	for (int i = mNodes[index].preorderBegin+1; i < mNodes[index].preorderEnd; i = mNodes[mPreorder[i]].preorderEnd)
+		this->appendToDocument(document, node, mPreorder[i]);
+}
+
 }
@@ -16,6 +16,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxForwardDeclarations.h"
 
+#include <vector>
+#include <QHash>
 #include <QDomDocument>
 #include "cxTypeConversions.h"
 
@@ -56,7 +58,13 @@ namespace cx
  * Relations between coordinate spaces among Data are created by
  * this class.
  *
- * The graph consists of several directed acyclic graphs.
+ * The graph consists of several directed acyclic graphs. Frames are
+ * identified by their uid. They are stored in a flat array indexed by
+ * a hash from uid, with parent indices and the descendants of each
+ * frame as a contiguous range of a preorder traversal, thus lookups
+ * and ancestor tests are constant time.
+ *
+ * Parent spaces forming a cycle are ignored with a warning.
  *
  *  \date   Sep 23, 2010
  *  \author christiana
@@ -65,20 +73,32 @@ class cxResource_EXPORT FrameForest
 {
 public:
 	explicit FrameForest(const std::map<QString, DataPtr>& source);
-	QDomNode getNode(QString frame);
-	QDomNode getOldestAncestor(QDomNode node);
+	QString getNode(QString frame) const; ///< frame if present in the forest, otherwise a null string
+	QString getOldestAncestor(QString frame) const;
 
-	QDomNode getOldestAncestorNotCommonToRef(QDomNode child, QDomNode ref);
-	std::vector<QDomNode> getDescendantsAndSelf(QDomNode node);
-	std::vector<DataPtr> getDataFromDescendantsAndSelf(QDomNode node);
-	QDomDocument getDocument();
+	QString getOldestAncestorNotCommonToRef(QString frame, QString ref) const;
+	std::vector<QString> getDescendantsAndSelf(QString frame) const;
+	std::vector<DataPtr> getDataFromDescendantsAndSelf(QString frame) const;
+	QDomDocument getDocument() const; ///< the forest as xml, for export and display only
 private:
-	bool isRootNode(QDomNode node);
-	QDomNode getNodeAnyway(QString frame);
-	bool isAncestorOf(QDomNode node, QDomNode ancestor);
+	struct Node
+	{
+		QString uid;
+		int parent; ///< -1 for the root frames
+		int preorderBegin; ///< position of node in mPreorder
+		int preorderEnd; ///< one past the position of the last descendant in mPreorder
+	};
+	int getIndex(QString frame) const;
+	int getIndexAnyway(QString frame);
+	int getOldestAncestor(int index) const;
+	bool isAncestorOf(int index, int ancestor) const;
 	void insertFrame(DataPtr data);
-	QDomDocument mDocument;
+	void buildPreorder();
+	void appendToDocument(QDomDocument& document, QDomNode parent, int index) const;
 
+	std::vector<Node> mNodes;
+	QHash<QString, int> mIndices; ///< frame uid -> index into mNodes
+	std::vector<int> mPreorder; ///< node indices in depth first order, all descendants of a node following it
 	std::map<QString, DataPtr> mSource;
 };
 
@@ -23,6 +23,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "vtkForwardDeclarations.h"
 #include "cxForwardDeclarations.h"
 #include "cxData.h"
+#include "cxImageStatistics.h"
+#include "cxImagePyramid.h"
 
 typedef boost::shared_ptr<std::map<int, int> > HistogramMapPtr;
 
@@ -98,7 +100,7 @@ public:
 
 	virtual DoubleBoundingBox3D boundingBox() const; ///< bounding box in image space
 	virtual Eigen::Array3d getSpacing() const;
-	virtual vtkImageAccumulatePtr getHistogram();///< \return The histogram for the image
+	virtual ImageStatisticsPtr getStatistics(); ///< \return Range and histogram of the image, cached until the image data are modified
 	virtual int getMax();	///< \return Return highest used value in the image
 	virtual int getMin();	///< \return Return lowest used value in the image
 	virtual int getRange();///< For convenience: getMax() - getMin()
@@ -148,7 +150,7 @@ public:
 	void setInterpolationType(int val);
 	int getInterpolationType() const;
 
-	vtkImageDataPtr resample(long maxVoxels);
+	vtkImageDataPtr resample(long maxVoxels); ///< Return a grayscale version with at most maxVoxels voxels, served from a cached pyramid.
 
 	virtual void save(const QString &basePath, FileManagerServicePtr filemanager);
 
@@ -174,7 +176,8 @@ protected:
 //	vtkImageReslicePtr mOrientator; ///< converts imagedata to outputimagedata
 //	vtkMatrix4x4Ptr mOrientatorMatrix;
 //	vtkImageDataPtr mReferenceImageData; ///< imagedata after filtering through the orientatior, given in reference space
-	vtkImageAccumulatePtr mHistogramPtr;///< Histogram
+	ImageStatisticsPtr mStatistics; ///< cached statistics, recomputed when mBaseImageData is modified
+	ImagePyramidPtr mPyramid; ///< cached downsampled versions of the grayscale data, used by resample()
 	ImagePtr mUnsigned; ///< version of this containing unsigned data.
 
 //	LandmarksPtr mLandmarks;
@@ -186,7 +189,6 @@ protected:
 
 	IMAGE_MODALITY mModality; ///< modality of the image, defined as DICOM tag (0008,0060), Section 3, C.7.3.1.1.1
 	IMAGE_SUBTYPE mImageType; ///< type of the image, defined as DICOM tag (0008,0008) (mainly value 3, but might be a merge of value 4), Section 3, C.7.6.1.1.2
-	double mMaxRGBIntensity;
 	int mInterpolationType; ///< mirror the interpolationType in vtkVolumeProperty
 
 
@@ -199,8 +201,6 @@ private:
 	DoubleBoundingBox3D getInitialBoundingBox() const;
 	double loadAttribute(QDomNode dataNode, QString name, double defVal);
 
-	double computeResampleFactor(long maxVoxels);
-
 	ColorMap createPreviewColorMap(const Eigen::Vector2d &threshold);
 	IntIntMap createPreviewOpacityMap(const Eigen::Vector2d &threshold);
 	void createThresholdPreviewTransferFunctions3D(const Eigen::Vector2d &threshold);
@@ -148,9 +148,8 @@ double_pair ImageDefaultTFGenerator::ensureNonZeroRoundedRange(double_pair range
 
 double_pair ImageDefaultTFGenerator::getFullScalarRange() const
 {
-	double smin = mImage->getBaseVtkImageData()->GetScalarRange()[0];
-	double smax = mImage->getBaseVtkImageData()->GetScalarRange()[1];
-	return std::make_pair(smin, smax);
+	ImageStatisticsPtr statistics = mImage->getStatistics();
+	return std::make_pair(statistics->getMin(), statistics->getMax());
 }
 
 double_pair ImageDefaultTFGenerator::getInitialWindowRange() const
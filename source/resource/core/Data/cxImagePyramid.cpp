@@ -0,0 +1,225 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxImagePyramid.h"
+
+#include <cmath>
+#include <limits>
+#include <vtkImageData.h>
+#include <vtkImageResample.h>
+#include "cxParallelFor.h"
+#include "cxLogger.h"
+#include "cxVector3D.h"
+
+namespace cx
+{
+
+namespace
+{
+
+Eigen::Array3i getDownsampleStep(vtkImageDataPtr image)
+{
+	Eigen::Array3i dim(image->GetDimensions());
+	return (dim > 1).select(Eigen::Array3i::Constant(2), Eigen::Array3i::Constant(1));
+}
+
+Eigen::Array3i getDownsampledDimensions(vtkImageDataPtr image)
+{
+	Eigen::Array3i dim(image->GetDimensions());
+	Eigen::Array3i step = getDownsampleStep(image);
+	return (dim + step - 1) / step;
+}
+
+template<class TYPE>
+TYPE roundToType(double value)
+{
+	if (std::numeric_limits<TYPE>::is_integer)
+		return static_cast<TYPE>(std::floor(value + 0.5));
+	return static_cast<TYPE>(value);
+}
+
+template<class TYPE>
+void boxFilter(vtkImageDataPtr input, vtkImageDataPtr output)
+{
+	const TYPE* in = static_cast<const TYPE*>(input->GetScalarPointer());
+	TYPE* out = static_cast<TYPE*>(output->GetScalarPointer());
+	int components = input->GetNumberOfScalarComponents();
+	Eigen::Array3i inDim(input->GetDimensions());
+	Eigen::Array3i outDim(output->GetDimensions());
+	Eigen::Array3i step = getDownsampleStep(input);
+
+	parallelFor(0, outDim[2], [=](int z)
+	{
+		for (int y = 0; y < outDim[1]; ++y)
+		{
+			for (int x = 0; x < outDim[0]; ++x)
+			{
+				for (int c = 0; c < components; ++c)
+				{
+					double sum = 0;
+					int count = 0;
+					for (int iz = z*step[2]; iz < std::min(inDim[2], (z+1)*step[2]); ++iz)
+						for (int iy = y*step[1]; iy < std::min(inDim[1], (y+1)*step[1]); ++iy)
+							for (int ix = x*step[0]; ix < std::min(inDim[0], (x+1)*step[0]); ++ix)
+							{
+								sum += in[((vtkIdType(iz)*inDim[1] + iy)*inDim[0] + ix)*components + c];
+								++count;
+							}
+					out[((vtkIdType(z)*outDim[1] + y)*outDim[0] + x)*components + c] = roundToType<TYPE>(sum/count);
+				}
+			}
+		}
+	}, 1);
+}
+
+/** Return the factor to apply along each axis to get below maxVoxels,
+ *  or 1 if no resampling is needed.
+ */
+double computeResampleFactor(vtkImageDataPtr image, long maxVoxels)
+{
+	if (maxVoxels==0)
+		return 1.0;
+
+	long voxels = image->GetNumberOfPoints();
+	double factor = (double)maxVoxels/(double)voxels;
+	factor = pow(factor, 1.0/3.0);
+	// cubic function leads to trouble for 138M-volume - must downsample to as low as 5-10 Mv in order to succeed on Mac.
+
+	if (factor<0.99)
+	{
+		return factor;
+	}
+	return 1.0;
+}
+
+} // namespace
+
+ImagePyramidPtr ImagePyramid::create(vtkImageDataPtr base)
+{
+	return ImagePyramidPtr(new ImagePyramid(base));
+}
+
+ImagePyramid::ImagePyramid(vtkImageDataPtr base) :
+	mBase(base.GetPointer()),
+	mModifiedTime(base ? base->GetMTime() : 0)
+{
+	mLevels.push_back(base);
+}
+
+bool ImagePyramid::isValidFor(vtkImageDataPtr base) const
+{
+	return base && (base.GetPointer() == mBase) && (base->GetMTime() == mModifiedTime);
+}
+
+bool ImagePyramid::canDownsample(vtkImageDataPtr image) const
+{
+	return (Eigen::Array3i(image->GetDimensions()) > 1).any();
+}
+
+vtkImageDataPtr ImagePyramid::getLevel(int level)
+{
+	while (int(mLevels.size()) <= level)
+		mLevels.push_back(downsample(mLevels.back()));
+	return mLevels[level];
+}
+
+vtkImageDataPtr ImagePyramid::resample(long maxVoxels)
+{
+	vtkImageDataPtr base = this->getLevel(0);
+	if (!base || computeResampleFactor(base, maxVoxels) == 1.0)
+		return base;
+
+	std::map<long, vtkImageDataPtr>::iterator cached = mResampled.find(maxVoxels);
+	if (cached != mResampled.end())
+		return cached->second;
+
+	// find the coarsest level that still has at least maxVoxels
+	int level = 0;
+	while (this->canDownsample(this->getLevel(level)) && (getDownsampledDimensions(this->getLevel(level)).cast<long>().prod() >= maxVoxels))
+		++level;
+
+	vtkImageDataPtr retval = this->getLevel(level);
+
+	double factor = computeResampleFactor(retval, maxVoxels);
+	if (factor != 1.0)
+	{
+		vtkImageResamplePtr resampler = vtkImageResamplePtr::New();
+		resampler->SetInterpolationModeToLinear();
+		resampler->SetAxisMagnificationFactor(0, factor);
+		resampler->SetAxisMagnificationFactor(1, factor);
+		resampler->SetAxisMagnificationFactor(2, factor);
+		resampler->SetInputData(retval);
+		resampler->Update();
+		retval = resampler->GetOutput();
+	}
+	retval->GetScalarRange();
+
+	mResampled[maxVoxels] = retval;
+	return retval;
+}
+
+vtkImageDataPtr ImagePyramid::downsample(vtkImageDataPtr input)
+{
+	Eigen::Array3i step = getDownsampleStep(input);
+	Eigen::Array3i dim = getDownsampledDimensions(input);
+	Vector3D spacing(input->GetSpacing());
+	Vector3D origin(input->GetOrigin());
+	int* extent = input->GetExtent();
+
+	// the new voxel centers are at the center of the merged input voxels
+	for (int i=0; i<3; ++i)
+	{
+		origin[i] += extent[2*i]*spacing[i] + 0.5*(step[i]-1)*spacing[i];
+		spacing[i] *= step[i];
+	}
+
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetSpacing(spacing.data());
+	retval->SetOrigin(origin.data());
+	retval->SetExtent(0, dim[0]-1, 0, dim[1]-1, 0, dim[2]-1);
+	retval->AllocateScalars(input->GetScalarType(), input->GetNumberOfScalarComponents());
+
+	switch (input->GetScalarType())
+	{
+	case VTK_CHAR:
+	case VTK_SIGNED_CHAR:
+		boxFilter<signed char>(input, retval);
+		break;
+	case VTK_UNSIGNED_CHAR:
+		boxFilter<unsigned char>(input, retval);
+		break;
+	case VTK_SHORT:
+		boxFilter<short>(input, retval);
+		break;
+	case VTK_UNSIGNED_SHORT:
+		boxFilter<unsigned short>(input, retval);
+		break;
+	case VTK_INT:
+		boxFilter<int>(input, retval);
+		break;
+	case VTK_UNSIGNED_INT:
+		boxFilter<unsigned int>(input, retval);
+		break;
+	case VTK_FLOAT:
+		boxFilter<float>(input, retval);
+		break;
+	case VTK_DOUBLE:
+		boxFilter<double>(input, retval);
+		break;
+	default:
+		CX_LOG_ERROR() << "ImagePyramid: Unhandled data type " << input->GetScalarTypeAsString();
+		break;
+	}
+
+	return retval;
+}
+
+} // namespace cx
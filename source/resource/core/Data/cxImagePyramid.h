@@ -0,0 +1,70 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXIMAGEPYRAMID_H
+#define CXIMAGEPYRAMID_H
+
+#include "cxResourceExport.h"
+
+#include <map>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <vtkType.h>
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+
+typedef boost::shared_ptr<class ImagePyramid> ImagePyramidPtr;
+
+/** \brief Multi-resolution pyramid of a volume, used for downsampled rendering.
+ *
+ * Level 0 is the input volume, each following level is a 2x box filtered
+ * version of the previous, computed in parallel. Axes with only one voxel
+ * are not downsampled. Levels are built lazily when first needed.
+ *
+ * resample() serves a voxel budget by starting from the coarsest level still
+ * within the budget, refining with linear interpolation from that level only
+ * if needed. Results are cached per budget.
+ *
+ * The pyramid is tied to one vtkImageData at a given MTime, use isValidFor()
+ * to check if it must be recreated.
+ *
+ * \ingroup cx_resource_core_data
+ */
+class cxResource_EXPORT ImagePyramid
+{
+public:
+	static ImagePyramidPtr create(vtkImageDataPtr base);
+	bool isValidFor(vtkImageDataPtr base) const;
+
+	vtkImageDataPtr getLevel(int level); ///< return level, compute if necessary. Level 0 is the input.
+	int getNumberOfComputedLevels() const { return mLevels.size(); }
+	/** Return a volume with approximately maxVoxels voxels or less.
+	 *  maxVoxels==0 means no limit, returning the input.
+	 */
+	vtkImageDataPtr resample(long maxVoxels);
+
+	static vtkImageDataPtr downsample(vtkImageDataPtr input); ///< 2x box filter along all axes with more than one voxel
+
+private:
+	explicit ImagePyramid(vtkImageDataPtr base);
+	bool canDownsample(vtkImageDataPtr image) const;
+
+	std::vector<vtkImageDataPtr> mLevels;
+	std::map<long, vtkImageDataPtr> mResampled;
+	vtkImageData* mBase; ///< identity only
+	vtkMTimeType mModifiedTime;
+};
+
+} // namespace cx
+
+#endif // CXIMAGEPYRAMID_H
@@ -0,0 +1,348 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxImageStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vtkImageData.h>
+#include "cxParallelFor.h"
+#include "cxLogger.h"
+
+namespace cx
+{
+
+namespace
+{
+
+/** Intensity as defined by vtkImageLuminance for color, component 0 otherwise.
+ */
+template<class TYPE>
+inline TYPE getIntensity(const TYPE* voxel, int components)
+{
+	if (components < 3)
+		return voxel[0];
+	double luminance = 0.30*voxel[0];
+	luminance += 0.59*voxel[1];
+	luminance += 0.11*voxel[2];
+	return static_cast<TYPE>(luminance);
+}
+
+/** Range of one block of rows, merged after the parallel pass.
+ */
+struct PartialRange
+{
+	PartialRange() :
+		mMin(std::numeric_limits<double>::max()),
+		mMax(-std::numeric_limits<double>::max()),
+		mRGBSumMax(-std::numeric_limits<double>::max())
+	{}
+	double mMin;
+	double mMax;
+	double mRGBSumMax;
+};
+
+template<class TYPE>
+struct ImageBlocks
+{
+	ImageBlocks(vtkImageDataPtr image)
+	{
+		int* dim = image->GetDimensions();
+		mData = static_cast<const TYPE*>(image->GetScalarPointer());
+		mComponents = image->GetNumberOfScalarComponents();
+		mRowLength = dim[0];
+		mRows = dim[1]*dim[2];
+		mBlocks = parallelForChunkCount(mRows, std::max<long long>(1, 64*1024/mRowLength));
+	}
+
+	const TYPE* mData;
+	int mComponents;
+	long long mRowLength; ///< voxels per row
+	int mRows;
+	int mBlocks;
+
+	int blockBegin(int block) const { return int((long long)mRows*block/mBlocks); }
+	int blockEnd(int block) const { return int((long long)mRows*(block+1)/mBlocks); }
+	const TYPE* voxel(int row, long long x) const { return mData + (row*mRowLength + x)*mComponents; }
+};
+
+template<class TYPE>
+std::vector<PartialRange> computePartialRanges(const ImageBlocks<TYPE>& blocks)
+{
+	std::vector<PartialRange> partials(blocks.mBlocks);
+	PartialRange* output = partials.data();
+	parallelFor(0, blocks.mBlocks, [=](int block)
+	{
+		PartialRange& partial = output[block];
+		for (int row = blocks.blockBegin(block); row < blocks.blockEnd(block); ++row)
+		{
+			for (long long x = 0; x < blocks.mRowLength; ++x)
+			{
+				const TYPE* voxel = blocks.voxel(row, x);
+				double value = voxel[0];
+				partial.mMin = std::min(partial.mMin, value);
+				partial.mMax = std::max(partial.mMax, value);
+				if (blocks.mComponents >= 3)
+					partial.mRGBSumMax = std::max(partial.mRGBSumMax, double(voxel[0])+double(voxel[1])+double(voxel[2]));
+			}
+		}
+	}, 1);
+	return partials;
+}
+
+/** Count the nonzero intensities in [origin, top] into size bins of the given width,
+ *  top falling in the last bin. Each block counts into its part of one buffer,
+ *  which are summed afterwards.
+ */
+template<class TYPE>
+std::vector<long long> computeCounts(const ImageBlocks<TYPE>& blocks, double origin, double width, int size, double top)
+{
+	std::vector<long long> buffer(std::size_t(size)*blocks.mBlocks, 0);
+	long long* output = buffer.data();
+	parallelFor(0, blocks.mBlocks, [=](int block)
+	{
+		long long* counts = output + std::size_t(size)*block;
+		for (int row = blocks.blockBegin(block); row < blocks.blockEnd(block); ++row)
+		{
+			for (long long x = 0; x < blocks.mRowLength; ++x)
+			{
+				double intensity = getIntensity(blocks.voxel(row, x), blocks.mComponents);
+				if (intensity == 0)
+					continue;
+				double bin = std::floor((intensity - origin) / width);
+				if (bin >= 0 && bin < size)
+					++counts[int(bin)];
+				else if (intensity == top)
+					++counts[size-1];
+			}
+		}
+	}, 1);
+
+	for (int block=1; block<blocks.mBlocks; ++block)
+		for (int i=0; i<size; ++i)
+			output[i] += output[std::size_t(size)*block + i];
+	buffer.resize(size);
+	return buffer;
+}
+
+} // namespace
+
+ImageStatistics::ImageStatistics() :
+	mMin(0),
+	mMax(0),
+	mRGBMax(-1),
+	mModifiedTime(0),
+	mHistogramComputed(false),
+	mHistogramOrigin(0),
+	mHistogramBinWidth(1),
+	mHistogramTop(0)
+{
+}
+
+ImageStatisticsPtr ImageStatistics::compute(vtkImageDataPtr image)
+{
+	ImageStatisticsPtr retval(new ImageStatistics());
+	if (!image || !image->GetNumberOfPoints() || !image->GetScalarPointer())
+	{
+		retval->mHistogramComputed = true;
+		return retval;
+	}
+
+	retval->mImage = image;
+	retval->mModifiedTime = image->GetMTime();
+
+	switch (image->GetScalarType())
+	{
+	case VTK_CHAR:
+	case VTK_SIGNED_CHAR:
+		retval->computeRange<signed char>();
+		break;
+	case VTK_UNSIGNED_CHAR:
+		retval->computeRange<unsigned char>();
+		break;
+	case VTK_SHORT:
+		retval->computeRange<short>();
+		break;
+	case VTK_UNSIGNED_SHORT:
+		retval->computeRange<unsigned short>();
+		break;
+	case VTK_INT:
+		retval->computeRange<int>();
+		break;
+	case VTK_UNSIGNED_INT:
+		retval->computeRange<unsigned int>();
+		break;
+	case VTK_FLOAT:
+		retval->computeRange<float>();
+		break;
+	case VTK_DOUBLE:
+		retval->computeRange<double>();
+		break;
+	default:
+		CX_LOG_ERROR() << "ImageStatistics: Unhandled data type " << image->GetScalarTypeAsString();
+		retval->mHistogramComputed = true;
+		break;
+	}
+
+	return retval;
+}
+
+template<class TYPE>
+void ImageStatistics::computeRange()
+{
+	ImageBlocks<TYPE> blocks(mImage);
+	std::vector<PartialRange> partials = computePartialRanges(blocks);
+
+	double rgbSumMax = -std::numeric_limits<double>::max();
+	mMin = std::numeric_limits<double>::max();
+	mMax = -std::numeric_limits<double>::max();
+	for (unsigned i=0; i<partials.size(); ++i)
+	{
+		mMin = std::min(mMin, partials[i].mMin);
+		mMax = std::max(mMax, partials[i].mMax);
+		rgbSumMax = std::max(rgbSumMax, partials[i].mRGBSumMax);
+	}
+	if (blocks.mComponents >= 3)
+		mRGBMax = std::floor(rgbSumMax/3);
+}
+
+/** Use unit bins from floor(min) to ceil(max) if they fit in getMaxHistogramSize(),
+ *  otherwise split [min,max] into getMaxHistogramSize() bins. All arithmetic is
+ *  in double, thus ranges outside int are safe.
+ */
+template<class TYPE>
+void ImageStatistics::computeHistogram() const
+{
+	ImageBlocks<TYPE> blocks(mImage);
+	double top = (blocks.mComponents >= 3) ? mRGBMax : mMax;
+	if (!std::isfinite(mMin) || !std::isfinite(top) || (top < mMin))
+		return;
+
+	double units = std::ceil(top) - std::floor(mMin) + 1;
+	int size = getMaxHistogramSize();
+	mHistogramOrigin = mMin;
+	mHistogramBinWidth = (top - mMin) / size;
+	if (units <= size)
+	{
+		size = int(units);
+		mHistogramOrigin = std::floor(mMin);
+		mHistogramBinWidth = 1;
+	}
+
+	mHistogramTop = top;
+	std::vector<long long> counts = computeCounts(blocks, mHistogramOrigin, mHistogramBinWidth, size, top);
+	mHistogram.resize(size);
+	mCumulative.resize(size);
+	long long total = 0;
+	for (int i=0; i<size; ++i)
+	{
+		mHistogram[i] = int(std::min<long long>(counts[i], std::numeric_limits<int>::max()));
+		total += counts[i];
+		mCumulative[i] = total;
+	}
+}
+
+void ImageStatistics::ensureHistogram() const
+{
+	QMutexLocker locker(&mHistogramMutex);
+	if (mHistogramComputed)
+		return;
+	mHistogramComputed = true;
+
+	switch (mImage->GetScalarType())
+	{
+	case VTK_CHAR:
+	case VTK_SIGNED_CHAR:
+		this->computeHistogram<signed char>();
+		break;
+	case VTK_UNSIGNED_CHAR:
+		this->computeHistogram<unsigned char>();
+		break;
+	case VTK_SHORT:
+		this->computeHistogram<short>();
+		break;
+	case VTK_UNSIGNED_SHORT:
+		this->computeHistogram<unsigned short>();
+		break;
+	case VTK_INT:
+		this->computeHistogram<int>();
+		break;
+	case VTK_UNSIGNED_INT:
+		this->computeHistogram<unsigned int>();
+		break;
+	case VTK_FLOAT:
+		this->computeHistogram<float>();
+		break;
+	case VTK_DOUBLE:
+		this->computeHistogram<double>();
+		break;
+	}
+}
+
+bool ImageStatistics::isValidFor(vtkImageDataPtr image) const
+{
+	return image && (image == mImage) && (image->GetMTime() == mModifiedTime);
+}
+
+double ImageStatistics::getHistogramOrigin() const
+{
+	this->ensureHistogram();
+	return mHistogramOrigin;
+}
+
+double ImageStatistics::getHistogramBinWidth() const
+{
+	this->ensureHistogram();
+	return mHistogramBinWidth;
+}
+
+const std::vector<int>& ImageStatistics::getHistogram() const
+{
+	this->ensureHistogram();
+	return mHistogram;
+}
+
+int ImageStatistics::getHistogramCount(double intensity) const
+{
+	this->ensureHistogram();
+	double bin = std::floor((intensity - mHistogramOrigin) / mHistogramBinWidth);
+	int size = int(mHistogram.size());
+	if (bin >= 0 && bin < size)
+		return mHistogram[int(bin)];
+	if (size && (intensity == mHistogramTop))
+		return mHistogram[size-1];
+	return 0;
+}
+
+int ImageStatistics::getHistogramMaxCount() const
+{
+	this->ensureHistogram();
+	if (mHistogram.empty())
+		return 0;
+	return *std::max_element(mHistogram.begin(), mHistogram.end());
+}
+
+double ImageStatistics::getPercentile(double fraction) const
+{
+	this->ensureHistogram();
+	if (mCumulative.empty() || mCumulative.back() == 0)
+		return mHistogramOrigin;
+
+	fraction = std::max(0.0, std::min(1.0, fraction));
+	double target = fraction * mCumulative.back();
+	std::vector<long long>::const_iterator iter = std::lower_bound(mCumulative.begin(), mCumulative.end(), target);
+	if (iter == mCumulative.end())
+		--iter;
+	return mHistogramOrigin + (iter - mCumulative.begin())*mHistogramBinWidth;
+}
+
+} // namespace cx
@@ -0,0 +1,94 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXIMAGESTATISTICS_H
+#define CXIMAGESTATISTICS_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <vtkType.h>
+#include <QMutex>
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+
+typedef boost::shared_ptr<class ImageStatistics> ImageStatisticsPtr;
+
+/** \brief Scalar range, histogram and percentiles of a vtkImageData.
+ *
+ * compute() finds the range in one multithreaded pass over the voxels.
+ * The histogram is built in a second pass the first time it is queried.
+ *
+ * The intensity used for the histogram is the single component for gray
+ * scale images and the luminance for color images, equal to what
+ * vtkImageLuminance produces. Zero is not counted, as in
+ * vtkImageAccumulate::IgnoreZeroOn(). The bins cover [getMin(), getMax()],
+ * or [getMin(), getRGBMax()] for color images. They have unit width, starting
+ * at the integer below getMin(), unless this would give more than
+ * getMaxHistogramSize() bins, in which case that many bins of equal width
+ * span the range.
+ *
+ * Instances are cached by Image::getStatistics(). The range is fixed, while
+ * the histogram reflects the image data when it is first queried.
+ *
+ * \ingroup cx_resource_core_data
+ */
+class cxResource_EXPORT ImageStatistics
+{
+public:
+	static ImageStatisticsPtr compute(vtkImageDataPtr image);
+	static int getMaxHistogramSize() { return 65536; }
+
+	double getMin() const { return mMin; } ///< min value of component 0, equal to vtkImageData::GetScalarRange()[0]
+	double getMax() const { return mMax; } ///< max value of component 0, equal to vtkImageData::GetScalarRange()[1]
+	double getRGBMax() const { return mRGBMax; } ///< max of the mean of the first three components, -1 if less than three components
+	vtkMTimeType getModifiedTime() const { return mModifiedTime; } ///< MTime of the image when computed
+	bool isValidFor(vtkImageDataPtr image) const; ///< true if computed from image at its current MTime
+
+	double getHistogramOrigin() const; ///< lower intensity of the first bin
+	double getHistogramBinWidth() const;
+	const std::vector<int>& getHistogram() const;
+	int getHistogramCount(double intensity) const; ///< number of voxels in the bin containing intensity, 0 if outside histogram
+	int getHistogramMaxCount() const; ///< number of voxels in the largest bin
+	/** Return the lower intensity of the first bin for which at least the given
+	 *  fraction [0,1] of the nonzero voxels are in that or lower bins.
+	 */
+	double getPercentile(double fraction) const;
+
+private:
+	ImageStatistics();
+	template<class TYPE>
+	void computeRange();
+	template<class TYPE>
+	void computeHistogram() const;
+	void ensureHistogram() const;
+
+	vtkImageDataPtr mImage;
+	double mMin;
+	double mMax;
+	double mRGBMax;
+	vtkMTimeType mModifiedTime;
+
+	mutable QMutex mHistogramMutex;
+	mutable bool mHistogramComputed;
+	mutable double mHistogramOrigin;
+	mutable double mHistogramBinWidth;
+	mutable double mHistogramTop; ///< upper intensity of the last bin
+	mutable std::vector<int> mHistogram;
+	mutable std::vector<long long> mCumulative;
+};
+
+} // namespace cx
+
+#endif // CXIMAGESTATISTICS_H
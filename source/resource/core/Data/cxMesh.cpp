@@ -15,9 +15,15 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkColorSeries.h>
 #include <vtkPolyData.h>
 #include <vtkPointData.h>
+#include <vtkFloatArray.h>
+#include <vtkDoubleArray.h>
 #include <QDomDocument>
 #include <QColor>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <vtkXMLPolyDataReader.h>
 #include <vtkTransformTextureCoords.h>
 #include <vtkTexture.h>
 #include <vtkTextureMapToCylinder.h>
@@ -32,6 +38,9 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxFileManagerService.h"
 #include "cxLogger.h"
 #include "cxNullDeleter.h"
+#include "cxUtilHelpers.h"
+#include "cxParallelFor.h"
+#include "cxMeshPlaneIntersection.h"
 
 namespace cx
 {
@@ -80,8 +89,11 @@ bool Mesh::getIsWireframe() const
 
 bool Mesh::load(QString path, FileManagerServicePtr filemanager)
 {
-	vtkPolyDataPtr raw;
-	raw = filemanager->loadVtkPolyData(path);
+	return this->load(path, filemanager->loadVtkPolyData(path));
+}
+
+bool Mesh::load(QString path, vtkPolyDataPtr raw)
+{
 	if(raw)
 	{
 		this->setVtkPolyData(raw);
@@ -134,6 +146,19 @@ vtkPolyDataPtr Mesh::getVtkPolyData() const
 	return mVtkPolyData;
 }
 
+MeshPlaneIntersectionPtr Mesh::getPlaneIntersection()
+{
+	if (!mVtkPolyData || (!mVtkPolyData->GetNumberOfPolys() && !mVtkPolyData->GetNumberOfStrips()))
+	{
+		mPlaneIntersection.reset();
+		return mPlaneIntersection;
+	}
+	// the intersection rebuilds itself if the polydata is modified
+	if (!mPlaneIntersection || (mPlaneIntersection->getPolyData() != mVtkPolyData))
+		mPlaneIntersection = MeshPlaneIntersection::create(mVtkPolyData);
+	return mPlaneIntersection;
+}
+
 vtkTexturePtr Mesh::getVtkTexture()
 {
 	return mVtkTexture;
@@ -412,32 +437,81 @@ DoubleBoundingBox3D Mesh::boundingBox() const
 	return bounds;
 }
 
+namespace
+{
+/** Write transform*input to output for count points, in parallel batches.
+ */
+template<class T>
+void transformPoints(const T* input, float* output, int count, const Transform3D& transform)
+{
+	double matrix[12];
+	for (int r=0; r<3; ++r)
+		for (int c=0; c<4; ++c)
+			matrix[4*r+c] = transform(r,c);
+	const double* m = matrix;
+
+	parallelForRange(0, count, [=](int begin, int end)
+	{
+		for (int i=begin; i<end; ++i)
+		{
+			const T* p = input + 3*i;
+			float* q = output + 3*i;
+			for (int r=0; r<3; ++r)
+				q[r] = static_cast<float>(m[4*r]*p[0] + m[4*r+1]*p[1] + m[4*r+2]*p[2] + m[4*r+3]);
+		}
+	}, 16384);
+}
+
+/** Return a new float point array with the points transformed.
+ */
+vtkPointsPtr createTransformedPoints(vtkPoints* points, const Transform3D& transform)
+{
+	vtkPointsPtr retval = vtkPointsPtr::New();
+	retval->SetDataTypeToFloat();
+	if (!points)
+		return retval;
+
+	int count = points->GetNumberOfPoints();
+	retval->SetNumberOfPoints(count);
+	float* output = static_cast<float*>(retval->GetVoidPointer(0));
+
+	if (vtkFloatArray* floatData = vtkFloatArray::SafeDownCast(points->GetData()))
+		transformPoints(floatData->GetPointer(0), output, count, transform);
+	else if (vtkDoubleArray* doubleData = vtkDoubleArray::SafeDownCast(points->GetData()))
+		transformPoints(doubleData->GetPointer(0), output, count, transform);
+	else
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			Vector3D p = transform.coord(Vector3D(points->GetPoint(i)));
+			retval->SetPoint(i, p.data());
+		}
+	}
+	return retval;
+}
+}
+
 vtkPolyDataPtr Mesh::getTransformedPolyDataCopy(Transform3D transform)
 {
 	// if transform elements exists, create a copy with entire position inside the polydata:
-    if (similar(transform, Transform3D::Identity()))
-    {
-        vtkPolyDataPtr poly = vtkPolyDataPtr::New();
-        poly->DeepCopy(getVtkPolyData());
-        return poly;
-    }
-
 	vtkPolyDataPtr poly = vtkPolyDataPtr::New();
 	poly->DeepCopy(getVtkPolyData());
-	vtkPointsPtr points = poly->GetPoints();
+	if (similar(transform, Transform3D::Identity()))
+		return poly;
 
-	vtkPointsPtr floatPoints = vtkPointsPtr::New();
-	floatPoints->DeepCopy(points);
-	floatPoints->SetDataTypeToFloat();
-	for (int i = 0; i < poly->GetNumberOfPoints(); ++i)
-	{
-		Vector3D p(points->GetPoint(i));
-		p = transform.coord(p);
-		floatPoints->SetPoint(i, p.begin());
-	}
-	poly->SetPoints(floatPoints.GetPointer());
+	poly->SetPoints(createTransformedPoints(poly->GetPoints(), transform));
 	poly->Modified();
+	return poly;
+}
 
+vtkPolyDataPtr Mesh::getTransformedPolyData(Transform3D transform)
+{
+	vtkPolyDataPtr poly = vtkPolyDataPtr::New();
+	poly->ShallowCopy(getVtkPolyData());
+	if (similar(transform, Transform3D::Identity()))
+		return poly;
+
+	poly->SetPoints(createTransformedPoints(getVtkPolyData()->GetPoints(), transform));
 	return poly;
 }
 
@@ -449,11 +523,23 @@ bool Mesh::isFiberBundle() const
 
 void Mesh::save(const QString& basePath, FileManagerServicePtr fileManager)
 {
-	QString filename = basePath + "/Images/" + this->getUid() + ".vtk";
+	QString filename = basePath + "/Images/" + this->getUid() + ".vtp";
 	this->setFilename(QDir(basePath).relativeFilePath(filename));
 	MeshPtr self = MeshPtr(this, null_deleter());
+	QDateTime saveStart = QDateTime::currentDateTime().addSecs(-2); // allow coarse file time resolution
 	fileManager->save(self, filename);
 
+	// meshes were earlier saved as legacy .vtk, remove it only when replaced by a valid .vtp
+	QString legacyFilename = changeExtension(filename, "vtk");
+	if (!QFile::exists(legacyFilename))
+		return;
+	QFileInfo written(filename);
+	vtkXMLPolyDataReaderPtr reader = vtkXMLPolyDataReaderPtr::New();
+	if (written.exists() && (written.size() > 0) && (written.lastModified() >= saveStart)
+			&& reader->CanReadFile(cstring_cast(filename)))
+		QFile::remove(legacyFilename);
+	else
+		reportWarning(QString("Keeping %1, failed to write %2").arg(legacyFilename).arg(filename));
 }
 
 } // namespace cx
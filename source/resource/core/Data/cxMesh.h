@@ -33,6 +33,7 @@ class QDomDocument;
 
 namespace cx
 {
+typedef boost::shared_ptr<class MeshPlaneIntersection> MeshPlaneIntersectionPtr;
 
 
 /** \brief A mesh data set.
@@ -60,6 +61,7 @@ public:
 	void addXml(QDomNode& dataNode); ///< adds xml information about the image and its variabels
 	virtual void parseXml(QDomNode& dataNode);///< Use a XML node to load data. \param dataNode A XML data representation of this object.
 	virtual bool load(QString path, FileManagerServicePtr filemanager);
+	bool load(QString path, vtkPolyDataPtr polyData); ///< set polyData already read from path, e.g. decoded on a worker thread
 	virtual QString getType() const
 	{
 		return getTypeName();
@@ -80,6 +82,16 @@ public:
 	void setIsWireframe(bool on);///< Set rep to wireframe, false means surface
 	bool getIsWireframe() const;///< true=wireframe, false=surface
 	vtkPolyDataPtr getTransformedPolyDataCopy(Transform3D tranform);///< Create a new transformed polydata
+	/** Create a transformed polydata sharing topology and attribute arrays with
+	  * this mesh, owning only a new transformed point array. Treat the shared
+	  * arrays as read only. The identity transform shares the points as well.
+	  * Use getTransformedPolyDataCopy() when the result is kept as new Data.
+	  */
+	vtkPolyDataPtr getTransformedPolyData(Transform3D transform);
+	/** Plane intersection of the current polydata, shared by all users of this
+	  * mesh, such as the 2D views. Null if the mesh has no polygons or strips.
+	  */
+	MeshPlaneIntersectionPtr getPlaneIntersection();
 	bool isFiberBundle() const;
 	bool showGlyph();
 	bool hasGlyph();
@@ -112,6 +124,7 @@ private:
 	vtkPolyDataPtr mVtkPolyData;
 	vtkPolyDataPtr mVtkPolyDataOriginal;
 	vtkTexturePtr mVtkTexture;
+	MeshPlaneIntersectionPtr mPlaneIntersection;
 	bool createTextureMapper(vtkDataSetAlgorithmPtr &tMapper);
 	bool mHasGlyph;
 	bool mShowGlyph;
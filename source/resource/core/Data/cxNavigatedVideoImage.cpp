@@ -24,6 +24,8 @@ NavigatedVideoImage::NavigatedVideoImage(QString uid, VideoSourcePtr source, Sli
 	mToolPositionX = -1;
 	mToolPositionY = -1;
 	connect(source.get(), &VideoSource::newFrame, this, &NavigatedVideoImage::newFrame);
+	if (mSliceProxy)
+		connect(mSliceProxy.get(), &SliceProxy::transformChanged, this, &Data::transformChanged); // get_rMd() follows the slice
 	getLookupTable2D()->setFullRangeWinLevel(source->getVtkImageData());
 }
 
@@ -55,6 +55,7 @@ void TrackedStream::setProbeTool(const ToolPtr &probeTool)
 		disconnect(mProbeTool.get(), &Tool::toolTransformAndTimestamp, this, &TrackedStream::toolTransformAndTimestamp);
 
 	mProbeTool = probeTool;
+	mProbePoses.clear();
 	emit newTool(mProbeTool);
 
 	if(mProbeTool)
@@ -62,6 +63,14 @@ void TrackedStream::setProbeTool(const ToolPtr &probeTool)
 }
 
 void TrackedStream::toolTransformAndTimestamp(Transform3D prMt, double timestamp)
+{
+	mProbePoses.add(prMt, timestamp);
+	// while streaming, newFrameSlot() sets the pose matching each frame
+	if (!this->isStreaming())
+		this->setProbePose(prMt);
+}
+
+void TrackedStream::setProbePose(Transform3D prMt)
 {
 	//tMu calculation in ProbeSector differ from the one used here
 //	Transform3D tMu = mProbeDefinition.get_tMu();
@@ -121,6 +130,12 @@ void TrackedStream::newFrameSlot()
 	if (mImage && mVideoSource && mVideoSource->isStreaming())
 	{
 		mImage->setVtkImageData(mVideoSource->getVtkImageData(), false);
+
+		// The probe adapter source has the temporal calibration
+		// subtracted from its timestamp, thus it is in the tracking clock.
+		Transform3D prMt;
+		if (mProbeTool && mProbePoses.interpolate(mVideoSource->getTimestamp(), &prMt))
+			this->setProbePose(prMt);
 		emit newFrame();
 	}
 }
@@ -13,6 +13,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #define CXTRACKEDSTREAM_H
 
 #include "cxImage.h"
+#include "cxTimedTransformRing.h"
 
 namespace cx
 {
@@ -21,6 +22,10 @@ namespace cx
  *
  * Allowing video stream as a data type
  *
+ * While streaming, the image pose is updated per frame, interpolated
+ * from the recent probe poses at the frame acquisition time. Otherwise
+ * it follows the latest probe pose.
+ *
  * \ingroup cx_resource_core_data
  *
  * \date jan 28, 2015
@@ -73,7 +78,9 @@ private:
 	ImagePtr mImage;
 
 	SpaceProviderPtr mSpaceProvider;
+	TimedTransformRing mProbePoses; ///< recent prMt
 	Transform3D get_tMu();
+	void setProbePose(Transform3D prMt);
 };
 
 typedef boost::shared_ptr<TrackedStream> TrackedStreamPtr;
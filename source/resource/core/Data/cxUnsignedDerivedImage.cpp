@@ -16,6 +16,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkImageData.h>
 #include <vtkPointData.h>
 #include <vtkDoubleArray.h>
+#include <vtkDataArray.h>
+#include <vtkWeakPointer.h>
+#include <limits>
+#include <QMutex>
 
 #include "cxImage.h"
 
@@ -32,12 +36,129 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxCoordinateSystemHelpers.h"
 #include "cxLogger.h"
+#include "cxParallelFor.h"
 
 typedef vtkSmartPointer<vtkDoubleArray> vtkDoubleArrayPtr;
 
 namespace cx
 {
 
+namespace
+{
+/** Converted data shared between all derived images of one input.
+ */
+struct SharedConversion
+{
+	vtkWeakPointer<vtkImageData> input;
+	unsigned long inputTime;
+	int shift;
+	int outputType;
+	vtkWeakPointer<vtkImageData> output;
+};
+typedef std::map<vtkImageData*, SharedConversion> SharedConversionMap;
+
+QMutex gSharedConversionMutex;
+SharedConversionMap gSharedConversions;
+bool gUseSharedConversion = true;
+int gNumberOfConversions = 0;
+
+/** Remove conversions where no derived image holds the output anymore.
+ */
+void pruneSharedConversions()
+{
+	for (SharedConversionMap::iterator iter = gSharedConversions.begin(); iter != gSharedConversions.end(); )
+	{
+		if (!iter->second.output)
+			gSharedConversions.erase(iter++);
+		else
+			++iter;
+	}
+}
+
+/** Return the smallest unsigned type fitting the intensity range of input.
+ */
+int findUnsignedOutputType(vtkImageDataPtr input)
+{
+	// total intensity range of voxels:
+	double range = input->GetScalarRange()[1] - input->GetScalarRange()[0];
+
+	// to to fit within smallest type
+	if (range <= VTK_UNSIGNED_SHORT_MAX-VTK_UNSIGNED_SHORT_MIN)
+		return VTK_UNSIGNED_SHORT;
+	else if (range <= VTK_UNSIGNED_INT_MAX-VTK_UNSIGNED_INT_MIN)
+		return VTK_UNSIGNED_INT;
+//	else if (range <= VTK_UNSIGNED_LONG_MAX-VTK_UNSIGNED_LONG_MIN) // not supported by vtk - it seems (crash in rendering)
+//		return VTK_UNSIGNED_LONG;
+	else
+		return VTK_UNSIGNED_INT;
+}
+
+/** out = clamp(in+shift) for all scalars, in parallel over z slices.
+ */
+template<class IN, class OUT>
+void shiftAndClamp(const IN* in, OUT* out, int slices, vtkIdType sliceSize, double shift)
+{
+	const double maxValue = std::numeric_limits<OUT>::max();
+	parallelForRange(0, slices, [=](int begin, int end)
+	{
+		for (vtkIdType i = begin*sliceSize; i < end*sliceSize; ++i)
+			out[i] = static_cast<OUT>(std::min(std::max(in[i] + shift, 0.0), maxValue));
+	}, 1);
+}
+
+template<class IN>
+void shiftAndClampTo(const IN* in, vtkImageDataPtr output, int slices, vtkIdType sliceSize, double shift)
+{
+	if (output->GetScalarType() == VTK_UNSIGNED_SHORT)
+		shiftAndClamp(in, static_cast<unsigned short*>(output->GetScalarPointer()), slices, sliceSize, shift);
+	else
+		shiftAndClamp(in, static_cast<unsigned int*>(output->GetScalarPointer()), slices, sliceSize, shift);
+}
+
+vtkImageDataPtr shiftAndClamp(vtkImageDataPtr input, int shift, int outputType)
+{
+	vtkImageDataPtr output = vtkImageDataPtr::New();
+	output->CopyStructure(input);
+	output->AllocateScalars(outputType, input->GetNumberOfScalarComponents());
+
+	int* dim = input->GetDimensions();
+	vtkIdType sliceSize = vtkIdType(dim[0]) * dim[1] * input->GetNumberOfScalarComponents();
+	void* in = input->GetScalarPointer();
+
+	switch (input->GetScalarType())
+	{
+		vtkTemplateMacro(shiftAndClampTo(static_cast<const VTK_TT*>(in), output, dim[2], sliceSize, shift));
+	}
+	return output;
+}
+}
+
+void UnsignedDerivedImage::setSharedConversion(bool on)
+{
+	gUseSharedConversion = on;
+}
+
+qint64 UnsignedDerivedImage::getAllocatedBytes()
+{
+	QMutexLocker lock(&gSharedConversionMutex);
+	pruneSharedConversions();
+
+	qint64 retval = 0;
+	for (SharedConversionMap::iterator iter = gSharedConversions.begin(); iter != gSharedConversions.end(); ++iter)
+	{
+		vtkDataArray* scalars = iter->second.output->GetPointData()->GetScalars();
+		if (scalars)
+			retval += qint64(scalars->GetNumberOfValues()) * scalars->GetDataTypeSize();
+	}
+	return retval;
+}
+
+int UnsignedDerivedImage::getNumberOfConversions()
+{
+	QMutexLocker lock(&gSharedConversionMutex);
+	return gNumberOfConversions;
+}
+
 ImagePtr UnsignedDerivedImage::create(ImagePtr base)
 {
     boost::shared_ptr<UnsignedDerivedImage> retval;
@@ -45,7 +166,10 @@ ImagePtr UnsignedDerivedImage::create(ImagePtr base)
     return retval;
 }
 
-UnsignedDerivedImage::UnsignedDerivedImage(ImagePtr base) : Image(base->getUid()+"_u", vtkImageDataPtr(), base->getName())
+UnsignedDerivedImage::UnsignedDerivedImage(ImagePtr base) :
+	Image(base->getUid()+"_u", vtkImageDataPtr(), base->getName()),
+	mConvertedInput(NULL),
+	mConvertedInputTime(0)
 {
     this->mBase = base;
 
@@ -89,7 +213,20 @@ void UnsignedDerivedImage::unsignedTransferFunctionsChangedSlot()
 
 void UnsignedDerivedImage::unsignedImageChangedSlot()
 {
-    this->setVtkImageData(this->convertImage());
+	ImagePtr base = mBase.lock();
+	vtkImageDataPtr input = base ? base->getBaseVtkImageData() : vtkImageDataPtr();
+
+	// the signal is also emitted for changes not affecting the voxels: reuse the converted data
+	if (input && (input.GetPointer() == mConvertedInput) && (input->GetMTime() == mConvertedInputTime))
+	{
+		emit vtkImageDataChanged(mUid);
+		return;
+	}
+
+	vtkImageDataPtr converted = gUseSharedConversion ? this->getSharedConvertedImage() : this->convertImage();
+	mConvertedInput = input.GetPointer();
+	mConvertedInputTime = input ? input->GetMTime() : 0;
+	this->setVtkImageData(converted);
 }
 
 int UnsignedDerivedImage::findShift()
@@ -127,26 +264,53 @@ vtkImageDataPtr UnsignedDerivedImage::convertImage()
 
     cast->SetShift(shift);
 
-    // total intensity range of voxels:
-    double range = input->GetScalarRange()[1] - input->GetScalarRange()[0];
-
-    // to to fit within smallest type
-    if (range <= VTK_UNSIGNED_SHORT_MAX-VTK_UNSIGNED_SHORT_MIN)
-        cast->SetOutputScalarType(VTK_UNSIGNED_SHORT);
-    else if (range <= VTK_UNSIGNED_INT_MAX-VTK_UNSIGNED_INT_MIN)
-        cast->SetOutputScalarType(VTK_UNSIGNED_INT);
-//	else if (range <= VTK_UNSIGNED_LONG_MAX-VTK_UNSIGNED_LONG_MIN) // not supported by vtk - it seems (crash in rendering)
-//		cast->SetOutputScalarType(VTK_UNSIGNED_LONG);
-    else
-        cast->SetOutputScalarType(VTK_UNSIGNED_INT);
+    cast->SetOutputScalarType(findUnsignedOutputType(input));
 
     cast->Update();
+    {
+        QMutexLocker lock(&gSharedConversionMutex);
+        ++gNumberOfConversions;
+    }
 //		if (verbose)
       report(QString("Converting image %1 from %2 to %3").arg(this->getName()).arg(input->GetScalarTypeAsString()).arg(cast->GetOutput()->GetScalarTypeAsString()));
     retval = cast->GetOutput();
     return retval;
 }
 
+/** As convertImage(), but reuse the converted data of other derived
+ *  images of the same input if it is up to date.
+ */
+vtkImageDataPtr UnsignedDerivedImage::getSharedConvertedImage()
+{
+	ImagePtr base = mBase.lock();
+	if (!base)
+		return vtkImageDataPtr();
+
+	int shift = this->findShift();
+	vtkImageDataPtr input = base->getBaseVtkImageData();
+	int outputType = findUnsignedOutputType(input);
+
+	QMutexLocker lock(&gSharedConversionMutex);
+	pruneSharedConversions();
+
+	SharedConversion& entry = gSharedConversions[input.GetPointer()];
+	if ((entry.input == input.GetPointer()) && (entry.inputTime == input->GetMTime())
+			&& (entry.shift == shift) && (entry.outputType == outputType) && entry.output)
+		return vtkImageDataPtr(entry.output.GetPointer());
+
+	vtkImageDataPtr retval = shiftAndClamp(input, shift, outputType);
+	++gNumberOfConversions;
+
+	entry.input = input.GetPointer();
+	entry.inputTime = input->GetMTime();
+	entry.shift = shift;
+	entry.outputType = outputType;
+	entry.output = retval.GetPointer();
+
+	report(QString("Converting image %1 from %2 to %3").arg(this->getName()).arg(input->GetScalarTypeAsString()).arg(retval->GetScalarTypeAsString()));
+	return retval;
+}
+
 CoordinateSystem UnsignedDerivedImage::getCoordinateSystem()
 {
 	CALL_IN_WEAK_PTR(mBase, getCoordinateSystem, CoordinateSystem(csCOUNT));
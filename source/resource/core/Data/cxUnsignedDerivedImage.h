@@ -36,6 +36,12 @@ struct CoordinateSystem;
  * Intended for structures that requires unsigned input, such
  * as TextureSlice3DProxy.
  *
+ * By default the converted data is shared between all derived images
+ * of the same base vtkImageData, and is converted in parallel chunks.
+ * The conversion is reused until the modification time of the base
+ * data changes, and the buffer is released when the last derived image
+ * holding it is destroyed.
+ *
  * \ingroup cx_resource_core_data
  *   \date Feb 21, 2013
  *   \author christiana
@@ -45,6 +51,9 @@ class cxResource_EXPORT UnsignedDerivedImage : public Image
     Q_OBJECT
 public:
     static ImagePtr create(ImagePtr base);
+    static void setSharedConversion(bool on); ///< share converted data between derived images (default), or convert each with vtkImageShiftScale
+    static qint64 getAllocatedBytes(); ///< memory held by converted data of all derived images
+    static int getNumberOfConversions(); ///< number of conversions run since start
 
 
     virtual RegistrationHistoryPtr get_rMd_History() { CALL_IN_WEAK_PTR(mBase, get_rMd_History, RegistrationHistoryPtr()); }
@@ -72,9 +81,12 @@ private:
     UnsignedDerivedImage(ImagePtr base);
     int findShift();
     vtkImageDataPtr convertImage();
+    vtkImageDataPtr getSharedConvertedImage();
     void convertTransferFunctions();
 
     boost::weak_ptr<Image> mBase;
+    vtkImageData* mConvertedInput; ///< base data converted to the current data
+    unsigned long mConvertedInputTime; ///< modification time of mConvertedInput when converted
 };
 
 }
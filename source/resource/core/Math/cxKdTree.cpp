@@ -0,0 +1,165 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxKdTree.h"
+
+#include <algorithm>
+#include <limits>
+#include <vtkPoints.h>
+#include "cxParallelFor.h"
+
+namespace cx
+{
+
+namespace
+{
+struct AxisLess
+{
+	AxisLess(const std::vector<Vector3D>& points, int axis) : mPoints(points), mAxis(axis) {}
+	bool operator()(int a, int b) const { return mPoints[a][mAxis] < mPoints[b][mAxis]; }
+	const std::vector<Vector3D>& mPoints;
+	int mAxis;
+};
+}
+
+KdTreePtr KdTree::create(const std::vector<Vector3D>& points)
+{
+	return KdTreePtr(new KdTree(points));
+}
+
+KdTreePtr KdTree::create(vtkPointsPtr points)
+{
+	std::vector<Vector3D> input;
+	if (points)
+	{
+		input.resize(points->GetNumberOfPoints());
+		for (unsigned i=0; i<input.size(); ++i)
+			points->GetPoint(i, input[i].data());
+	}
+	return create(input);
+}
+
+KdTree::KdTree(const std::vector<Vector3D>& points) :
+	mPoints(points),
+	mIndices(points.size()),
+	mAxis(points.size(), 0)
+{
+	for (unsigned i=0; i<mIndices.size(); ++i)
+		mIndices[i] = i;
+
+	this->build(0, this->size());
+
+	// store points in tree order for cache friendly searches
+	std::vector<Vector3D> ordered(mPoints.size());
+	mTreePositions.resize(mIndices.size());
+	for (unsigned i=0; i<mIndices.size(); ++i)
+	{
+		ordered[i] = mPoints[mIndices[i]];
+		mTreePositions[mIndices[i]] = i;
+	}
+	mPoints.swap(ordered);
+}
+
+int KdTree::size() const
+{
+	return mIndices.size();
+}
+
+Vector3D KdTree::getPoint(int index) const
+{
+	return mPoints[mTreePositions[index]];
+}
+
+void KdTree::build(int begin, int end)
+{
+	if (end-begin <= 1)
+		return;
+
+	// mPoints is still in input order here, mIndices is being partitioned.
+	Vector3D lo = mPoints[mIndices[begin]];
+	Vector3D hi = lo;
+	for (int i=begin+1; i<end; ++i)
+	{
+		lo = lo.cwiseMin(mPoints[mIndices[i]]);
+		hi = hi.cwiseMax(mPoints[mIndices[i]]);
+	}
+	int axis = 0;
+	(hi-lo).maxCoeff(&axis);
+
+	int mid = (begin+end)/2;
+	std::nth_element(mIndices.begin()+begin, mIndices.begin()+mid, mIndices.begin()+end, AxisLess(mPoints, axis));
+	mAxis[mid] = axis;
+
+	this->build(begin, mid);
+	this->build(mid+1, end);
+}
+
+int KdTree::findClosestPoint(const Vector3D& p, double* distanceSquared) const
+{
+	int best = -1;
+	double bestDistanceSquared = std::numeric_limits<double>::max();
+	this->search(0, this->size(), p, best, bestDistanceSquared);
+
+	if (distanceSquared)
+		*distanceSquared = bestDistanceSquared;
+	if (best<0)
+		return -1;
+	return mIndices[best];
+}
+
+void KdTree::search(int begin, int end, const Vector3D& p, int& best, double& bestDistanceSquared) const
+{
+	if (begin >= end)
+		return;
+
+	int mid = (begin+end)/2;
+	const Vector3D& q = mPoints[mid];
+	double d2 = (q-p).squaredNorm();
+	if (d2 < bestDistanceSquared)
+	{
+		bestDistanceSquared = d2;
+		best = mid;
+	}
+	if (end-begin == 1)
+		return;
+
+	int axis = mAxis[mid];
+	double diff = p[axis] - q[axis];
+	if (diff < 0)
+	{
+		this->search(begin, mid, p, best, bestDistanceSquared);
+		if (diff*diff < bestDistanceSquared)
+			this->search(mid+1, end, p, best, bestDistanceSquared);
+	}
+	else
+	{
+		this->search(mid+1, end, p, best, bestDistanceSquared);
+		if (diff*diff < bestDistanceSquared)
+			this->search(begin, mid, p, best, bestDistanceSquared);
+	}
+}
+
+void KdTree::findClosestPoints(const std::vector<Vector3D>& points, std::vector<int>* indices, std::vector<double>* distancesSquared) const
+{
+	indices->resize(points.size());
+	distancesSquared->resize(points.size());
+	int* indicesPtr = indices->data();
+	double* distancesPtr = distancesSquared->data();
+	const std::vector<Vector3D>* pointsPtr = &points;
+	const KdTree* tree = this;
+
+	parallelFor(0, points.size(), [=](int i)
+	{
+		indicesPtr[i] = tree->findClosestPoint((*pointsPtr)[i], &distancesPtr[i]);
+	}, 256);
+}
+
+} // namespace cx
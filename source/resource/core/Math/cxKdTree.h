@@ -0,0 +1,78 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXKDTREE_H
+#define CXKDTREE_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "cxVector3D.h"
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+
+/**
+ * \addtogroup cx_resource_core_math
+ * @{
+ */
+
+typedef boost::shared_ptr<class KdTree> KdTreePtr;
+
+/** \brief Static k-d tree over a 3D point cloud, for closest point queries.
+ *
+ * The tree is stored implicitly in a single array: each range [begin,end)
+ * has its split point at the median (begin+end)/2, splitting along the axis
+ * of largest extent. Building is O(N log N).
+ *
+ * All const methods are thread safe, thus many queries can be run
+ * concurrently on the same tree.
+ *
+ * Indices returned are indices into the input point list.
+ */
+class cxResource_EXPORT KdTree
+{
+public:
+	static KdTreePtr create(const std::vector<Vector3D>& points);
+	static KdTreePtr create(vtkPointsPtr points);
+	explicit KdTree(const std::vector<Vector3D>& points);
+
+	int size() const;
+	Vector3D getPoint(int index) const; ///< get point with input index
+
+	/** Return index of the point closest to p, or -1 if the tree is empty.
+	 *  The squared distance is returned in distanceSquared if non-null.
+	 */
+	int findClosestPoint(const Vector3D& p, double* distanceSquared = NULL) const;
+	/** Find the closest points for all input points, in parallel.
+	 *  Output vectors are resized to the size of points.
+	 */
+	void findClosestPoints(const std::vector<Vector3D>& points, std::vector<int>* indices, std::vector<double>* distancesSquared) const;
+
+private:
+	void build(int begin, int end);
+	void search(int begin, int end, const Vector3D& p, int& best, double& bestDistanceSquared) const;
+
+	std::vector<Vector3D> mPoints; ///< points in tree order
+	std::vector<int> mIndices; ///< input index for each tree node
+	std::vector<int> mTreePositions; ///< tree node for each input index
+	std::vector<unsigned char> mAxis; ///< split axis for each tree node
+};
+
+/**
+ * @}
+ */
+
+} // namespace cx
+
+#endif // CXKDTREE_H
@@ -0,0 +1,342 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxMeshPlaneIntersection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include "cxParallelFor.h"
+
+namespace cx
+{
+
+namespace
+{
+const int maxTrianglesInLeaf = 8;
+const int minNumberOfTasks = 256;
+const unsigned cacheSize = 8;
+
+struct CentroidLess
+{
+	CentroidLess(const std::vector<Vector3D>& centroids, int axis) : mCentroids(centroids), mAxis(axis) {}
+	bool operator()(int a, int b) const { return mCentroids[a][mAxis] < mCentroids[b][mAxis]; }
+	const std::vector<Vector3D>& mCentroids;
+	int mAxis;
+};
+}
+
+MeshPlaneIntersectionPtr MeshPlaneIntersection::create(vtkPolyDataPtr polyData)
+{
+	return MeshPlaneIntersectionPtr(new MeshPlaneIntersection(polyData));
+}
+
+MeshPlaneIntersection::MeshPlaneIntersection(vtkPolyDataPtr polyData) :
+	mPolyData(polyData),
+	mBuildTime(0),
+	mVisitedTriangles(0)
+{
+	this->build();
+}
+
+void MeshPlaneIntersection::build()
+{
+	mPoints.clear();
+	mTriangles.clear();
+	mNodes.clear();
+	mCache.clear();
+	if (!mPolyData)
+		return;
+	mBuildTime = mPolyData->GetMTime();
+
+	vtkPoints* points = mPolyData->GetPoints();
+	if (points)
+	{
+		mPoints.resize(points->GetNumberOfPoints());
+		for (unsigned i=0; i<mPoints.size(); ++i)
+			points->GetPoint(i, mPoints[i].data());
+	}
+	this->readTriangles();
+
+	int count = this->getNumberOfTriangles();
+	mOrder.resize(count);
+	mCentroids.resize(count);
+	for (int i=0; i<count; ++i)
+	{
+		mOrder[i] = i;
+		mCentroids[i] = (mPoints[mTriangles[3*i]] + mPoints[mTriangles[3*i+1]] + mPoints[mTriangles[3*i+2]]) / 3;
+	}
+
+	if (count)
+	{
+		mNodes.reserve(2*count/maxTrianglesInLeaf + 1);
+		this->buildNode(0, count);
+	}
+	std::vector<Vector3D>().swap(mCentroids);
+}
+
+/** Read polygons as triangle fans and strips as triangles.
+ */
+void MeshPlaneIntersection::readTriangles()
+{
+	vtkIdListPtr cell = vtkIdListPtr::New();
+
+	vtkCellArray* polys = mPolyData->GetPolys();
+	mTriangles.reserve(3*polys->GetNumberOfCells());
+	polys->InitTraversal();
+	while (polys->GetNextCell(cell))
+	{
+		for (vtkIdType i=2; i<cell->GetNumberOfIds(); ++i)
+		{
+			mTriangles.push_back(cell->GetId(0));
+			mTriangles.push_back(cell->GetId(i-1));
+			mTriangles.push_back(cell->GetId(i));
+		}
+	}
+
+	vtkCellArray* strips = mPolyData->GetStrips();
+	strips->InitTraversal();
+	while (strips->GetNextCell(cell))
+	{
+		for (vtkIdType i=2; i<cell->GetNumberOfIds(); ++i)
+		{
+			mTriangles.push_back(cell->GetId(i-2));
+			mTriangles.push_back(cell->GetId(i-1));
+			mTriangles.push_back(cell->GetId(i));
+		}
+	}
+}
+
+/** Build the node for mOrder[begin,end), splitting at the median centroid
+ *  along the axis of largest centroid extent. Return the node index.
+ */
+int MeshPlaneIntersection::buildNode(int begin, int end)
+{
+	int index = int(mNodes.size());
+	mNodes.push_back(Node());
+
+	Node node;
+	Vector3D centroidMin = Vector3D::Constant(std::numeric_limits<double>::max());
+	Vector3D centroidMax = -centroidMin;
+	for (int k=0; k<3; ++k)
+	{
+		node.mMin[k] = std::numeric_limits<double>::max();
+		node.mMax[k] = -std::numeric_limits<double>::max();
+	}
+	for (int i=begin; i<end; ++i)
+	{
+		int triangle = mOrder[i];
+		for (int j=0; j<3; ++j)
+		{
+			const Vector3D& p = mPoints[mTriangles[3*triangle+j]];
+			for (int k=0; k<3; ++k)
+			{
+				node.mMin[k] = std::min(node.mMin[k], p[k]);
+				node.mMax[k] = std::max(node.mMax[k], p[k]);
+			}
+		}
+		centroidMin = centroidMin.cwiseMin(mCentroids[triangle]);
+		centroidMax = centroidMax.cwiseMax(mCentroids[triangle]);
+	}
+
+	Vector3D extent = centroidMax - centroidMin;
+	int axis = 0;
+	for (int k=1; k<3; ++k)
+		if (extent[k] > extent[axis])
+			axis = k;
+
+	if ((end-begin <= maxTrianglesInLeaf) || (extent[axis] <= 0))
+	{
+		node.mFirst = begin;
+		node.mCount = end-begin;
+		node.mRight = -1;
+		mNodes[index] = node;
+		return index;
+	}
+
+	int mid = (begin+end)/2;
+	std::nth_element(mOrder.begin()+begin, mOrder.begin()+mid, mOrder.begin()+end, CentroidLess(mCentroids, axis));
+	node.mFirst = begin;
+	node.mCount = 0;
+	this->buildNode(begin, mid);
+	node.mRight = this->buildNode(mid, end);
+	mNodes[index] = node;
+	return index;
+}
+
+bool MeshPlaneIntersection::crossesPlane(const Node& node, const Vector3D& normal, double offset) const
+{
+	double distance = -offset;
+	double radius = 0;
+	for (int k=0; k<3; ++k)
+	{
+		double center = (node.mMin[k] + node.mMax[k]) / 2;
+		double halfExtent = (node.mMax[k] - node.mMin[k]) / 2;
+		distance += normal[k]*center;
+		radius += std::fabs(normal[k])*halfExtent;
+	}
+	return std::fabs(distance) <= radius;
+}
+
+vtkPolyDataPtr MeshPlaneIntersection::getContour(const Vector3D& point, const Vector3D& normal)
+{
+	if (mPolyData && (mPolyData->GetMTime() != mBuildTime))
+		this->build();
+
+	Vector3D n = normal.normalized();
+	double offset = dot(n, point);
+	for (unsigned i=0; i<mCache.size(); ++i)
+	{
+		if (similar(n, mCache[i].mNormal, 1.0E-12) && similar(offset, mCache[i].mOffset, 1.0E-9))
+		{
+			std::rotate(mCache.begin(), mCache.begin()+i, mCache.begin()+i+1);
+			return mCache.front().mContour;
+		}
+	}
+
+	// split the tree into independent subtrees crossing the plane
+	std::vector<int> tasks;
+	std::vector<int> queue;
+	if (!mNodes.empty())
+		queue.push_back(0);
+	for (unsigned head=0; head<queue.size(); ++head)
+	{
+		int index = queue[head];
+		const Node& node = mNodes[index];
+		if (!this->crossesPlane(node, n, offset))
+			continue;
+		if (node.mCount || (tasks.size() + queue.size() - head >= minNumberOfTasks))
+		{
+			tasks.push_back(index);
+			continue;
+		}
+		queue.push_back(index+1);
+		queue.push_back(node.mRight);
+	}
+
+	std::vector<std::vector<Segment> > segments(tasks.size());
+	std::vector<int> visited(tasks.size(), 0);
+	const MeshPlaneIntersection* self = this;
+	const Vector3D* normalPtr = &n;
+	const int* tasksPtr = tasks.data();
+	std::vector<Segment>* segmentsPtr = segments.data();
+	int* visitedPtr = visited.data();
+	parallelFor(0, int(tasks.size()), [=](int i)
+	{
+		self->intersect(tasksPtr[i], *normalPtr, offset, &segmentsPtr[i], &visitedPtr[i]);
+	}, 1);
+
+	mVisitedTriangles = 0;
+	for (unsigned i=0; i<visited.size(); ++i)
+		mVisitedTriangles += visited[i];
+
+	CachedContour cached;
+	cached.mNormal = n;
+	cached.mOffset = offset;
+	cached.mContour = this->createContour(segments);
+	mCache.insert(mCache.begin(), cached);
+	if (mCache.size() > cacheSize)
+		mCache.pop_back();
+	return cached.mContour;
+}
+
+void MeshPlaneIntersection::intersect(int root, const Vector3D& normal, double offset, std::vector<Segment>* segments, int* visited) const
+{
+	std::vector<int> stack(1, root);
+	while (!stack.empty())
+	{
+		const Node& node = mNodes[stack.back()];
+		int index = stack.back();
+		stack.pop_back();
+		if (!this->crossesPlane(node, normal, offset))
+			continue;
+
+		if (!node.mCount)
+		{
+			stack.push_back(node.mRight);
+			stack.push_back(index+1);
+			continue;
+		}
+
+		Segment segment;
+		for (int i=node.mFirst; i<node.mFirst+node.mCount; ++i)
+		{
+			++(*visited);
+			if (this->intersectTriangle(mOrder[i], normal, offset, &segment))
+				segments->push_back(segment);
+		}
+	}
+}
+
+/** Points on or above the plane count as above, thus a crossed triangle
+ *  has exactly two crossed edges. Each crossing is interpolated from the
+ *  lower vertex index, making points on shared edges identical.
+ */
+bool MeshPlaneIntersection::intersectTriangle(int triangle, const Vector3D& normal, double offset, Segment* segment) const
+{
+	const int* v = &mTriangles[3*triangle];
+	double d[3];
+	for (int k=0; k<3; ++k)
+		d[k] = dot(normal, mPoints[v[k]]) - offset;
+
+	int count = 0;
+	for (int k=0; k<3; ++k)
+	{
+		int a = k;
+		int b = (k+1)%3;
+		if ((d[a] >= 0) == (d[b] >= 0))
+			continue;
+		if (v[a] > v[b])
+			std::swap(a, b);
+		double t = d[a] / (d[a] - d[b]);
+		segment->mPoints[count] = mPoints[v[a]] + t*(mPoints[v[b]] - mPoints[v[a]]);
+		segment->mEdges[count] = (long long)(v[a])*mPoints.size() + v[b];
+		++count;
+	}
+	return (count == 2) && (segment->mPoints[0] != segment->mPoints[1]);
+}
+
+vtkPolyDataPtr MeshPlaneIntersection::createContour(const std::vector<std::vector<Segment> >& segments) const
+{
+	vtkPointsPtr points = vtkPointsPtr::New();
+	vtkCellArrayPtr lines = vtkCellArrayPtr::New();
+	std::unordered_map<long long, vtkIdType> pointIds;
+
+	for (unsigned i=0; i<segments.size(); ++i)
+	{
+		for (unsigned j=0; j<segments[i].size(); ++j)
+		{
+			const Segment& segment = segments[i][j];
+			vtkIdType ids[2];
+			for (int k=0; k<2; ++k)
+			{
+				std::pair<std::unordered_map<long long, vtkIdType>::iterator, bool> inserted =
+						pointIds.insert(std::make_pair(segment.mEdges[k], points->GetNumberOfPoints()));
+				if (inserted.second)
+					points->InsertNextPoint(segment.mPoints[k].data());
+				ids[k] = inserted.first->second;
+			}
+			lines->InsertNextCell(2, ids);
+		}
+	}
+
+	vtkPolyDataPtr retval = vtkPolyDataPtr::New();
+	retval->SetPoints(points);
+	retval->SetLines(lines);
+	return retval;
+}
+
+} // namespace cx
@@ -0,0 +1,106 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXMESHPLANEINTERSECTION_H
+#define CXMESHPLANEINTERSECTION_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "cxVector3D.h"
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+
+/**
+ * \addtogroup cx_resource_core_math
+ * @{
+ */
+
+typedef boost::shared_ptr<class MeshPlaneIntersection> MeshPlaneIntersectionPtr;
+
+/** \brief Intersection contour between a triangle mesh and a plane.
+ *
+ * The triangles of the polydata (polygons are fanned, strips split) are put
+ * in a bounding volume hierarchy once, thus a contour is found by visiting
+ * only the triangles near the plane. The subtrees crossing the plane are
+ * searched in parallel.
+ *
+ * The contour is returned as polydata with one line per intersected triangle,
+ * in the coordinates of the input. Points on the same mesh edge are shared,
+ * and the result is deterministic. The contours of the latest few planes are
+ * cached, thus one instance can be shared between several views of the same
+ * mesh. The cache is cleared and the hierarchy rebuilt when the input
+ * polydata (by MTime) changes. Lines and vertices are ignored.
+ */
+class cxResource_EXPORT MeshPlaneIntersection
+{
+public:
+	static MeshPlaneIntersectionPtr create(vtkPolyDataPtr polyData);
+	explicit MeshPlaneIntersection(vtkPolyDataPtr polyData);
+
+	/** Return the contour in the plane through point with the given normal.
+	 */
+	vtkPolyDataPtr getContour(const Vector3D& point, const Vector3D& normal);
+	vtkPolyDataPtr getPolyData() const { return mPolyData; }
+	int getNumberOfTriangles() const { return int(mTriangles.size()/3); }
+	int getNumberOfVisitedTriangles() const { return mVisitedTriangles; } ///< triangles tested in the last getContour(), for diagnostics
+
+private:
+	struct Node
+	{
+		double mMin[3];
+		double mMax[3];
+		int mFirst; ///< first index in mOrder for a leaf
+		int mCount; ///< number of triangles for a leaf, 0 for inner nodes
+		int mRight; ///< right child for inner nodes, the left is the next node
+	};
+	struct CachedContour
+	{
+		Vector3D mNormal;
+		double mOffset;
+		vtkPolyDataPtr mContour;
+	};
+	struct Segment
+	{
+		Vector3D mPoints[2];
+		long long mEdges[2];
+	};
+
+	void build();
+	void readTriangles();
+	int buildNode(int begin, int end);
+	bool crossesPlane(const Node& node, const Vector3D& normal, double offset) const;
+	void intersect(int root, const Vector3D& normal, double offset, std::vector<Segment>* segments, int* visited) const;
+	bool intersectTriangle(int triangle, const Vector3D& normal, double offset, Segment* segment) const;
+	vtkPolyDataPtr createContour(const std::vector<std::vector<Segment> >& segments) const;
+
+	vtkPolyDataPtr mPolyData;
+	unsigned long mBuildTime;
+	std::vector<Vector3D> mPoints;
+	std::vector<int> mTriangles; ///< three point indices per triangle
+	std::vector<int> mOrder; ///< triangle indices in leaf order
+	std::vector<Vector3D> mCentroids; ///< only used while building
+	std::vector<Node> mNodes; ///< depth first order, root first
+
+	std::vector<CachedContour> mCache; ///< most recent first
+	int mVisitedTriangles;
+};
+
+/**
+ * @}
+ */
+
+} // namespace cx
+
+#endif // CXMESHPLANEINTERSECTION_H
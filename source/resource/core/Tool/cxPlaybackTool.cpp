@@ -14,6 +14,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxTypeConversions.h"
 #include "cxPlaybackTime.h"
 #include "cxManualToolAdapter.h"
+#include "cxUSReconstructInputDataAlgoritms.h"
+#include <algorithm>
 
 namespace cx
 {
@@ -21,7 +23,12 @@ namespace cx
 PlaybackTool::PlaybackTool(ToolPtr base, PlaybackTimePtr time) :
 	ToolImpl(base->getUid(), "playback "+base->getName()), mBase(base),
 	mTime(time),
-	mVisible(false)
+	mInterpolation(true),
+	mCursorHistorySize(0),
+	mVisibilityTimeout(200),
+	mVisible(false),
+	mTimestamp(0),
+	m_rMpr(Transform3D::Identity())
 {
 	connect(mTime.get(), SIGNAL(changed()), this, SLOT(timeChangedSlot()));
 
@@ -33,6 +40,68 @@ PlaybackTool::~PlaybackTool()
 {
 }
 
+void PlaybackTool::setInterpolation(bool on)
+{
+	mInterpolation = on;
+	this->timeChangedSlot();
+}
+
+/** Use the median time between samples as a measure of the sample rate,
+ *  as the mean is skewed by the gaps where the tool was hidden.
+ */
+void PlaybackTool::updateVisibilityTimeout(TimedTransformMapPtr positions)
+{
+	if (positions->size() < 2)
+	{
+		mVisibilityTimeout = 200;
+		return;
+	}
+
+	std::vector<double> intervals;
+	intervals.reserve(positions->size());
+	TimedTransformMap::const_iterator iter = positions->begin();
+	for (TimedTransformMap::const_iterator next = std::next(iter); next != positions->end(); iter = next++)
+		intervals.push_back(next->first - iter->first);
+
+	std::nth_element(intervals.begin(), intervals.begin() + intervals.size()/2, intervals.end());
+	double median = intervals[intervals.size()/2];
+	// allow a few dropped samples before hiding the tool
+	mVisibilityTimeout = std::max(4.0*median, 10.0);
+}
+
+/** Move mCursor to the last sample at or before time.
+ *  Small steps walk the cursor, large jumps search the history.
+ */
+void PlaybackTool::updateCursor(TimedTransformMapPtr positions, double time)
+{
+	if ((positions != mCursorHistory) || (positions->size() != mCursorHistorySize))
+	{
+		mCursorHistory = positions;
+		mCursorHistorySize = positions->size();
+		mCursor = positions->begin();
+		this->updateVisibilityTimeout(positions);
+	}
+
+	const int maxSteps = 16;
+	int steps = 0;
+	while (steps < maxSteps)
+	{
+		TimedTransformMap::const_iterator next = mCursor;
+		++next;
+		if ((next != positions->end()) && (next->first <= time))
+			mCursor = next;
+		else if ((mCursor != positions->begin()) && (mCursor->first > time))
+			--mCursor;
+		else
+			return;
+		++steps;
+	}
+
+	mCursor = positions->upper_bound(time);
+	if (mCursor != positions->begin())
+		--mCursor;
+}
+
 void PlaybackTool::timeChangedSlot()
 {
 	QDateTime time = mTime->getTime();
@@ -42,14 +111,13 @@ void PlaybackTool::timeChangedSlot()
 	if (positions->empty())
 		return;
 
-	// find last stored time before current time.
-	TimedTransformMap::iterator lastSample = positions->lower_bound(time_ms);
-	if (lastSample!=positions->begin())
-		--lastSample;
+	this->updateCursor(positions, time_ms);
+	TimedTransformMap::const_iterator lastSample = mCursor;
+	TimedTransformMap::const_iterator nextSample = mCursor;
+	++nextSample;
 
 	// interpret as hidden if no samples has been received the last time:
-	qint64 timeout = 200;
-	bool visible = (lastSample!=positions->end()) && (fabs(time_ms - lastSample->first) < timeout);
+	bool visible = fabs(time_ms - lastSample->first) < mVisibilityTimeout;
 
 	// change visibility if applicable
 	if (mVisible!=visible)
@@ -61,8 +129,21 @@ void PlaybackTool::timeChangedSlot()
 	// emit new position if visible
 	if (this->getVisible())
 	{
-		m_rMpr = lastSample->second;
-		mTimestamp = lastSample->first;
+		bool bracketed = (lastSample->first <= time_ms)
+				&& (nextSample != positions->end())
+				&& (nextSample->first - lastSample->first < mVisibilityTimeout);
+
+		if (mInterpolation && bracketed)
+		{
+			double t = (time_ms - lastSample->first) / (nextSample->first - lastSample->first);
+			m_rMpr = USReconstructInputDataAlgorithm::slerpInterpolate(lastSample->second, nextSample->second, t);
+			mTimestamp = time_ms;
+		}
+		else
+		{
+			m_rMpr = lastSample->second;
+			mTimestamp = lastSample->first;
+		}
 		emit toolTransformAndTimestamp(m_rMpr, mTimestamp);
 	}
 }
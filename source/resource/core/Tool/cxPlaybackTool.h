@@ -24,6 +24,16 @@ typedef boost::shared_ptr<class PlaybackTime> PlaybackTimePtr;
 
 
 /** \brief A tool used during playback
+ *
+ * The position at the playback time is found from the history of the
+ * base tool using a cursor into the history, which makes stepping forward
+ * and backward in time amortized constant time. By default, the position
+ * is interpolated between the two samples bracketing the playback time:
+ * linearly for translation, and SLERP for rotation.
+ *
+ * The tool is hidden if the playback time is not within one visibility
+ * timeout of a sample. The timeout is derived from the sample rate of
+ * the history.
  *
  * \date Mar 29, 2012
  * \author Christian Askeland, SINTEF
@@ -64,13 +74,23 @@ public:
 
 	// extensions
 	ToolPtr getBase() { return mBase; }
+	void setInterpolation(bool on); ///< interpolate between samples, or use the last sample before the playback time.
+	double getVisibilityTimeout() const { return mVisibilityTimeout; } ///< max time between samples while visible, ms
 
 private slots:
 	void timeChangedSlot();
 private:
+	void updateCursor(TimedTransformMapPtr positions, double time);
+	void updateVisibilityTimeout(TimedTransformMapPtr positions);
 	ToolPtr mBase;
 	PlaybackTimePtr mTime;
 
+	bool mInterpolation;
+	TimedTransformMapPtr mCursorHistory; ///< the history mCursor points into
+	TimedTransformMap::const_iterator mCursor; ///< last sample at or before the current time, or begin()
+	size_t mCursorHistorySize;
+	double mVisibilityTimeout;
+
 	bool mVisible;
 	double mTimestamp;
 	Transform3D m_rMpr;
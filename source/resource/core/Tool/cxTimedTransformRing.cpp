@@ -0,0 +1,91 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#include "cxTimedTransformRing.h"
+
+#include <algorithm>
+#include "cxUSReconstructInputDataAlgoritms.h"
+
+namespace cx
+{
+
+TimedTransformRing::TimedTransformRing(unsigned capacity) :
+	mEntries(std::max(capacity, 2u)),
+	mFirst(0),
+	mEnd(0)
+{
+	for (unsigned i=0; i<mEntries.size(); ++i)
+	{
+		mEntries[i].mTime = 0;
+		mEntries[i].mTransform = Transform3D::Identity();
+	}
+}
+
+void TimedTransformRing::add(const Transform3D& transform, double timestamp)
+{
+	unsigned long long first = mFirst.load(std::memory_order_relaxed);
+	unsigned long long end = mEnd.load(std::memory_order_relaxed);
+
+	if ((first < end) && (timestamp < this->at(end-1).mTime))
+		first = end;
+	if (end+1 - first > mEntries.size())
+		first = end+1 - mEntries.size();
+
+	// invalidate the overwritten sample before writing it, readers check mFirst afterwards
+	mFirst.store(first, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Entry& entry = mEntries[end % mEntries.size()];
+	entry.mTime = timestamp;
+	entry.mTransform = transform;
+	mEnd.store(end+1, std::memory_order_release);
+}
+
+void TimedTransformRing::clear()
+{
+	mFirst.store(mEnd.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+bool TimedTransformRing::isEmpty() const
+{
+	return mFirst.load(std::memory_order_acquire) >= mEnd.load(std::memory_order_acquire);
+}
+
+bool TimedTransformRing::interpolate(double timestamp, Transform3D* result) const
+{
+	for (int attempt=0; attempt<3; ++attempt)
+	{
+		unsigned long long end = mEnd.load(std::memory_order_acquire);
+		unsigned long long first = mFirst.load(std::memory_order_acquire);
+		if (first >= end)
+			return false;
+
+		unsigned long long i = end-1;
+		while ((i > first) && (this->at(i).mTime > timestamp))
+			--i;
+		Entry a = this->at(i);
+		bool bracketed = (i+1 < end) && (a.mTime <= timestamp);
+		Entry b = bracketed ? this->at(i+1) : a;
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (mFirst.load(std::memory_order_relaxed) > i)
+			continue; // overwritten while reading
+
+		double dt = b.mTime - a.mTime;
+		if (!bracketed || (dt <= 0))
+			*result = a.mTransform;
+		else
+			*result = USReconstructInputDataAlgorithm::slerpInterpolate(a.mTransform, b.mTransform, (timestamp - a.mTime) / dt);
+		return true;
+	}
+	return false;
+}
+
+} // namespace cx
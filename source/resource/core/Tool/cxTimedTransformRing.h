@@ -0,0 +1,69 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXTIMEDTRANSFORMRING_H
+#define CXTIMEDTRANSFORMRING_H
+
+#include "cxResourceExport.h"
+
+#include <atomic>
+#include <vector>
+#include "cxTransform3D.h"
+
+namespace cx
+{
+
+/** Fixed size history of the latest timestamped transforms.
+ *
+ * Used to look up a tool pose at the acquisition time of a video frame,
+ * interpolating between the two closest samples (linear for translation,
+ * slerp for rotation). Times outside the history give the oldest or newest
+ * sample.
+ *
+ * add() overwrites the oldest sample and never allocates. The lookup
+ * searches back from the newest sample, thus it takes a step or two
+ * for live data, and at most the capacity.
+ *
+ * No locks are used: one thread may add() while others call interpolate().
+ * A reader overtaken by the writer retries, and fails after a few attempts.
+ *
+ * \ingroup cx_resource_core_tool
+ */
+class cxResource_EXPORT TimedTransformRing
+{
+public:
+	explicit TimedTransformRing(unsigned capacity = 64);
+	/** Add a sample. A timestamp older than the newest sample
+	 *  is taken as a clock reset and clears the history first.
+	 */
+	void add(const Transform3D& transform, double timestamp);
+	void clear();
+	bool isEmpty() const;
+	unsigned getCapacity() const { return unsigned(mEntries.size()); }
+	/** Write the transform at timestamp to result. Return false if empty.
+	 */
+	bool interpolate(double timestamp, Transform3D* result) const;
+
+private:
+	struct Entry
+	{
+		double mTime;
+		Transform3D mTransform;
+	};
+	const Entry& at(unsigned long long index) const { return mEntries[index % mEntries.size()]; }
+
+	std::vector<Entry> mEntries;
+	std::atomic<unsigned long long> mFirst; ///< index of the oldest valid sample
+	std::atomic<unsigned long long> mEnd; ///< index after the newest sample
+};
+
+} // namespace cx
+
+#endif // CXTIMEDTRANSFORMRING_H
@@ -29,48 +29,48 @@ void TrackingPositionFilter::setCutOffFrequency(double freq)
 
 void TrackingPositionFilter::addPosition(Transform3D pos, double timestamp)
 {
-	this->clearIfTimestampIsOlderThanHead(pos, timestamp);
-	this->clearIfJumpInTimestamps(pos, timestamp);
+	this->clearIfTimestampIsOlderThanHead(timestamp);
+	this->clearIfJumpInTimestamps(timestamp);
 
-	if (mResampled.empty())
-	{
-		mResampled[timestamp] = pos;
-		mHistory[timestamp] = pos;
-		return;
-	}
+	if (mHasSample)
+		this->interpolateAndFilterPositions(pos, timestamp);
+	else
+		mLastResampledTimestamp = timestamp;
 
-	this->interpolateAndFilterPositions(pos, timestamp);
-	mHistory[timestamp] = pos;
+	mHasSample = true;
+	mLastPosition = pos;
+	mLastRotation = Eigen::Quaterniond(pos.linear());
+	mLastTimestamp = timestamp;
 }
 
 Transform3D TrackingPositionFilter::getFilteredPosition()
 {
-	if (mFiltered.size() > mResampleFrequency) //check if mFiltered contains enough positions for the filter to be stable
-		return mFiltered.rbegin()->second;
-	else if (!mHistory.empty())
-		return mHistory.rbegin()->second;
+	if (mFilteredCount > mResampleFrequency) //check if enough positions have been filtered for the filter to be stable
+		return mFiltered;
+	else if (mHasSample)
+		return mLastPosition;
 	else
 		return Transform3D::Identity();
 }
 
-void TrackingPositionFilter::clearIfTimestampIsOlderThanHead(Transform3D pos, double timestamp)
+void TrackingPositionFilter::clearIfTimestampIsOlderThanHead(double timestamp)
 {
-	if (mResampled.empty())
+	if (!mHasSample)
 		return;
 
-	if (timestamp < mResampled.rbegin()->first)
+	if (timestamp < mLastResampledTimestamp)
 	{
 		// clear history if old timestamps appear
 		this->reset();
 	}
 }
 
-void TrackingPositionFilter::clearIfJumpInTimestamps(Transform3D pos, double timestamp)
+void TrackingPositionFilter::clearIfJumpInTimestamps(double timestamp)
 {
-	if (mResampled.empty())
+	if (!mHasSample)
 		return;
 
-	double timeStep = timestamp - mResampled.rbegin()->first;
+	double timeStep = timestamp - mLastResampledTimestamp;
 	if ( timeStep > 1000)
 	{
 		// clear history of resampled and filtered data if jump in timestamps of more than 1 second
@@ -80,39 +80,72 @@ void TrackingPositionFilter::clearIfJumpInTimestamps(Transform3D pos, double tim
 
 void TrackingPositionFilter::interpolateAndFilterPositions(Transform3D pos, double timestamp)
 {
-	Transform3D previousPositionMatrix = mHistory.rbegin()->second;
-	double deltaT = timestamp - mHistory.rbegin()->first; //time from previous measured position to this position
-	int numberOfInterpolationPoints = floor( (timestamp - mResampled.rbegin()->first)/1000 * mResampleFrequency ); // interpolate from last resampled position to current measured position
-	Transform3D interpolatedPosition;
-	Transform3D filteredPosition;
+	double deltaT = timestamp - mLastTimestamp; //time from previous measured position to this position
+	int numberOfInterpolationPoints = floor( (timestamp - mLastResampledTimestamp)/1000 * mResampleFrequency ); // interpolate from last resampled position to current measured position
+	if (numberOfInterpolationPoints <= 0)
+		return;
+
+	Eigen::Quaterniond rotation(pos.linear());
+	Vector3D previousTranslation = mLastPosition.translation();
+	Vector3D translation = pos.translation();
+
 	for (int i=0; i < numberOfInterpolationPoints; i++)
 	{
-		double resampledTimestamp = mResampled.rbegin()->first + 1000/mResampleFrequency;
-		double deltaTpast = resampledTimestamp - mHistory.rbegin()->first;
-		double deltaTfuture = timestamp - resampledTimestamp;
-		interpolatedPosition = pos.matrix() * deltaTpast/deltaT + previousPositionMatrix.matrix() * deltaTfuture/deltaT; // linear interpolation between previous and current measured position
-		mResampled[resampledTimestamp] = interpolatedPosition;
-
-		filteredPosition = interpolatedPosition;
-		filteredPosition(0,3) = fx.filter(interpolatedPosition(0,3));
-		filteredPosition(1,3) = fy.filter(interpolatedPosition(1,3));
-		filteredPosition(2,3) = fz.filter(interpolatedPosition(2,3));
-		mFiltered[resampledTimestamp] = filteredPosition;
+		double resampledTimestamp = mLastResampledTimestamp + 1000/mResampleFrequency;
+		double t = (deltaT > 0) ? (resampledTimestamp - mLastTimestamp)/deltaT : 1.0; // fraction of the way from previous to current measured position
+		Vector3D interpolatedTranslation = translation * t + previousTranslation * (1.0-t);
+		Eigen::Quaterniond interpolatedRotation = mLastRotation.slerp(t, rotation);
+
+		mFiltered = this->filter(interpolatedTranslation, interpolatedRotation);
+		++mFilteredCount;
+		mLastResampledTimestamp = resampledTimestamp;
 	}
 }
 
+Transform3D TrackingPositionFilter::filter(const Vector3D& translation, Eigen::Quaterniond rotation)
+{
+	// q and -q are the same rotation: keep the filter input continuous
+	if (rotation.dot(mLastFilterInput) < 0)
+		rotation.coeffs() = -rotation.coeffs();
+	mLastFilterInput = rotation;
+
+	Eigen::Quaterniond filteredRotation(mRotationFilter[0].filter(rotation.w()),
+										mRotationFilter[1].filter(rotation.x()),
+										mRotationFilter[2].filter(rotation.y()),
+										mRotationFilter[3].filter(rotation.z()));
+	if (filteredRotation.norm() > 1.0E-6)
+		filteredRotation.normalize();
+	else
+		filteredRotation = rotation;
+
+	Transform3D retval = Transform3D::Identity();
+	retval.linear() = filteredRotation.toRotationMatrix();
+	for (int i=0; i<3; ++i)
+		retval(i,3) = mTranslationFilter[i].filter(translation[i]);
+	return retval;
+}
+
 void TrackingPositionFilter::reset()
 {
-	mHistory.clear();
-	mResampled.clear();
-	mFiltered.clear();
-
-	fx.setup (mFilterOrder, mResampleFrequency, mCutOffFrequency);  // Lag perker isteden
-	fx.reset ();
-	fy.setup (mFilterOrder, mResampleFrequency, mCutOffFrequency);
-	fy.reset ();
-	fz.setup (mFilterOrder, mResampleFrequency, mCutOffFrequency);
-	fz.reset ();
+	mHasSample = false;
+	mLastPosition = Transform3D::Identity();
+	mLastRotation = Eigen::Quaterniond::Identity();
+	mLastTimestamp = 0;
+	mLastResampledTimestamp = 0;
+	mLastFilterInput = Eigen::Quaterniond::Identity();
+	mFiltered = Transform3D::Identity();
+	mFilteredCount = 0;
+
+	for (int i=0; i<3; ++i)
+	{
+		mTranslationFilter[i].setup(mFilterOrder, mResampleFrequency, mCutOffFrequency);
+		mTranslationFilter[i].reset();
+	}
+	for (int i=0; i<4; ++i)
+	{
+		mRotationFilter[i].setup(mFilterOrder, mResampleFrequency, mCutOffFrequency);
+		mRotationFilter[i].reset();
+	}
 }
 
 
@@ -14,7 +14,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxResourceExport.h"
 
 #include "cxTransform3D.h"
-#include <map>
+#include <Eigen/Geometry>
 #include <boost/shared_ptr.hpp>
 #include "iir/Butterworth.h"
 
@@ -23,6 +23,14 @@ namespace cx
 
 /** Applies a smoothing filter to tracking positions.
  *
+ * Incoming positions are resampled at a fixed rate by interpolating
+ * between consecutive samples (linear for translation, slerp for rotation),
+ * then low pass filtered. The translation is filtered per component,
+ * the orientation is filtered in the quaternion domain and renormalized.
+ *
+ * Only the latest sample and the filter states are kept, thus memory
+ * is constant and addPosition() does no heap allocation, regardless of
+ * how long the filter runs.
  *
  * \ingroup cx_resource_core_tool
  * \date 2014-03-06
@@ -37,19 +45,26 @@ public:
 	Transform3D getFilteredPosition();	
 
 private:
-	std::map<double, Transform3D> mHistory;
-	std::map<double, Transform3D> mResampled;
-	std::map<double, Transform3D> mFiltered;
-	void clearIfTimestampIsOlderThanHead(Transform3D pos, double timestamp);
-	void clearIfJumpInTimestamps(Transform3D pos, double timestamp);
+	void clearIfTimestampIsOlderThanHead(double timestamp);
+	void clearIfJumpInTimestamps(double timestamp);
 	void interpolateAndFilterPositions(Transform3D pos, double timestamp);
+	Transform3D filter(const Vector3D& translation, Eigen::Quaterniond rotation);
 	void reset();
+
+	bool mHasSample;
+	Transform3D mLastPosition; ///< latest input position
+	Eigen::Quaterniond mLastRotation; ///< rotation part of mLastPosition
+	double mLastTimestamp; ///< timestamp of latest input position
+	double mLastResampledTimestamp;
+	Eigen::Quaterniond mLastFilterInput; ///< used to keep the quaternion sign continuous
+	Transform3D mFiltered; ///< latest filtered position
+	int mFilteredCount; ///< number of filtered positions since reset
+
 	float mCutOffFrequency;
 	float mResampleFrequency;
 	static const int mFilterOrder = 2;
-	Iir::Butterworth::LowPass<mFilterOrder> fx;
-	Iir::Butterworth::LowPass<mFilterOrder> fy;
-	Iir::Butterworth::LowPass<mFilterOrder> fz;
+	Iir::Butterworth::LowPass<mFilterOrder> mTranslationFilter[3];
+	Iir::Butterworth::LowPass<mFilterOrder> mRotationFilter[4]; ///< quaternion w,x,y,z
 };
 typedef boost::shared_ptr<TrackingPositionFilter> TrackingPositionFilterPtr;
 
@@ -20,13 +20,15 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxLogger.h"
 #include "cxVolumeHelpers.h"
 #include "cxTypeConversions.h"
+#include "cxVideoStageTelemetry.h"
 
 
 namespace cx
 {
 
 BasicVideoSource::BasicVideoSource(QString uid) :
-	mStreaming(false)
+	mStreaming(false),
+	mTelemetry(VideoStageTelemetry::create(QString("BasicVideoSource %1").arg(uid)))
 {
 	mStatus = "USE_DEFAULT";
 	mRedirecter = vtkSmartPointer<vtkImageChangeInformation>::New(); // used for forwarding only.
@@ -175,6 +177,7 @@ void BasicVideoSource::setInput(ImagePtr input)
 	if (input)
 	{
 		mReceivedImage = input;
+		mTelemetry->frameReceived(QDateTime::currentMSecsSinceEpoch() - input->getAcquisitionTime().toMSecsSinceEpoch());
 	}
 	else
 	{
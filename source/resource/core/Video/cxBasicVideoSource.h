@@ -29,6 +29,7 @@ typedef vtkSmartPointer<class vtkImageChangeInformation> vtkImageChangeInformati
 
 namespace cx
 {
+typedef boost::shared_ptr<class VideoStageTelemetry> VideoStageTelemetryPtr;
 
 /**
  * \brief VideoSource controlled by a vtkImageData
@@ -37,6 +38,10 @@ namespace cx
  * Use the interface extensions to control the input:
  * Set a vtkImageData and
  *
+ * The telemetry records the end-to-end latency of each input, i.e. the
+ * time from acquisition to setInput(). Inputs are forwarded synchronously
+ * through newFrame(), thus none are dropped in this stage.
+ *
  * \ingroup cx_resource_core_video
  * \date April 26, 2013
  * \author Christian Askeland, SINTEF
@@ -87,6 +92,7 @@ public:
 	  * instead set timeout directly.
 	  */
 	void overrideTimeout(bool timeout);
+	VideoStageTelemetryPtr getTelemetry() { return mTelemetry; }
 
 private slots:
 	void timeout();
@@ -97,6 +103,7 @@ private:
 
 	ImagePtr mEmptyImage;
 	ImagePtr mReceivedImage;
+	VideoStageTelemetryPtr mTelemetry;
 	vtkImageChangeInformationPtr mRedirecter;
 	bool mTimeout;
 	QTimer* mTimeoutTimer;
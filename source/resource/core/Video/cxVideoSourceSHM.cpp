@@ -37,6 +37,9 @@ VideoSourceSHM::VideoSourceSHM(int width, int height, int depth)
 	mConnected = false;
 	mStreaming = false;
 
+	mUseRing = false;
+	mRingNotifier = new SharedMemoryRingNotifier(this);
+
 	mPollTimer = new QTimer(this);
 	mPollTimer->setInterval(40);	// Polling interval (currently set @ 25 fps)
 	mTimeStamp = 0;
@@ -53,6 +56,8 @@ VideoSourceSHM::~VideoSourceSHM()
 
 QString VideoSourceSHM::getUid()
 {
+	if (mUseRing)
+		return mRing.key();
 	return mSource.key();
 }
 
@@ -68,7 +73,7 @@ vtkImageDataPtr VideoSourceSHM::getVtkImageData()
 
 double VideoSourceSHM::getTimestamp()
 {
-	return (double) mSource.timestamp().toMSecsSinceEpoch();
+	return mTimeStamp;
 }
 
 /// Returns a short info message
@@ -93,7 +98,10 @@ void VideoSourceSHM::start()
 	mStartWhenConnected = false;
 	if (!mStreaming)
 	{
-		mPollTimer->start();
+		if (mUseRing)
+			mRingNotifier->start();
+		else
+			mPollTimer->start();
 		// If all is well - tell the system we're streaming
 		mStreaming = true;
 
@@ -106,6 +114,7 @@ void VideoSourceSHM::stop()
 	mStartWhenConnected = false;
 	if (mStreaming)
 	{
+		mRingNotifier->stop();
 		mPollTimer->stop();
 		// If all is well - tell the system we've stopped streaming
 		mStreaming = false;
@@ -137,11 +146,17 @@ bool VideoSourceSHM::isStreaming() const
  */
 void VideoSourceSHM::update()
 {
+	if (mUseRing)
+	{
+		this->updateFromRing();
+		return;
+	}
+
 	unsigned char* buffer = (unsigned char*) mSource.isNew(); // Fetch new data from server - NULL if no new data present
 	if (!buffer)
 		return;
 
-	mTimeStamp = mSource.timestamp().currentMSecsSinceEpoch();
+	mTimeStamp = mSource.timestamp().toMSecsSinceEpoch();
 
 	int numChannels = mImageColorDepth/sizeof(uchar);
 	Q_UNUSED(numChannels);
@@ -156,17 +171,49 @@ void VideoSourceSHM::update()
 	emit newFrame();
 }
 
+/**
+ * Copy the newest frame from the ring, and set up the import from its metadata.
+ * mRingFrame only changes when a frame is read, thus the import never sees a partial copy.
+ */
+void VideoSourceSHM::updateFromRing()
+{
+	SharedMemoryFrameInfo info;
+	if (!mRing.readLatest(&info, &mRingFrame))
+		return;
+
+	mTimeStamp = info.timestamp;
+	mImageWidth = info.width;
+	mImageHeight = info.height;
+
+	mImageImport->SetDataScalarType(info.scalarType);
+	mImageImport->SetNumberOfScalarComponents(info.components);
+	mImageImport->SetDataSpacing(info.spacing);
+	mImageImport->SetWholeExtent(0, mImageWidth - 1, 0, mImageHeight - 1, 0, 0);
+	mImageImport->SetDataExtentToWholeExtent();
+
+	mImageImport->SetImportVoidPointer(mRingFrame.data());
+	mImageImport->Modified();
+	mImageImport->Update();
+	mImportInitialized = true;
+
+	emit newFrame();
+}
+
 /**
  * Connects to a shared memory server end, described by a unique key string.
  * Connects signals and slots on success.
  */
 void VideoSourceSHM::connectServer(const QString& key)
 {
-	mConnected = mSource.attach(key);
+	mUseRing = mRing.attach(key) && mRingNotifier->attach(key);
+	mConnected = mUseRing || mSource.attach(key);
 
 	if (mConnected)
 	{
-		connect(mPollTimer, SIGNAL(timeout()), this, SLOT(serverPollSlot()));
+		if (mUseRing)
+			connect(mRingNotifier, SIGNAL(frameAvailable()), this, SLOT(serverPollSlot()), Qt::QueuedConnection);
+		else
+			connect(mPollTimer, SIGNAL(timeout()), this, SLOT(serverPollSlot()));
 		serverPollSlot(); // Pull in a new frame here, even if we may no be started yet to initialize the image import
 	}
 	if (mStartWhenConnected)
@@ -185,11 +232,14 @@ void VideoSourceSHM::disconnectServer()
 
 	if (mConnected)
 	{
+		disconnect(mRingNotifier, SIGNAL(frameAvailable()), this, SLOT(serverPollSlot()));
 		disconnect(mPollTimer, SIGNAL(timeout()), this, SLOT(serverPollSlot()));
 		mSource.release();
 	}
 
+	mRing.detach();
 	mSource.detach();
+	mUseRing = false;
 	mConnected = false;
 }
 
@@ -34,6 +34,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxVideoSource.h"
 #include "cxSharedMemory.h"
+#include "cxSharedMemoryRing.h"
 
 typedef vtkSmartPointer<class vtkImageImport> vtkImageImportPtr;
 
@@ -47,6 +48,10 @@ namespace cx
  *
  * Contains data assosiated with a shared memory video stream
  *
+ * If the server is a SharedMemoryRingServer, frames are received as soon
+ * as they are published, with the size, spacing, format and acquisition
+ * time given by the server. Otherwise the server is polled at 25 fps.
+ *
  * \ingroup cx_resource_core_video
  */
 class cxResource_EXPORT VideoSourceSHM : public VideoSource
@@ -91,7 +96,13 @@ protected:
 
 private:
 
+	void updateFromRing();
+
 	SharedMemoryClient mSource;
+	SharedMemoryRingClient mRing;
+	SharedMemoryRingNotifier* mRingNotifier;
+	std::vector<unsigned char> mRingFrame;
+	bool mUseRing;
 
 	vtkImageDataPtr mImageData;
 	vtkImageImportPtr mImageImport;
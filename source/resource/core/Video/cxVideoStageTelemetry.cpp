@@ -0,0 +1,183 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxVideoStageTelemetry.h"
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <QElapsedTimer>
+#include <boost/weak_ptr.hpp>
+#include "cxLogger.h"
+
+namespace cx
+{
+
+namespace
+{
+QMutex gStagesMutex;
+std::vector<boost::weak_ptr<VideoStageTelemetry> > gStages;
+
+const double gBinEdges[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, std::numeric_limits<double>::infinity() };
+const int gNumberOfBins = sizeof(gBinEdges)/sizeof(gBinEdges[0]);
+
+/** Upper edge of the bin containing the given fraction of the frames.
+ */
+double findPercentile(const std::vector<qint64>& histogram, qint64 count, double fraction, double maxAge)
+{
+	qint64 target = qint64(std::ceil(count*fraction));
+	qint64 sum = 0;
+	for (int i=0; i<gNumberOfBins; ++i)
+	{
+		sum += histogram[i];
+		if (sum >= target)
+			return std::min(gBinEdges[i], maxAge);
+	}
+	return maxAge;
+}
+}
+
+VideoStageStatistics::VideoStageStatistics() :
+	mReceived(0),
+	mDropped(0),
+	mMeanAge(0),
+	mMedianAge(0),
+	mP95Age(0),
+	mMaxAge(0)
+{
+}
+
+QString VideoStageStatistics::toString() const
+{
+	return QString("%1: received %2, dropped %3, age mean %4 ms, median <%5 ms, p95 <%6 ms, max %7 ms")
+			.arg(mName)
+			.arg(mReceived)
+			.arg(mDropped)
+			.arg(mMeanAge, 0, 'f', 1)
+			.arg(mMedianAge, 0, 'f', 0)
+			.arg(mP95Age, 0, 'f', 0)
+			.arg(mMaxAge, 0, 'f', 1);
+}
+
+VideoStageTelemetryPtr VideoStageTelemetry::create(QString name)
+{
+	VideoStageTelemetryPtr retval(new VideoStageTelemetry(name));
+
+	QMutexLocker sentry(&gStagesMutex);
+	gStages.push_back(retval);
+	return retval;
+}
+
+std::vector<VideoStageStatistics> VideoStageTelemetry::getAllStatistics()
+{
+	std::vector<VideoStageTelemetryPtr> stages;
+	{
+		QMutexLocker sentry(&gStagesMutex);
+		for (unsigned i=0; i<gStages.size(); ++i)
+			if (VideoStageTelemetryPtr stage = gStages[i].lock())
+				stages.push_back(stage);
+	}
+
+	std::vector<VideoStageStatistics> retval;
+	for (unsigned i=0; i<stages.size(); ++i)
+		retval.push_back(stages[i]->getStatistics());
+	return retval;
+}
+
+double VideoStageTelemetry::now()
+{
+	static QElapsedTimer timer;
+	static QMutex mutex;
+	QMutexLocker sentry(&mutex);
+	if (!timer.isValid())
+		timer.start();
+	return timer.nsecsElapsed() / 1.0E6;
+}
+
+std::vector<double> VideoStageTelemetry::getBinEdges()
+{
+	return std::vector<double>(gBinEdges, gBinEdges+gNumberOfBins);
+}
+
+VideoStageTelemetry::VideoStageTelemetry(QString name) :
+	mName(name),
+	mLogInterval(10000),
+	mLastLogTime(now())
+{
+	this->reset();
+}
+
+VideoStageTelemetry::~VideoStageTelemetry()
+{
+	QMutexLocker sentry(&gStagesMutex);
+	for (unsigned i=0; i<gStages.size(); )
+	{
+		if (gStages[i].expired())
+			gStages.erase(gStages.begin()+i);
+		else
+			++i;
+	}
+}
+
+void VideoStageTelemetry::frameReceived(double ageMs)
+{
+	ageMs = std::max(ageMs, 0.0);
+	double time = now();
+
+	QMutexLocker sentry(&mMutex);
+	++mReceived;
+	mAgeSum += ageMs;
+	mMaxAge = std::max(mMaxAge, ageMs);
+	++mAgeHistogram[std::upper_bound(gBinEdges, gBinEdges+gNumberOfBins-1, ageMs) - gBinEdges];
+
+	if ((mLogInterval <= 0) || (time - mLastLogTime < mLogInterval))
+		return;
+	mLastLogTime = time;
+	sentry.unlock();
+
+	CX_LOG_INFO() << this->getStatistics().toString();
+}
+
+void VideoStageTelemetry::frameDropped(int count)
+{
+	QMutexLocker sentry(&mMutex);
+	mDropped += count;
+}
+
+VideoStageStatistics VideoStageTelemetry::getStatistics() const
+{
+	QMutexLocker sentry(&mMutex);
+	VideoStageStatistics retval;
+	retval.mName = mName;
+	retval.mReceived = mReceived;
+	retval.mDropped = mDropped;
+	retval.mMaxAge = mMaxAge;
+	retval.mAgeHistogram = mAgeHistogram;
+	if (mReceived)
+	{
+		retval.mMeanAge = mAgeSum / mReceived;
+		retval.mMedianAge = findPercentile(mAgeHistogram, mReceived, 0.5, mMaxAge);
+		retval.mP95Age = findPercentile(mAgeHistogram, mReceived, 0.95, mMaxAge);
+	}
+	return retval;
+}
+
+void VideoStageTelemetry::reset()
+{
+	QMutexLocker sentry(&mMutex);
+	mReceived = 0;
+	mDropped = 0;
+	mAgeSum = 0;
+	mMaxAge = 0;
+	mAgeHistogram.assign(gNumberOfBins, 0);
+}
+
+} // namespace cx
@@ -0,0 +1,90 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXVIDEOSTAGETELEMETRY_H
+#define CXVIDEOSTAGETELEMETRY_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <QString>
+#include <QMutex>
+#include <boost/shared_ptr.hpp>
+
+namespace cx
+{
+typedef boost::shared_ptr<class VideoStageTelemetry> VideoStageTelemetryPtr;
+
+/** Counters for one stage of the video pipeline, see VideoStageTelemetry.
+ *
+ * \ingroup cx_resource_core_video
+ */
+struct cxResource_EXPORT VideoStageStatistics
+{
+	VideoStageStatistics();
+	QString mName;
+	qint64 mReceived; ///< frames passed on by the stage
+	qint64 mDropped; ///< frames lost in the stage
+	double mMeanAge; ///< ms
+	double mMedianAge; ///< ms, upper edge of the histogram bin
+	double mP95Age; ///< ms, upper edge of the histogram bin
+	double mMaxAge; ///< ms
+	std::vector<qint64> mAgeHistogram; ///< frame count per bin, see VideoStageTelemetry::getBinEdges()
+
+	QString toString() const;
+};
+
+/** \brief Frame counters and queue age histogram for one stage of the video pipeline.
+ *
+ * Each stage on the path from the grabber to the consumers (sender,
+ * receiver thread, video source, recorder) owns one of these, and
+ * records each frame passed on together with its age, i.e. the time
+ * the frame waited in that stage, and each frame lost in the stage.
+ *
+ * All live stages are listed by getAllStatistics(), and each stage logs
+ * its statistics at a fixed interval while it receives frames.
+ *
+ * Thread-safe.
+ *
+ * \ingroup cx_resource_core_video
+ */
+class cxResource_EXPORT VideoStageTelemetry
+{
+public:
+	static VideoStageTelemetryPtr create(QString name);
+	static std::vector<VideoStageStatistics> getAllStatistics(); ///< statistics of all live stages
+	static double now(); ///< monotonic time in ms, use for ages
+	static std::vector<double> getBinEdges(); ///< upper edge of each histogram bin in ms, the last is infinite
+	~VideoStageTelemetry();
+
+	void frameReceived(double ageMs);
+	void frameDropped(int count = 1);
+	VideoStageStatistics getStatistics() const;
+	void reset();
+	void setLogInterval(int milliseconds) { mLogInterval = milliseconds; } ///< 0 disables logging
+	QString getName() const { return mName; }
+
+private:
+	explicit VideoStageTelemetry(QString name);
+	QString mName;
+	mutable QMutex mMutex;
+	qint64 mReceived;
+	qint64 mDropped;
+	double mAgeSum;
+	double mMaxAge;
+	std::vector<qint64> mAgeHistogram;
+	int mLogInterval;
+	double mLastLogTime;
+};
+
+} // namespace cx
+
+#endif // CXVIDEOSTAGETELEMETRY_H
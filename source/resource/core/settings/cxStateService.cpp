@@ -77,9 +77,12 @@ void StateService::fillDefaultSettings()
 	this->fillDefault("backgroundColor", QColor(30,60,70)); // a dark, grey-blue hue
 	this->fillDefault("vlcPath", vlc()->getVLCPath());
 	this->fillDefault("globalPatientNumber", 1);
+	this->fillDefault("compressMetaImages", false);
 	this->fillDefault("Ultrasound/acquisitionName", "US-Acq");
 	this->fillDefault("Ultrasound/8bitAcquisitionData", false);
 	this->fillDefault("Ultrasound/CompressAcquisition", true);
+	this->fillDefault("Ultrasound/recordingQueueSize", 256);
+	this->fillDefault("Ultrasound/recordingQueuePolicy", "spill");
 	this->fillDefault("View3D/sphereRadius", 1.0);
 	this->fillDefault("View3D/labelSize", 2.5);
 	this->fillDefault("Navigation/anyplaneViewOffset", 0.25);
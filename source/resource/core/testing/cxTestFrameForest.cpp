@@ -11,7 +11,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "catch.hpp"
 #include "cxFrameForest.h"
-#include <QDomNode>
+#include <QDomDocument>
 #include "cxImage.h"
 #include "cxRegistrationTransform.h"
 #include "cxLogger.h"
@@ -93,12 +93,12 @@ TEST_CASE("FrameForest: Add data", "[unit]")
 	CHECK_FALSE(document.isNull());
 }
 
-//All images with cyclic graps are missing the the forest
+//The cycles are broken, keeping all images in the forest
 TEST_CASE("FrameForest: Add cyclic parent graph", "[unit]")
 {
 	std::map<QString, cx::DataPtr> source = getDataMap(true);
 	cx::FrameForest forest(source);
-//	findDataInForest(forest);//Will fail for all data
+	findDataInForest(forest);
 	QDomDocument document = forest.getDocument();
 	CHECK_FALSE(document.isNull());
 }
@@ -108,14 +108,14 @@ TEST_CASE("FrameForest: Get ancestors", "[unit]")
 	std::map<QString, cx::DataPtr> source = getDataMap(false);
 	cx::FrameForest forest(source);
 
-	QDomNode node0 = forest.getNode(getUid(0));
-	QDomNode node1 = forest.getNode(getUid(1));
-	QDomNode node2 = forest.getNode(getUid(2));
+	QString node0 = forest.getNode(getUid(0));
+	QString node1 = forest.getNode(getUid(1));
+	QString node2 = forest.getNode(getUid(2));
 	CHECK_FALSE(node0.isNull());
 	CHECK_FALSE(node1.isNull());
 	CHECK_FALSE(node2.isNull());
-	QDomNode ancestorNode0 = forest.getOldestAncestor(node0);
-	QDomNode ancestorNode1 = forest.getOldestAncestor(node1);
+	QString ancestorNode0 = forest.getOldestAncestor(node0);
+	QString ancestorNode1 = forest.getOldestAncestor(node1);
 	CHECK_FALSE(ancestorNode0.isNull());
 	CHECK_FALSE(ancestorNode1.isNull());
 
@@ -129,14 +129,14 @@ TEST_CASE("FrameForest: Get ancestors from cyclic graph", "[unit]")
 	std::map<QString, cx::DataPtr> source = getDataMap(true);
 	cx::FrameForest forest(source);
 
-	QDomNode node0 = forest.getNode(getUid(0));
-	QDomNode node1 = forest.getNode(getUid(1));
-	QDomNode node2 = forest.getNode(getUid(2));
+	QString node0 = forest.getNode(getUid(0));
+	QString node1 = forest.getNode(getUid(1));
+	QString node2 = forest.getNode(getUid(2));
 //	CHECK_FALSE(node0.isNull());
 //	CHECK_FALSE(node1.isNull());
 //	CHECK_FALSE(node2.isNull());
-	QDomNode ancestorNode0 = forest.getOldestAncestor(node0);
-	QDomNode ancestorNode1 = forest.getOldestAncestor(node1);
+	QString ancestorNode0 = forest.getOldestAncestor(node0);
+	QString ancestorNode1 = forest.getOldestAncestor(node1);
 //	CHECK_FALSE(ancestorNode0.isNull());
 //	CHECK_FALSE(ancestorNode1.isNull());
 
@@ -154,9 +154,9 @@ TEST_CASE("FrameForest: Get decendant lists", "[unit]")
 	std::map<QString, cx::DataPtr> source = getDataMap(false);
 	cx::FrameForest forest(source);
 
-	QDomNode node1 = forest.getNode(getUid(1));
+	QString node1 = forest.getNode(getUid(1));
 
-	std::vector<QDomNode> nodes = forest.getDescendantsAndSelf(node1);
+	std::vector<QString> nodes = forest.getDescendantsAndSelf(node1);
 	std::vector<cx::DataPtr> datas = forest.getDataFromDescendantsAndSelf(node1);
 	CHECK(nodes.size() == 3);
 	CHECK(datas.size() == 3);
@@ -167,9 +167,9 @@ TEST_CASE("FrameForest: Get decendant lists from cyclic graph", "[unit]")
 	std::map<QString, cx::DataPtr> source = getDataMap(true);
 	cx::FrameForest forest(source);
 
-	QDomNode node1 = forest.getNode(getUid(1));
+	QString node1 = forest.getNode(getUid(1));
 
-	std::vector<QDomNode> nodes = forest.getDescendantsAndSelf(node1);
+	std::vector<QString> nodes = forest.getDescendantsAndSelf(node1);
 	std::vector<cx::DataPtr> datas = forest.getDataFromDescendantsAndSelf(node1);
 	//These will fail, but the infinite loops are fixed
 //	CHECK(nodes.size() == 2);
@@ -178,3 +178,40 @@ TEST_CASE("FrameForest: Get decendant lists from cyclic graph", "[unit]")
 
 	CHECK_FALSE(nodes.empty());
 }
+
+TEST_CASE("FrameForest: Frame hierarchy of many data", "[unit]")
+{
+	// DummyImage(i) has parent DummyImage(i%10), DummyImage(0..9) have parent frame(i%2)
+	std::map<QString, cx::DataPtr> source;
+	vtkImageDataPtr dummyImageData = cx::Image::createDummyImageData(2, 1);
+	for (int i=0; i<500; ++i)
+	{
+		cx::ImagePtr image(new cx::Image(getUid(i), dummyImageData));
+		if (i<10)
+			image->get_rMd_History()->setParentSpace(QString("frame%1").arg(i%2));
+		else
+			image->get_rMd_History()->setParentSpace(getUid(i%10));
+		source[image->getUid()] = image;
+	}
+
+	cx::FrameForest forest(source);
+	findDataInForest(forest, 500);
+
+	CHECK(forest.getOldestAncestor(getUid(13)) == "frame1");
+	CHECK(forest.getOldestAncestor("frame1") == "frame1");
+	CHECK(forest.getOldestAncestor("noData").isNull());
+	CHECK(forest.getOldestAncestorNotCommonToRef(getUid(13), getUid(17)) == getUid(3));
+	CHECK(forest.getOldestAncestorNotCommonToRef(getUid(13), getUid(3)) == getUid(13));
+	CHECK(forest.getOldestAncestorNotCommonToRef(getUid(3), getUid(13)).isNull());
+	CHECK(forest.getOldestAncestorNotCommonToRef(getUid(13), getUid(12)) == "frame1");
+
+	std::vector<QString> descendants = forest.getDescendantsAndSelf(getUid(7));
+	CHECK(descendants.size() == 50);
+	CHECK(descendants.front() == getUid(7));
+	CHECK(forest.getDataFromDescendantsAndSelf("frame0").size() == 250);
+	CHECK(forest.getDataFromDescendantsAndSelf("frame1").size() == 250);
+
+	QDomElement root = forest.getDocument().documentElement();
+	CHECK(root.childNodes().size() == 2);
+	CHECK(root.elementsByTagName(getUid(13)).item(0).parentNode().toElement().tagName() == getUid(3));
+}
@@ -0,0 +1,101 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include "cxKdTree.h"
+#include <limits>
+#include <random>
+
+namespace cxtest
+{
+
+namespace
+{
+std::vector<cx::Vector3D> generateRandomPoints(int count, std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> range(-50, 50);
+	std::vector<cx::Vector3D> retval(count);
+	for (unsigned i=0; i<retval.size(); ++i)
+		retval[i] = cx::Vector3D(range(rng), range(rng), range(rng));
+	return retval;
+}
+
+int findClosestPointBruteForce(const std::vector<cx::Vector3D>& points, const cx::Vector3D& p, double* distanceSquared)
+{
+	int best = -1;
+	*distanceSquared = std::numeric_limits<double>::max();
+	for (unsigned i=0; i<points.size(); ++i)
+	{
+		double d2 = (points[i]-p).squaredNorm();
+		if (d2 < *distanceSquared)
+		{
+			*distanceSquared = d2;
+			best = i;
+		}
+	}
+	return best;
+}
+}
+
+TEST_CASE("KdTree: empty tree returns no point", "[unit][resource][core]")
+{
+	cx::KdTreePtr tree = cx::KdTree::create(std::vector<cx::Vector3D>());
+	CHECK(tree->size() == 0);
+	CHECK(tree->findClosestPoint(cx::Vector3D(1,2,3)) == -1);
+}
+
+TEST_CASE("KdTree: getPoint returns input points", "[unit][resource][core]")
+{
+	std::mt19937 rng(1);
+	std::vector<cx::Vector3D> points = generateRandomPoints(100, rng);
+	cx::KdTreePtr tree = cx::KdTree::create(points);
+
+	REQUIRE(tree->size() == 100);
+	for (unsigned i=0; i<points.size(); ++i)
+		CHECK(cx::similar(tree->getPoint(i), points[i]));
+}
+
+TEST_CASE("KdTree: closest points equal brute force search", "[unit][resource][core]")
+{
+	std::mt19937 rng(2);
+	std::vector<cx::Vector3D> points = generateRandomPoints(5000, rng);
+	std::vector<cx::Vector3D> queries = generateRandomPoints(1000, rng);
+	cx::KdTreePtr tree = cx::KdTree::create(points);
+
+	std::vector<int> indices;
+	std::vector<double> distances;
+	tree->findClosestPoints(queries, &indices, &distances);
+	REQUIRE(indices.size() == queries.size());
+
+	for (unsigned i=0; i<queries.size(); ++i)
+	{
+		double expectedDistance;
+		int expected = findClosestPointBruteForce(points, queries[i], &expectedDistance);
+		CHECK(indices[i] == expected);
+		CHECK(distances[i] == Approx(expectedDistance));
+	}
+}
+
+TEST_CASE("KdTree: points in the tree are their own closest point", "[unit][resource][core]")
+{
+	std::mt19937 rng(3);
+	std::vector<cx::Vector3D> points = generateRandomPoints(1000, rng);
+	cx::KdTreePtr tree = cx::KdTree::create(points);
+
+	for (unsigned i=0; i<points.size(); ++i)
+	{
+		double distance;
+		CHECK(tree->findClosestPoint(points[i], &distance) == int(i));
+		CHECK(distance == Approx(0));
+	}
+}
+
+} // namespace cxtest
@@ -10,7 +10,16 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 =========================================================================*/
 
 #include "cxSharedMemory.h"
+#include "cxSharedMemoryRing.h"
 #include "catch.hpp"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <iostream>
+
+#ifdef CX_LINUX
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 using namespace cx;
 
@@ -41,3 +50,143 @@ TEST_CASE("SharedMemory works", "[unit][resource][core]")
 
 
 
+
+TEST_CASE("SharedMemoryRing: Frames and metadata are transferred", "[unit][resource][core]")
+{
+	SharedMemoryRingServer srv("test_ring_", 3, 100);
+	REQUIRE(srv.isValid());
+	SharedMemoryRingClient cli;
+	REQUIRE(cli.attach(srv.key()));
+	CHECK(cli.getNumberOfSlots() == 3);
+	CHECK(cli.getSlotSize() == 100);
+
+	SharedMemoryFrameInfo info;
+	std::vector<unsigned char> data;
+	CHECK_FALSE(cli.readLatest(&info, &data));
+	CHECK_FALSE(cli.waitForFrame(10));
+
+	for (int i = 0; i < 5; i++)
+	{
+		SharedMemoryFrameInfo written;
+		written.timestamp = 1000 + i;
+		written.width = 4;
+		written.height = 2;
+		written.components = 3;
+		written.spacing[0] = 0.5;
+		written.size = 24;
+		std::vector<unsigned char> frame(written.size, i);
+		REQUIRE(srv.write(frame.data(), written));
+	}
+
+	// the newest frame is read, the ones before are dropped
+	REQUIRE(cli.waitForFrame(10));
+	REQUIRE(cli.readLatest(&info, &data));
+	CHECK(info.frame == 4);
+	CHECK(info.timestamp == 1004);
+	CHECK(info.width == 4);
+	CHECK(info.height == 2);
+	CHECK(info.components == 3);
+	CHECK(info.spacing[0] == 0.5);
+	REQUIRE(data.size() == 24);
+	CHECK(data[23] == 4);
+	CHECK(cli.getDroppedFrames() == 4);
+	CHECK_FALSE(cli.readLatest(&info, &data));
+
+	std::vector<unsigned char> tooLarge(200);
+	info.size = tooLarge.size();
+	CHECK_FALSE(srv.write(tooLarge.data(), info));
+}
+
+TEST_CASE("SharedMemoryRing: Client refuses a ring with slots beyond its size", "[unit][resource][core]")
+{
+	// a header with valid magic and version, describing 4 slots of 1 MB in a 4 kB area
+	QSharedMemory buffer("test_ring_truncated_");
+	REQUIRE(buffer.create(4096));
+	quint32 *header = static_cast<quint32 *>(buffer.data());
+	std::memset(header, 0, buffer.size());
+	header[0] = 0x43585247; // magic
+	header[1] = 1; // version
+	header[2] = 4; // numSlots
+	header[3] = 1024*1024; // slotSize
+	header[4] = 128; // headerSize
+	header[5] = 1024*1024 + 128; // slotStride
+
+	SharedMemoryRingClient cli;
+	CHECK_FALSE(cli.attach(buffer.key()));
+	CHECK_FALSE(cli.isAttached());
+
+	header[2] = 0;
+	CHECK_FALSE(cli.attach(buffer.key()));
+}
+
+#ifdef CX_LINUX
+TEST_CASE("SharedMemoryRing: Stream between two processes at 60+ fps", "[integration][resource][core]")
+{
+	QString key = QString("test_ring_process_%1").arg(getpid());
+	const int frames = 240;
+	const int width = 640;
+	const int height = 480;
+
+	pid_t pid = fork();
+	REQUIRE(pid >= 0);
+	if (pid == 0)
+	{
+		// child: write frames at 120 fps, then exit without touching the test framework
+		SharedMemoryRingServer srv(key, 4, width*height*3);
+		std::vector<unsigned char> frame(width*height*3);
+		QThread::msleep(300);
+		for (int i = 0; i < frames; i++)
+		{
+			memset(frame.data(), i % 256, frame.size());
+			SharedMemoryFrameInfo info;
+			info.timestamp = QDateTime::currentMSecsSinceEpoch();
+			info.width = width;
+			info.height = height;
+			info.components = 3;
+			info.size = frame.size();
+			srv.write(frame.data(), info);
+			QThread::usleep(1000000/120);
+		}
+		QThread::msleep(300);
+		_exit(0);
+	}
+
+	SharedMemoryRingClient cli;
+	QElapsedTimer attachTimer;
+	attachTimer.start();
+	while (!cli.attach(key) && attachTimer.elapsed() < 2000)
+		QThread::msleep(5);
+	REQUIRE(cli.isAttached());
+
+	SharedMemoryFrameInfo info;
+	std::vector<unsigned char> data;
+	int received = 0;
+	int corrupt = 0;
+	double latency = 0;
+	QElapsedTimer timer;
+	qint64 lastFrameTime = 0;
+	while (cli.waitForFrame(1000))
+	{
+		if (!cli.readLatest(&info, &data))
+			continue;
+		if (received == 0)
+			timer.start();
+		lastFrameTime = timer.elapsed();
+		latency += QDateTime::currentMSecsSinceEpoch() - info.timestamp;
+		if ((data.size() != size_t(width*height*3)) || (data.back() != info.frame % 256))
+			++corrupt;
+		++received;
+	}
+	int status = 0;
+	waitpid(pid, &status, 0);
+
+	// measured between the first and last frame, excluding the writer's tail and the final timeout
+	double fps = 1000.0 * (received-1) / std::max<qint64>(1, lastFrameTime);
+	latency /= std::max(1, received);
+	// latency depends on scheduling of the two processes, thus only reported
+	std::cout << "SharedMemoryRing: received " << received << " frames at " << fps << " fps, mean latency " << latency << " ms, dropped " << cli.getDroppedFrames() << std::endl;
+	CHECK(corrupt == 0);
+	CHECK(received > frames * 0.9);
+	CHECK(fps > 60);
+}
+#endif
@@ -12,6 +12,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "catch.hpp"
 #include <vtkImageData.h>
 #include "cxImage.h"
+#include "cxUnsignedDerivedImage.h"
 #include "cxDataLocations.h"
 #include "cxImageTF3D.h"
 #include "cxTransferFunctions3DPresets.h"
@@ -272,6 +273,59 @@ TEST_CASE("Image: Initial window is kept after using UnsignedDerivedImage", "[un
 	cx::LogicManager::shutdown();
 }
 
+TEST_CASE("Image: Signed CT held by several views is converted to unsigned once", "[integration][resource][core]")
+{
+	cx::LogicManager::initialize();
+
+	vtkImageDataPtr raw = vtkImageDataPtr::New();
+	raw->SetDimensions(512, 512, 1000);
+	raw->SetSpacing(0.7, 0.7, 0.5);
+	raw->AllocateScalars(VTK_SHORT, 1);
+	short* voxels = static_cast<short*>(raw->GetScalarPointer());
+	for (vtkIdType i=0; i<raw->GetNumberOfPoints(); ++i)
+		voxels[i] = short(i%3000 - 1024);
+	qint64 convertedBytes = qint64(raw->GetNumberOfPoints()) * sizeof(unsigned short);
+
+	int conversions = cx::UnsignedDerivedImage::getNumberOfConversions();
+	qint64 allocated = cx::UnsignedDerivedImage::getAllocatedBytes();
+
+	// each view wraps the same voxels in its own image
+	std::vector<cx::ImagePtr> images;
+	std::vector<cx::ImagePtr> unsignedImages;
+	for (int i=0; i<4; ++i)
+	{
+		cx::ImagePtr image(new cx::Image(QString("ct%1").arg(i), raw));
+		image->setModality(cx::imCT);
+		images.push_back(image);
+		unsignedImages.push_back(image->getUnsigned(image));
+		unsignedImages.push_back(image->getUnsigned(image));
+	}
+
+	CHECK(cx::UnsignedDerivedImage::getNumberOfConversions() == conversions+1);
+	CHECK(cx::UnsignedDerivedImage::getAllocatedBytes() == allocated+convertedBytes);
+	vtkImageDataPtr converted = unsignedImages[0]->getBaseVtkImageData();
+	REQUIRE(converted->GetScalarType() == VTK_UNSIGNED_SHORT);
+	for (unsigned i=0; i<unsignedImages.size(); ++i)
+		CHECK(unsignedImages[i]->getBaseVtkImageData() == converted);
+	unsigned short* convertedVoxels = static_cast<unsigned short*>(converted->GetScalarPointer());
+	CHECK(convertedVoxels[0] == 0);
+	CHECK(convertedVoxels[2999] == 2999);
+
+	raw->Modified();
+	cx::ImagePtr image(new cx::Image("ct", raw));
+	image->setModality(cx::imCT);
+	cx::ImagePtr unsignedImage = image->getUnsigned(image);
+	CHECK(cx::UnsignedDerivedImage::getNumberOfConversions() == conversions+2);
+	CHECK(unsignedImage->getBaseVtkImageData() != converted);
+
+	images.clear();
+	unsignedImages.clear();
+	converted = NULL;
+	CHECK(cx::UnsignedDerivedImage::getAllocatedBytes() == allocated+convertedBytes);
+
+	cx::LogicManager::shutdown();
+}
+
 TEST_CASE("Image: Initial window from mdh file is kept after using addXml and parseXml", "[unit][resource][core]")
 {
 	cx::LogicManager::initialize();
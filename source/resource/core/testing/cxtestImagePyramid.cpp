@@ -0,0 +1,64 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <vtkImageData.h>
+#include "cxImage.h"
+#include "cxImagePyramid.h"
+#include "cxVolumeHelpers.h"
+
+namespace cxtest
+{
+
+TEST_CASE("ImagePyramid: downsample halves dimensions and keeps physical extent", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = cx::generateVtkImageDataUnsignedShort(Eigen::Array3i(10, 7, 1), cx::Vector3D(0.5, 1, 2), 100);
+	vtkImageDataPtr down = cx::ImagePyramid::downsample(data);
+
+	Eigen::Array3i dim(down->GetDimensions());
+	CHECK(dim.isApprox(Eigen::Array3i(5, 4, 1)));
+	CHECK(cx::similar(cx::Vector3D(down->GetSpacing()), cx::Vector3D(1, 2, 2)));
+	CHECK(cx::similar(cx::Vector3D(down->GetOrigin()), cx::Vector3D(0.25, 0.5, 0)));
+
+	unsigned short* ptr = static_cast<unsigned short*>(down->GetScalarPointer());
+	for (int i=0; i<down->GetNumberOfPoints(); ++i)
+		CHECK(ptr[i] == 100);
+}
+
+TEST_CASE("ImagePyramid: resample is close to budget and is cached", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = cx::generateVtkImageDataUnsignedShort(Eigen::Array3i(64, 64, 64), cx::Vector3D(1, 1, 1), 0);
+	cx::fillShortImageDataWithGradient(data, 1000);
+	cx::ImagePyramidPtr pyramid = cx::ImagePyramid::create(data);
+
+	CHECK(pyramid->resample(0) == data);
+	CHECK(pyramid->resample(1000000) == data);
+
+	vtkImageDataPtr small = pyramid->resample(10000);
+	CHECK(small->GetNumberOfPoints() < 1.2*10000);
+	CHECK(small->GetNumberOfPoints() > 10000/2);
+	CHECK(pyramid->getNumberOfComputedLevels() == 2); // refined from 32^3, 16^3 is below budget and never built
+	CHECK(pyramid->resample(10000) == small);
+}
+
+TEST_CASE("ImagePyramid: Image recreates pyramid when data are modified", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = cx::generateVtkImageDataUnsignedShort(Eigen::Array3i(32, 32, 32), cx::Vector3D(1, 1, 1), 10);
+	cx::ImagePtr image(new cx::Image("pyramid", data));
+
+	vtkImageDataPtr first = image->resample(1000);
+	CHECK(image->resample(1000) == first);
+
+	data->Modified();
+	CHECK(image->resample(1000) != first);
+}
+
+} // namespace cxtest
@@ -0,0 +1,151 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <cmath>
+#include <vtkImageData.h>
+#include <vtkImageAccumulate.h>
+#include "cxImage.h"
+#include "cxImageStatistics.h"
+#include "cxVolumeHelpers.h"
+
+namespace cxtest
+{
+
+namespace
+{
+vtkImageDataPtr createGradientImage()
+{
+	vtkImageDataPtr data = cx::generateVtkImageDataSignedShort(Eigen::Array3i(30, 20, 40), cx::Vector3D(1, 1, 1), 0);
+	short* ptr = static_cast<short*>(data->GetScalarPointer());
+	for (int i=0; i<data->GetNumberOfPoints(); ++i)
+		ptr[i] = (i*7)%500 - 100;
+	data->Modified();
+	return data;
+}
+}
+
+TEST_CASE("ImageStatistics: Range equals vtk scalar range", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = createGradientImage();
+	cx::ImageStatisticsPtr statistics = cx::ImageStatistics::compute(data);
+
+	CHECK(statistics->getMin() == Approx(data->GetScalarRange()[0]));
+	CHECK(statistics->getMax() == Approx(data->GetScalarRange()[1]));
+	CHECK(statistics->getRGBMax() == Approx(-1));
+}
+
+TEST_CASE("ImageStatistics: Histogram equals vtkImageAccumulate", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = createGradientImage();
+	cx::ImageStatisticsPtr statistics = cx::ImageStatistics::compute(data);
+
+	int min = data->GetScalarRange()[0];
+	int max = data->GetScalarRange()[1];
+	vtkImageAccumulatePtr accumulate = vtkImageAccumulatePtr::New();
+	accumulate->SetInputData(data);
+	accumulate->IgnoreZeroOn();
+	accumulate->SetComponentExtent(0, max-min, 0, 0, 0, 0);
+	accumulate->SetComponentOrigin(min, 0, 0);
+	accumulate->SetComponentSpacing(1, 0, 0);
+	accumulate->Update();
+
+	REQUIRE(statistics->getHistogramOrigin() == min);
+	REQUIRE(int(statistics->getHistogram().size()) == max-min+1);
+	for (int i=min; i<=max; ++i)
+	{
+		int expected = static_cast<int*>(accumulate->GetOutput()->GetScalarPointer(i-min, 0, 0))[0];
+		CHECK(statistics->getHistogramCount(i) == expected);
+	}
+}
+
+TEST_CASE("ImageStatistics: Percentiles of uniform data", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = cx::generateVtkImageDataUnsignedShort(Eigen::Array3i(100, 10, 10), cx::Vector3D(1, 1, 1), 0);
+	unsigned short* ptr = static_cast<unsigned short*>(data->GetScalarPointer());
+	for (int i=0; i<data->GetNumberOfPoints(); ++i)
+		ptr[i] = i%100 + 1;
+	data->Modified();
+
+	cx::ImageStatisticsPtr statistics = cx::ImageStatistics::compute(data);
+	CHECK(statistics->getPercentile(0.0) == Approx(1));
+	CHECK(statistics->getPercentile(0.5) == Approx(50));
+	CHECK(statistics->getPercentile(0.9) == Approx(90));
+	CHECK(statistics->getPercentile(1.0) == Approx(100));
+}
+
+TEST_CASE("ImageStatistics: Wide int range gives a capped histogram", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = vtkImageDataPtr::New();
+	data->SetDimensions(100, 10, 10);
+	data->AllocateScalars(VTK_INT, 1);
+	int* ptr = static_cast<int*>(data->GetScalarPointer());
+	for (int i=0; i<data->GetNumberOfPoints(); ++i)
+		ptr[i] = i*100000 - 50000000;
+	data->Modified();
+
+	cx::ImageStatisticsPtr statistics = cx::ImageStatistics::compute(data);
+	CHECK(statistics->getMin() == Approx(-50000000));
+	CHECK(statistics->getMax() == Approx(49900000));
+
+	const std::vector<int>& histogram = statistics->getHistogram();
+	REQUIRE(int(histogram.size()) == cx::ImageStatistics::getMaxHistogramSize());
+	CHECK(statistics->getHistogramOrigin() == Approx(-50000000));
+	CHECK(statistics->getHistogramBinWidth() == Approx(99900000.0/histogram.size()));
+
+	long long total = 0;
+	for (unsigned i=0; i<histogram.size(); ++i)
+		total += histogram[i];
+	CHECK(total == data->GetNumberOfPoints()-1); // zero is ignored
+	CHECK(statistics->getHistogramCount(statistics->getMax()) == 1);
+	CHECK(statistics->getHistogramCount(0) == 0);
+	CHECK(std::fabs(statistics->getPercentile(0.5)) < 200000);
+}
+
+TEST_CASE("ImageStatistics: Double range beyond int does not overflow", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = cx::generateVtkImageDataDouble(Eigen::Array3i(10, 10, 10), cx::Vector3D(1, 1, 1), 0);
+	double* ptr = static_cast<double*>(data->GetScalarPointer());
+	for (int i=0; i<data->GetNumberOfPoints(); ++i)
+		ptr[i] = (i-500) * 1.0E10;
+	data->Modified();
+
+	cx::ImageStatisticsPtr statistics = cx::ImageStatistics::compute(data);
+	CHECK(statistics->getMin() == Approx(-5.0E12));
+	CHECK(statistics->getMax() == Approx(4.99E12));
+	REQUIRE(int(statistics->getHistogram().size()) == cx::ImageStatistics::getMaxHistogramSize());
+	CHECK(statistics->getHistogramCount(statistics->getMin()) == 1);
+	CHECK(statistics->getHistogramCount(statistics->getMax()) == 1);
+	CHECK(statistics->getPercentile(1.0) <= statistics->getMax());
+	CHECK(statistics->getPercentile(1.0) > statistics->getMax() - 2*statistics->getHistogramBinWidth());
+}
+
+TEST_CASE("ImageStatistics: Image caches statistics until data are modified", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = createGradientImage();
+	cx::ImagePtr image(new cx::Image("statistics", data));
+
+	cx::ImageStatisticsPtr first = image->getStatistics();
+	CHECK(image->getStatistics() == first);
+	CHECK(image->getMin() == -100);
+	CHECK(image->getMax() == 399);
+
+	short* ptr = static_cast<short*>(data->GetScalarPointer());
+	ptr[0] = 1000;
+	data->Modified();
+
+	cx::ImageStatisticsPtr second = image->getStatistics();
+	CHECK(second != first);
+	CHECK(image->getMax() == 1000);
+	CHECK(cx::calculateNumVoxelsWithMaxValue(image) == 1);
+}
+
+} // namespace cxtest
@@ -0,0 +1,90 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <vtkPolyData.h>
+#include <vtkPointData.h>
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkSphereSource.h>
+#include "cxMesh.h"
+#include "cxMeshPlaneIntersection.h"
+#include "cxTransform3D.h"
+#include "cxVector3D.h"
+
+namespace cxtest
+{
+
+namespace
+{
+cx::MeshPtr createSphereMesh()
+{
+	vtkSphereSourcePtr source = vtkSphereSourcePtr::New();
+	source->SetRadius(10);
+	source->SetThetaResolution(64);
+	source->SetPhiResolution(64);
+	source->SetOutputPointsPrecision(vtkAlgorithm::DOUBLE_PRECISION);
+	source->Update();
+	return cx::MeshPtr(new cx::Mesh("sphere", "sphere", source->GetOutput()));
+}
+}
+
+TEST_CASE("Mesh: Transformed polydata shares topology and attributes", "[unit][resource][core]")
+{
+	cx::MeshPtr mesh = createSphereMesh();
+	vtkPolyDataPtr original = mesh->getVtkPolyData();
+	cx::Transform3D transform = cx::createTransformTranslate(cx::Vector3D(5, -3, 2)) * cx::createTransformRotateZ(0.3);
+
+	vtkPolyDataPtr poly = mesh->getTransformedPolyData(transform);
+	REQUIRE(poly->GetNumberOfPoints() == original->GetNumberOfPoints());
+	CHECK(poly->GetPolys() == original->GetPolys());
+	CHECK(poly->GetPointData()->GetNormals() == original->GetPointData()->GetNormals());
+	CHECK(poly->GetPoints() != original->GetPoints());
+	CHECK(poly->GetPoints()->GetDataType() == VTK_FLOAT);
+
+	vtkPolyDataPtr copy = mesh->getTransformedPolyDataCopy(transform);
+	REQUIRE(copy->GetNumberOfPoints() == original->GetNumberOfPoints());
+	CHECK(copy->GetPolys() != original->GetPolys());
+	for (int i=0; i<original->GetNumberOfPoints(); i+=97)
+	{
+		cx::Vector3D expected = transform.coord(cx::Vector3D(original->GetPoint(i)));
+		CHECK(cx::similar(cx::Vector3D(poly->GetPoint(i)), expected, 1.0E-4));
+		CHECK(cx::similar(cx::Vector3D(copy->GetPoint(i)), expected, 1.0E-4));
+	}
+
+	// the original is untouched
+	CHECK(cx::similar(cx::Vector3D(original->GetPoint(0)), cx::Vector3D(0, 0, 10)));
+}
+
+TEST_CASE("Mesh: Identity transformed polydata shares the points", "[unit][resource][core]")
+{
+	cx::MeshPtr mesh = createSphereMesh();
+	vtkPolyDataPtr original = mesh->getVtkPolyData();
+
+	vtkPolyDataPtr poly = mesh->getTransformedPolyData(cx::Transform3D::Identity());
+	CHECK(poly != original);
+	CHECK(poly->GetPoints() == original->GetPoints());
+	CHECK(poly->GetPolys() == original->GetPolys());
+}
+
+TEST_CASE("Mesh: Plane intersection is shared and follows the polydata", "[unit][resource][core]")
+{
+	cx::MeshPtr mesh = createSphereMesh();
+	cx::MeshPlaneIntersectionPtr intersection = mesh->getPlaneIntersection();
+	REQUIRE(intersection);
+	CHECK(mesh->getPlaneIntersection() == intersection);
+	CHECK(intersection->getPolyData() == mesh->getVtkPolyData());
+
+	cx::MeshPtr lines(new cx::Mesh("lines", "lines", vtkPolyDataPtr::New()));
+	CHECK(!lines->getPlaneIntersection());
+}
+
+} // namespace cxtest
@@ -0,0 +1,105 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <QDir>
+#include <QFile>
+#include <vtkPolyData.h>
+#include <vtkPointData.h>
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkSphereSource.h>
+#include "cxMeshIO.h"
+#include "cxDataLocations.h"
+#include "cxVector3D.h"
+
+namespace cxtest
+{
+
+namespace
+{
+QString createSaveFolder(QString name)
+{
+	QString folder = cx::DataLocations::getTestDataPath() + "/temp/MeshIO/" + name;
+	QDir(folder).removeRecursively();
+	QDir().mkpath(folder);
+	return folder;
+}
+
+vtkPolyDataPtr createSphere()
+{
+	vtkSphereSourcePtr source = vtkSphereSourcePtr::New();
+	source->SetRadius(10);
+	source->SetThetaResolution(60);
+	source->SetPhiResolution(60);
+	source->Update();
+	return source->GetOutput();
+}
+}
+
+TEST_CASE("MeshIO: Binary roundtrip keeps points, cells and normals", "[unit][resource][core]")
+{
+	QString filename = createSaveFolder("roundtrip") + "/sphere.vtp";
+	vtkPolyDataPtr sphere = createSphere();
+	REQUIRE(sphere->GetPointData()->GetNormals());
+
+	REQUIRE(cx::MeshIO().write(sphere, filename));
+	CHECK(sphere->GetPointData()->GetNormals()); // input is unchanged
+
+	vtkPolyDataPtr read = cx::MeshIO().read(filename);
+	REQUIRE(read);
+	REQUIRE(read->GetNumberOfPoints() == sphere->GetNumberOfPoints());
+	CHECK(read->GetPolys()->GetNumberOfCells() == sphere->GetPolys()->GetNumberOfCells());
+	CHECK(read->GetPointData()->GetNumberOfArrays() == sphere->GetPointData()->GetNumberOfArrays());
+
+	vtkDataArray* normals = read->GetPointData()->GetNormals();
+	REQUIRE(normals);
+	CHECK(QString(normals->GetName()) == QString(sphere->GetPointData()->GetNormals()->GetName()));
+
+	double maxPointError = 0;
+	double maxNormalError = 0;
+	for (vtkIdType i=0; i<read->GetNumberOfPoints(); ++i)
+	{
+		maxPointError = std::max(maxPointError, (cx::Vector3D(read->GetPoint(i)) - cx::Vector3D(sphere->GetPoint(i))).norm());
+		cx::Vector3D n0(sphere->GetPointData()->GetNormals()->GetTuple3(i));
+		cx::Vector3D n1(normals->GetTuple3(i));
+		maxNormalError = std::max(maxNormalError, (n1-n0).norm());
+	}
+	CHECK(maxPointError == 0);
+	CHECK(maxNormalError < 1.0E-3);
+}
+
+TEST_CASE("MeshIO: Levels of detail are written, read and removed", "[unit][resource][core]")
+{
+	QString filename = createSaveFolder("lod") + "/sphere.vtp";
+	vtkPolyDataPtr sphere = createSphere();
+
+	cx::MeshIO io;
+	io.setLevelsOfDetail(2);
+	REQUIRE(io.write(sphere, filename));
+	REQUIRE(QFile::exists(cx::MeshIO::getLevelOfDetailFilename(filename, 1)));
+	REQUIRE(QFile::exists(cx::MeshIO::getLevelOfDetailFilename(filename, 2)));
+
+	vtkIdType full = io.readLevelOfDetail(filename, 0)->GetPolys()->GetNumberOfCells();
+	vtkIdType level1 = io.readLevelOfDetail(filename, 1)->GetPolys()->GetNumberOfCells();
+	vtkIdType level2 = io.readLevelOfDetail(filename, 2)->GetPolys()->GetNumberOfCells();
+	CHECK(level1 < full);
+	CHECK(level2 < level1);
+	CHECK(io.readLevelOfDetail(filename, 5)->GetPolys()->GetNumberOfCells() == level2);
+	CHECK(io.readLevelOfDetail(filename, 2)->GetPointData()->GetNormals());
+
+	io.setLevelsOfDetail(0);
+	REQUIRE(io.write(sphere, filename));
+	CHECK_FALSE(QFile::exists(cx::MeshIO::getLevelOfDetailFilename(filename, 1)));
+	CHECK_FALSE(QFile::exists(cx::MeshIO::getLevelOfDetailFilename(filename, 2)));
+}
+
+} // namespace cxtest
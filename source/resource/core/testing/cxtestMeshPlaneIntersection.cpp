@@ -0,0 +1,103 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <cmath>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkSphereSource.h>
+#include "cxMeshPlaneIntersection.h"
+#include "cxVector3D.h"
+
+namespace cxtest
+{
+
+namespace
+{
+vtkPolyDataPtr createSphere()
+{
+	vtkSphereSourcePtr source = vtkSphereSourcePtr::New();
+	source->SetRadius(10);
+	source->SetThetaResolution(64);
+	source->SetPhiResolution(64);
+	source->SetOutputPointsPrecision(vtkAlgorithm::DOUBLE_PRECISION);
+	source->Update();
+	return source->GetOutput();
+}
+
+void checkContourOnCircle(vtkPolyDataPtr contour, double z, double radius)
+{
+	REQUIRE(contour->GetNumberOfPoints() > 0);
+	for (vtkIdType i=0; i<contour->GetNumberOfPoints(); ++i)
+	{
+		cx::Vector3D p(contour->GetPoint(i));
+		CHECK(p[2] == Approx(z));
+		CHECK(std::fabs(cx::Vector3D(p[0], p[1], 0).norm() - radius) < 0.05);
+	}
+}
+}
+
+TEST_CASE("MeshPlaneIntersection: Cuts a sphere in a closed circle", "[unit][resource][core]")
+{
+	cx::MeshPlaneIntersectionPtr intersection = cx::MeshPlaneIntersection::create(createSphere());
+	REQUIRE(intersection->getNumberOfTriangles() > 0);
+
+	vtkPolyDataPtr contour = intersection->getContour(cx::Vector3D(0, 0, 3), cx::Vector3D(0, 0, 2));
+	checkContourOnCircle(contour, 3, std::sqrt(100.0-9.0));
+
+	// one line per cut triangle, each point shared by two lines
+	CHECK(contour->GetNumberOfLines() == contour->GetNumberOfPoints());
+	CHECK(intersection->getNumberOfVisitedTriangles() < intersection->getNumberOfTriangles()/4);
+}
+
+TEST_CASE("MeshPlaneIntersection: Caches the contour until plane or mesh changes", "[unit][resource][core]")
+{
+	vtkPolyDataPtr sphere = createSphere();
+	cx::MeshPlaneIntersectionPtr intersection = cx::MeshPlaneIntersection::create(sphere);
+
+	vtkPolyDataPtr first = intersection->getContour(cx::Vector3D(0, 0, 0), cx::Vector3D(0, 0, 1));
+	CHECK(intersection->getContour(cx::Vector3D(5, 5, 0), cx::Vector3D(0, 0, 1)) == first);
+
+	vtkPolyDataPtr moved = intersection->getContour(cx::Vector3D(0, 0, 5), cx::Vector3D(0, 0, 1));
+	CHECK(moved != first);
+	checkContourOnCircle(moved, 5, std::sqrt(100.0-25.0));
+	// several planes are cached, e.g. for one intersection shared by several views
+	CHECK(intersection->getContour(cx::Vector3D(0, 0, 0), cx::Vector3D(0, 0, 1)) == first);
+
+	vtkPoints* points = sphere->GetPoints();
+	for (vtkIdType i=0; i<points->GetNumberOfPoints(); ++i)
+	{
+		cx::Vector3D p(points->GetPoint(i));
+		points->SetPoint(i, p[0], p[1], p[2]+5);
+	}
+	points->Modified();
+	checkContourOnCircle(intersection->getContour(cx::Vector3D(0, 0, 5), cx::Vector3D(0, 0, 1)), 5, 10);
+}
+
+TEST_CASE("MeshPlaneIntersection: Gives identical contours on repeated runs", "[unit][resource][core]")
+{
+	vtkPolyDataPtr sphere = createSphere();
+	cx::Vector3D point(1, 2, 3);
+	cx::Vector3D normal = cx::Vector3D(1, -2, 0.5).normalized();
+
+	vtkPolyDataPtr a = cx::MeshPlaneIntersection::create(sphere)->getContour(point, normal);
+	vtkPolyDataPtr b = cx::MeshPlaneIntersection::create(sphere)->getContour(point, normal);
+
+	REQUIRE(a->GetNumberOfPoints() == b->GetNumberOfPoints());
+	REQUIRE(a->GetNumberOfLines() == b->GetNumberOfLines());
+	for (vtkIdType i=0; i<a->GetNumberOfPoints(); ++i)
+		CHECK(cx::Vector3D(a->GetPoint(i)) == cx::Vector3D(b->GetPoint(i)));
+	for (vtkIdType i=0; i<a->GetNumberOfPoints(); ++i)
+		CHECK(std::fabs(cx::dot(cx::Vector3D(a->GetPoint(i)) - point, normal)) < 1.0E-9);
+}
+
+} // namespace cxtest
@@ -0,0 +1,184 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <cstring>
+#include <iostream>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <vtkImageData.h>
+#include <vtkMetaImageReader.h>
+#include "cxMetaImageIO.h"
+#include "cxCustomMetaImage.h"
+#include "cxDataLocations.h"
+#include "cxVolumeHelpers.h"
+#include "cxTypeConversions.h"
+
+namespace cxtest
+{
+
+namespace
+{
+QString createSaveFolder(QString name)
+{
+	QString folder = cx::DataLocations::getTestDataPath() + "/temp/MetaImageIO/" + name;
+	QDir(folder).removeRecursively();
+	QDir().mkpath(folder);
+	return folder;
+}
+
+vtkImageDataPtr createImage(Eigen::Array3i dim)
+{
+	vtkImageDataPtr image = cx::generateVtkImageDataUnsignedShort(dim, cx::Vector3D(0.5, 0.75, 1.5), 0);
+	unsigned short* ptr = static_cast<unsigned short*>(image->GetScalarPointer());
+	for (vtkIdType i=0; i<image->GetNumberOfPoints(); ++i)
+		ptr[i] = (i*7/1000 + (i%13)) % 4000;
+	return image;
+}
+
+bool equalVoxels(vtkImageDataPtr a, vtkImageDataPtr b)
+{
+	if (!a || !b || a->GetNumberOfPoints() != b->GetNumberOfPoints() || a->GetScalarType() != b->GetScalarType())
+		return false;
+	return memcmp(a->GetScalarPointer(), b->GetScalarPointer(), a->GetNumberOfPoints()*a->GetScalarSize()) == 0;
+}
+
+vtkImageDataPtr readWithVtk(QString filename)
+{
+	vtkMetaImageReaderPtr reader = vtkMetaImageReaderPtr::New();
+	reader->SetFileName(cstring_cast(filename));
+	reader->Update();
+	return reader->GetOutput();
+}
+}
+
+TEST_CASE("MetaImageIO: Header parsing stops at ElementDataFile", "[unit][resource][core]")
+{
+	QString filename = createSaveFolder("header") + "/image.mha";
+	vtkImageDataPtr image = createImage(Eigen::Array3i(20, 30, 10));
+	cx::MetaImageHeader header = cx::MetaImageIO::createHeader(image);
+	header.setValue("Modality", "MR");
+	REQUIRE(cx::MetaImageIO().write(image, filename, header));
+
+	cx::MetaImageHeader read;
+	REQUIRE(read.read(filename));
+	CHECK(read.isLocalData());
+	CHECK(read.getValue("modality") == "MR");
+	CHECK(read.getValue("WindowLevel").isEmpty());
+	CHECK(read.getHeaderSize() + image->GetNumberOfPoints()*image->GetScalarSize() == QFile(filename).size());
+
+	cx::CustomMetaImagePtr custom = cx::CustomMetaImage::create(filename);
+	CHECK(custom->readModality() == cx::imMR);
+}
+
+TEST_CASE("MetaImageIO: CustomMetaImage reads keys written after caching", "[unit][resource][core]")
+{
+	QString filename = createSaveFolder("setkey") + "/image.mhd";
+	vtkImageDataPtr image = createImage(Eigen::Array3i(4, 4, 4));
+	cx::MetaImageHeader header = cx::MetaImageIO::createHeader(image);
+	header.setValue("Modality", "MR");
+	header.setValue("ImageType3Description", "T1");
+	REQUIRE(cx::MetaImageIO().write(image, filename, header));
+
+	cx::CustomMetaImagePtr custom = cx::CustomMetaImage::create(filename);
+	CHECK(custom->readModality() == cx::imMR);
+	CHECK(custom->readKey("ImageType3") == "T1"); // prefix match, as before caching
+
+	custom->setModality(cx::imCT);
+	custom->setImageType(cx::istUSBMODE);
+	CHECK(custom->readModality() == cx::imCT);
+	CHECK(custom->readImageType() == cx::istUSBMODE);
+}
+
+TEST_CASE("MetaImageIO: Transform is written and read", "[unit][resource][core]")
+{
+	cx::Transform3D M = cx::createTransformRotateZ(0.3) * cx::createTransformTranslate(cx::Vector3D(1, 2, 3));
+	cx::MetaImageHeader header;
+	header.setValue("ElementDataFile", "LOCAL");
+	header.setTransform(M);
+	CHECK(header.toString().endsWith("ElementDataFile = LOCAL\n"));
+	CHECK(cx::similar(header.getTransform(), M, 1.0E-4));
+}
+
+TEST_CASE("MetaImageIO: Uncompressed mhd roundtrip", "[unit][resource][core]")
+{
+	QString filename = createSaveFolder("uncompressed") + "/image.mhd";
+	vtkImageDataPtr image = createImage(Eigen::Array3i(40, 30, 20));
+	REQUIRE(cx::MetaImageIO().write(image, filename, cx::MetaImageIO::createHeader(image)));
+	CHECK(QFile::exists(QFileInfo(filename).dir().filePath("image.raw")));
+
+	vtkImageDataPtr read = cx::MetaImageIO().read(filename);
+	CHECK(equalVoxels(image, read));
+	CHECK(cx::similar(cx::Vector3D(read->GetSpacing()), cx::Vector3D(image->GetSpacing())));
+	CHECK(equalVoxels(image, readWithVtk(filename)));
+}
+
+TEST_CASE("MetaImageIO: Compressed chunks are readable in parallel and by vtk", "[unit][resource][core]")
+{
+	QString folder = createSaveFolder("compressed");
+	vtkImageDataPtr image = createImage(Eigen::Array3i(100, 80, 60));
+
+	cx::MetaImageIO io;
+	io.setCompression(true);
+	io.setChunkSize(64*1024); // many chunks
+
+	QStringList filenames = QStringList() << folder+"/image.mhd" << folder+"/image.mha";
+	for (int i=0; i<filenames.size(); ++i)
+	{
+		INFO(filenames[i]);
+		REQUIRE(io.write(image, filenames[i], cx::MetaImageIO::createHeader(image)));
+		cx::MetaImageHeader header;
+		header.read(filenames[i]);
+		CHECK(header.getValue("CompressedData") == "True");
+		CHECK(header.getValue("CompressedDataChunkSize").toInt() == 64*1024);
+		if (QFileInfo(filenames[i]).suffix() == "mhd")
+		{
+			CHECK(header.getValue("ElementDataFile") == "image.zraw");
+			CHECK(QFile::exists(folder+"/image.zraw"));
+			CHECK_FALSE(QFile::exists(folder+"/image.raw"));
+		}
+
+		CHECK(equalVoxels(image, cx::MetaImageIO().read(filenames[i])));
+		CHECK(equalVoxels(image, readWithVtk(filenames[i])));
+	}
+}
+
+TEST_CASE("MetaImageIO: Speed of reading and writing", "[speed][resource][core]")
+{
+	QString folder = createSaveFolder("speed");
+	vtkImageDataPtr image = createImage(Eigen::Array3i(512, 512, 400));
+	double megabytes = image->GetNumberOfPoints()*image->GetScalarSize()/1.0E6;
+
+	for (int compress=0; compress<2; ++compress)
+	{
+		QString filename = folder + (compress ? "/compressed.mhd" : "/raw.mhd");
+		cx::MetaImageIO io;
+		io.setCompression(compress);
+
+		QElapsedTimer timer;
+		timer.start();
+		REQUIRE(io.write(image, filename, cx::MetaImageIO::createHeader(image)));
+		double writeTime = timer.restart()/1000.0;
+		vtkImageDataPtr read = io.read(filename);
+		double readTime = timer.restart()/1000.0;
+		readWithVtk(filename);
+		double vtkReadTime = timer.restart()/1000.0;
+
+		CHECK(equalVoxels(image, read));
+		std::cout << "MetaImageIO " << (compress ? "compressed" : "raw") << " " << megabytes << "MB:"
+				  << " write " << megabytes/writeTime << "MB/s"
+				  << ", read " << megabytes/readTime << "MB/s"
+				  << ", vtk read " << megabytes/vtkReadTime << "MB/s" << std::endl;
+	}
+}
+
+} // namespace cxtest
@@ -0,0 +1,92 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include "cxPlaybackTool.h"
+#include "cxPlaybackTime.h"
+#include "cxDummyTool.h"
+#include "cxTransform3D.h"
+#include "cxVector3D.h"
+
+namespace cxtest
+{
+
+namespace
+{
+struct PlaybackToolFixture
+{
+	cx::DummyToolPtr mBase;
+	cx::PlaybackTimePtr mTime;
+	cx::PlaybackToolPtr mTool;
+	QDateTime mStart;
+
+	// 50 Hz samples for 1s, moving along x and rotating about z
+	PlaybackToolFixture()
+	{
+		mBase.reset(new cx::DummyTool());
+		mStart = QDateTime::fromMSecsSinceEpoch(1000000);
+		cx::TimedTransformMapPtr history = mBase->getPositionHistory();
+		for (int i=0; i<=50; ++i)
+			(*history)[mStart.toMSecsSinceEpoch() + 20*i] = this->getPose(20*i);
+
+		mTime.reset(new cx::PlaybackTime());
+		mTime->initialize(mStart, 2000);
+		mTool.reset(new cx::PlaybackTool(mBase, mTime));
+	}
+
+	cx::Transform3D getPose(double offset_ms) const
+	{
+		return cx::createTransformTranslate(cx::Vector3D(offset_ms/10, 0, 0)) * cx::createTransformRotateZ(offset_ms/1000);
+	}
+};
+}
+
+TEST_CASE_METHOD(PlaybackToolFixture, "PlaybackTool: Interpolates between samples", "[unit][resource][core]")
+{
+	mTime->setOffset(110);
+	REQUIRE(mTool->getVisible());
+	CHECK(cx::similar(mTool->get_prMt(), this->getPose(110)));
+
+	mTool->setInterpolation(false);
+	CHECK(cx::similar(mTool->get_prMt(), this->getPose(100)));
+}
+
+TEST_CASE_METHOD(PlaybackToolFixture, "PlaybackTool: Cursor follows forward, backward and jumping time", "[unit][resource][core]")
+{
+	for (int offset=0; offset<=1000; offset+=7)
+	{
+		mTime->setOffset(offset);
+		CHECK(cx::similar(mTool->get_prMt(), this->getPose(offset)));
+	}
+	for (int offset=1000; offset>=0; offset-=13)
+	{
+		mTime->setOffset(offset);
+		CHECK(cx::similar(mTool->get_prMt(), this->getPose(offset)));
+	}
+	mTime->setOffset(930);
+	CHECK(cx::similar(mTool->get_prMt(), this->getPose(930)));
+	mTime->setOffset(30);
+	CHECK(cx::similar(mTool->get_prMt(), this->getPose(30)));
+}
+
+TEST_CASE_METHOD(PlaybackToolFixture, "PlaybackTool: Visibility timeout follows sample rate", "[unit][resource][core]")
+{
+	mTime->setOffset(500);
+	CHECK(mTool->getVisibilityTimeout() == Approx(80));
+	CHECK(mTool->getVisible());
+
+	mTime->setOffset(1070);
+	CHECK(mTool->getVisible());
+	mTime->setOffset(1100);
+	CHECK_FALSE(mTool->getVisible());
+}
+
+} // namespace cxtest
@@ -0,0 +1,219 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <iostream>
+#include <QElapsedTimer>
+#include "cxSpaceProviderImpl.h"
+#include "cxDummyToolManager.h"
+#include "cxDummyTool.h"
+#include "cxImage.h"
+#include "cxRegistrationTransform.h"
+#include "cxVolumeHelpers.h"
+#include "cxtestPatientModelServiceMock.h"
+#include "cxParallelFor.h"
+
+namespace cxtest
+{
+
+namespace
+{
+
+class ValidPatientModelServiceMock : public PatientModelServiceMock
+{
+public:
+	virtual bool isPatientValid() const { return true; }
+};
+
+struct SpaceProviderFixture
+{
+	SpaceProviderFixture(int numberOfTools, int numberOfImages)
+	{
+		mTracking = cx::DummyToolManager::create();
+		mPatient.reset(new ValidPatientModelServiceMock());
+
+		for (int i=0; i<numberOfTools; ++i)
+		{
+			cx::DummyToolPtr tool(new cx::DummyTool(QString("tool%1").arg(i)));
+			tool->set_prMt(cx::createTransformTranslate(cx::Vector3D(i, 0, 0)));
+			mTracking->addTool(tool);
+			mTools.push_back(tool);
+		}
+
+		for (int i=0; i<numberOfImages; ++i)
+		{
+			vtkImageDataPtr raw = cx::generateVtkImageDataUnsignedShort(Eigen::Array3i(2, 2, 2), cx::Vector3D(1, 1, 1), 0);
+			cx::ImagePtr image(new cx::Image(QString("image%1").arg(i), raw));
+			image->get_rMd_History()->setRegistration(cx::createTransformTranslate(cx::Vector3D(0, i, 0)));
+			mPatient->insertData(image);
+			mImages.push_back(image);
+		}
+
+		mSpaces.reset(new cx::SpaceProviderImpl(mTracking, mPatient));
+	}
+
+	cx::CoordinateSystem tool(int i) const { return cx::CoordinateSystem(cx::csTOOL, mTools[i]->getUid()); }
+	cx::CoordinateSystem image(int i) const { return cx::CoordinateSystem(cx::csDATA, mImages[i]->getUid()); }
+
+	cx::DummyToolManagerPtr mTracking;
+	PatientModelServiceMockPtr mPatient;
+	std::vector<cx::DummyToolPtr> mTools;
+	std::vector<cx::ImagePtr> mImages;
+	boost::shared_ptr<cx::SpaceProviderImpl> mSpaces;
+};
+
+} // namespace
+
+TEST_CASE("SpaceProviderImpl: Tool space follows tool movement", "[unit][resource][core]")
+{
+	SpaceProviderFixture fixture(2, 0);
+	cx::CoordinateSystem pr(cx::csPATIENTREF);
+
+	cx::Transform3D prMt = fixture.mSpaces->get_toMfrom(fixture.tool(1), pr);
+	CHECK(cx::similar(prMt, cx::createTransformTranslate(cx::Vector3D(1, 0, 0))));
+
+	fixture.mTools[1]->set_prMt(cx::createTransformTranslate(cx::Vector3D(7, 0, 0)));
+	prMt = fixture.mSpaces->get_toMfrom(fixture.tool(1), pr);
+	CHECK(cx::similar(prMt, cx::createTransformTranslate(cx::Vector3D(7, 0, 0))));
+}
+
+TEST_CASE("SpaceProviderImpl: Handle equals get_toMfrom and follows changes", "[unit][resource][core]")
+{
+	SpaceProviderFixture fixture(2, 2);
+	cx::SpaceTransformHandlePtr handle = fixture.mSpaces->getTransformHandle(fixture.tool(0), fixture.image(1));
+
+	CHECK(cx::similar(handle->get_toMfrom(), fixture.mSpaces->get_toMfrom(fixture.tool(0), fixture.image(1))));
+
+	fixture.mTools[0]->set_prMt(cx::createTransformTranslate(cx::Vector3D(0, 0, 3)));
+	CHECK(cx::similar(handle->get_toMfrom(), fixture.mSpaces->get_toMfrom(fixture.tool(0), fixture.image(1))));
+	CHECK(cx::similar(handle->get_toMfrom(), cx::createTransformTranslate(cx::Vector3D(0, -1, 3))));
+
+	fixture.mImages[1]->get_rMd_History()->setRegistration(cx::createTransformTranslate(cx::Vector3D(0, 5, 0)));
+	CHECK(cx::similar(handle->get_toMfrom(), cx::createTransformTranslate(cx::Vector3D(0, -5, 3))));
+}
+
+TEST_CASE("SpaceProviderImpl: Patient reference change invalidates tool spaces", "[unit][resource][core]")
+{
+	SpaceProviderFixture fixture(1, 0);
+	cx::CoordinateSystem r(cx::csREF);
+	cx::SpaceTransformHandlePtr handle = fixture.mSpaces->getTransformHandle(fixture.tool(0), r);
+
+	CHECK(cx::similar(handle->get_toMfrom(), cx::createTransformTranslate(cx::Vector3D(0, 0, 0))));
+
+	cx::Transform3D rMpr = cx::createTransformTranslate(cx::Vector3D(10, 20, 30));
+	fixture.mPatient->get_rMpr_History()->setRegistration(rMpr);
+
+	CHECK(cx::similar(handle->get_toMfrom(), rMpr));
+	CHECK(cx::similar(fixture.mSpaces->get_toMfrom(fixture.tool(0), r), rMpr));
+}
+
+TEST_CASE("SpaceProviderImpl: Cached transforms equal uncached after signalled changes", "[unit][resource][core]")
+{
+	SpaceProviderFixture fixture(1, 1);
+	cx::CoordinateSystem r(cx::csREF);
+	cx::CoordinateSystem offset(cx::csTOOL_OFFSET, fixture.mTools[0]->getUid());
+	cx::CoordinateSystem sensor(cx::csSENSOR, fixture.mTools[0]->getUid());
+	std::vector<cx::SpaceTransformHandlePtr> handles;
+	handles.push_back(fixture.mSpaces->getTransformHandle(offset, fixture.image(0)));
+	handles.push_back(fixture.mSpaces->getTransformHandle(sensor, r));
+	handles.push_back(fixture.mSpaces->getTransformHandle(fixture.tool(0), fixture.image(0)));
+
+	for (int step=0; step<4; ++step)
+	{
+		if (step==1)
+			fixture.mTools[0]->setTooltipOffset(10);
+		if (step==2)
+			fixture.mImages[0]->get_rMd_History()->setRegistration(cx::createTransformTranslate(cx::Vector3D(0, 2, 0)));
+		if (step==3)
+			fixture.mPatient->get_rMpr_History()->setRegistration(cx::createTransformTranslate(cx::Vector3D(0, 0, 1)));
+
+		INFO("step " << step);
+		for (unsigned i=0; i<handles.size(); ++i)
+		{
+			cx::Transform3D expected = fixture.mSpaces->compute_toMfrom(handles[i]->getFrom(), handles[i]->getTo());
+			CHECK(cx::similar(handles[i]->get_toMfrom(), expected));
+			CHECK(cx::similar(fixture.mSpaces->get_toMfrom(handles[i]->getFrom(), handles[i]->getTo()), expected));
+		}
+	}
+	CHECK(cx::similar(fixture.mSpaces->get_toMfrom(offset, fixture.tool(0)), cx::createTransformTranslate(cx::Vector3D(0, 0, 10))));
+}
+
+TEST_CASE("SpaceProviderImpl: Concurrent queries give consistent transforms", "[unit][resource][core]")
+{
+	SpaceProviderFixture fixture(4, 8);
+	cx::SpaceProviderPtr spaces = fixture.mSpaces;
+	std::vector<cx::CoordinateSystem> tools;
+	std::vector<cx::CoordinateSystem> images;
+	for (int i=0; i<4; ++i)
+		tools.push_back(fixture.tool(i));
+	for (int i=0; i<8; ++i)
+		images.push_back(fixture.image(i));
+
+	int count = 10000;
+	std::vector<int> errors(count, 0);
+	cx::parallelFor(0, count, [&](int i)
+	{
+		cx::Transform3D M = spaces->get_toMfrom(tools[i%4], images[i%8]);
+		cx::Transform3D expected = cx::createTransformTranslate(cx::Vector3D(i%4, -(i%8), 0));
+		errors[i] = cx::similar(M, expected) ? 0 : 1;
+	}, 100);
+
+	int total = 0;
+	for (int i=0; i<count; ++i)
+		total += errors[i];
+	CHECK(total == 0);
+}
+
+TEST_CASE("SpaceProviderImpl: Speed of cached transform queries", "[speed][resource][core]")
+{
+	int numberOfTools = 20;
+	int numberOfImages = 200;
+	int numberOfQueries = 1000000;
+	SpaceProviderFixture fixture(numberOfTools, numberOfImages);
+
+	std::vector<cx::SpaceTransformHandlePtr> handles;
+	for (int i=0; i<numberOfImages; ++i)
+		handles.push_back(fixture.mSpaces->getTransformHandle(fixture.tool(i%numberOfTools), fixture.image(i)));
+
+	double uncachedSum = 0;
+	double cachedSum = 0;
+	QElapsedTimer timer;
+	timer.start();
+	for (int i=0; i<numberOfQueries; ++i)
+		uncachedSum += fixture.mSpaces->compute_toMfrom(fixture.tool(i%numberOfTools), fixture.image(i%numberOfImages))(0, 3);
+	double uncachedSeconds = std::max<qint64>(timer.elapsed(), 1)/1000.0;
+
+	timer.restart();
+	for (int i=0; i<numberOfQueries; ++i)
+		cachedSum += fixture.mSpaces->get_toMfrom(fixture.tool(i%numberOfTools), fixture.image(i%numberOfImages))(0, 3);
+	double directSeconds = std::max<qint64>(timer.elapsed(), 1)/1000.0;
+
+	timer.restart();
+	for (int i=0; i<numberOfQueries; ++i)
+	{
+		if (i%1000==0)
+			fixture.mTools[i%numberOfTools]->set_prMt(cx::createTransformTranslate(cx::Vector3D(i, 0, 0)));
+		handles[i%numberOfImages]->get_toMfrom();
+	}
+	double handleSeconds = std::max<qint64>(timer.elapsed(), 1)/1000.0;
+
+	std::cout << "SpaceProviderImpl with " << numberOfTools << " tools and " << numberOfImages << " images:" << std::endl;
+	std::cout << "  uncached:    " << numberOfQueries/uncachedSeconds << " queries/s" << std::endl;
+	std::cout << "  get_toMfrom: " << numberOfQueries/directSeconds << " queries/s, "
+			  << uncachedSeconds/directSeconds << " times uncached" << std::endl;
+	std::cout << "  handles:     " << numberOfQueries/handleSeconds << " queries/s (tool moved every 1000 queries), "
+			  << uncachedSeconds/handleSeconds << " times uncached" << std::endl;
+	CHECK(cachedSum == Approx(uncachedSum));
+	CHECK(directSeconds < uncachedSeconds);
+	CHECK(handleSeconds < uncachedSeconds);
+}
+
+} // namespace cxtest
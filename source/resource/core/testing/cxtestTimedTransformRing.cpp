@@ -0,0 +1,75 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <cmath>
+#include "cxTimedTransformRing.h"
+
+namespace cxtest
+{
+
+TEST_CASE("TimedTransformRing: Empty ring gives no transform", "[unit][resource][core]")
+{
+	cx::TimedTransformRing ring;
+	cx::Transform3D result;
+	CHECK(ring.isEmpty());
+	CHECK(!ring.interpolate(0, &result));
+}
+
+TEST_CASE("TimedTransformRing: Interpolates between samples and clamps outside", "[unit][resource][core]")
+{
+	cx::TimedTransformRing ring;
+	cx::Transform3D a = cx::createTransformTranslate(cx::Vector3D(0, 0, 0));
+	cx::Transform3D b = cx::createTransformTranslate(cx::Vector3D(10, 0, 0)) * cx::createTransformRotateZ(M_PI/2);
+	ring.add(a, 1000);
+	ring.add(b, 1020);
+
+	cx::Transform3D result;
+	REQUIRE(ring.interpolate(1005, &result));
+	cx::Transform3D expected = cx::createTransformTranslate(cx::Vector3D(2.5, 0, 0)) * cx::createTransformRotateZ(M_PI/8);
+	INFO(expected.matrix() << " == " << result.matrix());
+	CHECK(cx::similar(result, expected));
+
+	REQUIRE(ring.interpolate(900, &result));
+	CHECK(cx::similar(result, a));
+	REQUIRE(ring.interpolate(2000, &result));
+	CHECK(cx::similar(result, b));
+}
+
+TEST_CASE("TimedTransformRing: Keeps the latest samples only", "[unit][resource][core]")
+{
+	cx::TimedTransformRing ring(4);
+	for (int i=0; i<10; ++i)
+		ring.add(cx::createTransformTranslate(cx::Vector3D(i, 0, 0)), i*10);
+
+	cx::Transform3D result;
+	REQUIRE(ring.interpolate(0, &result));
+	CHECK(cx::similar(result, cx::createTransformTranslate(cx::Vector3D(6, 0, 0))));
+	REQUIRE(ring.interpolate(85, &result));
+	CHECK(cx::similar(result, cx::createTransformTranslate(cx::Vector3D(8.5, 0, 0))));
+}
+
+TEST_CASE("TimedTransformRing: Older timestamp resets the history", "[unit][resource][core]")
+{
+	cx::TimedTransformRing ring;
+	ring.add(cx::createTransformTranslate(cx::Vector3D(1, 0, 0)), 1000);
+	ring.add(cx::createTransformTranslate(cx::Vector3D(2, 0, 0)), 1010);
+	ring.add(cx::createTransformTranslate(cx::Vector3D(3, 0, 0)), 10);
+
+	cx::Transform3D result;
+	REQUIRE(ring.interpolate(1005, &result));
+	CHECK(cx::similar(result, cx::createTransformTranslate(cx::Vector3D(3, 0, 0))));
+
+	ring.clear();
+	CHECK(ring.isEmpty());
+}
+
+} // namespace cxtest
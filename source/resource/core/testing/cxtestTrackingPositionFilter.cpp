@@ -10,6 +10,9 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 =========================================================================*/
 
 #include "catch.hpp"
+#include <iostream>
+#include <random>
+#include <QElapsedTimer>
 #include "cxTrackingPositionFilter.h"
 
 namespace cxtest
@@ -55,6 +58,74 @@ TEST_CASE("TrackingPositionFilter: Check if interpolation is correct", "[unit]")
 	//CHECK(cx::similar(expected, result));
 }
 
+TEST_CASE("TrackingPositionFilter: Constant rotation is preserved", "[unit]")
+{
+	cx::Transform3D expected = cx::createTransformTranslate(cx::Vector3D(1,2,3)) * cx::createTransformRotateZ(0.5) * cx::createTransformRotateX(0.3);
+	cx::TrackingPositionFilter filter;
+	for (int i = 0; i < 500; i++)
+		filter.addPosition(expected, i*4);
+
+	cx::Transform3D result = filter.getFilteredPosition();
+	INFO(expected << " == " << result);
+	CHECK(cx::similar(expected, result, 1.0E-3));
+}
+
+TEST_CASE("TrackingPositionFilter: Orientation noise is smoothed", "[unit]")
+{
+	std::mt19937 generator(0);
+	std::normal_distribution<double> noise(0, 0.05);
+	cx::Transform3D nominal = cx::createTransformRotateZ(0.5);
+	cx::TrackingPositionFilter filter;
+
+	double inputError = 0;
+	double outputError = 0;
+	for (int i = 0; i < 2000; i++)
+	{
+		cx::Transform3D pos = nominal * cx::createTransformRotateX(noise(generator)) * cx::createTransformRotateY(noise(generator));
+		filter.addPosition(pos, i*4);
+		if (i < 1000)
+			continue;
+		inputError += Eigen::AngleAxisd(nominal.linear().transpose() * pos.linear()).angle();
+		cx::Transform3D result = filter.getFilteredPosition();
+		outputError += Eigen::AngleAxisd(nominal.linear().transpose() * result.linear()).angle();
+		REQUIRE((result.linear() * result.linear().transpose()).isIdentity(1.0E-6));
+	}
+
+	CHECK(outputError < inputError/3);
+}
+
+TEST_CASE("TrackingPositionFilter: Latency is constant over hours of 250 Hz tracking", "[speed]")
+{
+	double frequency = 250; // Hz
+	int hours = 4;
+	int samplesPerHour = 3600*frequency;
+	cx::TrackingPositionFilter filter;
+	std::mt19937 generator(0);
+	std::normal_distribution<double> noise(0, 0.1);
+
+	std::vector<double> secondsPerHour;
+	int sample = 0;
+	for (int hour = 0; hour < hours; ++hour)
+	{
+		QElapsedTimer timer;
+		timer.start();
+		for (int i = 0; i < samplesPerHour; ++i, ++sample)
+		{
+			double t = sample/frequency;
+			cx::Transform3D pos = cx::createTransformTranslate(cx::Vector3D(100*sin(t), 50*cos(t), noise(generator)))
+					* cx::createTransformRotateZ(sin(t/10)) * cx::createTransformRotateX(noise(generator)/10);
+			filter.addPosition(pos, t*1000);
+			filter.getFilteredPosition();
+		}
+		secondsPerHour.push_back(timer.nsecsElapsed()*1.0E-9);
+		std::cout << "TrackingPositionFilter: hour " << hour << " of 250 Hz data processed in " << secondsPerHour.back()
+				  << " s, " << secondsPerHour.back()/samplesPerHour*1.0E6 << " us/sample" << std::endl;
+	}
+
+	// the filter keeps a fixed amount of state, so the cost of each hour should be the same
+	CHECK(sizeof(cx::TrackingPositionFilter) < 4096);
+	CHECK(secondsPerHour.back() < 2*secondsPerHour.front() + 0.1);
+}
 
 } // namespace cx
 
@@ -0,0 +1,135 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <QDir>
+#include <QFile>
+#include <vtkImageData.h>
+#include "cxSavingVideoRecorder.h"
+#include "cxVideoStageTelemetry.h"
+#include "cxDataLocations.h"
+#include "cxVolumeHelpers.h"
+
+namespace cxtest
+{
+
+namespace
+{
+QString createSaveFolder(QString name)
+{
+	QString folder = cx::DataLocations::getTestDataPath() + "/temp/VideoRecorderSaveThread/" + name;
+	QDir(folder).removeRecursively();
+	QDir().mkpath(folder);
+	return folder;
+}
+
+vtkImageDataPtr createFrame(int value)
+{
+	return cx::generateVtkImageData(Eigen::Array3i(64, 48, 1), cx::Vector3D(1, 1, 1), value);
+}
+
+int countLines(QString filename)
+{
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly))
+		return -1;
+	return QString(file.readAll()).split("\n", QString::SkipEmptyParts).size();
+}
+}
+
+TEST_CASE("VideoRecorderSaveThread: Full queue drops frames", "[unit][resource][core]")
+{
+	QString folder = createSaveFolder("drop");
+	cx::VideoRecorderSaveThread thread(NULL, folder, "drop", false, true);
+	cx::VideoRecorderSaveThread::QueueSettings settings;
+	settings.mMaxQueueSize = 3;
+	settings.mPolicy = cx::VideoRecorderSaveThread::qpDROP;
+	thread.setQueueSettings(settings);
+
+	// fill the queue before the writer starts
+	int added = 0;
+	for (int i=0; i<10; ++i)
+		if (!thread.addData(cx::TimeInfo(i), createFrame(i)).isEmpty())
+			++added;
+
+	CHECK(added == 3);
+	CHECK(thread.getMetrics().mQueueDepth == 3);
+	CHECK(thread.getMetrics().mDroppedFrames == 7);
+
+	thread.start();
+	thread.stop();
+	thread.wait();
+
+	cx::VideoRecorderMetrics metrics = thread.getMetrics();
+	CHECK(metrics.mQueueDepth == 0);
+	CHECK(metrics.mWrittenFrames == 3);
+	CHECK(thread.getTelemetry()->getStatistics().mReceived == 3);
+	CHECK(thread.getTelemetry()->getStatistics().mDropped == 7);
+	CHECK(countLines(folder + "/drop.fts") == 3);
+	CHECK(QFile::exists(folder + "/drop_2.mhd"));
+	CHECK(!QFile::exists(folder + "/drop_3.mhd"));
+}
+
+TEST_CASE("VideoRecorderSaveThread: Full queue spills frames to disk in order", "[unit][resource][core]")
+{
+	QString folder = createSaveFolder("spill");
+	cx::VideoRecorderSaveThread thread(NULL, folder, "spill", true, true);
+	cx::VideoRecorderSaveThread::QueueSettings settings;
+	settings.mMaxQueueSize = 2;
+	settings.mPolicy = cx::VideoRecorderSaveThread::qpSPILL_TO_DISK;
+	settings.mWriterThreads = 2;
+	thread.setQueueSettings(settings);
+
+	// the spill thread holds as many frames as the queue
+	for (int i=0; i<4; ++i)
+		CHECK(thread.addData(cx::TimeInfo(i), createFrame(i)) == QString("%1/spill_%2.mhd").arg(folder).arg(i));
+
+	CHECK(thread.getMetrics().mSpilledFrames == 2);
+	CHECK(thread.getMetrics().mMaxQueueDepth == 2);
+
+	thread.start();
+	thread.stop();
+	thread.wait();
+
+	QFile timestamps(folder + "/spill.fts");
+	REQUIRE(timestamps.open(QIODevice::ReadOnly));
+	QStringList lines = QString(timestamps.readAll()).split("\n", QString::SkipEmptyParts);
+	REQUIRE(lines.size() == 4);
+	for (int i=0; i<lines.size(); ++i)
+	{
+		CHECK(lines[i].toDouble() == Approx(i));
+		CHECK(QFile::exists(QString("%1/spill_%2.mhd").arg(folder).arg(i)));
+		// spilled frames are written compressed, without an uncompressed copy
+		CHECK(QFile::exists(QString("%1/spill_%2.zraw").arg(folder).arg(i)));
+		CHECK(!QFile::exists(QString("%1/spill_%2.raw").arg(folder).arg(i)));
+	}
+}
+
+TEST_CASE("VideoRecorderSaveThread: Full queue does not block when not writing", "[unit][resource][core]")
+{
+	QString folder = createSaveFolder("block");
+	cx::VideoRecorderSaveThread thread(NULL, folder, "block", false, true);
+	cx::VideoRecorderSaveThread::QueueSettings settings;
+	settings.mMaxQueueSize = 1;
+	settings.mPolicy = cx::VideoRecorderSaveThread::qpBLOCK;
+	thread.setQueueSettings(settings);
+
+	CHECK(!thread.addData(cx::TimeInfo(0), createFrame(0)).isEmpty());
+	CHECK(thread.addData(cx::TimeInfo(1), createFrame(1)).isEmpty());
+	CHECK(thread.getMetrics().mDroppedFrames == 1);
+
+	thread.start();
+	thread.stop();
+	thread.wait();
+	CHECK(countLines(folder + "/block.fts") == 1);
+}
+
+} // namespace cxtest
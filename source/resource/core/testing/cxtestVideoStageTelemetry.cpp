@@ -0,0 +1,102 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <QDateTime>
+#include "cxVideoStageTelemetry.h"
+#include "cxBasicVideoSource.h"
+#include "cxImage.h"
+#include "cxVolumeHelpers.h"
+
+namespace cxtest
+{
+
+namespace
+{
+bool isListed(QString name)
+{
+	std::vector<cx::VideoStageStatistics> all = cx::VideoStageTelemetry::getAllStatistics();
+	for (unsigned i=0; i<all.size(); ++i)
+		if (all[i].mName == name)
+			return true;
+	return false;
+}
+}
+
+TEST_CASE("VideoStageTelemetry: Counts frames and bins their age", "[unit][resource][core]")
+{
+	cx::VideoStageTelemetryPtr telemetry = cx::VideoStageTelemetry::create("test");
+	telemetry->setLogInterval(0);
+
+	for (int i=0; i<10; ++i)
+		telemetry->frameReceived(0.5);
+	for (int i=0; i<5; ++i)
+		telemetry->frameReceived(3);
+	for (int i=0; i<4; ++i)
+		telemetry->frameReceived(30);
+	telemetry->frameReceived(2000);
+	telemetry->frameDropped();
+	telemetry->frameDropped(2);
+
+	cx::VideoStageStatistics stats = telemetry->getStatistics();
+	CHECK(stats.mName == "test");
+	CHECK(stats.mReceived == 20);
+	CHECK(stats.mDropped == 3);
+	CHECK(stats.mMeanAge == Approx(107));
+	CHECK(stats.mMedianAge == Approx(1));
+	CHECK(stats.mP95Age == Approx(50));
+	CHECK(stats.mMaxAge == Approx(2000));
+
+	std::vector<double> edges = cx::VideoStageTelemetry::getBinEdges();
+	REQUIRE(stats.mAgeHistogram.size() == edges.size());
+	CHECK(stats.mAgeHistogram.front() == 10);
+	CHECK(stats.mAgeHistogram.back() == 1);
+	qint64 total = 0;
+	for (unsigned i=0; i<stats.mAgeHistogram.size(); ++i)
+		total += stats.mAgeHistogram[i];
+	CHECK(total == 20);
+
+	telemetry->reset();
+	stats = telemetry->getStatistics();
+	CHECK(stats.mReceived == 0);
+	CHECK(stats.mDropped == 0);
+	CHECK(stats.mMaxAge == 0);
+}
+
+TEST_CASE("VideoStageTelemetry: Lists live stages only", "[unit][resource][core]")
+{
+	cx::VideoStageTelemetryPtr telemetry = cx::VideoStageTelemetry::create("listed stage");
+	CHECK(isListed("listed stage"));
+	telemetry.reset();
+	CHECK(!isListed("listed stage"));
+}
+
+TEST_CASE("VideoStageTelemetry: BasicVideoSource records latency from acquisition", "[unit][resource][core]")
+{
+	cx::BasicVideoSourcePtr source(new cx::BasicVideoSource("telemetry"));
+	source->getTelemetry()->setLogInterval(0);
+
+	vtkImageDataPtr data = cx::generateVtkImageData(Eigen::Array3i(8, 8, 1), cx::Vector3D(1, 1, 1), 0);
+	for (int i=0; i<3; ++i)
+	{
+		cx::ImagePtr image(new cx::Image("telemetry", data));
+		image->setAcquisitionTime(QDateTime::fromMSecsSinceEpoch(QDateTime::currentMSecsSinceEpoch() - 40));
+		source->setInput(image);
+	}
+
+	cx::VideoStageStatistics stats = source->getTelemetry()->getStatistics();
+	CHECK(stats.mReceived == 3);
+	CHECK(stats.mDropped == 0);
+	CHECK(stats.mMeanAge >= 40);
+	CHECK(stats.mMeanAge < 1000);
+}
+
+} // namespace cxtest
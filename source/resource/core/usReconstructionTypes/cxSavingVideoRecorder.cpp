@@ -15,6 +15,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QFile>
 #include <QFileInfo>
 #include <QTextStream>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cstring>
+#include <functional>
 
 #include <vtkImageChangeInformation.h>
 #include <vtkImageLuminance.h>
@@ -28,27 +32,75 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxXmlOptionItem.h"
 #include "cxImageDataContainer.h"
 #include "cxVideoSource.h"
+#include "cxParallelFor.h"
+#include "cxVideoStageTelemetry.h"
+#include "cxUtilHelpers.h"
 
 namespace cx
 {
 
+namespace
+{
+/** Thread running a function.
+ */
+class FunctionThread : public QThread
+{
+public:
+	FunctionThread(std::function<void()> function) : mFunction(function) {}
+protected:
+	virtual void run() { mFunction(); }
+private:
+	std::function<void()> mFunction;
+};
+}
+
 VideoRecorderSaveThread::VideoRecorderSaveThread(QObject* parent, QString saveFolder, QString prefix, bool compressed, bool writeColor) :
 	QThread(parent),
 	mSaveFolder(saveFolder),
 	mPrefix(prefix),
 	mImageIndex(0),
-	mMutex(QMutex::Recursive),
 	mStop(false),
 	mCancel(false),
 	mTimestampsFile(saveFolder+"/"+prefix+".fts"),
 	mCompressed(compressed),
-	mWriteColor(writeColor)
+	mWriteColor(writeColor),
+	mTelemetry(VideoStageTelemetry::create("SavingVideoRecorder "+prefix)),
+	mSpillCount(0),
+	mSpillWritten(0),
+	mSpillStop(false)
 {
 	this->setObjectName("org.custusx.resource.videorecordersave"); // becomes the thread name
 }
 
 VideoRecorderSaveThread::~VideoRecorderSaveThread()
 {
+	this->stopSpillThread();
+}
+
+void VideoRecorderSaveThread::setQueueSettings(QueueSettings settings)
+{
+	QMutexLocker sentry(&mMutex);
+	mQueueSettings = settings;
+	mSpaceAvailable.wakeAll();
+}
+
+VideoRecorderMetrics VideoRecorderSaveThread::getMetrics() const
+{
+	QMutexLocker sentry(&mMutex);
+	return mMetrics;
+}
+
+bool VideoRecorderSaveThread::isQueueFull() const
+{
+	return (mQueueSettings.mMaxQueueSize > 0) && (mMetrics.mQueueDepth >= mQueueSettings.mMaxQueueSize);
+}
+
+int VideoRecorderSaveThread::getWriterThreads() const
+{
+	if (mQueueSettings.mWriterThreads > 0)
+		return mQueueSettings.mWriterThreads;
+	// compression is cpu bound and gains from parallel writes, raw writes are io bound.
+	return mCompressed ? std::max(1, QThread::idealThreadCount()) : 2;
 }
 
 QString VideoRecorderSaveThread::addData(TimeInfo timestamp, vtkImageDataPtr image)
@@ -56,29 +108,163 @@ QString VideoRecorderSaveThread::addData(TimeInfo timestamp, vtkImageDataPtr ima
 	if (!image)
 		return "";
 
+	QMutexLocker sentry(&mMutex);
+
+	if (this->isQueueFull() && (mQueueSettings.mPolicy == qpBLOCK) && this->isRunning())
+	{
+		QElapsedTimer timer;
+		timer.start();
+		while (this->isQueueFull() && !mCancel && (mQueueSettings.mPolicy == qpBLOCK))
+		{
+			int remaining = mQueueSettings.mBlockTimeout - timer.elapsed();
+			if (remaining <= 0)
+				break;
+			mSpaceAvailable.wait(&mMutex, remaining);
+		}
+		if (mCancel)
+			return "";
+	}
+	bool spill = (mQueueSettings.mPolicy == qpSPILL_TO_DISK);
+	if (this->isQueueFull() && (!spill || (int(mSpillData.size()) >= std::max(mQueueSettings.mMaxQueueSize, 1))))
+	{
+		++mMetrics.mDroppedFrames;
+		mTelemetry->frameDropped();
+		return "";
+	}
+
 	DataType data;
 	data.mTimestamp = timestamp;
-	data.mImage = vtkImageDataPtr::New();
-	data.mImage->DeepCopy(image);
+	data.mQueuedTime = VideoStageTelemetry::now();
 	data.mImageFilename = QString("%1/%2_%3.mhd").arg(mSaveFolder).arg(mPrefix).arg(mImageIndex++);
 
+	if (this->isQueueFull())
 	{
-		QMutexLocker sentry(&mMutex);
+		// spill: write on the spill thread, keeping the queue entry for the timestamp
+		data.mSpilled = true;
+		data.mSpillIndex = mSpillCount++;
+		++mMetrics.mSpilledFrames;
 		mPendingData.push_back(data);
+
+		data.mImage = this->copyToBuffer(image);
+		mSpillData.push_back(data);
+		if (!mSpillThread)
+		{
+			mSpillThread.reset(new FunctionThread([this]() { this->writeSpilled(); }));
+			mSpillThread->setObjectName("org.custusx.resource.videorecorderspill");
+			mSpillThread->start();
+		}
+		mSpillAvailable.wakeAll();
+		return data.mImageFilename;
 	}
 
+	data.mImage = this->copyToBuffer(image);
+	mPendingData.push_back(data);
+	++mMetrics.mQueueDepth;
+	mMetrics.mMaxQueueDepth = std::max(mMetrics.mMaxQueueDepth, mMetrics.mQueueDepth);
+	mDataAvailable.wakeAll();
+
 	return data.mImageFilename;
 }
 
+/** Copy image into a buffer from the pool, allocating a new buffer if the pool
+  * is empty. The pool grows as buffers are released, up to the queue capacity,
+  * and is emptied if the frame format changes. Call with mMutex locked.
+  */
+vtkImageDataPtr VideoRecorderSaveThread::copyToBuffer(vtkImageDataPtr image)
+{
+	int* extent = image->GetExtent();
+	int components = image->GetNumberOfScalarComponents();
+
+	if (!mFreeBuffers.empty())
+	{
+		vtkImageDataPtr candidate = mFreeBuffers.back();
+		int* candidateExtent = candidate->GetExtent();
+		bool match = std::equal(extent, extent+6, candidateExtent)
+				&& (candidate->GetScalarType() == image->GetScalarType())
+				&& (candidate->GetNumberOfScalarComponents() == components);
+		if (!match)
+			mFreeBuffers.clear();
+	}
+
+	if (mFreeBuffers.empty())
+	{
+		vtkImageDataPtr buffer = vtkImageDataPtr::New();
+		buffer->SetExtent(extent);
+		buffer->AllocateScalars(image->GetScalarType(), components);
+		mFreeBuffers.push_back(buffer);
+	}
+
+	vtkImageDataPtr retval = mFreeBuffers.back();
+	mFreeBuffers.pop_back();
+
+	retval->SetSpacing(image->GetSpacing());
+	retval->SetOrigin(image->GetOrigin());
+	vtkIdType size = image->GetNumberOfPoints() * components * image->GetScalarSize();
+	memcpy(retval->GetScalarPointer(), image->GetScalarPointer(), size);
+	retval->Modified();
+	return retval;
+}
+
+void VideoRecorderSaveThread::releaseBuffer(vtkImageDataPtr buffer)
+{
+	int capacity = std::max(mQueueSettings.mMaxQueueSize, 1) + this->getWriterThreads();
+	if (int(mFreeBuffers.size()) < capacity)
+		mFreeBuffers.push_back(buffer);
+}
+
+/** Write spilled frames in their final format, in spill order, until
+  * stopSpillThread() is called and all are written, or cancel().
+  */
+void VideoRecorderSaveThread::writeSpilled()
+{
+	QMutexLocker sentry(&mMutex);
+	while (!mCancel)
+	{
+		if (mSpillData.empty())
+		{
+			if (mSpillStop)
+				return;
+			mSpillAvailable.wait(&mMutex, 20);
+			continue;
+		}
+
+		DataType data = mSpillData.front();
+		mSpillData.pop_front();
+		sentry.unlock();
+		this->write(data, mCompressed);
+		sentry.relock();
+
+		this->releaseBuffer(data.mImage);
+		++mSpillWritten;
+		mDataAvailable.wakeAll();
+	}
+}
+
+void VideoRecorderSaveThread::stopSpillThread()
+{
+	{
+		QMutexLocker sentry(&mMutex);
+		mSpillStop = true;
+		mSpillAvailable.wakeAll();
+	}
+	if (mSpillThread)
+		mSpillThread->wait();
+}
+
 void VideoRecorderSaveThread::stop()
 {
 	mStop = true;
+	mDataAvailable.wakeAll();
 }
 
 void VideoRecorderSaveThread::cancel()
 {
+	QMutexLocker sentry(&mMutex);
 	mCancel = true;
 	mStop = true;
+	mDataAvailable.wakeAll();
+	mSpaceAvailable.wakeAll();
+	mSpillAvailable.wakeAll();
 }
 
 bool VideoRecorderSaveThread::openTimestampsFile()
@@ -106,10 +292,11 @@ bool VideoRecorderSaveThread::closeTimestampsFile()
 	return true;
 }
 
-void VideoRecorderSaveThread::write(VideoRecorderSaveThread::DataType data)
+/** Write image only, the timestamp is written separately in frame order.
+  * Can be called from several threads.
+  */
+void VideoRecorderSaveThread::write(VideoRecorderSaveThread::DataType data, bool compressed)
 {
-	this->writeTimeStampsFile(data.mTimestamp);
-
 	// convert to 8 bit data if applicable.
 	if (!mWriteColor && data.mImage->GetNumberOfScalarComponents()>2)
 	{
@@ -124,7 +311,7 @@ void VideoRecorderSaveThread::write(VideoRecorderSaveThread::DataType data)
 	vtkMetaImageWriterPtr writer = vtkMetaImageWriterPtr::New();
 	writer->SetInputData(data.mImage);
 	writer->SetFileName(cstring_cast(data.mImageFilename));
-	writer->SetCompression(mCompressed);
+	writer->SetCompression(compressed);
 	writer->Write();
 }
 
@@ -135,25 +322,86 @@ void VideoRecorderSaveThread::writeTimeStampsFile(TimeInfo timeStamps)
 	stream << endl;
 }
 
+/** Take the next frames from the queue, one for each writer thread.
+  * Spilled entries are included, as their timestamps must be written in order,
+  * but not before the spill thread has written them.
+  */
+std::vector<VideoRecorderSaveThread::DataType> VideoRecorderSaveThread::takeBatch()
+{
+	QMutexLocker sentry(&mMutex);
+	std::vector<DataType> retval;
+	int images = 0;
+	int maxImages = this->getWriterThreads();
+	while (!mPendingData.empty() && (images < maxImages))
+	{
+		const DataType& next = mPendingData.front();
+		if (next.mSpilled && (next.mSpillIndex >= mSpillWritten))
+			break;
+		retval.push_back(mPendingData.front());
+		mPendingData.pop_front();
+		if (!retval.back().mSpilled)
+		{
+			++images;
+			--mMetrics.mQueueDepth;
+		}
+	}
+	mSpaceAvailable.wakeAll();
+	return retval;
+}
+
+/** Write all images in the batch in parallel,
+  * then write their timestamps in order.
+  */
+void VideoRecorderSaveThread::writeBatch(std::vector<DataType> batch)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	DataType* data = batch.data();
+	bool compressed = mCompressed;
+	parallelFor(0, int(batch.size()), [this, data, compressed](int i)
+	{
+		if (!data[i].mSpilled)
+			this->write(data[i], compressed);
+	}, 1);
+
+	double bytes = 0;
+	double now = VideoStageTelemetry::now();
+	for (unsigned i=0; i<batch.size(); ++i)
+	{
+		this->writeTimeStampsFile(batch[i].mTimestamp);
+		mTelemetry->frameReceived(now - batch[i].mQueuedTime);
+		if (!batch[i].mSpilled)
+			bytes += double(batch[i].mImage->GetNumberOfPoints()) * batch[i].mImage->GetNumberOfScalarComponents() * batch[i].mImage->GetScalarSize();
+	}
+
+	QMutexLocker sentry(&mMutex);
+	for (unsigned i=0; i<batch.size(); ++i)
+		if (!batch[i].mSpilled)
+			this->releaseBuffer(batch[i].mImage);
+
+	double megabytes = bytes/1024/1024;
+	double seconds = std::max<double>(timer.nsecsElapsed()*1.0E-9, 1.0E-6);
+	mMetrics.mWrittenFrames += batch.size();
+	mMetrics.mWrittenMB += megabytes;
+	if (megabytes > 0)
+	{
+		double rate = megabytes/seconds;
+		mMetrics.mWriteMBPerSecond = mMetrics.mWriteMBPerSecond ? 0.8*mMetrics.mWriteMBPerSecond + 0.2*rate : rate;
+	}
+}
+
 /** Write all pending images to file.
   *
   */
 void VideoRecorderSaveThread::writeQueue()
 {
-	while(!mPendingData.empty())
+	while(!mCancel)
 	{
-		if (mCancel)
+		std::vector<DataType> batch = this->takeBatch();
+		if (batch.empty())
 			return;
-
-		DataType current;
-
-		{
-			QMutexLocker sentry(&mMutex);
-			current = mPendingData.front();
-			mPendingData.pop_front();
-		}
-
-		this->write(current);
+		this->writeBatch(batch);
 	}
 }
 
@@ -163,11 +411,20 @@ void VideoRecorderSaveThread::run()
 	while (!mStop)
 	{
 		this->writeQueue();
-		this->msleep(20);
+
+		QMutexLocker sentry(&mMutex);
+		bool waitingForSpill = !mPendingData.empty() && mPendingData.front().mSpilled && (mPendingData.front().mSpillIndex >= mSpillWritten);
+		if ((mPendingData.empty() || waitingForSpill) && !mStop)
+			mDataAvailable.wait(&mMutex, 20);
 	}
 
+	this->stopSpillThread();
 	this->writeQueue();
 	this->closeTimestampsFile();
+
+	QMutexLocker sentry(&mMutex);
+	if (mCancel && !mPendingData.empty())
+		mTelemetry->frameDropped(int(mPendingData.size()));
 }
 
 //---------------------------------------------------------
@@ -212,11 +469,28 @@ void SavingVideoRecorder::newFrameSlot()
 	vtkImageDataPtr image = mSource->getVtkImageData();
 	TimeInfo timestamp = mSource->getAdvancedTimeInfo();
 	QString filename = mSaveThread->addData(timestamp, image);
+	if (filename.isEmpty())
+		return; // dropped
 
 	mImages->append(filename);
 	mTimestamps.push_back(timestamp);
 }
 
+void SavingVideoRecorder::setQueueSettings(VideoRecorderSaveThread::QueueSettings settings)
+{
+	mSaveThread->setQueueSettings(settings);
+}
+
+VideoRecorderMetrics SavingVideoRecorder::getMetrics() const
+{
+	return mSaveThread->getMetrics();
+}
+
+VideoStageTelemetryPtr SavingVideoRecorder::getTelemetry()
+{
+	return mSaveThread->getTelemetry();
+}
+
 CachedImageDataContainerPtr SavingVideoRecorder::getImageData()
 {
 	return mImages;
@@ -258,6 +532,17 @@ void SavingVideoRecorder::completeSave()
 {
 	mSaveThread->stop();
 	mSaveThread->wait(); // wait indefinitely for thread to finish
+
+	VideoRecorderMetrics metrics = mSaveThread->getMetrics();
+	if (metrics.mDroppedFrames)
+		reportWarning(QString("Recording of %1 dropped %2 frames due to full save queue.").arg(mPrefix).arg(metrics.mDroppedFrames));
+	reportDebug(QString("Recording of %1: wrote %2 frames, %3 MB, %4 MB/s, max queue depth %5, spilled %6 frames.")
+				.arg(mPrefix)
+				.arg(metrics.mWrittenFrames)
+				.arg(metrics.mWrittenMB, 0, 'f', 1)
+				.arg(metrics.mWriteMBPerSecond, 0, 'f', 1)
+				.arg(metrics.mMaxQueueDepth)
+				.arg(metrics.mSpilledFrames));
 }
 
 } // namespace cx
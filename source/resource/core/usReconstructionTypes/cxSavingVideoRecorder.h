@@ -14,9 +14,11 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxResourceExport.h"
 
 #include <vector>
+#include <list>
 #include <QFile>
 #include <QThread>
 #include <QMutex>
+#include <QWaitCondition>
 
 #include "vtkForwardDeclarations.h"
 #include "cxForwardDeclarations.h"
@@ -25,6 +27,31 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 namespace cx
 {
 typedef boost::shared_ptr<class CachedImageDataContainer> CachedImageDataContainerPtr;
+typedef boost::shared_ptr<class VideoStageTelemetry> VideoStageTelemetryPtr;
+
+/** Live state of a VideoRecorderSaveThread.
+ *
+ * \ingroup cx_resource_usreconstructiontypes
+ */
+struct cxResource_EXPORT VideoRecorderMetrics
+{
+	VideoRecorderMetrics() :
+		mQueueDepth(0),
+		mMaxQueueDepth(0),
+		mDroppedFrames(0),
+		mSpilledFrames(0),
+		mWrittenFrames(0),
+		mWrittenMB(0),
+		mWriteMBPerSecond(0)
+	{}
+	int mQueueDepth; ///< frames in memory waiting to be written
+	int mMaxQueueDepth; ///< largest queue depth seen
+	int mDroppedFrames; ///< frames discarded because the queue was full
+	int mSpilledFrames; ///< frames written directly to disk because the queue was full
+	int mWrittenFrames;
+	double mWrittenMB; ///< uncompressed size of written frames
+	double mWriteMBPerSecond; ///< recent write rate, uncompressed size
+};
 
 /** Class that saves vtkImageData continously to file.
   *
@@ -36,6 +63,17 @@ typedef boost::shared_ptr<class CachedImageDataContainer> CachedImageDataContain
   * A sequence of N files named \<prefix\>_i.mhd (0<i<N) and corresponding .raw
   * files are written.
   *
+  * Incoming frames are copied into buffers from a recycled pool and put on a
+  * queue. The queue can be bounded, see QueueSettings: When full, new frames
+  * either block the caller for a while, are dropped, or are spilled: handed to
+  * a separate thread writing them to disk, bypassing the queue. The save
+  * thread takes frames from the queue in batches, writes (and compresses)
+  * each batch on several threads, then appends the timestamps in frame order.
+  * All frames are written once, in the final format.
+  *
+  * The telemetry records the time each frame waited from addData() until
+  * written, and counts frames dropped by a full queue or by cancel().
+  *
   * If stop() is called, the thread will continue to write all remaining data,
   * then close files and return from run().
   *
@@ -49,35 +87,75 @@ class cxResource_EXPORT VideoRecorderSaveThread : public QThread
 {
 	Q_OBJECT
 public:
+	enum QUEUE_POLICY
+	{
+		qpBLOCK, ///< wait in addData() until there is room in the queue, drop the frame after mBlockTimeout
+		qpDROP, ///< discard the new frame
+		qpSPILL_TO_DISK ///< write the new frame on the spill thread, bypassing the queue. Drop if the spill thread is full too.
+	};
+	struct QueueSettings
+	{
+		QueueSettings() :
+			mMaxQueueSize(0),
+			mPolicy(qpSPILL_TO_DISK),
+			mWriterThreads(0),
+			mBlockTimeout(1000)
+		{}
+		int mMaxQueueSize; ///< max number of frames in memory, 0 means unbounded
+		QUEUE_POLICY mPolicy; ///< action when the queue is full
+		int mWriterThreads; ///< number of frames written in parallel, 0 means automatic
+		int mBlockTimeout; ///< max ms to wait in addData() for qpBLOCK
+	};
+
 	/**
 	  * Create the thread object, set folder to save to.
 	  */
 	VideoRecorderSaveThread(QObject* parent, QString saveFolder, QString prefix, bool compressed, bool writeColor);
 	virtual ~VideoRecorderSaveThread();
+	void setQueueSettings(QueueSettings settings);
 	/**
 	  * Add data to be saved.
+	  * Return the filename the data will be written to, or empty if the data was dropped.
 	  */
 	QString addData(TimeInfo timestamp, vtkImageDataPtr data);
 	void stop();
 	void cancel();
+	VideoRecorderMetrics getMetrics() const;
+	VideoStageTelemetryPtr getTelemetry() { return mTelemetry; }
 
 protected:
 	struct DataType
 	{
+		DataType() : mQueuedTime(0), mSpilled(false), mSpillIndex(0) {}
 		TimeInfo mTimestamp;
+		double mQueuedTime; ///< see VideoStageTelemetry::now()
 		QString mImageFilename;
 		vtkImageDataPtr mImage;
+		bool mSpilled; ///< image handed to the spill thread, only the timestamp remains
+		quint64 mSpillIndex; ///< order of a spilled frame on the spill thread
 	};
 	QString mSaveFolder;
 	QString mPrefix;
 	int mImageIndex;
 	std::list<DataType> mPendingData;
-	QMutex mMutex; ///< protects the mPendingData
+	mutable QMutex mMutex; ///< protects mPendingData, mFreeBuffers, mQueueSettings and mMetrics
+	QWaitCondition mDataAvailable;
+	QWaitCondition mSpaceAvailable;
 	bool mStop;
 	bool mCancel;
 	QFile mTimestampsFile;
 	bool mCompressed;
 	bool mWriteColor;
+	QueueSettings mQueueSettings;
+	VideoRecorderMetrics mMetrics;
+	VideoStageTelemetryPtr mTelemetry;
+	std::vector<vtkImageDataPtr> mFreeBuffers; ///< recycled frame buffers
+	std::list<DataType> mSpillData; ///< spilled frames waiting to be written
+	QWaitCondition mSpillAvailable;
+	quint64 mSpillCount; ///< frames handed to the spill thread
+	quint64 mSpillWritten; ///< frames written by the spill thread, in spill order
+	bool mSpillStop;
+	boost::shared_ptr<QThread> mSpillThread;
 	/**
 	  * Save the images to disk
 	  */
@@ -86,8 +164,18 @@ protected:
 	void writeQueue();
 	bool openTimestampsFile();
 	bool closeTimestampsFile();
-	void write(DataType data);
+	void write(DataType data, bool compressed);
 	void writeTimeStampsFile(TimeInfo timeStamps);
+
+private:
+	bool isQueueFull() const;
+	int getWriterThreads() const;
+	std::vector<DataType> takeBatch();
+	void writeBatch(std::vector<DataType> batch);
+	void writeSpilled();
+	void stopSpillThread();
+	vtkImageDataPtr copyToBuffer(vtkImageDataPtr image);
+	void releaseBuffer(vtkImageDataPtr buffer);
 };
 
 /** \brief Recorder for a VideoSource.
@@ -123,6 +211,10 @@ public:
 
 	VideoSourcePtr getSource() { return mSource; }
 
+	void setQueueSettings(VideoRecorderSaveThread::QueueSettings settings);
+	VideoRecorderMetrics getMetrics() const;
+	VideoStageTelemetryPtr getTelemetry();
+
 private slots:
 	void newFrameSlot();
 private:
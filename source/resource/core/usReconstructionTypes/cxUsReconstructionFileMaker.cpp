@@ -30,7 +30,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxImageDataContainer.h"
 #include "cxUSReconstructInputDataAlgoritms.h"
 #include "cxCustomMetaImage.h"
-#include "cxErrorObserver.h"
+#include "cxMetaImageIO.h"
+#include "cxEnumConversion.h"
+#include "cxUtilHelpers.h"
+#include "cxUsReconstructionSidecar.h"
 
 
 typedef vtkSmartPointer<vtkImageAppend> vtkImageAppendPtr;
@@ -332,31 +335,81 @@ void UsReconstructionFileMaker::report()
 	}
 }
 
+/** Write each frame, with its final header, into path.
+ *
+ * Frames recorded to cache files in the requested compression are hard
+ * linked into path, falling back to a copy, and only the header is
+ * rewritten. The cache file stays valid for readers of images. Other
+ * frames are read and encoded by MetaImageIO. Neither takes the global
+ * vtk mutex.
+ */
 void UsReconstructionFileMaker::writeUSImages(QString path, ImageDataContainerPtr images, bool compression, std::vector<TimedPosition> pos)
 {
 	CX_ASSERT(images->size()==pos.size());
-	vtkMetaImageWriterPtr writer = vtkMetaImageWriterPtr::New();
+	CachedImageDataContainerPtr cached = boost::dynamic_pointer_cast<CachedImageDataContainer>(images);
 
 	for (unsigned i=0; i<images->size(); ++i)
 	{
-		vtkImageDataPtr currentImage = images->get(i);
 		QString filename = QString("%1/%2_%3.mhd").arg(path).arg(mSessionDescription).arg(i);
 
-		writer->SetInputData(currentImage);
-		writer->SetFileName(cstring_cast(filename));
-		writer->SetCompression(compression);
+		MetaImageHeader source;
+		bool onFile = cached && source.read(cached->getFilename(i)) && MetaImageIO::canRead(source);
+		bool sourceCompressed = source.getValue("CompressedData").toLower() == "true";
+		bool success = false;
+
+		if (onFile && !source.isLocalData() && (sourceCompressed == compression))
 		{
-			StaticMutexVtkLocker lock;
-			writer->Write();
+			success = this->copyUSImage(source, filename, pos[i].mPos);
+		}
+		else
+		{
+			vtkImageDataPtr image = onFile ? MetaImageIO().read(source) : images->get(i);
+			success = this->writeUSImage(image, filename, compression, pos[i].mPos);
 		}
 
-		CustomMetaImagePtr customReader = CustomMetaImage::create(filename);
-		customReader->setTransform(pos[i].mPos);
-		customReader->setModality(imUS);
-		customReader->setImageType(convertToImageSubType(mSessionDescription));
+		if (!success)
+			reportError("Failed to write US frame " + filename);
 	}
 }
 
+void UsReconstructionFileMaker::setUSImageKeys(MetaImageHeader* header, Transform3D rMu) const
+{
+	header->setTransform(rMu);
+	header->setValue("Modality", enum2string(imUS));
+	header->setValue("ImageType3", enum2string(convertToImageSubType(mSessionDescription)));
+}
+
+bool UsReconstructionFileMaker::writeUSImage(vtkImageDataPtr image, QString filename, bool compression, Transform3D rMu)
+{
+	if (!image)
+		return false;
+
+	MetaImageHeader header = MetaImageIO::createHeader(image);
+	this->setUSImageKeys(&header, rMu);
+
+	MetaImageIO io;
+	io.setCompression(compression);
+	return io.write(image, filename, header);
+}
+
+bool UsReconstructionFileMaker::copyUSImage(MetaImageHeader header, QString filename, Transform3D rMu)
+{
+	QString sourceData = header.getDataFilename();
+	QString targetData = changeExtension(filename, QFileInfo(sourceData).suffix());
+
+	this->setUSImageKeys(&header, rMu);
+	header.setValue("ElementDataFile", QFileInfo(targetData).fileName());
+
+	if (!linkOrCopyFile(sourceData, targetData))
+		return false;
+
+	QFile file(filename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+	QByteArray text = header.toString().toLatin1();
+	return file.write(text) == text.size();
+}
+
 void UsReconstructionFileMaker::writeMask(QString path, QString session, vtkImageDataPtr mask)
 {
 	QString filename = QString("%1/%2.mask.mhd").arg(path).arg(session);
@@ -374,6 +427,16 @@ void UsReconstructionFileMaker::writeMask(QString path, QString session, vtkImag
 }
 
 
+bool UsReconstructionFileMaker::writeSidecar(QString reconstructionFolder, QString session)
+{
+	QString filename = UsReconstructionSidecar::getFilename(reconstructionFolder, session);
+	bool success = UsReconstructionSidecar::write(filename, mReconstructData.mFrames, mReconstructData.mPositions);
+
+	QFileInfo info(filename);
+	mReport << QString("%1, %2 bytes, binary frame and tracking positions.").arg(info.fileName()).arg(info.size());
+	return success;
+}
+
 void UsReconstructionFileMaker::writeREADMEFile(QString reconstructionFolder, QString session)
 {
 	QString text = ""
@@ -409,6 +472,7 @@ QString UsReconstructionFileMaker::writeToNewFolder(QString path, bool compressi
 	this->writeTrackerTransforms(path, session, mReconstructData.mPositions);
 	this->writeUSTimestamps(path, session, mReconstructData.mFrames);
 	this->writeUSTransforms(path, session, mReconstructData.mFrames);
+	this->writeSidecar(path, session);
 	this->writeProbeConfiguration(path, session, mReconstructData.mProbeDefinition.mData, mReconstructData.mProbeUid);
 	this->writeMask(path, session, mReconstructData.getMask());
 	this->writeREADMEFile(path, session);
@@ -20,6 +20,7 @@ class QDir;
 #include "cxTool.h"
 #include "cxUSReconstructInputData.h"
 #include "cxForwardDeclarations.h"
+#include "cxMetaImageHeader.h"
 
 
 namespace cx
@@ -93,7 +94,11 @@ private:
 	bool writeTrackerTransforms(QString reconstructionFolder, QString session, std::vector<TimedPosition> ts);
 	bool writeTrackerTimestamps(QString reconstructionFolder, QString session, std::vector<TimedPosition> ts);
 	void writeProbeConfiguration(QString reconstructionFolder, QString session, ProbeDefinition data, QString uid);
+	bool writeSidecar(QString reconstructionFolder, QString session);
 	void writeUSImages(QString path, ImageDataContainerPtr images, bool compression, std::vector<TimedPosition> pos);
+	bool writeUSImage(vtkImageDataPtr image, QString filename, bool compression, Transform3D rMu);
+	bool copyUSImage(MetaImageHeader header, QString filename, Transform3D rMu);
+	void setUSImageKeys(MetaImageHeader* header, Transform3D rMu) const;
 	void writeMask(QString path, QString session, vtkImageDataPtr mask);
 	void writeREADMEFile(QString reconstructionFolder, QString session);
 	bool writeTimestamps(QString filename, std::vector<TimedPosition> ts, QString type, TimeStampType timeStampType = Modified);
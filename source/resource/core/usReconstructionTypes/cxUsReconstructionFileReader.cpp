@@ -23,6 +23,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxCreateProbeDefinitionFromConfiguration.h"
 #include "cxVolumeHelpers.h"
 #include "cxUSFrameData.h"
+#include "cxUsReconstructionSidecar.h"
 
 namespace cx
 {
@@ -77,8 +78,11 @@ USReconstructInputData UsReconstructionFileReader::readAllFiles(QString fileName
   retval.mProbeDefinition.setData(probeDefinition);
   retval.mProbeUid = probeDefinitionFull.first;
 
-  retval.mFrames = this->readFrameTimestamps(fileName);
-  retval.mPositions = this->readPositions(fileName);
+  if (!this->readSidecar(fileName, &retval))
+  {
+    retval.mFrames = this->readFrameTimestamps(fileName);
+    retval.mPositions = this->readPositions(fileName);
+  }
 
 	if (!this->valid(retval))
 	{
@@ -228,6 +232,37 @@ USFrameDataPtr UsReconstructionFileReader::readUsDataFile(QString mhdFileName)
 	return USFrameData::create(mhdFileName, mFileManagerService);
 }
 
+/** Read frame and tracking positions from the binary sidecar, if it is
+ *  current and matches the number of images. Return false otherwise,
+ *  making the caller read the text files.
+ *  The frame transforms are reset, as when reading the text files.
+ */
+bool UsReconstructionFileReader::readSidecar(QString fileName, USReconstructInputData* data)
+{
+  QString filename = changeExtension(fileName, "sweep");
+  if (!UsReconstructionSidecar::isCurrent(filename))
+    return false;
+
+  std::vector<TimedPosition> frames;
+  std::vector<TimedPosition> positions;
+  if (!UsReconstructionSidecar::read(filename, &frames, &positions))
+    return false;
+
+  if (data->mUsRaw && (data->mUsRaw->getNumImages() != frames.size()))
+  {
+    reportWarning(QString("%1 has %2 frames, expected %3, reading the text files instead.")
+                  .arg(QFileInfo(filename).fileName()).arg(frames.size()).arg(data->mUsRaw->getNumImages()));
+    return false;
+  }
+
+  for (unsigned i=0; i<frames.size(); ++i)
+    frames[i].mPos = Transform3D::Identity();
+
+  data->mFrames = frames;
+  data->mPositions = positions;
+  return true;
+}
+
 std::vector<TimedPosition> UsReconstructionFileReader::readFrameTimestamps(QString fileName)
 {
   bool useOldFormat = !QFileInfo(changeExtension(fileName, "fts")).exists();
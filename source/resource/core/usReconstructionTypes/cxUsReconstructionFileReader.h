@@ -140,6 +140,7 @@ public:
 	USReconstructInputData readAllFiles(QString fileName, QString calFilesPath = "");
 
 	std::vector<TimedPosition> readFrameTimestamps(QString fileName);
+	std::vector<TimedPosition> readPositions(QString fileName); ///< tracking positions prMt with timestamps
 	/**
 	  * Read probe data from the probedata config file attached to the mhd file,
 	  * named \<mhdfilename-base\>.probedata.xml
@@ -148,7 +149,7 @@ public:
 
 private:
 	bool valid(USReconstructInputData input);
-	std::vector<TimedPosition> readPositions(QString fileName);
+	bool readSidecar(QString fileName, USReconstructInputData* data);
 	bool readMaskFile(QString mhdFileName, ImagePtr mask);
 	USFrameDataPtr readUsDataFile(QString mhdFileName);
 
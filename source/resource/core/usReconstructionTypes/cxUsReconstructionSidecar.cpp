@@ -0,0 +1,164 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxUsReconstructionSidecar.h"
+
+#include <QFile>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QStringList>
+#include "cxLogger.h"
+#include "cxUtilHelpers.h"
+
+namespace cx
+{
+
+namespace
+{
+const char sidecarMagic[] = "CXSWEEP1";
+const int sidecarMagicSize = 8;
+
+void writeTransform(QDataStream& stream, const Transform3D& M)
+{
+	for (int r=0; r<3; ++r)
+		for (int c=0; c<4; ++c)
+			stream << M(r,c);
+}
+
+Transform3D readTransform(QDataStream& stream)
+{
+	Transform3D M = Transform3D::Identity();
+	for (int r=0; r<3; ++r)
+		for (int c=0; c<4; ++c)
+			stream >> M(r,c);
+	return M;
+}
+}
+
+QString UsReconstructionSidecar::getFilename(QString folder, QString session)
+{
+	return folder+"/"+session+".sweep";
+}
+
+bool UsReconstructionSidecar::write(QString filename, const std::vector<TimedPosition>& frames, const std::vector<TimedPosition>& positions)
+{
+	QFile file(filename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		reportError("Cannot open "+file.fileName());
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+	stream.writeRawData(sidecarMagic, sidecarMagicSize);
+	stream << quint32(frames.size()) << quint32(positions.size());
+
+	for (unsigned i=0; i<frames.size(); ++i)
+	{
+		stream << frames[i].mTime;
+		stream << frames[i].mTimeInfo.getScannerAcquisitionTime();
+		stream << frames[i].mTimeInfo.getSoftwareAcquisitionTime();
+		writeTransform(stream, frames[i].mPos);
+	}
+
+	for (unsigned i=0; i<positions.size(); ++i)
+	{
+		stream << positions[i].mTime;
+		writeTransform(stream, positions[i].mPos);
+	}
+
+	return stream.status() == QDataStream::Ok;
+}
+
+bool UsReconstructionSidecar::read(QString filename, std::vector<TimedPosition>* frames, std::vector<TimedPosition>* positions)
+{
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream stream(&file);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+	char magic[sidecarMagicSize];
+	if ((stream.readRawData(magic, sidecarMagicSize) != sidecarMagicSize) || (QByteArray(magic, sidecarMagicSize) != sidecarMagic))
+	{
+		reportWarning("Invalid sweep sidecar file: " + filename);
+		return false;
+	}
+
+	quint32 frameCount = 0;
+	quint32 positionCount = 0;
+	stream >> frameCount >> positionCount;
+
+	// guard against truncated files before allocating
+	qint64 frameBytes = sizeof(double)*(3+12);
+	qint64 positionBytes = sizeof(double)*(1+12);
+	if (file.size() < file.pos() + frameCount*frameBytes + positionCount*positionBytes)
+	{
+		reportWarning("Truncated sweep sidecar file: " + filename);
+		return false;
+	}
+
+	std::vector<TimedPosition> readFrames(frameCount);
+	for (unsigned i=0; i<readFrames.size(); ++i)
+	{
+		double scanner = 0;
+		double arrive = 0;
+		stream >> readFrames[i].mTime >> scanner >> arrive;
+		readFrames[i].mTimeInfo.setAcquisitionTime(readFrames[i].mTime);
+		readFrames[i].mTimeInfo.mOriginalAcquisitionTime.setMSecsSinceEpoch(scanner);
+		readFrames[i].mTimeInfo.mSoftwareAcquisitionTime.setMSecsSinceEpoch(arrive);
+		readFrames[i].mPos = readTransform(stream);
+	}
+
+	std::vector<TimedPosition> readPositions(positionCount);
+	for (unsigned i=0; i<readPositions.size(); ++i)
+	{
+		stream >> readPositions[i].mTime;
+		readPositions[i].mTimeInfo.setAcquisitionTime(readPositions[i].mTime);
+		readPositions[i].mPos = readTransform(stream);
+	}
+
+	if (stream.status() != QDataStream::Ok)
+	{
+		reportWarning("Failed to read sweep sidecar file: " + filename);
+		return false;
+	}
+
+	*frames = readFrames;
+	*positions = readPositions;
+	return true;
+}
+
+bool UsReconstructionSidecar::isCurrent(QString filename)
+{
+	QFileInfo sidecar(filename);
+	if (!sidecar.exists())
+		return false;
+
+	QStringList textFiles = QStringList() << "fts" << "fp" << "tts" << "tp";
+	foreach (QString suffix, textFiles)
+	{
+		QFileInfo text(changeExtension(filename, suffix));
+		if (text.exists() && (text.lastModified() > sidecar.lastModified()))
+		{
+			reportWarning(QString("%1 is newer than %2, ignoring the sidecar.").arg(text.fileName()).arg(sidecar.fileName()));
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace cx
@@ -0,0 +1,66 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXUSRECONSTRUCTIONSIDECAR_H
+#define CXUSRECONSTRUCTIONSIDECAR_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <QString>
+#include "cxUSReconstructInputData.h"
+
+namespace cx
+{
+
+/**
+* \file
+* \addtogroup cx_resource_usreconstructiontypes
+* @{
+*/
+
+/** \brief Binary storage of the frame and tracking positions of an US acquisition.
+ *
+ * The \<session\>.sweep file holds the same timestamps and transforms as the
+ * .fts/.fp/.tts/.tp text files, in little endian doubles:
+ *
+ *  - The magic "CXSWEEP1", followed by the number of frames and number of
+ *    tracking positions as 32 bit unsigned.
+ *  - For each frame: acquisition, scanner and software arrive time, followed
+ *    by the upper 3 rows of rMu, row major.
+ *  - For each tracking position: time, followed by the upper 3 rows of prMt.
+ *
+ * The text files are still written alongside for compatibility, and are
+ * authoritative: readers use the sidecar only if isCurrent(), avoiding text
+ * parsing of large sweeps, and fall back to the text files otherwise.
+ */
+class cxResource_EXPORT UsReconstructionSidecar
+{
+public:
+	static QString getFilename(QString folder, QString session);
+	static bool write(QString filename, const std::vector<TimedPosition>& frames, const std::vector<TimedPosition>& positions);
+	/** Read frames and positions from filename. Return false if the file is
+	 *  missing or invalid, in which case frames and positions are unchanged.
+	 */
+	static bool read(QString filename, std::vector<TimedPosition>* frames, std::vector<TimedPosition>* positions);
+	/** Return true if filename exists and none of the text files
+	 *  beside it has been modified after it.
+	 */
+	static bool isCurrent(QString filename);
+};
+
+/**
+* @}
+*/
+
+} // namespace cx
+
+#endif // CXUSRECONSTRUCTIONSIDECAR_H
@@ -10,6 +10,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 =========================================================================*/
 
 #include "catch.hpp"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
 #include <vtkPolyData.h>
 
 #include "cxtestUSReconstructionFileFixture.h"
@@ -19,6 +23,9 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxDataLocations.h"
 #include "cxLogicManager.h"
 #include "cxFileManagerServiceProxy.h"
+#include "cxUsReconstructionSidecar.h"
+#include "cxTransform3D.h"
+#include "cxUtilHelpers.h"
 
 
 TEST_CASE_METHOD(cxtest::USReconstructionFileFixture, "USReconstructionFile: Create unique folders", "[unit][resource][usReconstructionTypes]")
@@ -79,3 +86,67 @@ TEST_CASE_METHOD(cxtest::USReconstructionFileFixture, "USReconstructionFile: Sav
 	this->assertCorrespondence(input, hasBeenRead);
 	cx::LogicManager::shutdown();
 }
+
+TEST_CASE_METHOD(cxtest::USReconstructionFileFixture, "USReconstructionFile: Binary sidecar roundtrip", "[unit][resource][usReconstructionTypes]")
+{
+	QDir().mkpath(this->getDataPath());
+	QString filename = cx::UsReconstructionSidecar::getFilename(this->getDataPath(), "test_session");
+
+	std::vector<cx::TimedPosition> frames(3);
+	std::vector<cx::TimedPosition> positions(5);
+	for (unsigned i=0; i<frames.size(); ++i)
+	{
+		frames[i].mTime = 1000.25 + i*33.3;
+		frames[i].mTimeInfo.setAcquisitionTime(frames[i].mTime);
+		frames[i].mPos = cx::createTransformTranslate(cx::Vector3D(i, 2*i, 0.1)) * cx::createTransformRotateZ(0.1*i);
+	}
+	for (unsigned i=0; i<positions.size(); ++i)
+	{
+		positions[i].mTime = 990.5 + i*20;
+		positions[i].mPos = cx::createTransformRotateX(0.2*i) * cx::createTransformTranslate(cx::Vector3D(0, i, 3));
+	}
+
+	REQUIRE(cx::UsReconstructionSidecar::write(filename, frames, positions));
+
+	std::vector<cx::TimedPosition> readFrames;
+	std::vector<cx::TimedPosition> readPositions;
+	REQUIRE(cx::UsReconstructionSidecar::read(filename, &readFrames, &readPositions));
+	REQUIRE(readFrames.size() == frames.size());
+	REQUIRE(readPositions.size() == positions.size());
+	for (unsigned i=0; i<frames.size(); ++i)
+	{
+		CHECK(readFrames[i].mTime == frames[i].mTime);
+		CHECK(cx::similar(readFrames[i].mPos, frames[i].mPos));
+	}
+	for (unsigned i=0; i<positions.size(); ++i)
+	{
+		CHECK(readPositions[i].mTime == positions[i].mTime);
+		CHECK(cx::similar(readPositions[i].mPos, positions[i].mPos));
+	}
+
+	CHECK_FALSE(cx::UsReconstructionSidecar::read(filename+".missing", &readFrames, &readPositions));
+}
+
+TEST_CASE_METHOD(cxtest::USReconstructionFileFixture, "USReconstructionFile: Sidecar older than the text files is not current", "[unit][resource][usReconstructionTypes]")
+{
+	QDir().mkpath(this->getDataPath());
+	QString filename = cx::UsReconstructionSidecar::getFilename(this->getDataPath(), "test_session");
+	QString textFile = cx::changeExtension(filename, "tp");
+	QFile::remove(textFile);
+
+	REQUIRE(cx::UsReconstructionSidecar::write(filename, std::vector<cx::TimedPosition>(2), std::vector<cx::TimedPosition>(3)));
+	CHECK(cx::UsReconstructionSidecar::isCurrent(filename));
+	CHECK_FALSE(cx::UsReconstructionSidecar::isCurrent(filename+".missing"));
+
+	// set the time explicitly, as file time resolution may be as coarse as seconds
+	QDateTime sidecarTime = QFileInfo(filename).lastModified();
+	QFile file(textFile);
+	REQUIRE(file.open(QIODevice::WriteOnly));
+	file.write("0 1 0 0 0 0 1 0 0 0 0 1 0\n");
+	file.flush(); // a later flush would reset the time
+	REQUIRE(file.setFileTime(sidecarTime.addSecs(10), QFileDevice::FileModificationTime));
+	file.close();
+	CHECK_FALSE(cx::UsReconstructionSidecar::isCurrent(filename));
+
+	QFile::remove(textFile);
+}
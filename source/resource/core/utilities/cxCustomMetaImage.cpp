@@ -87,32 +87,27 @@ CustomMetaImage::CustomMetaImage(QString filename) :
     mFilename(filename)
 {}
 
-QString CustomMetaImage::readKey(QString key)
+const MetaImageHeader& CustomMetaImage::getHeader()
 {
-	QFile file(mFilename);
-
-	QString line;
-	if (file.open(QIODevice::ReadOnly))
+	if (!mHeader)
 	{
-		QTextStream t(&file);
-		while (!t.atEnd())
-		{
-			line.clear();
-			line = t.readLine();
-			// do something with the line
-			if (line.startsWith(key, Qt::CaseInsensitive))
-			{
-				QStringList list = line.split("=", QString::SkipEmptyParts);
-				if (list.size() >= 2)
-				{
-					list = list.mid(1);
-					return list.join("=");
-				}
-			}
-		}
-		file.close();
+		mHeader.reset(new MetaImageHeader());
+		mHeader->read(mFilename);
 	}
+	return *mHeader;
+}
 
+/** Return the value of the first key starting with key (case insensitive),
+  * as the line based reader did before the header was cached.
+  *
+  */
+QString CustomMetaImage::readKey(QString key)
+{
+	const MetaImageHeader& header = this->getHeader();
+	QStringList keys = header.getKeys();
+	for (int i=0; i<keys.size(); ++i)
+		if (keys[i].startsWith(key, Qt::CaseInsensitive))
+			return header.getValue(keys[i]);
 	return "";
 }
 
@@ -168,6 +163,7 @@ void CustomMetaImage::setKey(QString key, QString value)
 
 	file.resize(0);
 	file.write(data.join("\n").toLatin1());
+	mHeader.reset();
 }
 
 void CustomMetaImage::setModality(IMAGE_MODALITY value)
@@ -183,61 +179,7 @@ void CustomMetaImage::setImageType(IMAGE_SUBTYPE value)
 
 Transform3D CustomMetaImage::readTransform()
 {
-  //read the specific TransformMatrix-tag from the header
-  Vector3D p_r(0, 0, 0);
-  Vector3D e_x(1, 0, 0);
-  Vector3D e_y(0, 1, 0);
-  Vector3D e_z(0, 0, 1);
-
-  QFile file(mFilename);
-
-  QString line;
-  if (file.open(QIODevice::ReadOnly))
-  {
-    QTextStream t(&file);
-    while (!t.atEnd())
-    {
-      line.clear();
-      line = t.readLine();
-      // do something with the line
-      if (line.startsWith("Position", Qt::CaseInsensitive) || line.startsWith("Offset", Qt::CaseInsensitive))
-      {
-        QStringList list = line.split(" ", QString::SkipEmptyParts);
-        if (list.size()>=5)
-          p_r = Vector3D(list[2].toDouble(), list[3].toDouble(), list[4].toDouble());
-      }
-      else if (line.startsWith("TransformMatrix", Qt::CaseInsensitive) || line.startsWith("Orientation",
-          Qt::CaseInsensitive))
-      {
-        QStringList list = line.split(" ", QString::SkipEmptyParts);
-
-        if (list.size()>=8)
-        {
-          e_x = Vector3D(list[2].toDouble(), list[3].toDouble(), list[4].toDouble());
-          e_y = Vector3D(list[5].toDouble(), list[6].toDouble(), list[7].toDouble());
-          e_z = cross(e_x, e_y);
-        }
-      }
-    }
-    file.close();
-  }
-
-  Transform3D rMd = Transform3D::Identity();
-
-  // add rotational part
-  for (unsigned i = 0; i < 3; ++i)
-  {
-    rMd(i,0) = e_x[i];
-    rMd(i,1) = e_y[i];
-    rMd(i,2) = e_z[i];
-  }
-
-
-  // add translational part
-  rMd(0,3) = p_r[0];
-  rMd(1,3) = p_r[1];
-  rMd(2,3) = p_r[2];
-  return rMd;
+	return this->getHeader().getTransform();
 }
 
 void CustomMetaImage::setTransform(const Transform3D M)
@@ -254,20 +196,14 @@ void CustomMetaImage::setTransform(const Transform3D M)
 
   this->remove(&data, QStringList()<<"TransformMatrix"<<"Offset"<<"Position"<<"Orientation");
 
-  int dim = 3; // hardcoded - will fail for 2d images
-  std::stringstream tmList;
-  for (int c=0; c<dim; ++c)
-    for (int r=0; r<dim; ++r)
-      tmList << " " << M(r,c);
-  this->append(&data, "TransformMatrix", qstring_cast(tmList.str()));
-
-  std::stringstream posList;
-  for (int r=0; r<dim; ++r)
-    posList << " " << M(r,3);
-  this->append(&data, "Offset", qstring_cast(posList.str()));
+  MetaImageHeader formatted;
+  formatted.setTransform(M);
+  this->append(&data, "TransformMatrix", formatted.getValue("TransformMatrix"));
+  this->append(&data, "Offset", formatted.getValue("Offset"));
 
   file.resize(0);
   file.write(data.join("\n").toLatin1());
+  mHeader.reset();
 }
 
 }
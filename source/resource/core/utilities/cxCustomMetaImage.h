@@ -16,6 +16,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QString>
 #include "cxTransform3D.h"
 #include "cxDefinitions.h"
+#include "cxMetaImageHeader.h"
 
 namespace cx
 {
@@ -30,6 +31,9 @@ typedef boost::shared_ptr<class CustomMetaImage> CustomMetaImagePtr;
  * This is meant as a supplement to vtkMetaImageReader/Writer,
  * extending that interface.
  *
+ * The header is parsed once on the first read, and reparsed
+ * only after it has been changed by one of the set methods.
+ *
  * \ingroup cx_resource_core_utilities
  */
 class cxResource_EXPORT CustomMetaImage
@@ -50,7 +54,9 @@ public:
   void setKey(QString key, QString value);
 
 private:
+  const MetaImageHeader& getHeader();
   QString mFilename;
+  boost::shared_ptr<MetaImageHeader> mHeader;
 
   void remove(QStringList* data, QStringList keys);
   void append(QStringList* data, QString key, QString value);
@@ -0,0 +1,270 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxMeshIO.h"
+
+#include <cmath>
+#include <algorithm>
+#include <QFile>
+#include <QFileInfo>
+#include <vtkPolyData.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkCellArray.h>
+#include <vtkShortArray.h>
+#include <vtkFloatArray.h>
+#include <vtkXMLPolyDataReader.h>
+#include <vtkXMLPolyDataWriter.h>
+#include <vtkTriangleFilter.h>
+#include <vtkQuadricDecimation.h>
+#include <vtkPolyDataNormals.h>
+#include "cxErrorObserver.h"
+#include "cxParallelFor.h"
+#include "cxTypeConversions.h"
+#include "cxLogger.h"
+
+typedef vtkSmartPointer<vtkShortArray> vtkShortArrayPtr;
+typedef vtkSmartPointer<vtkTriangleFilter> vtkTriangleFilterPtr;
+typedef vtkSmartPointer<vtkQuadricDecimation> vtkQuadricDecimationPtr;
+
+namespace cx
+{
+
+namespace
+{
+const char* QUANTIZED_NORMALS_PREFIX = "cxOctNormals:";
+const size_t COMPRESSION_BLOCK_SIZE = 1024*1024;
+const double OCT_SCALE = 32767.0;
+
+double signNotZero(double v)
+{
+	return (v < 0.0) ? -1.0 : 1.0;
+}
+
+void encodeOctahedral(const double* n, short* out)
+{
+	double l1 = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+	double u = 0;
+	double v = 0;
+	if (l1 > 0)
+	{
+		u = n[0]/l1;
+		v = n[1]/l1;
+		if (n[2] < 0)
+		{
+			double pu = u;
+			u = (1.0-std::fabs(v))*signNotZero(pu);
+			v = (1.0-std::fabs(pu))*signNotZero(v);
+		}
+	}
+	out[0] = static_cast<short>(std::lround(std::max(-1.0, std::min(1.0, u))*OCT_SCALE));
+	out[1] = static_cast<short>(std::lround(std::max(-1.0, std::min(1.0, v))*OCT_SCALE));
+}
+
+void decodeOctahedral(const short* in, float* n)
+{
+	double u = in[0]/OCT_SCALE;
+	double v = in[1]/OCT_SCALE;
+	double z = 1.0 - std::fabs(u) - std::fabs(v);
+	if (z < 0)
+	{
+		double pu = u;
+		u = (1.0-std::fabs(v))*signNotZero(pu);
+		v = (1.0-std::fabs(pu))*signNotZero(v);
+	}
+	double length = std::sqrt(u*u + v*v + z*z);
+	n[0] = u/length;
+	n[1] = v/length;
+	n[2] = z/length;
+}
+
+/** Replace the normals of attributes with an octahedral encoded array.
+ *  attributes must be owned by a shallow copy, the arrays are not modified.
+ */
+void quantizeNormals(vtkDataSetAttributes* attributes)
+{
+	vtkDataArray* normals = attributes->GetNormals();
+	if (!normals || normals->GetNumberOfComponents()!=3)
+		return;
+
+	QString name = normals->GetName() ? QString(normals->GetName()) : QString("Normals");
+	vtkIdType count = normals->GetNumberOfTuples();
+	vtkShortArrayPtr quantized = vtkShortArrayPtr::New();
+	quantized->SetName(cstring_cast(QUANTIZED_NORMALS_PREFIX + name));
+	quantized->SetNumberOfComponents(2);
+	quantized->SetNumberOfTuples(count);
+	short* out = quantized->GetPointer(0);
+
+	parallelFor(0, static_cast<int>(count), [normals, out](int i)
+	{
+		double n[3];
+		normals->GetTuple(i, n);
+		encodeOctahedral(n, out+2*i);
+	}, 64*1024);
+
+	vtkSmartPointer<vtkDataArray> keepAlive = normals;
+	attributes->RemoveArray(normals->GetName());
+	attributes->AddArray(quantized);
+}
+
+/** Decode arrays written by quantizeNormals() and set them as normals.
+ */
+void restoreNormals(vtkDataSetAttributes* attributes)
+{
+	QString prefix(QUANTIZED_NORMALS_PREFIX);
+	for (int a=0; a<attributes->GetNumberOfArrays(); ++a)
+	{
+		vtkShortArray* quantized = vtkShortArray::SafeDownCast(attributes->GetArray(a));
+		if (!quantized || !quantized->GetName() || quantized->GetNumberOfComponents()!=2)
+			continue;
+		QString name(quantized->GetName());
+		if (!name.startsWith(prefix))
+			continue;
+
+		vtkIdType count = quantized->GetNumberOfTuples();
+		vtkFloatArrayPtr normals = vtkFloatArrayPtr::New();
+		normals->SetName(cstring_cast(name.mid(prefix.size())));
+		normals->SetNumberOfComponents(3);
+		normals->SetNumberOfTuples(count);
+		const short* in = quantized->GetPointer(0);
+		float* out = normals->GetPointer(0);
+
+		parallelFor(0, static_cast<int>(count), [in, out](int i)
+		{
+			decodeOctahedral(in+2*i, out+3*i);
+		}, 64*1024);
+
+		attributes->RemoveArray(quantized->GetName());
+		attributes->SetNormals(normals);
+		return;
+	}
+}
+
+vtkPolyDataPtr createReducedLevel(vtkPolyDataPtr input)
+{
+	vtkTriangleFilterPtr triangles = vtkTriangleFilterPtr::New();
+	triangles->SetInputData(input);
+	triangles->PassVertsOff();
+	triangles->PassLinesOff();
+
+	vtkQuadricDecimationPtr decimation = vtkQuadricDecimationPtr::New();
+	decimation->SetInputConnection(triangles->GetOutputPort());
+	decimation->SetTargetReduction(0.5);
+	decimation->VolumePreservationOn();
+
+	if (!input->GetPointData()->GetNormals())
+	{
+		decimation->Update();
+		return decimation->GetOutput();
+	}
+
+	vtkPolyDataNormalsPtr normals = vtkPolyDataNormalsPtr::New();
+	normals->SetInputConnection(decimation->GetOutputPort());
+	normals->SplittingOff();
+	normals->ConsistencyOff();
+	normals->Update();
+	return normals->GetOutput();
+}
+} // namespace
+
+MeshIO::MeshIO() :
+	mQuantizeNormals(true),
+	mLevelsOfDetail(0)
+{
+}
+
+QString MeshIO::getLevelOfDetailFilename(QString filename, int level)
+{
+	if (level <= 0)
+		return filename;
+	QFileInfo info(filename);
+	return QString("%1/%2_lod%3.%4").arg(info.absolutePath()).arg(info.completeBaseName()).arg(level).arg(info.suffix());
+}
+
+bool MeshIO::write(vtkPolyDataPtr polyData, QString filename)
+{
+	if (!polyData)
+		return false;
+	if (!this->writeSingle(polyData, filename))
+		return false;
+
+	bool hasTriangles = polyData->GetPolys()->GetNumberOfCells() > 0;
+	int level = 1;
+	vtkPolyDataPtr current = polyData;
+	for (; hasTriangles && level<=mLevelsOfDetail; ++level)
+	{
+		current = createReducedLevel(current);
+		if (!this->writeSingle(current, getLevelOfDetailFilename(filename, level)))
+			return false;
+	}
+
+	// remove levels left over from earlier saves
+	for (; QFile::exists(getLevelOfDetailFilename(filename, level)); ++level)
+		QFile::remove(getLevelOfDetailFilename(filename, level));
+
+	return true;
+}
+
+bool MeshIO::writeSingle(vtkPolyDataPtr polyData, QString filename)
+{
+	vtkPolyDataPtr copy = vtkPolyDataPtr::New();
+	copy->ShallowCopy(polyData);
+	if (mQuantizeNormals)
+	{
+		quantizeNormals(copy->GetPointData());
+		quantizeNormals(copy->GetCellData());
+	}
+
+	vtkXMLPolyDataWriterPtr writer = vtkXMLPolyDataWriterPtr::New();
+	writer->SetInputData(copy);
+	writer->SetFileName(cstring_cast(filename));
+	writer->SetDataModeToAppended();
+	writer->EncodeAppendedDataOff();
+	writer->SetHeaderTypeToUInt64();
+	writer->SetCompressorTypeToLZ4();
+	writer->SetBlockSize(COMPRESSION_BLOCK_SIZE);
+
+	if (!writer->Write())
+	{
+		reportError(QString("Failed to write mesh to %1").arg(filename));
+		return false;
+	}
+	return true;
+}
+
+vtkPolyDataPtr MeshIO::read(QString filename)
+{
+	vtkXMLPolyDataReaderPtr reader = vtkXMLPolyDataReaderPtr::New();
+	reader->SetFileName(cstring_cast(filename));
+
+	// Parsing takes the global vtk mutex like all other readers,
+	// the normal decoding below runs in parallel between meshes.
+	if (!ErrorObserver::checkedRead(reader, filename))
+		return vtkPolyDataPtr();
+
+	vtkPolyDataPtr polyData = reader->GetOutput();
+	restoreNormals(polyData->GetPointData());
+	restoreNormals(polyData->GetCellData());
+	return polyData;
+}
+
+vtkPolyDataPtr MeshIO::readLevelOfDetail(QString filename, int level)
+{
+	for (; level>0; --level)
+	{
+		QString lodFilename = getLevelOfDetailFilename(filename, level);
+		if (QFile::exists(lodFilename))
+			return this->read(lodFilename);
+	}
+	return this->read(filename);
+}
+
+} // namespace cx
@@ -0,0 +1,66 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXMESHIO_H
+#define CXMESHIO_H
+
+#include "cxResourceExport.h"
+
+#include <QString>
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+
+/** \brief Read and write meshes as binary, block compressed VTK XML (.vtp) files.
+ *
+ * The arrays are written raw and appended after the XML header,
+ * compressed with LZ4 in independent blocks, which is fast to decode
+ * and readable by any VTK XML reader.
+ *
+ * Normals are stored octahedral encoded as two 16 bit integers,
+ * giving an angular error below 0.01 degree at a third of the size,
+ * and decoded back to float normals by read().
+ *
+ * Optionally, precomputed levels of detail are written next to the
+ * mesh, as <name>_lod<level>.vtp, each level with roughly half the
+ * triangles of the previous.
+ *
+ * read() can be run on several meshes from worker threads. The file
+ * parsing is serialized by the global vtk mutex, as for all vtk readers,
+ * while the normal decoding runs in parallel.
+ *
+ * \ingroup cx_resource_core_utilities
+ */
+class cxResource_EXPORT MeshIO
+{
+public:
+	MeshIO();
+	void setLevelsOfDetail(int levels) { mLevelsOfDetail = levels; } ///< number of reduced levels written in addition to the full mesh
+	void setQuantizeNormals(bool on) { mQuantizeNormals = on; }
+
+	bool write(vtkPolyDataPtr polyData, QString filename);
+	vtkPolyDataPtr read(QString filename); ///< null on failure
+	/** Read a precomputed level of detail of filename, level 0 is the full mesh.
+	 *  Falls back to the nearest finer level if level is missing.
+	 */
+	vtkPolyDataPtr readLevelOfDetail(QString filename, int level);
+	static QString getLevelOfDetailFilename(QString filename, int level);
+
+private:
+	bool writeSingle(vtkPolyDataPtr polyData, QString filename);
+	bool mQuantizeNormals;
+	int mLevelsOfDetail;
+};
+
+} // namespace cx
+
+#endif // CXMESHIO_H
@@ -0,0 +1,201 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxMetaImageHeader.h"
+
+#include <sstream>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QRegExp>
+#include "cxTypeConversions.h"
+
+namespace cx
+{
+
+namespace
+{
+const qint64 MAX_HEADER_SIZE = 1024*1024; ///< stop looking for ElementDataFile after this
+const qint64 MAX_LINE_LENGTH = 64*1024;
+}
+
+MetaImageHeader::MetaImageHeader() :
+	mHeaderSize(0)
+{
+}
+
+bool MetaImageHeader::read(QString filename)
+{
+	mFilename = filename;
+	mEntries.clear();
+	mHeaderSize = 0;
+
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	while (!file.atEnd() && (file.pos() < MAX_HEADER_SIZE))
+	{
+		QByteArray line = file.readLine(MAX_LINE_LENGTH);
+		mHeaderSize = file.pos();
+		int separator = line.indexOf('=');
+		if (separator < 0)
+			continue;
+
+		QString key = QString::fromLatin1(line.left(separator)).trimmed();
+		QString value = QString::fromLatin1(line.mid(separator+1)).trimmed();
+		mEntries.push_back(std::make_pair(key, value));
+
+		if (key.compare("ElementDataFile", Qt::CaseInsensitive) == 0)
+			break;
+	}
+
+	return !mEntries.empty();
+}
+
+int MetaImageHeader::find(QString key) const
+{
+	for (unsigned i=0; i<mEntries.size(); ++i)
+		if (mEntries[i].first.compare(key, Qt::CaseInsensitive) == 0)
+			return i;
+	return -1;
+}
+
+bool MetaImageHeader::hasKey(QString key) const
+{
+	return this->find(key) >= 0;
+}
+
+QStringList MetaImageHeader::getKeys() const
+{
+	QStringList retval;
+	for (unsigned i=0; i<mEntries.size(); ++i)
+		retval << mEntries[i].first;
+	return retval;
+}
+
+QString MetaImageHeader::getValue(QString key) const
+{
+	int index = this->find(key);
+	if (index < 0)
+		return "";
+	return mEntries[index].second;
+}
+
+QStringList MetaImageHeader::getValues(QString key) const
+{
+	return this->getValue(key).split(QRegExp("\\s+"), QString::SkipEmptyParts);
+}
+
+void MetaImageHeader::setValue(QString key, QString value)
+{
+	int index = this->find(key);
+	if (index >= 0)
+	{
+		mEntries[index].second = value;
+		return;
+	}
+
+	int last = this->find("ElementDataFile");
+	if (last < 0)
+		mEntries.push_back(std::make_pair(key, value));
+	else
+		mEntries.insert(mEntries.begin()+last, std::make_pair(key, value));
+}
+
+void MetaImageHeader::removeKey(QString key)
+{
+	int index = this->find(key);
+	if (index >= 0)
+		mEntries.erase(mEntries.begin()+index);
+}
+
+QString MetaImageHeader::toString() const
+{
+	QString retval;
+	for (unsigned i=0; i<mEntries.size(); ++i)
+		retval += QString("%1 = %2\n").arg(mEntries[i].first).arg(mEntries[i].second);
+	return retval;
+}
+
+Transform3D MetaImageHeader::getTransform() const
+{
+	Vector3D p_r(0, 0, 0);
+	Vector3D e_x(1, 0, 0);
+	Vector3D e_y(0, 1, 0);
+	Vector3D e_z(0, 0, 1);
+
+	// later keys override earlier ones
+	for (unsigned i=0; i<mEntries.size(); ++i)
+	{
+		QString key = mEntries[i].first;
+		QStringList list = mEntries[i].second.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+		if (key.compare("Position", Qt::CaseInsensitive)==0 || key.compare("Offset", Qt::CaseInsensitive)==0)
+		{
+			if (list.size()>=3)
+				p_r = Vector3D(list[0].toDouble(), list[1].toDouble(), list[2].toDouble());
+		}
+		else if (key.compare("TransformMatrix", Qt::CaseInsensitive)==0 || key.compare("Orientation", Qt::CaseInsensitive)==0)
+		{
+			if (list.size()>=6)
+			{
+				e_x = Vector3D(list[0].toDouble(), list[1].toDouble(), list[2].toDouble());
+				e_y = Vector3D(list[3].toDouble(), list[4].toDouble(), list[5].toDouble());
+				e_z = cross(e_x, e_y);
+			}
+		}
+	}
+
+	Transform3D rMd = Transform3D::Identity();
+	for (unsigned i = 0; i < 3; ++i)
+	{
+		rMd(i,0) = e_x[i];
+		rMd(i,1) = e_y[i];
+		rMd(i,2) = e_z[i];
+		rMd(i,3) = p_r[i];
+	}
+	return rMd;
+}
+
+void MetaImageHeader::setTransform(const Transform3D& M)
+{
+	this->removeKey("Position");
+	this->removeKey("Orientation");
+
+	int dim = 3; // hardcoded - will fail for 2d images
+	std::stringstream tmList;
+	for (int c=0; c<dim; ++c)
+		for (int r=0; r<dim; ++r)
+			tmList << " " << M(r,c);
+	this->setValue("TransformMatrix", qstring_cast(tmList.str()).trimmed());
+
+	std::stringstream posList;
+	for (int r=0; r<dim; ++r)
+		posList << " " << M(r,3);
+	this->setValue("Offset", qstring_cast(posList.str()).trimmed());
+}
+
+bool MetaImageHeader::isLocalData() const
+{
+	return this->getValue("ElementDataFile").compare("LOCAL", Qt::CaseInsensitive) == 0;
+}
+
+QString MetaImageHeader::getDataFilename() const
+{
+	if (this->isLocalData())
+		return mFilename;
+	QString dataFile = this->getValue("ElementDataFile");
+	if (dataFile.isEmpty() || QFileInfo(dataFile).isAbsolute())
+		return dataFile;
+	return QFileInfo(mFilename).absoluteDir().filePath(dataFile);
+}
+
+} // namespace cx
@@ -0,0 +1,65 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXMETAIMAGEHEADER_H
+#define CXMETAIMAGEHEADER_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <utility>
+#include <QString>
+#include <QStringList>
+#include "cxTransform3D.h"
+
+namespace cx
+{
+
+/** \brief The key = value header of a MetaImage (.mhd/.mha) file.
+ *
+ * read() parses the header once, stopping at the ElementDataFile key,
+ * which is required to be the last key. Thus the voxel payload of a .mha
+ * file is never scanned. Keys are case insensitive.
+ *
+ * \ingroup cx_resource_core_utilities
+ */
+class cxResource_EXPORT MetaImageHeader
+{
+public:
+	MetaImageHeader();
+	bool read(QString filename); ///< parse the header of filename, return false if not a valid header
+	QString getFilename() const { return mFilename; }
+
+	bool hasKey(QString key) const;
+	QStringList getKeys() const; ///< all keys, in file order
+	QString getValue(QString key) const; ///< trimmed value of key, empty if missing
+	QStringList getValues(QString key) const; ///< value of key split on whitespace
+	void setValue(QString key, QString value); ///< replace key, or add it before ElementDataFile
+	void removeKey(QString key);
+	QString toString() const; ///< header text, one key per line
+
+	Transform3D getTransform() const; ///< from Offset/Position and TransformMatrix/Orientation
+	void setTransform(const Transform3D& M); ///< set as TransformMatrix and Offset
+
+	qint64 getHeaderSize() const { return mHeaderSize; } ///< bytes of header in file, the start of LOCAL data
+	bool isLocalData() const; ///< true if the data follow the header in the same file
+	QString getDataFilename() const; ///< absolute path of the file holding the data
+
+private:
+	int find(QString key) const;
+	QString mFilename;
+	std::vector<std::pair<QString, QString> > mEntries;
+	qint64 mHeaderSize;
+};
+
+} // namespace cx
+
+#endif // CXMETAIMAGEHEADER_H
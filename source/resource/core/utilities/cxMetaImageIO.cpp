@@ -0,0 +1,486 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxMetaImageIO.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSysInfo>
+#include <vtkImageData.h>
+#include <vtk_zlib.h>
+#include "cxParallelFor.h"
+#include "cxLogger.h"
+
+namespace cx
+{
+
+namespace
+{
+
+const qint64 IO_BLOCK_SIZE = 64*1024*1024;
+const char CHUNK_TABLE_MAGIC[9] = "CXZCHUNK";
+
+struct ElementType
+{
+	const char* mMetaName;
+	int mVtkType;
+};
+
+const ElementType ELEMENT_TYPES[] =
+{
+	{ "MET_CHAR", VTK_SIGNED_CHAR },
+	{ "MET_UCHAR", VTK_UNSIGNED_CHAR },
+	{ "MET_SHORT", VTK_SHORT },
+	{ "MET_USHORT", VTK_UNSIGNED_SHORT },
+	{ "MET_INT", VTK_INT },
+	{ "MET_UINT", VTK_UNSIGNED_INT },
+	{ "MET_FLOAT", VTK_FLOAT },
+	{ "MET_DOUBLE", VTK_DOUBLE }
+};
+const int ELEMENT_TYPE_COUNT = sizeof(ELEMENT_TYPES)/sizeof(ElementType);
+
+int toVtkType(QString metaType)
+{
+	for (int i=0; i<ELEMENT_TYPE_COUNT; ++i)
+		if (metaType.compare(ELEMENT_TYPES[i].mMetaName, Qt::CaseInsensitive)==0)
+			return ELEMENT_TYPES[i].mVtkType;
+	return -1;
+}
+
+QString toMetaType(int vtkType)
+{
+	if (vtkType == VTK_CHAR)
+		vtkType = VTK_SIGNED_CHAR;
+	for (int i=0; i<ELEMENT_TYPE_COUNT; ++i)
+		if (ELEMENT_TYPES[i].mVtkType == vtkType)
+			return ELEMENT_TYPES[i].mMetaName;
+	return "";
+}
+
+bool isTrue(QString value)
+{
+	return value.compare("True", Qt::CaseInsensitive)==0 || value=="1";
+}
+
+bool readFully(QFile& file, char* data, qint64 size)
+{
+	for (qint64 done=0; done<size; )
+	{
+		qint64 count = file.read(data+done, std::min(IO_BLOCK_SIZE, size-done));
+		if (count <= 0)
+			return false;
+		done += count;
+	}
+	return true;
+}
+
+bool writeFully(QFile& file, const char* data, qint64 size)
+{
+	for (qint64 done=0; done<size; )
+	{
+		qint64 count = file.write(data+done, std::min(IO_BLOCK_SIZE, size-done));
+		if (count <= 0)
+			return false;
+		done += count;
+	}
+	return true;
+}
+
+/** Deflate one chunk as raw deflate data. All but the last chunk end with a
+ *  sync flush, leaving the stream byte aligned and open for the next chunk.
+ */
+bool deflateChunk(const char* data, qint64 size, bool last, std::vector<char>* output)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return false;
+
+	output->resize(deflateBound(&stream, uLong(size)) + 16);
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+	stream.avail_in = uInt(size);
+	stream.next_out = reinterpret_cast<Bytef*>(output->data());
+	stream.avail_out = uInt(output->size());
+
+	int result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+	bool ok = (stream.avail_in == 0) && (last ? (result == Z_STREAM_END) : (result == Z_OK));
+	output->resize(stream.total_out);
+	deflateEnd(&stream);
+	return ok;
+}
+
+/** Inflate raw deflate data into exactly outputSize bytes.
+ */
+bool inflateChunk(const char* data, qint64 size, char* output, qint64 outputSize)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+		return false;
+
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+	stream.avail_in = uInt(size);
+	stream.next_out = reinterpret_cast<Bytef*>(output);
+	stream.avail_out = uInt(outputSize);
+
+	int result = inflate(&stream, Z_SYNC_FLUSH);
+	bool ok = (result == Z_OK || result == Z_STREAM_END || result == Z_BUF_ERROR) && (stream.avail_out == 0);
+	inflateEnd(&stream);
+	return ok;
+}
+
+/** Inflate a complete zlib or gzip stream of any size into output.
+ */
+bool inflateStream(const char* data, qint64 size, char* output, qint64 outputSize)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (inflateInit2(&stream, MAX_WBITS+32) != Z_OK)
+		return false;
+
+	const qint64 maxBlock = 1024*1024*1024; // avail_in/out are 32 bit
+	qint64 inputDone = 0;
+	qint64 outputDone = 0;
+	int result = Z_OK;
+	do
+	{
+		if (stream.avail_in == 0 && inputDone < size)
+		{
+			stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data+inputDone));
+			stream.avail_in = uInt(std::min(maxBlock, size-inputDone));
+			inputDone += stream.avail_in;
+		}
+		if (stream.avail_out == 0 && outputDone < outputSize)
+		{
+			stream.next_out = reinterpret_cast<Bytef*>(output+outputDone);
+			stream.avail_out = uInt(std::min(maxBlock, outputSize-outputDone));
+			outputDone += stream.avail_out;
+		}
+		result = inflate(&stream, Z_NO_FLUSH);
+	} while (result == Z_OK);
+
+	bool ok = (result == Z_STREAM_END) && (outputDone - stream.avail_out == outputSize);
+	inflateEnd(&stream);
+	return ok;
+}
+
+void appendInt64(std::vector<char>* buffer, qint64 value)
+{
+	for (int i=0; i<8; ++i)
+		buffer->push_back(char((quint64(value) >> (8*i)) & 0xFF));
+}
+
+qint64 readInt64(const char* data)
+{
+	quint64 value = 0;
+	for (int i=0; i<8; ++i)
+		value |= quint64(static_cast<unsigned char>(data[i])) << (8*i);
+	return qint64(value);
+}
+
+/** Read the chunk offsets appended after the compressed stream,
+ *  return an empty vector if not present.
+ */
+std::vector<qint64> readChunkTable(QFile& file, qint64 tableStart)
+{
+	std::vector<qint64> retval;
+	qint64 tableSize = file.size() - tableStart;
+	if (tableSize < 16 || !file.seek(tableStart))
+		return retval;
+
+	std::vector<char> table(tableSize);
+	if (!readFully(file, table.data(), tableSize))
+		return retval;
+	if (memcmp(table.data()+tableSize-8, CHUNK_TABLE_MAGIC, 8) != 0)
+		return retval;
+	qint64 count = readInt64(table.data()+tableSize-16);
+	if (count <= 0 || 8*count+16 != tableSize)
+		return retval;
+
+	for (qint64 i=0; i<count; ++i)
+		retval.push_back(readInt64(table.data()+8*i));
+	return retval;
+}
+
+} // namespace
+
+MetaImageIO::MetaImageIO() :
+	mCompression(false),
+	mChunkSize(4*1024*1024)
+{
+}
+
+bool MetaImageIO::canRead(const MetaImageHeader& header)
+{
+	int dims = header.getValue("NDims").toInt();
+	if (dims < 2 || dims > 3 || header.getValues("DimSize").size() != dims)
+		return false;
+	if (toVtkType(header.getValue("ElementType")) < 0)
+		return false;
+	if (header.hasKey("BinaryData") && !isTrue(header.getValue("BinaryData")))
+		return false;
+
+	bool msb = isTrue(header.getValue("ElementByteOrderMSB")) || isTrue(header.getValue("BinaryDataByteOrderMSB"));
+	if (msb != (QSysInfo::ByteOrder == QSysInfo::BigEndian))
+		return false;
+
+	QString dataFile = header.getValue("ElementDataFile");
+	if (dataFile.isEmpty() || dataFile.startsWith("LIST", Qt::CaseInsensitive) || dataFile.contains("%"))
+		return false;
+	return QFileInfo(header.getDataFilename()).isFile();
+}
+
+vtkImageDataPtr MetaImageIO::read(QString filename)
+{
+	MetaImageHeader header;
+	if (!header.read(filename))
+		return vtkImageDataPtr();
+	return this->read(header);
+}
+
+vtkImageDataPtr MetaImageIO::read(const MetaImageHeader& header)
+{
+	if (!this->canRead(header))
+		return vtkImageDataPtr();
+
+	QStringList dimSize = header.getValues("DimSize");
+	QStringList spacing = header.getValues("ElementSpacing");
+	QStringList offset = header.getValues("Offset");
+	int dim[3] = {1, 1, 1};
+	double space[3] = {1, 1, 1};
+	double origin[3] = {0, 0, 0};
+	for (int i=0; i<dimSize.size(); ++i)
+	{
+		dim[i] = dimSize[i].toInt();
+		if (i<spacing.size())
+			space[i] = spacing[i].toDouble();
+		if (i<offset.size())
+			origin[i] = offset[i].toDouble();
+	}
+	int channels = std::max(1, header.getValue("ElementNumberOfChannels").toInt());
+
+	vtkImageDataPtr image = vtkImageDataPtr::New();
+	image->SetExtent(0, dim[0]-1, 0, dim[1]-1, 0, dim[2]-1);
+	image->SetSpacing(space);
+	image->SetOrigin(origin);
+	image->AllocateScalars(toVtkType(header.getValue("ElementType")), channels);
+	char* output = static_cast<char*>(image->GetScalarPointer());
+	qint64 outputSize = qint64(image->GetNumberOfPoints()) * channels * image->GetScalarSize();
+
+	QFile file(header.getDataFilename());
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		reportError("MetaImageIO: Failed to open " + file.fileName());
+		return vtkImageDataPtr();
+	}
+
+	bool compressed = isTrue(header.getValue("CompressedData"));
+	qint64 start = header.isLocalData() ? header.getHeaderSize() : std::max(0, header.getValue("HeaderSize").toInt());
+	qint64 dataSize = compressed ? file.size()-start : outputSize;
+	if (compressed && header.hasKey("CompressedDataSize"))
+		dataSize = header.getValue("CompressedDataSize").toLongLong();
+	if (header.getValue("HeaderSize").toInt() == -1)
+		start = file.size()-dataSize;
+
+	if (start < 0 || start+dataSize > file.size() || !file.seek(start))
+	{
+		reportError("MetaImageIO: Data size mismatch in " + file.fileName());
+		return vtkImageDataPtr();
+	}
+
+	bool ok = false;
+	if (!compressed)
+	{
+		ok = readFully(file, output, outputSize);
+	}
+	else
+	{
+		std::vector<char> input(dataSize);
+		ok = readFully(file, input.data(), dataSize);
+
+		qint64 chunkSize = header.getValue("CompressedDataChunkSize").toLongLong();
+		std::vector<qint64> offsets;
+		if (ok && chunkSize > 0)
+			offsets = readChunkTable(file, start+dataSize);
+
+		if (ok && !offsets.empty() && qint64(offsets.size()) == (outputSize+chunkSize-1)/chunkSize)
+		{
+			offsets.push_back(dataSize-4); // end of last chunk, before adler32
+			std::vector<char> chunkOk(offsets.size()-1, 0);
+			const char* in = input.data();
+			parallelFor(0, int(offsets.size()-1), [&](int i)
+			{
+				qint64 begin = i*chunkSize;
+				qint64 size = std::min(chunkSize, outputSize-begin);
+				chunkOk[i] = inflateChunk(in+offsets[i], offsets[i+1]-offsets[i], output+begin, size);
+			}, 1);
+			ok = std::find(chunkOk.begin(), chunkOk.end(), 0) == chunkOk.end();
+		}
+		else if (ok)
+		{
+			ok = inflateStream(input.data(), dataSize, output, outputSize);
+		}
+	}
+
+	if (!ok)
+	{
+		reportError("MetaImageIO: Failed to read data from " + file.fileName());
+		return vtkImageDataPtr();
+	}
+	image->Modified();
+	return image;
+}
+
+MetaImageHeader MetaImageIO::createHeader(vtkImageDataPtr image)
+{
+	int* dim = image->GetDimensions();
+	double* spacing = image->GetSpacing();
+	double* origin = image->GetOrigin();
+	QString msb = (QSysInfo::ByteOrder == QSysInfo::BigEndian) ? "True" : "False";
+
+	MetaImageHeader header;
+	header.setValue("ObjectType", "Image");
+	header.setValue("NDims", "3");
+	header.setValue("BinaryData", "True");
+	header.setValue("BinaryDataByteOrderMSB", msb);
+	header.setValue("CompressedData", "False");
+	header.setValue("TransformMatrix", "1 0 0 0 1 0 0 0 1");
+	header.setValue("Offset", QString("%1 %2 %3").arg(origin[0]).arg(origin[1]).arg(origin[2]));
+	header.setValue("CenterOfRotation", "0 0 0");
+	header.setValue("ElementSpacing", QString("%1 %2 %3").arg(spacing[0]).arg(spacing[1]).arg(spacing[2]));
+	header.setValue("DimSize", QString("%1 %2 %3").arg(dim[0]).arg(dim[1]).arg(dim[2]));
+	if (image->GetNumberOfScalarComponents() > 1)
+		header.setValue("ElementNumberOfChannels", QString::number(image->GetNumberOfScalarComponents()));
+	header.setValue("ElementType", toMetaType(image->GetScalarType()));
+	return header;
+}
+
+bool MetaImageIO::write(vtkImageDataPtr image, QString filename, MetaImageHeader header)
+{
+	if (!image || !image->GetScalarPointer() || toMetaType(image->GetScalarType()).isEmpty())
+	{
+		reportError("MetaImageIO: Cannot write image to " + filename);
+		return false;
+	}
+
+	const char* data = static_cast<const char*>(image->GetScalarPointer());
+	qint64 dataSize = qint64(image->GetNumberOfPoints()) * image->GetNumberOfScalarComponents() * image->GetScalarSize();
+
+	// compress chunks in parallel, then join them into one zlib stream
+	std::vector<std::vector<char> > chunks;
+	std::vector<char> prefix;
+	std::vector<char> suffix;
+	if (mCompression)
+	{
+		qint64 chunkSize = std::max<qint64>(64*1024, std::min<qint64>(mChunkSize, 256*1024*1024));
+		int count = int(std::max<qint64>(1, (dataSize+chunkSize-1)/chunkSize));
+		chunks.resize(count);
+		std::vector<uLong> adler(count);
+		std::vector<char> chunkOk(count, 0);
+		parallelFor(0, count, [&](int i)
+		{
+			qint64 begin = i*chunkSize;
+			qint64 size = std::min(chunkSize, dataSize-begin);
+			chunkOk[i] = deflateChunk(data+begin, size, i==count-1, &chunks[i]);
+			adler[i] = adler32(adler32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(data+begin), uInt(size));
+		}, 1);
+		if (std::find(chunkOk.begin(), chunkOk.end(), 0) != chunkOk.end())
+		{
+			reportError("MetaImageIO: Failed to compress " + filename);
+			return false;
+		}
+
+		prefix.push_back(char(0x78)); // zlib header: deflate, 32k window
+		prefix.push_back(char(0x01));
+		uLong checksum = adler[0];
+		qint64 offset = prefix.size();
+		std::vector<qint64> offsets;
+		for (int i=0; i<count; ++i)
+		{
+			if (i>0)
+				checksum = adler32_combine(checksum, adler[i], z_off_t(std::min(chunkSize, dataSize-i*chunkSize)));
+			offsets.push_back(offset);
+			offset += chunks[i].size();
+		}
+		for (int i=3; i>=0; --i)
+			suffix.push_back(char((checksum >> (8*i)) & 0xFF));
+		qint64 compressedSize = offset + suffix.size();
+
+		for (unsigned i=0; i<offsets.size(); ++i)
+			appendInt64(&suffix, offsets[i]);
+		appendInt64(&suffix, offsets.size());
+		suffix.insert(suffix.end(), CHUNK_TABLE_MAGIC, CHUNK_TABLE_MAGIC+8);
+
+		header.setValue("CompressedData", "True");
+		header.setValue("CompressedDataSize", QString::number(compressedSize));
+		header.setValue("CompressedDataChunkSize", QString::number(chunkSize));
+	}
+	else
+	{
+		header.setValue("CompressedData", "False");
+		header.removeKey("CompressedDataSize");
+		header.removeKey("CompressedDataChunkSize");
+	}
+
+	QFileInfo info(filename);
+	QDir().mkpath(info.path());
+	bool local = info.suffix().compare("mha", Qt::CaseInsensitive)==0;
+	QString dataSuffix = mCompression ? ".zraw" : ".raw"; // as vtkMetaImageWriter
+	QString dataFilename = local ? filename : info.dir().filePath(info.completeBaseName()+dataSuffix);
+	if (!local)
+		QFile::remove(info.dir().filePath(info.completeBaseName()+(mCompression ? ".raw" : ".zraw")));
+	header.removeKey("ElementDataFile");
+	header.setValue("ElementDataFile", local ? QString("LOCAL") : QFileInfo(dataFilename).fileName());
+
+	QFile headerFile(filename);
+	if (!headerFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		reportError("MetaImageIO: Failed to open " + filename);
+		return false;
+	}
+	QByteArray headerText = header.toString().toLatin1();
+	bool ok = writeFully(headerFile, headerText.constData(), headerText.size());
+
+	QFile dataFile(dataFilename);
+	QFile* output = &headerFile;
+	if (!local)
+	{
+		headerFile.close();
+		if (!dataFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		{
+			reportError("MetaImageIO: Failed to open " + dataFilename);
+			return false;
+		}
+		output = &dataFile;
+	}
+
+	if (mCompression)
+	{
+		ok = ok && writeFully(*output, prefix.data(), prefix.size());
+		for (unsigned i=0; i<chunks.size(); ++i)
+			ok = ok && writeFully(*output, chunks[i].data(), chunks[i].size());
+		ok = ok && writeFully(*output, suffix.data(), suffix.size());
+	}
+	else
+	{
+		ok = ok && writeFully(*output, data, dataSize);
+	}
+
+	if (!ok)
+		reportError("MetaImageIO: Failed to write " + output->fileName());
+	return ok;
+}
+
+} // namespace cx
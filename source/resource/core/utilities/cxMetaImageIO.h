@@ -0,0 +1,70 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXMETAIMAGEIO_H
+#define CXMETAIMAGEIO_H
+
+#include "cxResourceExport.h"
+
+#include "vtkForwardDeclarations.h"
+#include "cxMetaImageHeader.h"
+
+namespace cx
+{
+
+/** \brief Read and write the voxel data of MetaImage (.mhd/.mha) files.
+ *
+ * Uncompressed data are read and written with large sequential block
+ * transfers directly to and from the vtkImageData buffer.
+ *
+ * Compressed data are written as one zlib stream built from independently
+ * deflated chunks joined at byte aligned sync points, as done by pigz.
+ * The chunks are compressed in parallel, and the result is a standard
+ * stream readable by any MetaImage reader. The chunk offsets are appended
+ * to the data file after the CompressedDataSize bytes of the stream, where
+ * other readers ignore them, and are used to decompress in parallel.
+ * Compressed data without chunk offsets are decompressed as one stream.
+ *
+ * Files with layouts not handled here (ASCII data, file lists,
+ * foreign byte order) are rejected by canRead(), callers should
+ * fall back to vtkMetaImageReader for those.
+ *
+ * \ingroup cx_resource_core_utilities
+ */
+class cxResource_EXPORT MetaImageIO
+{
+public:
+	MetaImageIO();
+	void setCompression(bool on) { mCompression = on; }
+	void setChunkSize(qint64 bytes) { mChunkSize = bytes; } ///< uncompressed size of each compressed chunk
+
+	static bool canRead(const MetaImageHeader& header);
+	vtkImageDataPtr read(const MetaImageHeader& header); ///< read the data described by header, null on failure
+	vtkImageDataPtr read(QString filename);
+
+	/** Create a header describing image, with identity transform
+	 *  and the image origin as Offset. Add keys to it before write().
+	 */
+	static MetaImageHeader createHeader(vtkImageDataPtr image);
+	/** Write image to filename using header, adding the data file and compression keys.
+	 *  .mha files get the data in the same file, .mhd files in a .zraw file if
+	 *  compressed, otherwise in a .raw file, as written by vtkMetaImageWriter.
+	 */
+	bool write(vtkImageDataPtr image, QString filename, MetaImageHeader header);
+
+private:
+	bool mCompression;
+	qint64 mChunkSize;
+};
+
+} // namespace cx
+
+#endif // CXMETAIMAGEIO_H
@@ -0,0 +1,111 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXPARALLELFOR_H
+#define CXPARALLELFOR_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <algorithm>
+#include <QFuture>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace cx
+{
+
+/**
+* \file
+* \addtogroup cx_resource_core_utilities
+* @{
+*/
+
+/** Helper for parallelForRange(): runs function(begin, end) for one chunk.
+ */
+template<class FUNCTION>
+struct ParallelForChunk
+{
+	typedef void result_type;
+	ParallelForChunk(FUNCTION function, int begin, int end) : mFunction(function), mBegin(begin), mEnd(end) {}
+	void operator()() const { mFunction(mBegin, mEnd); }
+	FUNCTION mFunction;
+	int mBegin;
+	int mEnd;
+};
+
+/** Helper for parallelFor(): runs function(i) for each i in a chunk.
+ */
+template<class FUNCTION>
+struct ParallelForEach
+{
+	ParallelForEach(FUNCTION function) : mFunction(function) {}
+	void operator()(int begin, int end) const
+	{
+		for (int i=begin; i<end; ++i)
+			mFunction(i);
+	}
+	FUNCTION mFunction;
+};
+
+/** Return the number of chunks parallelForRange() will use for count
+ *  items with the given minimum chunk size.
+ */
+inline int parallelForChunkCount(int count, int minChunkSize)
+{
+	int threads = std::max(1, QThreadPool::globalInstance()->maxThreadCount());
+	return std::max(1, std::min(threads, count/std::max(1, minChunkSize)));
+}
+
+/** Split [begin,end) into contiguous chunks and call function(chunkBegin, chunkEnd)
+ *  for each of them using the global QThreadPool. The first chunk is run in the
+ *  calling thread. Blocks until all chunks are done.
+ *
+ *  Use this when each chunk needs local state, e.g. a partial histogram,
+ *  otherwise use parallelFor().
+ *
+ *  Nested calls are safe: waiting on a chunk that has not yet started runs
+ *  it in the waiting thread.
+ */
+template<class FUNCTION>
+void parallelForRange(int begin, int end, FUNCTION function, int minChunkSize=1024)
+{
+	int count = end-begin;
+	if (count<=0)
+		return;
+	int chunks = parallelForChunkCount(count, minChunkSize);
+	int chunkSize = (count+chunks-1)/chunks;
+
+	std::vector<QFuture<void> > futures;
+	for (int start=begin+chunkSize; start<end; start+=chunkSize)
+		futures.push_back(QtConcurrent::run(ParallelForChunk<FUNCTION>(function, start, std::min(end, start+chunkSize))));
+
+	function(begin, std::min(end, begin+chunkSize));
+
+	for (unsigned i=0; i<futures.size(); ++i)
+		futures[i].waitForFinished();
+}
+
+/** Call function(i) for all i in [begin,end), distributed over the global QThreadPool.
+ *  The iterations must be independent of each other.
+ */
+template<class FUNCTION>
+void parallelFor(int begin, int end, FUNCTION function, int minChunkSize=1024)
+{
+	parallelForRange(begin, end, ParallelForEach<FUNCTION>(function), minChunkSize);
+}
+
+/**
+* @}
+*/
+
+} // namespace cx
+
+#endif // CXPARALLELFOR_H
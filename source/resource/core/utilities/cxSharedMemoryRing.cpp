@@ -0,0 +1,398 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxSharedMemoryRing.h"
+
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <QElapsedTimer>
+#include "cxLogger.h"
+
+#ifdef CX_LINUX
+#include <climits>
+#include <ctime>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+namespace cx
+{
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory ring requires lock free 64 bit atomics");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "shared memory ring requires lock free 32 bit atomics");
+
+const quint32 ringMagic = 0x43585247; // "CXRG"
+const quint32 ringVersion = 1;
+const int ringAlignment = 64;
+
+// Shared header kept first in shared memory area
+struct SharedMemoryRingHeader
+{
+	quint32 magic;
+	quint32 version;
+	qint32 numSlots;		// number of slots
+	qint32 slotSize;		// max frame size
+	qint32 headerSize;		// offset to first slot
+	qint32 slotStride;		// offset between slots
+	std::atomic<quint64> published; // number of frames published
+	std::atomic<quint32> wake;	// futex word, incremented on each publish
+};
+
+// Header of each slot, followed by the frame data
+struct SharedMemoryRingSlot
+{
+	std::atomic<quint64> sequence; // 2*frame+1 while writing frame, 2*frame+2 when done
+	SharedMemoryFrameInfo info;
+};
+
+namespace
+{
+int alignUp(int value)
+{
+	return (value + ringAlignment - 1) / ringAlignment * ringAlignment;
+}
+
+int getSlotHeaderSize()
+{
+	return alignUp(sizeof(SharedMemoryRingSlot));
+}
+
+SharedMemoryRingSlot *getSlot(SharedMemoryRingHeader *header, quint64 frame)
+{
+	char *base = reinterpret_cast<char *>(header) + header->headerSize;
+	return reinterpret_cast<SharedMemoryRingSlot *>(base + (frame % header->numSlots) * header->slotStride);
+}
+
+unsigned char *getSlotData(SharedMemoryRingSlot *slot)
+{
+	return reinterpret_cast<unsigned char *>(slot) + getSlotHeaderSize();
+}
+
+/** True if the slots described by the header fit in a buffer of bufferSize bytes.
+ */
+bool hasValidLayout(const SharedMemoryRingHeader *header, qint64 bufferSize)
+{
+	if ((header->numSlots <= 0) || (header->slotSize < 0))
+		return false;
+	if (header->headerSize < qint64(sizeof(SharedMemoryRingHeader)))
+		return false;
+	if (header->slotStride < qint64(getSlotHeaderSize()) + header->slotSize)
+		return false;
+	return qint64(header->headerSize) + qint64(header->numSlots)*header->slotStride <= bufferSize;
+}
+
+void wakeAll(std::atomic<quint32> *word)
+{
+#ifdef CX_LINUX
+	syscall(SYS_futex, reinterpret_cast<quint32 *>(word), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+	Q_UNUSED(word);
+#endif
+}
+
+/** Sleep until *word changes from expected, or timeout.
+ *  Spurious returns are allowed.
+ */
+void waitForChange(std::atomic<quint32> *word, quint32 expected, int timeout_ms)
+{
+#ifdef CX_LINUX
+	timespec timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+	syscall(SYS_futex, reinterpret_cast<quint32 *>(word), FUTEX_WAIT, expected, &timeout, NULL, 0);
+#else
+	// no process shared wait primitive available: poll
+	Q_UNUSED(word);
+	Q_UNUSED(expected);
+	QThread::msleep(std::min(1, timeout_ms));
+#endif
+}
+}
+
+SharedMemoryFrameInfo::SharedMemoryFrameInfo() :
+	timestamp(0), width(0), height(0), components(1), scalarType(0), size(0), frame(0)
+{
+	spacing[0] = spacing[1] = spacing[2] = 1;
+}
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+SharedMemoryRingServer::SharedMemoryRingServer(QString key, int numberOfSlots, int slotSize, QObject *parent) :
+	mBuffer(key, parent),
+	mHeader(NULL),
+	mSlots(numberOfSlots),
+	mSlotSize(slotSize),
+	mNextFrame(0),
+	mWriting(false)
+{
+	int headerSize = alignUp(sizeof(SharedMemoryRingHeader));
+	int slotStride = getSlotHeaderSize() + alignUp(slotSize);
+	int size = headerSize + numberOfSlots * slotStride;
+	if (!mBuffer.create(size))
+	{
+		if (mBuffer.error() == QSharedMemory::AlreadyExists && mBuffer.attach() && mBuffer.size() >= size)
+		{
+			// reuse and overwrite; hopefully it was made by previous run of same program that crashed
+			CX_LOG_WARNING() << "Reusing existing shared memory ring " << key;
+		}
+		else
+		{
+			CX_LOG_ERROR() << QString("Failed to create shared memory ring of size %1: %2").arg(size).arg(mBuffer.errorString());
+			return;
+		}
+	}
+
+	char *data = static_cast<char *>(mBuffer.data());
+	std::memset(data, 0, size);
+	mHeader = new (data) SharedMemoryRingHeader;
+	mHeader->numSlots = numberOfSlots;
+	mHeader->slotSize = slotSize;
+	mHeader->headerSize = headerSize;
+	mHeader->slotStride = slotStride;
+	mHeader->published.store(0);
+	mHeader->wake.store(0);
+	for (int i=0; i<numberOfSlots; ++i)
+	{
+		SharedMemoryRingSlot *slot = new (data + headerSize + i*slotStride) SharedMemoryRingSlot;
+		slot->sequence.store(0);
+	}
+	mHeader->version = ringVersion;
+	std::atomic_thread_fence(std::memory_order_release);
+	mHeader->magic = ringMagic;
+}
+
+SharedMemoryRingServer::~SharedMemoryRingServer()
+{
+	if (mHeader)
+	{
+		// wake readers, letting them discover that the server is gone
+		mHeader->wake.fetch_add(1);
+		wakeAll(&mHeader->wake);
+	}
+}
+
+void *SharedMemoryRingServer::beginWrite()
+{
+	if (!mHeader)
+		return NULL;
+
+	SharedMemoryRingSlot *slot = getSlot(mHeader, mNextFrame);
+	slot->sequence.store(2*mNextFrame+1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	mWriting = true;
+	return getSlotData(slot);
+}
+
+void SharedMemoryRingServer::endWrite(SharedMemoryFrameInfo info)
+{
+	if (!mHeader || !mWriting)
+		return;
+
+	SharedMemoryRingSlot *slot = getSlot(mHeader, mNextFrame);
+	info.frame = mNextFrame;
+	info.size = std::min<qint64>(info.size, mSlotSize);
+	slot->info = info;
+	slot->sequence.store(2*mNextFrame+2, std::memory_order_release);
+
+	++mNextFrame;
+	mWriting = false;
+	mHeader->published.store(mNextFrame, std::memory_order_release);
+	mHeader->wake.fetch_add(1, std::memory_order_release);
+	wakeAll(&mHeader->wake);
+}
+
+bool SharedMemoryRingServer::write(const void *data, SharedMemoryFrameInfo info)
+{
+	if (info.size > mSlotSize)
+	{
+		CX_LOG_WARNING() << QString("Frame of %1 bytes does not fit in shared memory ring slot of %2 bytes").arg(info.size).arg(mSlotSize);
+		return false;
+	}
+	void *buffer = this->beginWrite();
+	if (!buffer)
+		return false;
+	std::memcpy(buffer, data, info.size);
+	this->endWrite(info);
+	return true;
+}
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+SharedMemoryRingClient::SharedMemoryRingClient(QObject *parent) :
+	mBuffer(parent),
+	mHeader(NULL),
+	mSlots(0),
+	mSlotSize(0),
+	mRead(0),
+	mDropped(0)
+{
+}
+
+SharedMemoryRingClient::~SharedMemoryRingClient()
+{
+}
+
+bool SharedMemoryRingClient::attach(const QString &key)
+{
+	this->detach();
+	mBuffer.setKey(key);
+	if (!mBuffer.attach(QSharedMemory::ReadWrite))
+		return false;
+
+	SharedMemoryRingHeader *header = static_cast<SharedMemoryRingHeader *>(mBuffer.data());
+	if ((mBuffer.size() < int(sizeof(SharedMemoryRingHeader))) || (header->magic != ringMagic) || (header->version != ringVersion))
+	{
+		mBuffer.detach();
+		return false;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (!hasValidLayout(header, mBuffer.size()))
+	{
+		CX_LOG_WARNING() << QString("Shared memory ring %1 has slots beyond its size %2, refusing to attach").arg(key).arg(mBuffer.size());
+		mBuffer.detach();
+		return false;
+	}
+
+	mHeader = header;
+	mSlots = header->numSlots;
+	mSlotSize = header->slotSize;
+	mRead = header->published.load(std::memory_order_acquire);
+	if (mRead > 0)
+		--mRead; // let the newest frame be read
+	mDropped = 0;
+	return true;
+}
+
+bool SharedMemoryRingClient::detach()
+{
+	mHeader = NULL;
+	mSlots = 0;
+	mSlotSize = 0;
+	if (!mBuffer.isAttached())
+		return true;
+	return mBuffer.detach();
+}
+
+quint64 SharedMemoryRingClient::getPublished() const
+{
+	if (!mHeader)
+		return 0;
+	return mHeader->published.load(std::memory_order_acquire);
+}
+
+bool SharedMemoryRingClient::waitForPublished(quint64 count, int timeout_ms)
+{
+	if (!mHeader)
+		return false;
+
+	QElapsedTimer timer;
+	timer.start();
+	while (true)
+	{
+		quint32 wake = mHeader->wake.load(std::memory_order_acquire);
+		if (this->getPublished() >= count)
+			return true;
+		int remaining = timeout_ms - timer.elapsed();
+		if (remaining <= 0)
+			return false;
+		waitForChange(&mHeader->wake, wake, remaining);
+	}
+}
+
+bool SharedMemoryRingClient::waitForFrame(int timeout_ms)
+{
+	return this->waitForPublished(mRead+1, timeout_ms);
+}
+
+bool SharedMemoryRingClient::readLatest(SharedMemoryFrameInfo *info, std::vector<unsigned char> *data)
+{
+	if (!mHeader)
+		return false;
+
+	// retry if the writer overwrites the slot while we copy it
+	for (int attempt=0; attempt<3; ++attempt)
+	{
+		quint64 published = this->getPublished();
+		if (published <= mRead)
+			return false;
+
+		quint64 frame = published-1;
+		SharedMemoryRingSlot *slot = getSlot(mHeader, frame);
+		quint64 before = slot->sequence.load(std::memory_order_acquire);
+		if (before != 2*frame+2)
+			continue;
+
+		SharedMemoryFrameInfo current = slot->info;
+		qint64 size = std::max<qint64>(0, std::min<qint64>(current.size, mSlotSize));
+		mScratch.resize(size);
+		if (size)
+			std::memcpy(mScratch.data(), getSlotData(slot), size);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot->sequence.load(std::memory_order_relaxed) != before)
+			continue;
+
+		mDropped += frame - mRead;
+		mRead = frame+1;
+		*info = current;
+		data->swap(mScratch);
+		return true;
+	}
+	return false;
+}
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+SharedMemoryRingNotifier::SharedMemoryRingNotifier(QObject *parent) :
+	QThread(parent),
+	mStop(0)
+{
+}
+
+SharedMemoryRingNotifier::~SharedMemoryRingNotifier()
+{
+	this->stop();
+}
+
+bool SharedMemoryRingNotifier::attach(const QString &key)
+{
+	this->stop();
+	return mClient.attach(key);
+}
+
+void SharedMemoryRingNotifier::stop()
+{
+	mStop = 1;
+	this->wait();
+	mStop = 0;
+}
+
+void SharedMemoryRingNotifier::run()
+{
+	quint64 published = mClient.getPublished();
+	while (!mStop)
+	{
+		if (!mClient.waitForPublished(published+1, 100))
+			continue;
+		published = mClient.getPublished();
+		emit frameAvailable();
+	}
+}
+
+} // namespace cx
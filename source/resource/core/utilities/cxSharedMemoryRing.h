@@ -0,0 +1,159 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXSHAREDMEMORYRING_H
+#define CXSHAREDMEMORYRING_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <QSharedMemory>
+#include <QThread>
+#include <QAtomicInt>
+
+namespace cx
+{
+struct SharedMemoryRingHeader;
+struct SharedMemoryRingSlot;
+
+/** Description of one frame in a shared memory ring.
+ *
+ * \ingroup cx_resource_core_utilities
+ */
+struct cxResource_EXPORT SharedMemoryFrameInfo
+{
+	SharedMemoryFrameInfo();
+	double timestamp; ///< acquisition time, ms since epoch
+	qint32 width;
+	qint32 height;
+	qint32 components; ///< scalar components per pixel
+	qint32 scalarType; ///< vtk scalar type, i.e. VTK_UNSIGNED_CHAR
+	double spacing[3];
+	qint64 size; ///< bytes of frame data
+	quint64 frame; ///< running frame number, set by the server
+};
+
+/**\brief Lock free shared memory ring buffer, server side.
+ *
+ * One writer publishes frames into a ring of slots, read by any number of
+ * readers in other processes. No lock is taken: each slot carries a
+ * sequence counter which is odd while the slot is being written, and readers
+ * copy the frame out and discard it if the counter changed meanwhile. Thus
+ * the writer never waits for the readers, and a reader slower than the ring
+ * skips frames instead of blocking.
+ *
+ * Readers are woken by a process shared futex on Linux. Other
+ * platforms fall back to polling every millisecond.
+ *
+ * Each slot holds the metadata of its frame in a SharedMemoryFrameInfo.
+ *
+ * \sa SharedMemoryRingClient
+ * \ingroup cx_resource_core_utilities
+ */
+class cxResource_EXPORT SharedMemoryRingServer
+{
+public:
+	/**
+	 * \param key A string identifying this resource. Must be unique system wide
+	 * \param numberOfSlots Number of frames in the ring. Readers must copy a frame within
+	 *              numberOfSlots-1 frame periods in order to receive it.
+	 * \param slotSize Max size of each frame.
+	 */
+	SharedMemoryRingServer(QString key, int numberOfSlots, int slotSize, QObject *parent = 0);
+	~SharedMemoryRingServer();
+	bool isValid() const { return mHeader!=NULL; }
+	QString key() const { return mBuffer.key(); }
+	int getNumberOfSlots() const { return mSlots; }
+	int getSlotSize() const { return mSlotSize; }
+
+	void *beginWrite(); ///< Return the buffer of the next frame
+	void endWrite(SharedMemoryFrameInfo info); ///< Publish the frame written into the beginWrite() buffer, waking all readers
+	bool write(const void *data, SharedMemoryFrameInfo info); ///< Copy info.size bytes of data into the next frame and publish it
+
+private:
+	QSharedMemory mBuffer;
+	SharedMemoryRingHeader *mHeader;
+	int mSlots;
+	int mSlotSize;
+	quint64 mNextFrame;
+	bool mWriting;
+};
+
+/**\brief Lock free shared memory ring buffer, client side.
+ *
+ * \sa SharedMemoryRingServer
+ * \ingroup cx_resource_core_utilities
+ */
+class cxResource_EXPORT SharedMemoryRingClient
+{
+public:
+	SharedMemoryRingClient(QObject *parent = 0);
+	~SharedMemoryRingClient();
+	bool attach(const QString &key); ///< false if key is missing, not a ring, or its slots exceed its size
+	bool detach();
+	bool isAttached() const { return mHeader!=NULL; }
+	QString key() const { return mBuffer.key(); }
+	int getNumberOfSlots() const { return mSlots; }
+	int getSlotSize() const { return mSlotSize; }
+
+	quint64 getPublished() const; ///< number of frames published by the server
+	bool waitForPublished(quint64 count, int timeout_ms); ///< wait until count frames are published, false on timeout
+	bool waitForFrame(int timeout_ms); ///< wait for a frame newer than the last one read
+
+	/** Copy the newest frame into data, if it is newer than the last one read.
+	 *  Return false if there is no new frame.
+	 *
+	 *  The frame is copied to a scratch buffer and swapped into data once
+	 *  it is known to be consistent, thus data is left untouched on failure.
+	 *  Memory owned by data before a successful call must not be used after it.
+	 */
+	bool readLatest(SharedMemoryFrameInfo *info, std::vector<unsigned char> *data);
+	quint64 getDroppedFrames() const { return mDropped; } ///< frames skipped between calls to readLatest()
+
+private:
+	QSharedMemory mBuffer;
+	SharedMemoryRingHeader *mHeader;
+	int mSlots;
+	int mSlotSize;
+	quint64 mRead; ///< number of frames up to and including the last one read
+	quint64 mDropped;
+	std::vector<unsigned char> mScratch; ///< frame being copied, swapped with the caller's buffer on success
+};
+
+/**\brief Thread emitting frameAvailable() each time a frame is published to a SharedMemoryRingServer.
+ *
+ * Use to drive a SharedMemoryRingClient from the Qt event loop.
+ *
+ * \ingroup cx_resource_core_utilities
+ */
+class cxResource_EXPORT SharedMemoryRingNotifier : public QThread
+{
+	Q_OBJECT
+public:
+	SharedMemoryRingNotifier(QObject *parent = 0);
+	virtual ~SharedMemoryRingNotifier();
+	bool attach(const QString &key);
+	void stop();
+
+signals:
+	void frameAvailable();
+
+protected:
+	virtual void run();
+
+private:
+	SharedMemoryRingClient mClient;
+	QAtomicInt mStop;
+};
+
+} // namespace cx
+
+#endif // CXSHAREDMEMORYRING_H
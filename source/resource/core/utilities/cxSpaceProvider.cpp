@@ -15,6 +15,30 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 namespace cx
 {
 
+namespace
+{
+/** Handle simply forwarding to SpaceProvider::get_toMfrom().
+ */
+class ForwardingSpaceTransformHandle : public SpaceTransformHandle
+{
+public:
+	ForwardingSpaceTransformHandle(SpaceProvider* provider, CoordinateSystem from, CoordinateSystem to) :
+		mProvider(provider), mFrom(from), mTo(to) {}
+	virtual Transform3D get_toMfrom() { return mProvider->get_toMfrom(mFrom, mTo); }
+	virtual CoordinateSystem getFrom() const { return mFrom; }
+	virtual CoordinateSystem getTo() const { return mTo; }
+private:
+	SpaceProvider* mProvider;
+	CoordinateSystem mFrom;
+	CoordinateSystem mTo;
+};
+} // namespace
+
+SpaceTransformHandlePtr SpaceProvider::getTransformHandle(CoordinateSystem from, CoordinateSystem to)
+{
+	return SpaceTransformHandlePtr(new ForwardingSpaceTransformHandle(this, from, to));
+}
+
 SpaceProviderPtr SpaceProvider::getNullObject()
 {
 	static SpaceProviderPtr mNull;
@@ -21,6 +21,23 @@ namespace cx
 {
 typedef boost::shared_ptr<class SpaceListener> SpaceListenerPtr;
 typedef boost::shared_ptr<class SpaceProvider> SpaceProviderPtr;
+typedef boost::shared_ptr<class SpaceTransformHandle> SpaceTransformHandlePtr;
+
+/** Handle to the transform between two spaces, for clients querying
+ *  the same transform repeatedly, e.g. once per render.
+ *
+ * The handle must not outlive the SpaceProvider that created it.
+ *
+ * \ingroup cx_resource_core_utilities
+ */
+class cxResource_EXPORT SpaceTransformHandle
+{
+public:
+	virtual ~SpaceTransformHandle() {}
+	virtual Transform3D get_toMfrom() = 0; ///< to_M_from, for the current state
+	virtual CoordinateSystem getFrom() const = 0;
+	virtual CoordinateSystem getTo() const = 0;
+};
 
 /** Provides information about all the coordinate systems in the application.
  *
@@ -36,6 +53,7 @@ public:
 	virtual ~SpaceProvider() {}
 
 	virtual Transform3D get_toMfrom(CoordinateSystem from, CoordinateSystem to) = 0; ///< to_M_from
+	virtual SpaceTransformHandlePtr getTransformHandle(CoordinateSystem from, CoordinateSystem to); ///< handle for repeated queries of to_M_from
 	virtual std::vector<CoordinateSystem> getSpacesToPresentInGUI() = 0;
 	virtual std::map<QString, QString> getDisplayNamesForCoordRefObjects() = 0;
 	virtual SpaceListenerPtr createListener() = 0;
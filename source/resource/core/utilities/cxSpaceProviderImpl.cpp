@@ -19,6 +19,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxSpaceListenerImpl.h"
 #include "cxTool.h"
 #include "cxActiveData.h"
+#include <QMutex>
 
 
 namespace cx
@@ -31,6 +32,7 @@ SpaceProviderImpl::SpaceProviderImpl(TrackingServicePtr trackingService, Patient
 //	connect(mTrackingService.get(), SIGNAL(stateChanged()), this, SIGNAL(spaceAddedOrRemoved()));
 	connect(mTrackingService.get(), &TrackingService::stateChanged, this, &SpaceProvider::spaceAddedOrRemoved);
 	connect(mDataManager.get(), &PatientModelService::dataAddedOrRemoved, this, &SpaceProvider::spaceAddedOrRemoved);
+	mCache.reset(new SpaceTransformCache(mTrackingService, mDataManager));
 }
 
 SpaceListenerPtr SpaceProviderImpl::createListener()
@@ -126,13 +128,153 @@ Transform3D SpaceProviderImpl::getActiveToolTipTransform(CoordinateSystem to, bo
 	return retval;
 }
 
+namespace
+{
+/** Handle keeping the nodes of both spaces, memoizing to_M_from
+ *  until one of them is recomputed.
+ */
+class CachedSpaceTransformHandle : public SpaceTransformHandle
+{
+public:
+	CachedSpaceTransformHandle(SpaceProviderImpl* provider, SpaceNodePtr from, SpaceNodePtr to) :
+		mProvider(provider),
+		mFrom(from),
+		mTo(to),
+		mFromRevision(0),
+		mToRevision(0),
+		m_toMfrom(Transform3D::Identity())
+	{}
+	virtual Transform3D get_toMfrom()
+	{
+		unsigned fromRevision = 0;
+		unsigned toRevision = 0;
+		Transform3D rMfrom = mProvider->get_rMspace(mFrom.get(), &fromRevision);
+		Transform3D rMto = mProvider->get_rMspace(mTo.get(), &toRevision);
+
+		QMutexLocker locker(&mMutex);
+		if ((fromRevision != mFromRevision) || (toRevision != mToRevision))
+		{
+			m_toMfrom = rMto.inv() * rMfrom;
+			mFromRevision = fromRevision;
+			mToRevision = toRevision;
+		}
+		return m_toMfrom;
+	}
+	virtual CoordinateSystem getFrom() const { return mFrom->mSpace; }
+	virtual CoordinateSystem getTo() const { return mTo->mSpace; }
+private:
+	SpaceProviderImpl* mProvider;
+	SpaceNodePtr mFrom;
+	SpaceNodePtr mTo;
+	QMutex mMutex; ///< protects the memoized to_M_from
+	unsigned mFromRevision;
+	unsigned mToRevision;
+	Transform3D m_toMfrom;
+};
+} // namespace
+
 Transform3D SpaceProviderImpl::get_toMfrom(CoordinateSystem from, CoordinateSystem to)
 {
 	Transform3D to_M_from = get_rMfrom(to).inv() * get_rMfrom(from);
 	return to_M_from;
 }
 
+Transform3D SpaceProviderImpl::compute_toMfrom(CoordinateSystem from, CoordinateSystem to)
+{
+	return compute_rMfrom(to).inv() * compute_rMfrom(from);
+}
+
+SpaceTransformHandlePtr SpaceProviderImpl::getTransformHandle(CoordinateSystem from, CoordinateSystem to)
+{
+	QWriteLocker locker(&mCacheLock);
+	return SpaceTransformHandlePtr(new CachedSpaceTransformHandle(this, mCache->getNode(from), mCache->getNode(to)));
+}
+
 Transform3D SpaceProviderImpl::get_rMfrom(CoordinateSystem from)
+{
+	SpaceNodePtr node;
+	{
+		QReadLocker locker(&mCacheLock);
+		node = mCache->findNode(from);
+		if (node && mCache->isValid(*node))
+			return node->m_rMspace;
+	}
+	if (!node)
+	{
+		QWriteLocker locker(&mCacheLock);
+		node = mCache->getNode(from);
+	}
+	unsigned revision = 0;
+	return this->get_rMspace(node.get(), &revision);
+}
+
+Transform3D SpaceProviderImpl::get_rMspace(SpaceNode* node, unsigned* revision)
+{
+	{
+		QReadLocker locker(&mCacheLock);
+		if (mCache->isValid(*node))
+		{
+			*revision = node->mRevision;
+			return node->m_rMspace;
+		}
+	}
+	return this->updateNode(node, revision);
+}
+
+/** Recompute node. No lock is held while the tools, data and transforms are
+ *  read, as they might emit signals reaching this class. The versions are
+ *  recorded before the read, thus a change during the read invalidates the
+ *  result at the next query.
+ */
+Transform3D SpaceProviderImpl::updateNode(SpaceNode* node, unsigned* revision)
+{
+	SpaceNode update;
+	{
+		QWriteLocker locker(&mCacheLock);
+		update = *node;
+		mCache->beginUpdate(&update);
+		bool dataSpace = (update.mSpace.mId==csDATA) || (update.mSpace.mId==csDATA_VOXEL);
+		if (dataSpace && (update.mSpace.mRefObject=="active"))
+			mCache->listenToActiveData();
+	}
+
+	CoordinateSystem space = update.mSpace;
+	ToolPtr tool;
+	DataPtr data;
+	bool requiresObject = true;
+	switch(space.mId)
+	{
+	case csDATA:
+	case csDATA_VOXEL:
+		data = this->findData(space.mRefObject);
+		break;
+	case csTOOL:
+	case csTOOL_OFFSET:
+	case csSENSOR:
+		tool = this->findTool(space.mRefObject);
+		break;
+	default:
+		requiresObject = false;
+		break;
+	};
+
+	{
+		QWriteLocker locker(&mCacheLock);
+		mCache->setObject(&update, tool);
+		mCache->setObject(&update, data);
+	}
+
+	update.m_rMspace = this->compute_rMfrom(space);
+	// unknown objects might appear without notice, don't cache them
+	update.mComputed = !requiresObject || update.mObject;
+
+	QWriteLocker locker(&mCacheLock);
+	mCache->store(node, update);
+	*revision = node->mRevision;
+	return update.m_rMspace;
+}
+
+Transform3D SpaceProviderImpl::compute_rMfrom(CoordinateSystem from)
 {
 	Transform3D rMfrom = Transform3D::Identity();
 
@@ -261,6 +403,29 @@ CoordinateSystem SpaceProviderImpl::convertToSpecific(CoordinateSystem space)
 	return space;
 }
 
+DataPtr SpaceProviderImpl::findData(QString uid)
+{
+	if (!mDataManager->isPatientValid())
+		return DataPtr();
+
+	if (uid=="active")
+	{
+		ActiveDataPtr activeData = mDataManager->getActiveData();
+		return activeData->getActive<Image>();
+	}
+	return mDataManager->getData(uid);
+}
+
+ToolPtr SpaceProviderImpl::findTool(QString uid)
+{
+	ToolPtr tool = mTrackingService->getTool(uid);
+
+	if (!tool && uid=="active")
+		tool = mTrackingService->getActiveTool();
+
+	return tool;
+}
+
 Transform3D SpaceProviderImpl::get_rMr()
 {
 	return Transform3D::Identity(); // ref_M_ref
@@ -271,15 +436,7 @@ Transform3D SpaceProviderImpl::get_rMd(QString uid)
 	if (!mDataManager->isPatientValid())
 		return Transform3D::Identity();
 
-	DataPtr data;
-	if (uid=="active")
-	{
-		ActiveDataPtr activeData = mDataManager->getActiveData();
-		data = activeData->getActive<Image>();
-	}
-	else
-		data = mDataManager->getData(uid);
-
+	DataPtr data = this->findData(uid);
 	if(!data)
 	{
 		reportWarning("Could not find data with uid: "+uid+". Can not find transform to unknown coordinate system, returning identity!");
@@ -293,15 +450,7 @@ Transform3D SpaceProviderImpl::get_rMdv(QString uid)
 	if (!mDataManager->isPatientValid())
 		return Transform3D::Identity();
 
-	DataPtr data;
-	if (uid=="active")
-	{
-		ActiveDataPtr activeData = mDataManager->getActiveData();
-		data = activeData->getActive<Image>();
-	}
-	else
-		data = mDataManager->getData(uid);
-
+	DataPtr data = this->findData(uid);
 	if(!data)
 	{
 		reportWarning("Could not find data with uid: "+uid+". Can not find transform to unknown coordinate system, returning identity!");
@@ -322,11 +471,7 @@ Transform3D SpaceProviderImpl::get_rMpr()
 
 Transform3D SpaceProviderImpl::get_rMt(QString uid)
 {
-	ToolPtr tool = mTrackingService->getTool(uid);
-
-	if (!tool && uid=="active")
-		tool = mTrackingService->getActiveTool();
-
+	ToolPtr tool = this->findTool(uid);
 	if(!tool)
 	{
 		reportWarning("Could not find tool with uid: "+uid+". Can not find transform to unknown coordinate system, returning identity!");
@@ -337,11 +482,7 @@ Transform3D SpaceProviderImpl::get_rMt(QString uid)
 
 Transform3D SpaceProviderImpl::get_rMto(QString uid)
 {
-	ToolPtr tool = mTrackingService->getTool(uid);
-
-	if (!tool && uid=="active")
-		tool = mTrackingService->getActiveTool();
-
+	ToolPtr tool = this->findTool(uid);
 	if(!tool)
 	{
 		reportWarning("Could not find tool with uid: "+uid+". Can not find transform to unknown coordinate system, returning identity!");
@@ -355,11 +496,7 @@ Transform3D SpaceProviderImpl::get_rMto(QString uid)
 
 Transform3D SpaceProviderImpl::get_rMs(QString uid)
 {
-	ToolPtr tool = mTrackingService->getTool(uid);
-
-	if (!tool && uid=="active")
-		tool = mTrackingService->getActiveTool();
-
+	ToolPtr tool = this->findTool(uid);
 	if(!tool)
 	{
 		reportWarning("Could not find tool with uid: "+uid+". Can not find transform to unknown coordinate system, returning identity!");
@@ -15,12 +15,20 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxSpaceProvider.h"
 #include "cxForwardDeclarations.h"
+#include "cxSpaceTransformCache.h"
+#include <QReadWriteLock>
 
 namespace cx
 {
 
 /** Provides information about all the coordinate systems in the application.
  *
+ * The transform from each space to ref is cached in a SpaceTransformCache,
+ * and recomputed only when the tool, data or patient reference defining it
+ * has signalled a change. Handles from getTransformHandle() also memoize
+ * the composed to_M_from. The cache is guarded by a read/write lock, thus
+ * transforms can be queried from any thread, and queries on valid spaces
+ * run concurrently.
  *
  * \ingroup cx_resource_core_utilities
  * \date 2014-02-21
@@ -33,6 +41,7 @@ public:
 	virtual ~SpaceProviderImpl() {}
 
 	virtual Transform3D get_toMfrom(CoordinateSystem from, CoordinateSystem to); ///< to_M_from
+	virtual SpaceTransformHandlePtr getTransformHandle(CoordinateSystem from, CoordinateSystem to);
 	virtual std::vector<CoordinateSystem> getSpacesToPresentInGUI();
 	virtual std::map<QString, QString> getDisplayNamesForCoordRefObjects();
 	virtual SpaceListenerPtr createListener();
@@ -49,8 +58,15 @@ public:
 	virtual CoordinateSystem getR(); ///<data references coordinate system
 	virtual CoordinateSystem convertToSpecific(CoordinateSystem space);
 
+	Transform3D compute_toMfrom(CoordinateSystem from, CoordinateSystem to); ///< to_M_from, bypassing the cache
+	Transform3D get_rMspace(SpaceNode* node, unsigned* revision); ///< ref_M_space of node and its revision, recomputed if invalid, used by transform handles
+
 private:
 	Transform3D get_rMfrom(CoordinateSystem from); ///< ref_M_from
+	Transform3D updateNode(SpaceNode* node, unsigned* revision); ///< recompute node, call with mCacheLock unlocked
+	Transform3D compute_rMfrom(CoordinateSystem from); ///< ref_M_from, uncached
+	DataPtr findData(QString uid);
+	ToolPtr findTool(QString uid);
 
 	Transform3D get_rMr(); ///< ref_M_ref
 	Transform3D get_rMd(QString uid);
@@ -64,6 +80,8 @@ private:
 
 	TrackingServicePtr mTrackingService;
 	PatientModelServicePtr mDataManager;
+	SpaceTransformCachePtr mCache;
+	QReadWriteLock mCacheLock;
 };
 
 } // namespace cx
@@ -0,0 +1,149 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxSpaceTransformCache.h"
+
+#include "cxPatientModelService.h"
+#include "cxTrackingService.h"
+#include "cxActiveData.h"
+#include "cxImage.h"
+#include "cxTool.h"
+
+namespace cx
+{
+
+SpaceTransformCache::SpaceTransformCache(TrackingServicePtr trackingService, PatientModelServicePtr dataManager) :
+	mTrackingService(trackingService),
+	mDataManager(dataManager),
+	mStructureVersion(0),
+	mPatientRefVersion(0)
+{
+	connect(mTrackingService.get(), &TrackingService::stateChanged, this, &SpaceTransformCache::structureChangedSlot);
+	connect(mTrackingService.get(), &TrackingService::activeToolChanged, this, &SpaceTransformCache::structureChangedSlot);
+	connect(mDataManager.get(), &PatientModelService::dataAddedOrRemoved, this, &SpaceTransformCache::structureChangedSlot);
+	connect(mDataManager.get(), &PatientModelService::patientChanged, this, &SpaceTransformCache::structureChangedSlot);
+	connect(mDataManager.get(), &PatientModelService::rMprChanged, this, &SpaceTransformCache::patientRefChangedSlot);
+}
+
+SpaceTransformCache::~SpaceTransformCache()
+{
+}
+
+void SpaceTransformCache::listenToActiveData()
+{
+	if (mActiveData)
+		return;
+	mActiveData = mDataManager->getActiveData();
+	if (mActiveData)
+		connect(mActiveData.get(), &ActiveData::activeDataChanged, this, &SpaceTransformCache::structureChangedSlot, Qt::DirectConnection);
+}
+
+void SpaceTransformCache::structureChangedSlot()
+{
+	++mStructureVersion;
+}
+
+void SpaceTransformCache::patientRefChangedSlot()
+{
+	++mPatientRefVersion;
+}
+
+SpaceNodePtr SpaceTransformCache::getNode(const CoordinateSystem& space)
+{
+	SpaceNodePtr& node = mNodes[std::make_pair(int(space.mId), space.mRefObject)];
+	if (!node)
+	{
+		node.reset(new SpaceNode());
+		node->mSpace = space;
+	}
+	return node;
+}
+
+SpaceNodePtr SpaceTransformCache::findNode(const CoordinateSystem& space) const
+{
+	std::map<std::pair<int, QString>, SpaceNodePtr>::const_iterator iter = mNodes.find(std::make_pair(int(space.mId), space.mRefObject));
+	if (iter == mNodes.end())
+		return SpaceNodePtr();
+	return iter->second;
+}
+
+bool SpaceTransformCache::isValid(const SpaceNode& node) const
+{
+	if (!node.mComputed)
+		return false;
+	if (node.mStructureVersion != mStructureVersion)
+		return false;
+	if (node.mPatientRefVersion != mPatientRefVersion)
+		return false;
+	if (node.mObject && ((node.mObject->getVersion() != node.mObjectVersion) || !node.mObject->getObject()))
+		return false;
+	return true;
+}
+
+void SpaceTransformCache::beginUpdate(SpaceNode* update)
+{
+	update->mComputed = false;
+	update->mStructureVersion = mStructureVersion;
+	update->mPatientRefVersion = mPatientRefVersion;
+	update->mObject.reset();
+	update->mObjectVersion = 0;
+}
+
+void SpaceTransformCache::setObject(SpaceNode* update, ToolPtr tool)
+{
+	if (!tool)
+		return;
+	update->mObject = this->getCounter(&mToolCounters, tool->getUid(), tool.get());
+	update->mObjectVersion = update->mObject->getVersion();
+}
+
+void SpaceTransformCache::setObject(SpaceNode* update, DataPtr data)
+{
+	if (!data)
+		return;
+	update->mObject = this->getCounter(&mDataCounters, data->getUid(), data.get());
+	update->mObjectVersion = update->mObject->getVersion();
+}
+
+void SpaceTransformCache::store(SpaceNode* node, const SpaceNode& update)
+{
+	unsigned revision = node->mRevision;
+	*node = update;
+	node->mRevision = revision+1;
+}
+
+/** Return the counter for the object with the given uid,
+ *  creating a new one if the object is new or has been replaced.
+ */
+SpaceVersionCounterPtr SpaceTransformCache::getCounter(std::map<QString, SpaceVersionCounterPtr>* counters, QString uid, QObject* object)
+{
+	SpaceVersionCounterPtr& counter = (*counters)[uid];
+	if (counter && (counter->getObject() == object))
+		return counter;
+
+	// direct connections, as the counter might be created in a thread without an event loop
+	counter.reset(new SpaceVersionCounter(object));
+	if (qobject_cast<Tool*>(object))
+	{
+		connect(object, SIGNAL(toolTransformAndTimestamp(Transform3D,double)), counter.get(), SLOT(increment()), Qt::DirectConnection);
+		connect(object, SIGNAL(tooltipOffset(double)), counter.get(), SLOT(increment()), Qt::DirectConnection);
+		connect(object, SIGNAL(toolProbeSector()), counter.get(), SLOT(increment()), Qt::DirectConnection); // probe depth is the tooltip offset
+	}
+	else
+	{
+		connect(object, SIGNAL(transformChanged()), counter.get(), SLOT(increment()), Qt::DirectConnection);
+		if (qobject_cast<Image*>(object))
+			connect(object, SIGNAL(vtkImageDataChanged(QString)), counter.get(), SLOT(increment()), Qt::DirectConnection); // voxel spacing
+	}
+	return counter;
+}
+
+} // namespace cx
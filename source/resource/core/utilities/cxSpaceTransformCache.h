@@ -0,0 +1,128 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXSPACETRANSFORMCACHE_H
+#define CXSPACETRANSFORMCACHE_H
+
+#include "cxResourceExport.h"
+
+#include <map>
+#include <atomic>
+#include <QObject>
+#include <QPointer>
+#include "cxTransform3D.h"
+#include "cxCoordinateSystemHelpers.h"
+#include "cxForwardDeclarations.h"
+
+namespace cx
+{
+
+/** Version counter for one tool or data object, incremented each
+ *  time the object signals that its transform has changed.
+ *  The counter is atomic, as the signals may come from other threads.
+ *
+ * \ingroup cx_resource_core_utilities
+ */
+class cxResource_EXPORT SpaceVersionCounter : public QObject
+{
+	Q_OBJECT
+public:
+	explicit SpaceVersionCounter(QObject* object) : mObject(object), mVersion(0) {}
+	unsigned getVersion() const { return mVersion.load(); }
+	QObject* getObject() const { return mObject; }
+public slots:
+	void increment() { ++mVersion; }
+private:
+	QPointer<QObject> mObject;
+	std::atomic<unsigned> mVersion;
+};
+typedef boost::shared_ptr<SpaceVersionCounter> SpaceVersionCounterPtr;
+
+/** One space in the transform graph, holding the cached rMspace
+ *  and the versions it was computed from.
+ *
+ * \ingroup cx_resource_core_utilities
+ */
+struct cxResource_EXPORT SpaceNode
+{
+	SpaceNode() :
+		m_rMspace(Transform3D::Identity()),
+		mRevision(0),
+		mComputed(false),
+		mStructureVersion(0),
+		mPatientRefVersion(0),
+		mObjectVersion(0)
+	{}
+	CoordinateSystem mSpace;
+	Transform3D m_rMspace;
+	unsigned mRevision; ///< incremented each time m_rMspace is recomputed
+	bool mComputed;
+	unsigned mStructureVersion;
+	unsigned mPatientRefVersion;
+	SpaceVersionCounterPtr mObject; ///< tool or data defining the space, if any
+	unsigned mObjectVersion;
+};
+typedef boost::shared_ptr<SpaceNode> SpaceNodePtr;
+
+/** Cache of the transforms from all spaces to ref, used by SpaceProviderImpl.
+ *
+ * Each space is a SpaceNode holding its last computed rMspace. The node is
+ * valid as long as the versions it was computed from are unchanged:
+ *  - structure: tools or data added/removed, active tool/data changed, patient changed.
+ *  - patient reference: rMpr changed.
+ *  - object: the tool or data defining the space signalled a transform change.
+ *
+ * The versions are bumped by the existing Qt signals, which all sources of
+ * transform changes emit. Thus a query on a valid node is a map lookup and
+ * a few integer comparisons.
+ *
+ * The cache is not locked, SpaceProviderImpl guards access to it.
+ *
+ * \ingroup cx_resource_core_utilities
+ */
+class cxResource_EXPORT SpaceTransformCache : public QObject
+{
+	Q_OBJECT
+public:
+	SpaceTransformCache(TrackingServicePtr trackingService, PatientModelServicePtr dataManager);
+	virtual ~SpaceTransformCache();
+
+	SpaceNodePtr getNode(const CoordinateSystem& space); ///< get or create the node for space
+	SpaceNodePtr findNode(const CoordinateSystem& space) const; ///< get the node for space, null if not created
+	bool isValid(const SpaceNode& node) const;
+
+	void beginUpdate(SpaceNode* update); ///< record the current versions in a copy of a node, before recomputing it
+	void setObject(SpaceNode* update, ToolPtr tool);
+	void setObject(SpaceNode* update, DataPtr data);
+	void store(SpaceNode* node, const SpaceNode& update); ///< replace node with the recomputed update, incrementing the revision
+	void listenToActiveData(); ///< include active data changes in the structure version
+
+private slots:
+	void structureChangedSlot();
+	void patientRefChangedSlot();
+
+private:
+	SpaceVersionCounterPtr getCounter(std::map<QString, SpaceVersionCounterPtr>* counters, QString uid, QObject* object);
+
+	TrackingServicePtr mTrackingService;
+	PatientModelServicePtr mDataManager;
+	ActiveDataPtr mActiveData;
+	std::atomic<unsigned> mStructureVersion;
+	std::atomic<unsigned> mPatientRefVersion;
+	std::map<std::pair<int, QString>, SpaceNodePtr> mNodes;
+	std::map<QString, SpaceVersionCounterPtr> mToolCounters;
+	std::map<QString, SpaceVersionCounterPtr> mDataCounters;
+};
+typedef boost::shared_ptr<SpaceTransformCache> SpaceTransformCachePtr;
+
+} // namespace cx
+
+#endif // CXSPACETRANSFORMCACHE_H
@@ -11,6 +11,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxUtilHelpers.h"
 #include <QStringList>
+#include <QFile>
 
 #ifndef CX_WINDOWS
 #include <unistd.h>
@@ -79,6 +80,19 @@ void sleep_ms(int ms)
 #endif
 }
 
+bool linkOrCopyFile(QString source, QString target)
+{
+	QFile::remove(target);
+#ifndef CX_WINDOWS
+	if (::link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0)
+		return true;
+#else
+	if (CreateHardLinkW((LPCWSTR)target.utf16(), (LPCWSTR)source.utf16(), NULL))
+		return true;
+#endif
+	return QFile::copy(source, target);
+}
+
 
 } // namespace cx
 
@@ -53,6 +53,10 @@ cxResource_EXPORT int constrainValue(int val, int min, int max);
 cxResource_EXPORT int sign(double x);
 cxResource_EXPORT QString changeExtension(QString name, QString ext);
 cxResource_EXPORT void sleep_ms(int ms);
+/** Make target a hard link to source, replacing any existing target.
+ *  Fall back to a copy where links are unsupported, e.g. across file systems.
+ */
+cxResource_EXPORT bool linkOrCopyFile(QString source, QString target);
 
 /**
  * \}
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <time.h>
 #include <fstream>
+#include <algorithm>
+#include <limits>
 
 #include <QFileInfo>
 
@@ -25,13 +27,14 @@
 #include "vtkImageData.h"
 #include "vtkGeneralTransform.h"
 #include "vtkMath.h"
-#include "vtkSortDataArray.h"
+#include "vtkLinearTransform.h"
 #include "vtkMaskPoints.h"
 #include "vtkPointData.h"
 #include "vtkLandmarkTransform.h"
 #include "vtkFloatArray.h"
 #include "cxMesh.h"
 #include "cxLogger.h"
+#include "cxParallelFor.h"
 
 namespace cx
 {
@@ -49,6 +52,7 @@ SeansVesselReg::SeansVesselReg()// : mInvertedTransform(false)
 	mt_maximumNumberOfIterations = 100;
 	mt_verbose = false;
 	mt_maximumDurationSeconds = 1E6; // Random high number
+	mt_usePointCloudBackend = true;
 	margin = 40;
 }
 
@@ -159,16 +163,31 @@ SeansVesselReg::ContextPtr SeansVesselReg::linearRefineAllLTS(ContextPtr seed)
 	lts.push_back(100);
 
 	std::vector<ContextPtr> paths;
-
-	// iterate along all paths
 	for (unsigned i=0; i<lts.size(); ++i)
 	{
 		ContextPtr current = this->splitContext(seed);
-		paths.push_back(current);
 		current->mLtsRatio = lts[i];
-		this->linearRefine(current);
-		if (mt_verbose)
-			std::cout << QString("LTS=%1, metric=%2").arg(current->mLtsRatio).arg(current->mMetric) << std::endl;
+		paths.push_back(current);
+	}
+
+	// iterate along all paths, concurrently if the search structure allows it
+	if (seed->mTargetKdTree)
+	{
+		parallelFor(0, paths.size(), [this, &paths](int i)
+		{
+			this->linearRefine(paths[i]);
+		}, 1);
+	}
+	else
+	{
+		for (unsigned i=0; i<paths.size(); ++i)
+			this->linearRefine(paths[i]);
+	}
+
+	if (mt_verbose)
+	{
+		for (unsigned i=0; i<paths.size(); ++i)
+			std::cout << QString("LTS=%1, metric=%2").arg(paths[i]->mLtsRatio).arg(paths[i]->mMetric) << std::endl;
 	}
 
 	// search for best path
@@ -223,6 +242,7 @@ SeansVesselReg::ContextPtr SeansVesselReg::splitContext(ContextPtr context)
 
 	// constant data: shallow copy
 	retval->mTargetPointLocator = context->mTargetPointLocator;
+	retval->mTargetKdTree = context->mTargetKdTree;
 	retval->mTargetPoints = context->mTargetPoints;
 
 	// will be modified: deep copy
@@ -287,10 +307,17 @@ SeansVesselReg::ContextPtr SeansVesselReg::createContext(DataPtr source, DataPtr
 
 	// Create locator for target points
 	context->mTargetPoints = targetPolyData;
-	context->mTargetPointLocator = vtkCellLocatorPtr::New();
-	context->mTargetPointLocator->SetDataSet(targetPolyData);
-	context->mTargetPointLocator->SetNumberOfCellsPerBucket(1);
-	context->mTargetPointLocator->BuildLocator();
+	if (mt_usePointCloudBackend)
+	{
+		context->mTargetKdTree = KdTree::create(targetPolyData->GetPoints());
+	}
+	else
+	{
+		context->mTargetPointLocator = vtkCellLocatorPtr::New();
+		context->mTargetPointLocator->SetDataSet(targetPolyData);
+		context->mTargetPointLocator->SetNumberOfCellsPerBucket(1);
+		context->mTargetPointLocator->BuildLocator();
+	}
 
 	//Since we are going to play with the data, we have to make a copy
 	context->mSourcePoints = vtkPointsPtr::New();
@@ -326,46 +353,86 @@ void SeansVesselReg::computeDistances(ContextPtr context)
 	// - closestPoint is used so that the internal state of LandmarkTransform remains
 	//   correct whenever the iteration process is stopped (hence its source
 	//   and landmark points might be used in a vtkThinPlateSplineTransform).
-	vtkPointsPtr closestPoint = vtkPointsPtr::New();
-	closestPoint->SetNumberOfPoints(numPoints);
-
-	// Fill points with the closest points to each vertex in input
-	vtkFloatArrayPtr residuals = vtkFloatArrayPtr::New();
-	residuals->SetNumberOfValues(numPoints);
+	std::vector<Vector3D> sourcePoints;
+	std::vector<Vector3D> closestPoints;
+	std::vector<double> residuals;
+	if (!this->findClosestPoints(context, &sourcePoints, &closestPoints, &residuals))
+	{
+		std::cout << "nan found during findClosestPoint!" << std::endl;
+		context->mMetric = 1E6;
+		return;
+	}
 
-	vtkIdListPtr IdList = vtkIdListPtr::New();
-	IdList->SetNumberOfIds(numPoints);
 	double total_distance = 0;
-	double distanceSquared = 0;
-	//Find closest points to all source points
 	for (int i = 0; i < numPoints; ++i)
+		total_distance += sqrt(residuals[i]);
+
+	// quality of the current iteration
+	context->mMetric = total_distance / numPoints;
+
+	// Keep the nb_points closest points. The order inside the kept set does not
+	// matter to the landmark transform, thus a partial sort is sufficient.
+	std::vector<int> IdList(numPoints);
+	for (int i = 0; i < numPoints; ++i)
+		IdList[i] = i;
+	if (nb_points < numPoints)
 	{
-		//Check the distance to neighbouring points (neighbours should be matched to nearby points)
-		vtkIdType cell_id;
-		int sub_id;
-		double outPoint[3];
-		context->mTargetPointLocator->FindClosestPoint(context->mSourcePoints->GetPoint(i), outPoint, cell_id, sub_id, distanceSquared);
-		closestPoint->SetPoint(i, outPoint);
-		if ((boost::math::isnan)(distanceSquared))
+		std::nth_element(IdList.begin(), IdList.begin()+nb_points, IdList.end(),
+						 [&residuals](int a, int b) { return residuals[a] < residuals[b]; });
+	}
+
+	context->mSortedSourcePoints = this->createSortedPoints(IdList, sourcePoints, nb_points);
+	context->mSortedTargetPoints = this->createSortedPoints(IdList, closestPoints, nb_points);
+}
+
+/**Find the closest target point for each of the source points in context.
+ * Return false if the search failed (nan found).
+ *
+ */
+bool SeansVesselReg::findClosestPoints(ContextPtr context, std::vector<Vector3D>* sourcePoints, std::vector<Vector3D>* closestPoints, std::vector<double>* distancesSquared)
+{
+	vtkPoints* points = context->mSourcePoints.GetPointer();
+	int numPoints = points->GetNumberOfPoints();
+	sourcePoints->resize(numPoints);
+	closestPoints->resize(numPoints);
+	distancesSquared->resize(numPoints);
+
+	if (context->mTargetKdTree)
+	{
+		const KdTree* tree = context->mTargetKdTree.get();
+		Vector3D* source = sourcePoints->data();
+		Vector3D* closest = closestPoints->data();
+		double* distances = distancesSquared->data();
+		parallelFor(0, numPoints, [=](int i)
 		{
-			std::cout << "nan found during findClosestPoint!" << std::endl;
+			points->GetPoint(i, source[i].data());
+			int index = tree->findClosestPoint(source[i], &distances[i]);
+			if (index < 0)
 			{
-				context->mMetric = 1E6;
-				return;
+				distances[i] = std::numeric_limits<double>::quiet_NaN();
+				closest[i] = source[i];
 			}
+			else
+			{
+				closest[i] = tree->getPoint(index);
+			}
+		}, 256);
+	}
+	else
+	{
+		for (int i = 0; i < numPoints; ++i)
+		{
+			vtkIdType cell_id;
+			int sub_id;
+			points->GetPoint(i, (*sourcePoints)[i].data());
+			context->mTargetPointLocator->FindClosestPoint((*sourcePoints)[i].data(), (*closestPoints)[i].data(), cell_id, sub_id, (*distancesSquared)[i]);
 		}
-		residuals->InsertValue(i, distanceSquared);
-		IdList->InsertId(i, i);
-		total_distance += sqrt(distanceSquared);
 	}
 
-	// quality of the current iteration
-	context->mMetric = total_distance / numPoints;
-
-	vtkSortDataArrayPtr sort = vtkSortDataArrayPtr::New();
-	sort->Sort(residuals, IdList);
-	context->mSortedSourcePoints = this->createSortedPoints(IdList, context->mSourcePoints, nb_points);
-	context->mSortedTargetPoints = this->createSortedPoints(IdList, closestPoint, nb_points);
+	for (int i = 0; i < numPoints; ++i)
+		if ((boost::math::isnan)((*distancesSquared)[i]))
+			return false;
+	return true;
 }
 
 /**\brief Register the source points to the target point in a single ste.
@@ -398,7 +465,7 @@ void SeansVesselReg::performOneRegistration(ContextPtr context, bool linear)
 
 	// Transform the source points with the transform found during this iteration,
 	// in order to use an updated guess for the next iteration
-	context->mSourcePoints = this->transformPoints(context->mSourcePoints, context->mTransform);
+	this->transformPointsInPlace(context->mSourcePoints, context->mTransform);
 
 	// clear sorting data - enables us to call iteratively without fuss.
 	context->mSortedSourcePoints = vtkPointsPtr();
@@ -414,44 +481,54 @@ void SeansVesselReg::performOneRegistration(ContextPtr context, bool linear)
  * based on the numPoint first of unsortedPoints.
  *
  */
-vtkPointsPtr SeansVesselReg::createSortedPoints(vtkIdListPtr sortedIDList, vtkPointsPtr unsortedPoints, int numPoints)
+vtkPointsPtr SeansVesselReg::createSortedPoints(const std::vector<int>& sortedIDList, const std::vector<Vector3D>& unsortedPoints, int numPoints)
 {
 	vtkPointsPtr retval = vtkPointsPtr::New();
 	retval->SetNumberOfPoints(numPoints);
 
-	double temp_point[3];
-
 	for (int i = 0; i < numPoints; ++i)
 	{
-		vtkIdType index = sortedIDList->GetId(i);
-		unsortedPoints->GetPoint(index, temp_point); // source points to use in tps
-		retval->SetPoint(i, temp_point);
+		int index = sortedIDList[i];
+		retval->SetPoint(i, unsortedPoints[index].data()); // source points to use in tps
 	}
 
 	return retval;
 }
 
-/**Transform input using the transform
+/**Transform points using the transform, overwriting the input.
+ * Linear transforms are applied in parallel.
  *
  */
-vtkPointsPtr SeansVesselReg::transformPoints(vtkPointsPtr input, vtkAbstractTransformPtr transform)
+void SeansVesselReg::transformPointsInPlace(vtkPointsPtr points, vtkAbstractTransformPtr transform)
 {
-//	QTime start = QTime::currentTime();
-
-	int N = input->GetNumberOfPoints();
-	vtkPointsPtr retval = vtkPointsPtr::New();
-	retval->SetNumberOfPoints(N);
+	int N = points->GetNumberOfPoints();
+	vtkLinearTransform* linear = vtkLinearTransform::SafeDownCast(transform.GetPointer());
 
-		//Transform ALL source points
-	double temp[3];
-	for (int i = 0; i < N; ++i)
+	if (linear && mt_usePointCloudBackend)
 	{
-		transform->InternalTransformPoint(input->GetPoint(i), temp);
-		retval->SetPoint(i, temp);
+		Transform3D M(linear->GetMatrix());
+		vtkPoints* raw = points.GetPointer();
+		parallelFor(0, N, [=](int i)
+		{
+			Vector3D p;
+			raw->GetPoint(i, p.data());
+			p = M.coord(p);
+			raw->SetPoint(i, p.data());
+		}, 1024);
+	}
+	else
+	{
+		double p[3];
+		double temp[3];
+		for (int i = 0; i < N; ++i)
+		{
+			points->GetPoint(i, p);
+			transform->InternalTransformPoint(p, temp);
+			points->SetPoint(i, temp);
+		}
 	}
 
-//	std::cout << QString("\nV2V Transform time: %1s").arg(start.secsTo(QTime::currentTime())) << endl;
-	return retval;
+	points->Modified();
 }
 
 vtkAbstractTransformPtr SeansVesselReg::linearRegistration(vtkPointsPtr sortedSourcePoints,
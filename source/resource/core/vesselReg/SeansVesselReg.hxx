@@ -6,6 +6,7 @@
 #include "cxForwardDeclarations.h"
 #include "vtkForwardDeclarations.h"
 #include "cxTransform3D.h"
+#include "cxKdTree.h"
 #include "vtkSmartPointer.h"
 
 namespace cx
@@ -17,6 +18,11 @@ namespace cx
  *
  * Basic usage: Run execute(), then get result with getLinearTransform()
  *
+ * The default closest point search is point cloud to point cloud using a
+ * k-d tree over the target points. The queries and the auto LTS search are
+ * run in parallel. Set mt_usePointCloudBackend=false to use the original
+ * point to cell search using vtkCellLocator, which runs single threaded.
+ *
  *
  * \ingroup cx_resource_core_utilities
  * \date Feb 4, 2011
@@ -36,6 +42,7 @@ public:
 	struct cxResource_EXPORT Context
 	{
 		vtkCellLocatorPtr mTargetPointLocator; ///< input: target data wrapped in a locator
+		KdTreePtr mTargetKdTree; ///< input: target points wrapped in a k-d tree, used instead of the locator if set
 		vtkPolyDataPtr mTargetPoints; ///< input: target data
 		vtkPointsPtr mSourcePoints; ///< input: current source data, modified according to last iteration
 
@@ -93,6 +100,7 @@ public:
 	int mt_maximumNumberOfIterations;
 	bool mt_verbose;
 	double mt_maximumDurationSeconds;
+	bool mt_usePointCloudBackend; ///< use k-d tree closest point search and parallel execution (default), instead of vtkCellLocator
 	double margin;
 	QString m_logPath;
 
@@ -120,8 +128,9 @@ protected:
 	vtkAbstractTransformPtr linearRegistration(vtkPointsPtr sortedSourcePoints, vtkPointsPtr sortedTargetPoints);
 	vtkAbstractTransformPtr nonLinearRegistration(vtkPointsPtr sortedSourcePoints, vtkPointsPtr sortedTargetPoints);
 	vtkPolyDataPtr convertToPolyData(DataPtr data, QString id);
-	vtkPointsPtr transformPoints(vtkPointsPtr input, vtkAbstractTransformPtr transform);
-	vtkPointsPtr createSortedPoints(vtkIdListPtr sortedIDList, vtkPointsPtr unsortedPoints, int numPoints);
+	void transformPointsInPlace(vtkPointsPtr points, vtkAbstractTransformPtr transform);
+	vtkPointsPtr createSortedPoints(const std::vector<int>& sortedIDList, const std::vector<Vector3D>& unsortedPoints, int numPoints);
+	bool findClosestPoints(ContextPtr context, std::vector<Vector3D>* sourcePoints, std::vector<Vector3D>* closestPoints, std::vector<double>* distancesSquared);
 	vtkPolyDataPtr crop(vtkPolyDataPtr input, vtkPolyDataPtr fixed, double margin);
 	ContextPtr linearRefineAllLTS(ContextPtr context);
 	void linearRefine(ContextPtr context);
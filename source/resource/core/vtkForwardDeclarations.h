@@ -114,6 +114,7 @@ typedef vtkSmartPointer<class vtkPolyDataMapper> vtkPolyDataMapperPtr;
 typedef vtkSmartPointer<class vtkPolyDataNormals> vtkPolyDataNormalsPtr;
 typedef vtkSmartPointer<class vtkPolyDataReader> vtkPolyDataReaderPtr;
 typedef vtkSmartPointer<class vtkXMLPolyDataReader> vtkXMLPolyDataReaderPtr;
+typedef vtkSmartPointer<class vtkXMLPolyDataWriter> vtkXMLPolyDataWriterPtr;
 typedef vtkSmartPointer<class vtkPolyData> vtkPolyDataPtr;
 typedef vtkSmartPointer<class vtkPolyDataWriter> vtkPolyDataWriterPtr;
 typedef vtkSmartPointer<class vtkProbeFilter> vtkProbeFilterPtr;
@@ -31,6 +31,11 @@ FilterPtr FilterTimedAlgorithm::getFilter()
 	return mFilter;
 }
 
+bool FilterTimedAlgorithm::getSuccess()
+{
+	return this->getResult();
+}
+
 void FilterTimedAlgorithm::preProcessingSlot()
 {
 	mFilter->preProcess();
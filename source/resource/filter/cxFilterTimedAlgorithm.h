@@ -36,6 +36,7 @@ public:
 	virtual ~FilterTimedAlgorithm();
 
 	FilterPtr getFilter();
+	bool getSuccess(); ///< result of the last execution, call after finished()
 
 protected slots:
 	virtual void preProcessingSlot();
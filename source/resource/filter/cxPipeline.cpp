@@ -22,7 +22,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxDoublePropertyBase.h"
 #include "cxColorPropertyBase.h"
 #include "cxStringPropertyBase.h"
-#include "cxCompositeTimedAlgorithm.h"
+#include "cxPipelineExecutor.h"
 #include "cxFilterTimedAlgorithm.h"
 
 namespace cx
@@ -134,7 +134,7 @@ Pipeline::Pipeline(PatientModelServicePtr patientModelService, QObject *parent)
 		QObject(parent),
 		mPatientModelService(patientModelService)
 {
-	mCompositeTimedAlgorithm.reset(new CompositeSerialTimedAlgorithm("Pipeline"));
+	mExecutor.reset(new PipelineExecutor(mPatientModelService, "Pipeline"));
 }
 
 void Pipeline::initialize(FilterGroupPtr filters)
@@ -275,7 +275,7 @@ TimedAlgorithmPtr Pipeline::getTimedAlgorithm(QString uid)
 
 TimedAlgorithmPtr Pipeline::getPipelineTimedAlgorithm()
 {
-	return mCompositeTimedAlgorithm;
+	return mExecutor;
 }
 
 void Pipeline::execute(QString uid)
@@ -324,12 +324,21 @@ void Pipeline::execute(QString uid)
 		return;
 	}
 
-	mCompositeTimedAlgorithm->clear();
+	if (mExecutor->isRunning())
+		return;
+
+	// filter i depends on filter i-1 through node i
+	mExecutor->clearStages();
 	for (unsigned i=startIndex; i<endIndex; ++i)
-		mCompositeTimedAlgorithm->append(mTimedAlgorithm[mFilters->get(i)->getUid()]);
+	{
+		QStringList dependencies;
+		if (i>0)
+			dependencies << mFilters->get(i-1)->getUid();
+		mExecutor->addStage(mTimedAlgorithm[mFilters->get(i)->getUid()], dependencies);
+	}
 
-	// run all filters
-	mCompositeTimedAlgorithm->execute();
+	// run all filters, skipping those with unchanged input and options
+	mExecutor->execute();
 }
 
 //void Pipeline::execute(QString uid)
@@ -21,7 +21,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 namespace cx
 {
 typedef boost::shared_ptr<class TimedBaseAlgorithm> TimedAlgorithmPtr;
-typedef boost::shared_ptr<class CompositeTimedAlgorithm> CompositeTimedAlgorithmPtr;
+typedef boost::shared_ptr<class FilterTimedAlgorithm> FilterTimedAlgorithmPtr;
+typedef boost::shared_ptr<class PipelineExecutor> PipelineExecutorPtr;
 
 typedef boost::shared_ptr<class StringPropertyFusedInputOutputSelectData> StringPropertyFusedInputOutputSelectDataPtr;
 
@@ -69,6 +70,10 @@ protected:
 
 
 /** Sequential execution of Filters.
+ *
+ * The filters are run by a PipelineExecutor, thus filters whose
+ * inputs and options are unchanged since the last execution are
+ * not rerun, instead their previous output is reused.
  *
  * \ingroup cxPluginAlgorithms
  * \date Nov 22, 2012
@@ -120,7 +125,8 @@ public:
 	/**
 	  * Execute the filter at filterIndex. Recursively execute
 	  * all filters earlier in the pipeline if they dont have
-	  * an output value.
+	  * an output value. Filters with unchanged input and options
+	  * reuse their cached output.
 	  *
 	  * Empty input tries to update the pipeline output, i.e. execute
 	  * all filters required to generate the final output, or none if already
@@ -139,8 +145,8 @@ private:
 
 	FilterGroupPtr mFilters;
 	std::vector<SelectDataStringPropertyBasePtr> mNodes;
-	std::map<QString, TimedAlgorithmPtr> mTimedAlgorithm;
-	CompositeTimedAlgorithmPtr mCompositeTimedAlgorithm;
+	std::map<QString, FilterTimedAlgorithmPtr> mTimedAlgorithm;
+	PipelineExecutorPtr mExecutor;
 	PatientModelServicePtr mPatientModelService;
 };
 typedef boost::shared_ptr<Pipeline> PipelinePtr;
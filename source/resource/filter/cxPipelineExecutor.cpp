@@ -0,0 +1,324 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#include "cxPipelineExecutor.h"
+
+#include <QThread>
+#include <QHash>
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include "cxFilter.h"
+#include "cxFilterTimedAlgorithm.h"
+#include "cxSelectDataStringProperty.h"
+#include "cxPatientModelService.h"
+#include "cxImage.h"
+#include "cxMesh.h"
+#include "cxTypeConversions.h"
+#include "cxLogger.h"
+
+namespace cx
+{
+
+namespace
+{
+/** Identify data and its modification state: uid, modification time of the
+ *  vtk data and the transform.
+ */
+QString createDataKey(DataPtr data)
+{
+	if (!data)
+		return "none";
+
+	unsigned long modified = 0;
+	ImagePtr image = boost::dynamic_pointer_cast<Image>(data);
+	MeshPtr mesh = boost::dynamic_pointer_cast<Mesh>(data);
+	if (image && image->getBaseVtkImageData())
+		modified = image->getBaseVtkImageData()->GetMTime();
+	else if (mesh && mesh->getVtkPolyData())
+		modified = mesh->getVtkPolyData()->GetMTime();
+
+	return QString("%1@%2[%3]").arg(data->getUid()).arg(modified).arg(qstring_cast(data->get_rMd()));
+}
+}
+
+PipelineExecutor::PipelineExecutor(PatientModelServicePtr patientModelService, QString name) :
+	TimedBaseAlgorithm(name, 20),
+	mPatientModelService(patientModelService),
+	mMaxConcurrentStages(std::max(1, QThread::idealThreadCount())),
+	mRunning(false)
+{
+}
+
+void PipelineExecutor::addStage(FilterTimedAlgorithmPtr algorithm, QStringList dependencies)
+{
+	if (mRunning)
+	{
+		reportError("Attempt to add stage to PipelineExecutor while running failed.");
+		return;
+	}
+
+	Stage stage;
+	stage.algorithm = algorithm;
+	stage.dependencies = dependencies;
+	stage.state = sPENDING;
+	stage.cached = false;
+	stage.seconds = 0;
+	mStages.push_back(stage);
+}
+
+void PipelineExecutor::clearStages()
+{
+	if (mRunning)
+	{
+		reportError("Attempt to clear PipelineExecutor while running failed.");
+		return;
+	}
+	mStages.clear();
+}
+
+void PipelineExecutor::clearCache()
+{
+	mCache.clear();
+}
+
+void PipelineExecutor::setMaxConcurrentStages(int count)
+{
+	mMaxConcurrentStages = std::max(1, count);
+}
+
+std::vector<PipelineExecutor::StageTiming> PipelineExecutor::getStageTimings() const
+{
+	std::vector<StageTiming> retval;
+	for (unsigned i=0; i<mStages.size(); ++i)
+	{
+		StageTiming timing;
+		timing.uid = mStages[i].algorithm->getFilter()->getUid();
+		timing.cached = mStages[i].cached;
+		timing.success = (mStages[i].state == sDONE);
+		timing.seconds = mStages[i].seconds;
+		retval.push_back(timing);
+	}
+	return retval;
+}
+
+QString PipelineExecutor::getProduct() const
+{
+	QStringList running;
+	for (unsigned i=0; i<mStages.size(); ++i)
+		if (mStages[i].state == sRUNNING)
+			running << mStages[i].algorithm->getProduct();
+
+	if (running.isEmpty())
+		return mProduct;
+	return running.join(", ");
+}
+
+void PipelineExecutor::execute()
+{
+	if (mRunning)
+		return;
+
+	emit aboutToStart();
+	this->startTiming();
+	mRunning = true;
+	for (unsigned i=0; i<mStages.size(); ++i)
+	{
+		mStages[i].state = sPENDING;
+		mStages[i].cached = false;
+		mStages[i].seconds = 0;
+	}
+	emit started(0);
+
+	this->scheduleStages();
+}
+
+bool PipelineExecutor::isFinished() const
+{
+	return !mRunning;
+}
+
+bool PipelineExecutor::isRunning() const
+{
+	return mRunning;
+}
+
+int PipelineExecutor::getStageIndex(QString uid) const
+{
+	for (unsigned i=0; i<mStages.size(); ++i)
+		if (mStages[i].algorithm->getFilter()->getUid() == uid)
+			return i;
+	return -1;
+}
+
+int PipelineExecutor::countStages(STAGE_STATE state) const
+{
+	int count = 0;
+	for (unsigned i=0; i<mStages.size(); ++i)
+		if (mStages[i].state == state)
+			++count;
+	return count;
+}
+
+PipelineExecutor::STAGE_STATE PipelineExecutor::getDependencyState(const Stage& stage) const
+{
+	STAGE_STATE retval = sDONE;
+	for (int i=0; i<stage.dependencies.size(); ++i)
+	{
+		int index = this->getStageIndex(stage.dependencies[i]);
+		if (index < 0)
+			continue;
+		if (mStages[index].state == sFAILED)
+			return sFAILED;
+		if (mStages[index].state != sDONE)
+			retval = sPENDING;
+	}
+	return retval;
+}
+
+QString PipelineExecutor::createKey(const Stage& stage) const
+{
+	FilterPtr filter = stage.algorithm->getFilter();
+
+	QStringList inputs;
+	std::vector<SelectDataStringPropertyBasePtr> inputTypes = filter->getInputTypes();
+	for (unsigned i=0; i<inputTypes.size(); ++i)
+		inputs << createDataKey(inputTypes[i]->getData());
+
+	QString options;
+	std::vector<PropertyPtr> optionTypes = filter->getOptions();
+	for (unsigned i=0; i<optionTypes.size(); ++i)
+		options += optionTypes[i]->getUid() + "=" + optionTypes[i]->getValueAsVariant().toString() + ";";
+
+	return QString("%1 options:%2").arg(inputs.join(",")).arg(qHash(options));
+}
+
+void PipelineExecutor::scheduleStages()
+{
+	// restoring a cached stage can make other stages ready: iterate until stable
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (unsigned i=0; i<mStages.size(); ++i)
+		{
+			Stage& stage = mStages[i];
+			if (stage.state != sPENDING)
+				continue;
+
+			STAGE_STATE dependencies = this->getDependencyState(stage);
+			if (dependencies == sFAILED)
+			{
+				stage.state = sFAILED;
+				changed = true;
+				continue;
+			}
+			if (dependencies != sDONE)
+				continue;
+
+			stage.key = this->createKey(stage);
+			if (this->restoreCachedOutput(stage))
+			{
+				stage.state = sDONE;
+				stage.cached = true;
+				report(QString("Reused cached result of \"%1\"").arg(stage.algorithm->getFilter()->getName()));
+				emit productChanged();
+				changed = true;
+				continue;
+			}
+
+			if (this->countStages(sRUNNING) < mMaxConcurrentStages)
+				this->startStage(stage);
+		}
+	}
+
+	if (this->countStages(sRUNNING) > 0)
+		return;
+
+	// nothing running and nothing can start: remaining stages are in a cycle
+	for (unsigned i=0; i<mStages.size(); ++i)
+	{
+		if (mStages[i].state != sPENDING)
+			continue;
+		reportWarning(QString("Pipeline stage %1 has unresolvable dependencies").arg(mStages[i].algorithm->getFilter()->getUid()));
+		mStages[i].state = sFAILED;
+	}
+
+	mRunning = false;
+	this->stopTiming();
+	emit productChanged();
+	emit finished();
+}
+
+void PipelineExecutor::startStage(Stage& stage)
+{
+	stage.state = sRUNNING;
+	stage.timer.start();
+	connect(stage.algorithm.get(), SIGNAL(finished()), this, SLOT(stageFinished()));
+	emit productChanged();
+	stage.algorithm->execute();
+}
+
+void PipelineExecutor::stageFinished()
+{
+	for (unsigned i=0; i<mStages.size(); ++i)
+	{
+		Stage& stage = mStages[i];
+		if ((stage.state != sRUNNING) || (stage.algorithm.get() != this->sender()))
+			continue;
+
+		disconnect(stage.algorithm.get(), SIGNAL(finished()), this, SLOT(stageFinished()));
+		stage.seconds = stage.timer.elapsed()/1000.0;
+		if (stage.algorithm->getSuccess())
+		{
+			stage.state = sDONE;
+			this->storeCachedOutput(stage);
+		}
+		else
+		{
+			stage.state = sFAILED;
+			mCache.erase(stage.algorithm->getFilter()->getUid());
+		}
+	}
+
+	this->scheduleStages();
+}
+
+bool PipelineExecutor::restoreCachedOutput(Stage& stage)
+{
+	FilterPtr filter = stage.algorithm->getFilter();
+	std::map<QString, CacheEntry>::iterator entry = mCache.find(filter->getUid());
+	if ((entry == mCache.end()) || (entry->second.key != stage.key))
+		return false;
+
+	std::vector<SelectDataStringPropertyBasePtr> outputTypes = filter->getOutputTypes();
+	QStringList outputs = entry->second.outputs;
+	if (outputs.size() != int(outputTypes.size()))
+		return false;
+	for (int i=0; i<outputs.size(); ++i)
+		if (!outputs[i].isEmpty() && !mPatientModelService->getData(outputs[i]))
+			return false;
+
+	for (int i=0; i<outputs.size(); ++i)
+		outputTypes[i]->setValue(outputs[i]);
+	return true;
+}
+
+void PipelineExecutor::storeCachedOutput(const Stage& stage)
+{
+	FilterPtr filter = stage.algorithm->getFilter();
+	CacheEntry entry;
+	entry.key = stage.key;
+	std::vector<SelectDataStringPropertyBasePtr> outputTypes = filter->getOutputTypes();
+	for (unsigned i=0; i<outputTypes.size(); ++i)
+		entry.outputs << outputTypes[i]->getValue();
+	mCache[filter->getUid()] = entry;
+}
+
+} // namespace cx
@@ -0,0 +1,117 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXPIPELINEEXECUTOR_H
+#define CXPIPELINEEXECUTOR_H
+
+#include "cxResourceFilterExport.h"
+
+#include <map>
+#include <vector>
+#include <QStringList>
+#include <QElapsedTimer>
+#include "cxTimedAlgorithm.h"
+#include "cxForwardDeclarations.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class FilterTimedAlgorithm> FilterTimedAlgorithmPtr;
+
+/** Memoizing execution of a DAG of Filters.
+ *
+ * Each stage is a filter, depending on the stages producing its input.
+ * A stage is started when all its dependencies are done, and stages
+ * without dependencies on each other run concurrently, at most
+ * getMaxConcurrentStages() at a time.
+ *
+ * The outputs of each stage are cached, keyed on the uid and modification
+ * state of its inputs and a hash of its option values. A stage with an
+ * unchanged key and outputs still present in the patient model is
+ * skipped, and the cached outputs are set on the output properties.
+ * The cache lives across executions.
+ *
+ * Progress is reported through the TimedBaseAlgorithm signals, and
+ * the timing and cache hit of each stage is available from
+ * getStageTimings() after finished().
+ *
+ * \ingroup cxResourceAlgorithms
+ */
+class cxResourceFilter_EXPORT PipelineExecutor : public TimedBaseAlgorithm
+{
+	Q_OBJECT
+
+public:
+	struct StageTiming
+	{
+		QString uid;
+		bool cached; ///< output reused from an earlier execution
+		bool success;
+		double seconds;
+	};
+
+	explicit PipelineExecutor(PatientModelServicePtr patientModelService, QString name="Pipeline");
+	virtual ~PipelineExecutor() {}
+
+	/** Add a stage running algorithm, after the stages with the filter uids in dependencies.
+	 *  Dependencies not added as stages are assumed to be satisfied.
+	 */
+	void addStage(FilterTimedAlgorithmPtr algorithm, QStringList dependencies = QStringList());
+	void clearStages();
+	void clearCache();
+	void setMaxConcurrentStages(int count);
+	int getMaxConcurrentStages() const { return mMaxConcurrentStages; }
+	std::vector<StageTiming> getStageTimings() const;
+
+	virtual QString getProduct() const;
+	virtual void execute();
+	virtual bool isFinished() const;
+	virtual bool isRunning() const;
+
+private slots:
+	void stageFinished();
+
+private:
+	enum STAGE_STATE { sPENDING, sRUNNING, sDONE, sFAILED };
+	struct Stage
+	{
+		FilterTimedAlgorithmPtr algorithm;
+		QStringList dependencies;
+		STAGE_STATE state;
+		QString key;
+		bool cached;
+		QElapsedTimer timer;
+		double seconds;
+	};
+	struct CacheEntry
+	{
+		QString key;
+		QStringList outputs;
+	};
+
+	void scheduleStages();
+	void startStage(Stage& stage);
+	STAGE_STATE getDependencyState(const Stage& stage) const;
+	int getStageIndex(QString uid) const;
+	int countStages(STAGE_STATE state) const;
+	QString createKey(const Stage& stage) const;
+	bool restoreCachedOutput(Stage& stage);
+	void storeCachedOutput(const Stage& stage);
+
+	PatientModelServicePtr mPatientModelService;
+	std::vector<Stage> mStages;
+	std::map<QString, CacheEntry> mCache; ///< filter uid -> last output
+	int mMaxConcurrentStages;
+	bool mRunning;
+};
+typedef boost::shared_ptr<PipelineExecutor> PipelineExecutorPtr;
+
+} // namespace cx
+
+#endif // CXPIPELINEEXECUTOR_H
@@ -11,10 +11,12 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include <random>
 #include <cmath>
+#include <algorithm>
 
 #include <vtkCellData.h>
 #include <vtkUnsignedCharArray.h>
 #include <vtkPolyData.h>
+#include <vtkIdList.h>
 
 #include "cxColorVariationFilter.h"
 #include "cxTypeConversions.h"
@@ -28,6 +30,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "vtkForwardDeclarations.h"
 #include "cxLogger.h"
 #include "cxRegistrationTransform.h"
+#include "cxParallelFor.h"
 
 namespace cx
 {
@@ -165,45 +168,54 @@ bool ColorVariationFilter::postProcess()
 	return true;
 }
 
-void ColorVariationFilter::sortPolyData(vtkPolyDataPtr polyData)
+void ColorVariationFilter::setSeed(unsigned seed)
 {
-	mPolyToPointsArray.clear();
-	mPointToPolysArray.clear();
+	m_gen.seed(seed);
+}
 
+/** Build the polygon-to-point and point-to-polygon arrays.
+ *  The polys of each point are in increasing order.
+ */
+void ColorVariationFilter::sortPolyData(vtkPolyDataPtr polyData)
+{
 	vtkIdType numberOfCells = polyData->GetNumberOfCells();
+	vtkIdType numberOfPoints = polyData->GetNumberOfPoints();
 
-	mPolyToPointsArray = std::vector<std::vector<vtkIdType>>(numberOfCells);
+	mPolyPointOffsets.assign(1, 0);
+	mPolyPointOffsets.reserve(numberOfCells+1);
+	mPolyPoints.clear();
+	mPolyPoints.reserve(3*numberOfCells);
+	mPointPolyOffsets.assign(numberOfPoints+1, 0);
 
-	std::vector<std::vector<vtkIdType>> pointToPolysArray(polyData->GetNumberOfPoints());
+	vtkIdListPtr points = vtkIdListPtr::New();
 	for(vtkIdType i = 0; i < numberOfCells; i++)
 	{
-		vtkIdListPtr points = polyData->GetCell(i)->GetPointIds();
-		vtkIdType numberOfIds = points->GetNumberOfIds();
-		std::vector<vtkIdType> pointsArray(numberOfIds);
-		for(vtkIdType j = 0; j < numberOfIds; j++)
+		polyData->GetCellPoints(i, points);
+		for(vtkIdType j = 0; j < points->GetNumberOfIds(); j++)
 		{
 			vtkIdType p = points->GetId(j);
-			pointsArray[j]= p;
-			pointToPolysArray[p].resize(pointToPolysArray[p].size()+1, i);
+			mPolyPoints.push_back(p);
+			++mPointPolyOffsets[p+1];
 		}
-		mPolyToPointsArray[i] = pointsArray;
+		mPolyPointOffsets.push_back(mPolyPoints.size());
 	}
-	mPointToPolysArray = pointToPolysArray;
 
+	for(vtkIdType p = 0; p < numberOfPoints; p++)
+		mPointPolyOffsets[p+1] += mPointPolyOffsets[p];
+
+	mPointPolys.resize(mPolyPoints.size());
+	std::vector<vtkIdType> fill(mPointPolyOffsets.begin(), mPointPolyOffsets.end()-1);
+	for(vtkIdType i = 0; i < numberOfCells; i++)
+		for(vtkIdType j = mPolyPointOffsets[i]; j < mPolyPointOffsets[i+1]; j++)
+			mPointPolys[fill[mPolyPoints[j]]++] = i;
 }
 
 vtkUnsignedCharArrayPtr ColorVariationFilter::colorPolyData(MeshPtr mesh)
 {
-	if(mPolyToPointsArray.empty() || mPointToPolysArray.empty())
+	vtkIdType numberOfPolys = this->getNumberOfPolys();
+	if(!numberOfPolys || mPointPolys.empty())
 		return mColors;
 
-	vtkPolyDataPtr polyData = mesh->getTransformedPolyDataCopy(Transform3D::Identity());
-
-	mAssignedColorValues.clear();
-	mColors = vtkUnsignedCharArrayPtr::New();
-	mColors->SetNumberOfComponents(3);
-	int numberOfPolys = polyData->GetNumberOfCells();
-	mColors->SetNumberOfTuples(numberOfPolys);
 	QColor originalColor = mesh->getColor();
 
 	mR_mean = originalColor.red();
@@ -212,63 +224,53 @@ vtkUnsignedCharArrayPtr ColorVariationFilter::colorPolyData(MeshPtr mesh)
 	
 	this->generateColorDistribution();
 
-	mAssignedColorValues.clear();
-	mAssignedColorValues = std::vector<bool>(numberOfPolys, false);
+	mColorValues.assign(3*numberOfPolys, 0);
+	mAssignedColorValues.assign(numberOfPolys, false);
 
-	for(int i=0; i<numberOfPolys; i++) //Loop needed if multiple independent meshes in model.
+	for(vtkIdType i=0; i<numberOfPolys; i++) //Loop needed if multiple independent meshes in model.
 		if(!mAssignedColorValues[i])
-			for(int j=0; j<mPolyToPointsArray[i].size(); j++)
-				this->applyColorToNeighbourPolys(mPolyToPointsArray[i][j], mR_mean, mG_mean, mB_mean);
+			for(vtkIdType j=mPolyPointOffsets[i]; j<mPolyPointOffsets[i+1]; j++)
+				this->applyColorToNeighbourPolys(mPolyPoints[j], mR_mean, mG_mean, mB_mean);
 
+	this->createColorArray();
 	return mColors;
 }
 
-void ColorVariationFilter::applyColorToNeighbourPolys(int startIndex, double R, double G, double B)
+/** Color all polys connected to the start point, breadth first.
+ *  Each poly in the queue passes its own color on as the mean of the
+ *  colors of the unassigned polys around each of its points.
+ */
+void ColorVariationFilter::applyColorToNeighbourPolys(vtkIdType startIndex, double R, double G, double B)
 {
+	double color[3] = {R, G, B};
+	std::vector<vtkIdType> polyIndexColoringQueue;
+	this->applyColorAndFindNeighbours(startIndex, color, &polyIndexColoringQueue);
 
-	std::vector<vtkIdType> polyIndexColoringQueue = this->applyColorAndFindNeighbours(startIndex, R, G, B);
-	std::vector<double> color {R, G, B};
-	std::vector<std::vector<double>> polyColorColoringQueue(polyIndexColoringQueue.size(), color);
-
-	while(!polyIndexColoringQueue.empty())
+	for(size_t head = 0; head < polyIndexColoringQueue.size(); ++head)
 	{
-		std::vector<vtkIdType> neighbourPointsList = mPolyToPointsArray[polyIndexColoringQueue[0]]; //Prosess first index in FIFO queue
-
-		for(int i=0; i<neighbourPointsList.size(); i++)
+		vtkIdType poly = polyIndexColoringQueue[head];
+		for(vtkIdType i=mPolyPointOffsets[poly]; i<mPolyPointOffsets[poly+1]; i++)
 		{
-			std::vector<double> newColor = generateColor(polyColorColoringQueue[0][0], polyColorColoringQueue[0][1], polyColorColoringQueue[0][2]);
-			std::vector<vtkIdType> polyIndexToColor = this->applyColorAndFindNeighbours(neighbourPointsList[i], newColor[0], newColor[1], newColor[2]);
-			polyIndexColoringQueue.insert(polyIndexColoringQueue.end(), polyIndexToColor.begin(), polyIndexToColor.end());
-			polyColorColoringQueue.resize(polyColorColoringQueue.size()+polyIndexToColor.size(), newColor);
+			double newColor[3];
+			this->generateColor(&mColorValues[3*poly], newColor);
+			this->applyColorAndFindNeighbours(mPolyPoints[i], newColor, &polyIndexColoringQueue);
 		}
-		polyIndexColoringQueue.erase(polyIndexColoringQueue.begin());
-		polyColorColoringQueue.erase(polyColorColoringQueue.begin());
 	}
 }
 
-std::vector<vtkIdType> ColorVariationFilter::applyColorAndFindNeighbours(int pointIndex, double R, double G, double B)
+/** Assign color to all unassigned polys around the point, and append them to the queue.
+ */
+void ColorVariationFilter::applyColorAndFindNeighbours(vtkIdType pointIndex, const double* color, std::vector<vtkIdType>* queue)
 {
-	std::vector<vtkIdType> neighbourPolysList = mPointToPolysArray[pointIndex];
-	std::vector<int> removeIndexList;
-
-	for(int i=0; i<neighbourPolysList.size(); i++)
+	for(vtkIdType i=mPointPolyOffsets[pointIndex]; i<mPointPolyOffsets[pointIndex+1]; i++)
 	{
-		if(!mAssignedColorValues[neighbourPolysList[i]]) //Check if tuple is already assigned a color
-		{
-			mColors->InsertTuple3(neighbourPolysList[i], R, G, B);
-			mAssignedColorValues[neighbourPolysList[i]] = true;
-		}
-		else
-		{
-			removeIndexList.push_back(i); //Remove tuple if already assigned
-		}
+		vtkIdType poly = mPointPolys[i];
+		if(mAssignedColorValues[poly]) //Check if tuple is already assigned a color
+			continue;
+		std::copy(color, color+3, &mColorValues[3*poly]);
+		mAssignedColorValues[poly] = true;
+		queue->push_back(poly);
 	}
-
-	int N = removeIndexList.size();
-	for(int i=N-1; i>=0; i--) //Removeing neighbour polys which is already assigned a color
-		neighbourPolysList.erase(neighbourPolysList.begin() + removeIndexList[i]);
-
-	return neighbourPolysList;
 }
 
 void ColorVariationFilter::generateColorDistribution()
@@ -278,62 +280,71 @@ void ColorVariationFilter::generateColorDistribution()
 	mB_dist = std::normal_distribution<> {mB_mean, mGlobalVariance};
 }
 
-std::vector<double> ColorVariationFilter::generateColor(double R, double G, double B)
+void ColorVariationFilter::generateColor(const double* color, double* newColor)
 {
-
-	std::vector<double> color;
-	color.push_back( std::max(std::min( std::max(std::min(mR_dist(m_gen),R+mLocalVariance),R-mLocalVariance) ,254.999),0.0001) );
-	color.push_back( std::max(std::min( std::max(std::min(mG_dist(m_gen),G+mLocalVariance),G-mLocalVariance) ,254.999),0.0001) );
-	color.push_back( std::max(std::min( std::max(std::min(mB_dist(m_gen),B+mLocalVariance),B-mLocalVariance) ,254.999),0.0001) );
-
-	return color;
+	newColor[0] = std::max(std::min( std::max(std::min(mR_dist(m_gen),color[0]+mLocalVariance),color[0]-mLocalVariance) ,254.999),0.0001);
+	newColor[1] = std::max(std::min( std::max(std::min(mG_dist(m_gen),color[1]+mLocalVariance),color[1]-mLocalVariance) ,254.999),0.0001);
+	newColor[2] = std::max(std::min( std::max(std::min(mB_dist(m_gen),color[2]+mLocalVariance),color[2]-mLocalVariance) ,254.999),0.0001);
 }
 
+/** Replace each poly color with the average of itself and all polys sharing a point with it.
+ *  Each iteration reads one buffer and writes the other, thus polys are independent
+ *  and processed in parallel.
+ */
 void ColorVariationFilter::smoothColorsInMesh(int iterations)
 {
+	vtkIdType numberOfPolys = this->getNumberOfPolys();
+	if(mColorValues.size() != size_t(3*numberOfPolys))
+		return;
+
+	std::vector<double> buffer(mColorValues.size());
 	for(int itr=0; itr<iterations; itr++)
 	{
-		vtkUnsignedCharArrayPtr newColors = mColors;
-		int numberofPolys = newColors->GetNumberOfTuples();
-	
-		Eigen::MatrixXd allColors(numberofPolys,3);
-		for(int i=0; i<numberofPolys; i++)
-		{
-			double colorTuple[3];
-			mColors->GetTuple(i, colorTuple);
-			allColors(i,0) = colorTuple[0];
-			allColors(i,1) = colorTuple[1];
-			allColors(i,2) = colorTuple[2];
-		}
-	
-		for(int i=0; i<numberofPolys; i++)
+		const double* input = mColorValues.data();
+		double* output = buffer.data();
+		const ColorVariationFilter* self = this;
+
+		parallelForRange(0, numberOfPolys, [=](int begin, int end)
 		{
-			std::vector<vtkIdType> connectedPoints = mPolyToPointsArray[i];
-			std::vector<int> neighbourPolys;
-			for(int j=0; j<connectedPoints.size(); j++)
+			std::vector<vtkIdType> neighbourPolys;
+			for(vtkIdType i=begin; i<end; i++)
 			{
-				std::vector<vtkIdType> newNeighbours = mPointToPolysArray[connectedPoints[j]];
-				neighbourPolys.insert(neighbourPolys.end(), newNeighbours.begin(), newNeighbours.end());
+				neighbourPolys.clear();
+				for(vtkIdType j=self->mPolyPointOffsets[i]; j<self->mPolyPointOffsets[i+1]; j++)
+				{
+					vtkIdType point = self->mPolyPoints[j];
+					neighbourPolys.insert(neighbourPolys.end(),
+										  self->mPointPolys.begin() + self->mPointPolyOffsets[point],
+										  self->mPointPolys.begin() + self->mPointPolyOffsets[point+1]);
+				}
+				std::sort(neighbourPolys.begin(), neighbourPolys.end());
+				neighbourPolys.erase(std::unique(neighbourPolys.begin(), neighbourPolys.end()), neighbourPolys.end()); // includes i itself
+
+				double sum[3] = {0, 0, 0};
+				for(size_t j=0; j<neighbourPolys.size(); j++)
+					for(int k=0; k<3; k++)
+						sum[k] += input[3*neighbourPolys[j]+k];
+				double count = std::max<size_t>(neighbourPolys.size(), 1);
+				for(int k=0; k<3; k++)
+					output[3*i+k] = neighbourPolys.empty() ? input[3*i+k] : sum[k] / count;
 			}
-			neighbourPolys.erase( unique( neighbourPolys.begin(), neighbourPolys.end() ), neighbourPolys.end() );// remove duplicates
-			std::vector<std::vector<double>> neighbourColors;
-			Eigen::Vector3d sumNeighbourColors = Eigen::Vector3d::Zero();
-			for(int j=0; j<neighbourPolys.size(); j++)
-			{
-				sumNeighbourColors(0) += allColors(neighbourPolys[j],0);
-				sumNeighbourColors(1) += allColors(neighbourPolys[j],1);
-				sumNeighbourColors(2) += allColors(neighbourPolys[j],2);
-			}
-			
-			Eigen::Vector3d color;
-			for(int j=0; j<3; j++)
-				color(j) = ( sumNeighbourColors(j) + allColors(i,j) ) / (neighbourPolys.size() + 1); //Average of current color and all neighbour colors
-			
-			newColors->InsertTuple3(i, color[0], color[1], color[2]);
-		}
-	
-		mColors = newColors;
+		}, 4096);
+
+		mColorValues.swap(buffer);
 	}
+
+	this->createColorArray();
+}
+
+void ColorVariationFilter::createColorArray()
+{
+	vtkIdType numberOfPolys = this->getNumberOfPolys();
+	mColors = vtkUnsignedCharArrayPtr::New();
+	mColors->SetNumberOfComponents(3);
+	mColors->SetNumberOfTuples(numberOfPolys);
+	unsigned char* colors = mColors->GetPointer(0);
+	for(vtkIdType i=0; i<3*numberOfPolys; i++)
+		colors[i] = static_cast<unsigned char>(mColorValues[i]);
 }
 
 } // namespace cx
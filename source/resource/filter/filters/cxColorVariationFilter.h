@@ -19,6 +19,14 @@ namespace cx
 {
 
 /** Filter to apply variation in colors to a mesh
+ *
+ * Colors are assigned by region growing over polygons sharing a point,
+ * each new color drawn around the color of the polygon it grew from.
+ * The mesh connectivity is stored as compressed (CSR) point-to-polygon
+ * and polygon-to-point arrays, built once per execute. Smoothing averages
+ * each polygon with its neighbours, in parallel between two color buffers.
+ *
+ * The output is deterministic for a given seed, see setSeed().
  *
  * \ingroup cxResourceAlgorithms
  * \date Aug 26, 2021
@@ -40,6 +48,7 @@ public:
 
 	virtual bool execute();
 	MeshPtr execute(MeshPtr inputMesh, double globaleVariance, double localeVariance, int smoothingIterations);
+	void setSeed(unsigned seed); ///< seed the color generator, default is random
 	virtual bool postProcess();
 
 protected:
@@ -54,16 +63,21 @@ private:
 
 	void sortPolyData(vtkPolyDataPtr polyData);
 	vtkUnsignedCharArrayPtr colorPolyData(MeshPtr mesh);
-	void applyColorToNeighbourPolys(int startIndex, double R, double G, double B);
-	std::vector<vtkIdType> applyColorAndFindNeighbours(int pointIndex, double R, double G, double B);
+	void applyColorToNeighbourPolys(vtkIdType startIndex, double R, double G, double B);
+	void applyColorAndFindNeighbours(vtkIdType pointIndex, const double* color, std::vector<vtkIdType>* queue);
 	void generateColorDistribution();
-	std::vector<double> generateColor(double R, double G, double B);
+	void generateColor(const double* color, double* newColor);
 	void smoothColorsInMesh(int iterations = 1);
+	void createColorArray();
+	vtkIdType getNumberOfPolys() const { return mPolyPointOffsets.empty() ? 0 : vtkIdType(mPolyPointOffsets.size()) - 1; }
 
 	MeshPtr mOutputMesh;
 	vtkUnsignedCharArrayPtr mColors;
-	std::vector<std::vector<vtkIdType>> mPolyToPointsArray;
-	std::vector<std::vector<vtkIdType>> mPointToPolysArray;
+	std::vector<vtkIdType> mPolyPointOffsets; ///< points of poly i are mPolyPoints[mPolyPointOffsets[i]] to mPolyPoints[mPolyPointOffsets[i+1]-1]
+	std::vector<vtkIdType> mPolyPoints;
+	std::vector<vtkIdType> mPointPolyOffsets; ///< polys of point i are mPointPolys[mPointPolyOffsets[i]] to mPointPolys[mPointPolyOffsets[i+1]-1]
+	std::vector<vtkIdType> mPointPolys;
+	std::vector<double> mColorValues; ///< RGB for each poly
 	std::vector<bool> mAssignedColorValues;
 	double mGlobalVariance;
 	double mLocalVariance;
@@ -10,6 +10,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 =========================================================================*/
 
 #include "catch.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include "cxData.h"
 #include "cxImage.h"
 #include "cxDataLocations.h"
@@ -19,11 +21,52 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxVisServices.h"
 #include <vtkImageData.h>
 #include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkUnsignedCharArray.h>
+#include "cxMesh.h"
 #include "cxtestVisServices.h"
 
 
 namespace cxtest {
 
+namespace
+{
+/** Two separate triangulated n x n grids.
+ */
+vtkPolyDataPtr createTwoGrids(int n)
+{
+	vtkPointsPtr points = vtkPointsPtr::New();
+	vtkCellArrayPtr polys = vtkCellArrayPtr::New();
+	for (int grid=0; grid<2; ++grid)
+	{
+		vtkIdType first = points->GetNumberOfPoints();
+		for (int y=0; y<=n; ++y)
+			for (int x=0; x<=n; ++x)
+				points->InsertNextPoint(x, y, 10*grid);
+		for (int y=0; y<n; ++y)
+			for (int x=0; x<n; ++x)
+			{
+				vtkIdType p = first + y*(n+1) + x;
+				vtkIdType lower[3] = {p, p+1, p+n+2};
+				vtkIdType upper[3] = {p, p+n+2, p+n+1};
+				polys->InsertNextCell(3, lower);
+				polys->InsertNextCell(3, upper);
+			}
+	}
+	vtkPolyDataPtr retval = vtkPolyDataPtr::New();
+	retval->SetPoints(points);
+	retval->SetPolys(polys);
+	return retval;
+}
+
+vtkUnsignedCharArray* getColors(cx::MeshPtr mesh)
+{
+	return vtkUnsignedCharArray::SafeDownCast(mesh->getVtkPolyData()->GetCellData()->GetScalars());
+}
+}
+
 TEST_CASE("ColorVariationFilter: execute", "[unit][ColorVariationFilter]")
 {
 	cxtest::SessionStorageTestFixture storageFixture;
@@ -55,4 +98,43 @@ TEST_CASE("ColorVariationFilter: execute", "[unit][ColorVariationFilter]")
 	REQUIRE(coloredMesh->getTransformedPolyDataCopy(coloredMesh->get_rMd()));
 }
 
+TEST_CASE("ColorVariationFilter: Colors all polys deterministically for a fixed seed", "[unit][ColorVariationFilter]")
+{
+	cxtest::TestVisServicesPtr dummyservices = cxtest::TestVisServices::create();
+	cx::MeshPtr mesh(new cx::Mesh("grids", "grids", createTwoGrids(100)));
+	mesh->setColor(QColor(200, 100, 50));
+	int numberOfPolys = mesh->getVtkPolyData()->GetNumberOfCells();
+
+	double globalVariance = 50.0;
+	double localVariance = 5.0;
+	std::vector<cx::MeshPtr> results;
+	for (int i=0; i<2; ++i)
+	{
+		cx::ColorVariationFilterPtr filter(new cx::ColorVariationFilter(dummyservices));
+		filter->setSeed(42);
+		results.push_back(filter->execute(mesh, globalVariance, localVariance, 3));
+		REQUIRE(results.back());
+	}
+
+	vtkUnsignedCharArray* first = getColors(results[0]);
+	vtkUnsignedCharArray* second = getColors(results[1]);
+	REQUIRE(first);
+	REQUIRE(second);
+	REQUIRE(first->GetNumberOfTuples() == numberOfPolys);
+	REQUIRE(first->GetNumberOfComponents() == 3);
+	CHECK(std::equal(first->GetPointer(0), first->GetPointer(0)+3*numberOfPolys, second->GetPointer(0)));
+
+	// region growing keeps colors near the mesh color, smoothing keeps them within range
+	int maxDeviation = 0;
+	int distinct = 0;
+	for (int i=0; i<numberOfPolys; ++i)
+	{
+		maxDeviation = std::max(maxDeviation, std::abs(int(first->GetValue(3*i)) - 200));
+		if (i && (first->GetValue(3*i) != first->GetValue(3*i-3)))
+			++distinct;
+	}
+	CHECK(maxDeviation < 100);
+	CHECK(distinct > 0);
+}
+
 }; // end cxtest namespace
@@ -0,0 +1,95 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <vtkImageData.h>
+#include "cxPipelineExecutor.h"
+#include "cxFilterTimedAlgorithm.h"
+#include "cxDummyFilter.h"
+#include "cxImage.h"
+#include "cxVolumeHelpers.h"
+#include "cxXmlOptionItem.h"
+#include "cxSelectDataStringProperty.h"
+#include "cxPatientModelService.h"
+#include "cxtestVisServices.h"
+#include "cxtestQueuedSignalListener.h"
+
+namespace
+{
+cx::FilterTimedAlgorithmPtr createStage(cxtest::TestVisServicesPtr services, QString uid, QString input)
+{
+	cx::FilterPtr filter(new cx::DummyFilter(services));
+	filter->initialize(cx::XmlOptionFile::createNull().descend(uid).getElement(), uid);
+	filter->getOptions();
+	filter->getOutputTypes();
+	REQUIRE(filter->getInputTypes()[0]->setValue(input));
+	return cx::FilterTimedAlgorithmPtr(new cx::FilterTimedAlgorithm(filter));
+}
+
+void executeAndWait(cx::PipelineExecutorPtr executor)
+{
+	executor->execute();
+	if (!executor->isFinished())
+		cxtest::waitForQueuedSignal(executor.get(), SIGNAL(finished()), 5000);
+	REQUIRE(executor->isFinished());
+}
+
+QStringList getCachedStages(cx::PipelineExecutorPtr executor)
+{
+	QStringList retval;
+	std::vector<cx::PipelineExecutor::StageTiming> timings = executor->getStageTimings();
+	for (unsigned i=0; i<timings.size(); ++i)
+	{
+		CHECK(timings[i].success);
+		if (timings[i].cached)
+			retval << timings[i].uid;
+	}
+	return retval;
+}
+}
+
+TEST_CASE("PipelineExecutor: Stages with unchanged input and options are skipped", "[unit]")
+{
+	cxtest::TestVisServicesPtr services = cxtest::TestVisServices::create();
+	vtkImageDataPtr raw = cx::generateVtkImageData(Eigen::Array3i(10, 10, 10), cx::Vector3D(1, 1, 1), 100);
+	cx::ImagePtr image(new cx::Image("image0", raw));
+	services->patient()->insertData(image);
+
+	// A diamond: B and C depend on A, and are independent of each other
+	cx::FilterTimedAlgorithmPtr a = createStage(services, "A", image->getUid());
+	cx::FilterTimedAlgorithmPtr b = createStage(services, "B", image->getUid());
+	cx::FilterTimedAlgorithmPtr c = createStage(services, "C", image->getUid());
+
+	cx::PipelineExecutorPtr executor(new cx::PipelineExecutor(services->patient()));
+	executor->setMaxConcurrentStages(2);
+	executor->addStage(c, QStringList() << "A");
+	executor->addStage(b, QStringList() << "A");
+	executor->addStage(a);
+
+	executeAndWait(executor);
+	CHECK(getCachedStages(executor).isEmpty());
+	CHECK(b->getFilter()->getOutputTypes()[0]->getValue() == image->getUid());
+
+	executeAndWait(executor);
+	CHECK(getCachedStages(executor) == QStringList() << "C" << "B" << "A");
+
+	b->getFilter()->getOptions()[1]->setValueFromVariant(5.0);
+	executeAndWait(executor);
+	CHECK(getCachedStages(executor) == QStringList() << "C" << "A");
+
+	raw->Modified();
+	executeAndWait(executor);
+	CHECK(getCachedStages(executor).isEmpty());
+
+	executor->clearCache();
+	executeAndWait(executor);
+	CHECK(getCachedStages(executor).isEmpty());
+}
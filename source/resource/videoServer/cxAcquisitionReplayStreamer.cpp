@@ -0,0 +1,363 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxAcquisitionReplayStreamer.h"
+
+#include <cmath>
+#include <algorithm>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <vtkImageData.h>
+#include <vtkMetaImageReader.h>
+
+#include "cxSender.h"
+#include "cxImage.h"
+#include "cxImageDataContainer.h"
+#include "cxMetaImageIO.h"
+#include "cxUsReconstructionFileReader.h"
+#include "cxUsReconstructionSidecar.h"
+#include "cxUtilHelpers.h"
+#include "cxTypeConversions.h"
+#include "cxLogger.h"
+
+namespace cx
+{
+
+AcquisitionReplayStreamer::AcquisitionReplayStreamer() :
+	mSpeed(1),
+	mStampSendTime(false),
+	mLoop(false),
+	mStreaming(false),
+	mStartTime(0),
+	mDuration(0),
+	mCompletedLoops(0),
+	mNextFrame(0),
+	mNextPosition(0),
+	mSentFrames(0),
+	mDroppedFrames(0)
+{
+}
+
+QString AcquisitionReplayStreamer::getType()
+{
+	return "ReplayAcquisition";
+}
+
+QStringList AcquisitionReplayStreamer::getArgumentDescription()
+{
+	QStringList retval;
+	retval << "--filename:		acquisition folder, or any file of the acquisition";
+	retval << "--speed:		replay speed multiplier, default 1";
+	retval << "--stamp:		stamp frames and positions with send time instead of recorded time";
+	retval << "--loop:		restart the replay when done";
+	return retval;
+}
+
+void AcquisitionReplayStreamer::initialize(StringMap arguments)
+{
+	CommandLineStreamer::initialize(arguments);
+
+	double speed = 1;
+	if (arguments.count("speed"))
+		speed = arguments["speed"].toDouble();
+	bool stamp = arguments.count("stamp") ? true : false;
+	bool loop = arguments.count("loop") ? true : false;
+	this->initialize(arguments["filename"], speed, stamp, loop);
+}
+
+void AcquisitionReplayStreamer::initialize(QString acquisition, double speed, bool stampSendTime, bool loop)
+{
+	this->setInitialized(false);
+	mSpeed = (speed > 0) ? speed : 1;
+	mStampSendTime = stampSendTime;
+	mLoop = loop;
+	mFrames.clear();
+	mFrameTimes.clear();
+	mPositions.clear();
+
+	QString filename = this->findAcquisitionFile(acquisition);
+	if (filename.isEmpty())
+	{
+		reportError(QString("AcquisitionReplayStreamer: No acquisition found in %1").arg(acquisition));
+		return;
+	}
+	mUid = QFileInfo(filename).completeBaseName();
+	mToolUid = this->readToolUid(filename);
+
+	UsReconstructionFileReader reader((FileManagerServicePtr()));
+	QString sidecar = changeExtension(filename, "sweep");
+	if (!UsReconstructionSidecar::isCurrent(sidecar) || !UsReconstructionSidecar::read(sidecar, &mFrameTimes, &mPositions))
+	{
+		mFrameTimes = reader.readFrameTimestamps(filename);
+		mPositions = reader.readPositions(filename);
+	}
+
+	if (!this->loadFrames(filename))
+		return;
+	if (mFrames.size() != mFrameTimes.size())
+	{
+		reportError(QString("AcquisitionReplayStreamer: Mismatch between %1 frames and %2 frame timestamps in %3")
+					.arg(mFrames.size()).arg(mFrameTimes.size()).arg(filename));
+		mFrames.clear();
+		return;
+	}
+	double first = mFrameTimes.front().mTime;
+	double last = mFrameTimes.back().mTime;
+	if (!mPositions.empty())
+	{
+		first = std::min(first, mPositions.front().mTime);
+		last = std::max(last, mPositions.back().mTime);
+	}
+	mStartTime = first;
+	mDuration = last - first;
+
+	if (!mSendTimer)
+		this->createSendTimer(true);
+	mSendTimer->setTimerType(Qt::PreciseTimer);
+
+	report(QString("AcquisitionReplayStreamer: Replaying %1 frames and %2 positions over %3 s from %4")
+		   .arg(mFrames.size()).arg(mPositions.size()).arg(mDuration/1000/mSpeed, 0, 'f', 1).arg(filename));
+	this->setInitialized(true);
+}
+
+/** Return the uid of the tool that recorded the acquisition, or
+ *  the acquisition uid if the probe data is missing.
+ */
+QString AcquisitionReplayStreamer::readToolUid(QString filename) const
+{
+	QString uid;
+	if (QFileInfo(changeExtension(filename, "probedata.xml")).exists())
+		uid = UsReconstructionFileReader::readProbeDefinitionFromFile(changeExtension(filename, "mhd")).first;
+	return uid.isEmpty() ? mUid : uid;
+}
+
+/** Find the .fts file of the acquisition, either acquisition itself or
+ *  the first one found in the folder acquisition.
+ */
+QString AcquisitionReplayStreamer::findAcquisitionFile(QString acquisition)
+{
+	QFileInfo info(acquisition);
+	if (info.isDir())
+	{
+		QStringList files = QDir(acquisition).entryList(QStringList() << "*.fts", QDir::Files, QDir::Name);
+		if (files.isEmpty())
+			return "";
+		return QDir(acquisition).absoluteFilePath(files.front());
+	}
+
+	// any file of the acquisition: remove frame index and extension
+	QString base = info.absolutePath() + "/" + info.completeBaseName();
+	QString fts = base + ".fts";
+	if (QFileInfo(fts).exists())
+		return fts;
+	fts = base.left(base.lastIndexOf("_")) + ".fts";
+	if (QFileInfo(fts).exists())
+		return fts;
+	return "";
+}
+
+/** Load frames from the indexed files <base>_<index>.mhd, or from the
+ *  single file <base>.mhd with time along z.
+ */
+bool AcquisitionReplayStreamer::loadFrames(QString filename)
+{
+	QString base = QFileInfo(filename).absolutePath() + "/" + QFileInfo(filename).completeBaseName();
+
+	for (unsigned i=0; i<mFrameTimes.size(); ++i)
+	{
+		QString frameFile = QString("%1_%2.mhd").arg(base).arg(i);
+		if (!QFileInfo(frameFile).exists())
+			break;
+		vtkImageDataPtr frame = this->loadFrame(frameFile);
+		if (!frame)
+		{
+			mFrames.clear();
+			return false;
+		}
+		mFrames.push_back(frame);
+	}
+
+	if (mFrames.empty() && QFileInfo(base + ".mhd").exists())
+	{
+		vtkImageDataPtr volume = this->loadFrame(base + ".mhd");
+		if (!volume)
+			return false;
+		SplitFramesContainer frames(volume);
+		for (unsigned i=0; i<frames.size(); ++i)
+			mFrames.push_back(frames.get(i));
+	}
+
+	if (mFrames.empty())
+	{
+		reportError(QString("AcquisitionReplayStreamer: No frames found for %1").arg(filename));
+		return false;
+	}
+	return true;
+}
+
+vtkImageDataPtr AcquisitionReplayStreamer::loadFrame(QString filename)
+{
+	vtkImageDataPtr retval = MetaImageIO().read(filename);
+	if (retval)
+		return retval;
+
+	vtkMetaImageReaderPtr reader = vtkMetaImageReaderPtr::New();
+	reader->SetFileName(cstring_cast(filename));
+	reader->Update();
+	retval = reader->GetOutput();
+	if (!retval || !retval->GetNumberOfPoints())
+	{
+		reportError(QString("AcquisitionReplayStreamer: Failed to read %1").arg(filename));
+		return vtkImageDataPtr();
+	}
+	return retval;
+}
+
+void AcquisitionReplayStreamer::startStreaming(SenderPtr sender)
+{
+	if (!this->isInitialized())
+	{
+		reportError("AcquisitionReplayStreamer: Failed to start streaming: Not initialized.");
+		return;
+	}
+	mSender = sender;
+	mStreaming = true;
+	mCompletedLoops = 0;
+	mNextFrame = 0;
+	mNextPosition = 0;
+	mSentFrames = 0;
+	mDroppedFrames = 0;
+	mClock.start();
+	this->streamSlot();
+}
+
+void AcquisitionReplayStreamer::stopStreaming()
+{
+	mStreaming = false;
+	if (mSendTimer)
+		mSendTimer->stop();
+}
+
+bool AcquisitionReplayStreamer::isStreaming()
+{
+	return this->isInitialized() && mStreaming;
+}
+
+/** Return the recorded time corresponding to now, within the current loop.
+ */
+double AcquisitionReplayStreamer::getReplayTime() const
+{
+	double elapsed = mClock.nsecsElapsed() / 1.0E6 * mSpeed;
+	return mStartTime + elapsed - mCompletedLoops * mDuration;
+}
+
+double AcquisitionReplayStreamer::getTimestamp(double recordedTime) const
+{
+	if (mStampSendTime)
+		return QDateTime::currentMSecsSinceEpoch();
+	return recordedTime + mCompletedLoops * mDuration;
+}
+
+void AcquisitionReplayStreamer::sendFrame(int index)
+{
+	if (!this->isReadyToSend())
+	{
+		++mDroppedFrames;
+		return;
+	}
+
+	ImagePtr image(new Image(mUid, mFrames[index]));
+	image->setAcquisitionTime(QDateTime::fromMSecsSinceEpoch(qint64(this->getTimestamp(mFrameTimes[index].mTime))));
+
+	PackagePtr package(new Package());
+	package->mImage = image;
+	mSender->send(package);
+	++mSentFrames;
+}
+
+/** Send the position as the pose of the recording tool. Positions are
+ *  not dropped when the sender is busy, the sender does that itself.
+ */
+void AcquisitionReplayStreamer::sendPosition(int index)
+{
+	const TimedPosition& position = mPositions[index];
+	double timestamp = this->getTimestamp(position.mTime);
+
+	if (mSender)
+	{
+		PackagePtr package(new Package());
+		package->mToolUid = mToolUid;
+		package->m_prMt = position.mPos;
+		package->mTransformTime = QDateTime::fromMSecsSinceEpoch(qint64(timestamp));
+		mSender->send(package);
+	}
+	emit trackingPosition(position.mPos, timestamp);
+}
+
+/** Send all frames and positions that are due, in recorded order,
+ *  then sleep until the next one is due.
+ */
+void AcquisitionReplayStreamer::streamSlot()
+{
+	if (!mStreaming)
+		return;
+
+	double now = this->getReplayTime();
+	while (true)
+	{
+		bool frameDue = (mNextFrame < mFrames.size()) && (mFrameTimes[mNextFrame].mTime <= now);
+		bool positionDue = (mNextPosition < mPositions.size()) && (mPositions[mNextPosition].mTime <= now);
+		if (!frameDue && !positionDue)
+			break;
+
+		if (frameDue && (!positionDue || mFrameTimes[mNextFrame].mTime <= mPositions[mNextPosition].mTime))
+		{
+			this->sendFrame(mNextFrame++);
+		}
+		else
+		{
+			this->sendPosition(mNextPosition++);
+		}
+
+		if (!mStreaming) // stopped by a receiver
+			return;
+	}
+
+	if ((mNextFrame >= mFrames.size()) && (mNextPosition >= mPositions.size()))
+	{
+		if (!mLoop || (mDuration <= 0))
+		{
+			mStreaming = false;
+			emit finished();
+			return;
+		}
+		++mCompletedLoops;
+		mNextFrame = 0;
+		mNextPosition = 0;
+	}
+
+	this->scheduleNext();
+}
+
+void AcquisitionReplayStreamer::scheduleNext()
+{
+	double next = mStartTime + mDuration;
+	if (mNextFrame < mFrames.size())
+		next = std::min(next, mFrameTimes[mNextFrame].mTime);
+	if (mNextPosition < mPositions.size())
+		next = std::min(next, mPositions[mNextPosition].mTime);
+
+	double delay = (next - this->getReplayTime()) / mSpeed;
+	mSendTimer->start(std::max(0, int(std::ceil(delay))));
+}
+
+} // namespace cx
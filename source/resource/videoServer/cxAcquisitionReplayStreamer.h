@@ -0,0 +1,113 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXACQUISITIONREPLAYSTREAMER_H_
+#define CXACQUISITIONREPLAYSTREAMER_H_
+
+#include "cxGrabberExport.h"
+
+#include <vector>
+#include <QElapsedTimer>
+#include "cxStreamer.h"
+#include "cxTransform3D.h"
+#include "cxUSReconstructInputData.h"
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+
+/**
+ * Replays a recorded US acquisition, as written by UsReconstructionFileMaker.
+ *
+ * Frames are sent paced by their recorded timestamps, scaled by a speed
+ * multiplier, and the tracking positions are sent on their own recorded
+ * schedule as the pose of the recording tool, and also emitted through
+ * trackingPosition(). All frames are
+ * loaded up front, and sent without copying: consumers must treat the
+ * image data as read only.
+ *
+ * By default the timestamps sent are the recorded ones, shifted by the
+ * duration of the acquisition for each completed loop. With send time
+ * stamping on, frames and positions are instead stamped with the time
+ * they are sent, thus a receiver can measure end-to-end latency as
+ * receive time minus acquisition time.
+ *
+ * A frame due while the sender is not ready is dropped, as a grabber would.
+ *
+ * \ingroup cx_resource_videoserver
+ * \date Oct 19, 2026
+ */
+class cxGrabber_EXPORT AcquisitionReplayStreamer : public CommandLineStreamer
+{
+	Q_OBJECT
+
+public:
+	AcquisitionReplayStreamer();
+	virtual ~AcquisitionReplayStreamer() {}
+
+	/** Initialize from an acquisition folder, or any file of the acquisition.
+	 */
+	void initialize(QString acquisition, double speed = 1, bool stampSendTime = false, bool loop = false);
+	virtual void initialize(StringMap arguments);
+	virtual void startStreaming(SenderPtr sender);
+	virtual void stopStreaming();
+	virtual bool isStreaming();
+
+	virtual QString getType();
+	virtual QStringList getArgumentDescription();
+
+	int getNumberOfFrames() const { return int(mFrames.size()); }
+	int getNumberOfPositions() const { return int(mPositions.size()); }
+	int getSentFrames() const { return mSentFrames; }
+	int getDroppedFrames() const { return mDroppedFrames; }
+
+signals:
+	void trackingPosition(Transform3D prMt, double timestamp); ///< timestamp in ms since epoch
+	void finished(); ///< all frames and positions replayed, not emitted when looping
+
+private slots:
+	virtual void streamSlot();
+
+private:
+	static QString findAcquisitionFile(QString acquisition);
+	QString readToolUid(QString filename) const;
+	bool loadFrames(QString filename);
+	vtkImageDataPtr loadFrame(QString filename);
+	double getReplayTime() const;
+	double getTimestamp(double recordedTime) const;
+	void sendFrame(int index);
+	void sendPosition(int index);
+	void scheduleNext();
+
+	QString mUid;
+	QString mToolUid;
+	std::vector<vtkImageDataPtr> mFrames;
+	std::vector<TimedPosition> mFrameTimes;
+	std::vector<TimedPosition> mPositions;
+	double mSpeed;
+	bool mStampSendTime;
+	bool mLoop;
+
+	bool mStreaming;
+	QElapsedTimer mClock;
+	double mStartTime; ///< recorded time of the first frame or position
+	double mDuration; ///< recorded time from first to last frame or position
+	int mCompletedLoops;
+	unsigned mNextFrame;
+	unsigned mNextPosition;
+	int mSentFrames;
+	int mDroppedFrames;
+};
+typedef boost::shared_ptr<class AcquisitionReplayStreamer> AcquisitionReplayStreamerPtr;
+
+}
+
+#endif /* CXACQUISITIONREPLAYSTREAMER_H_ */
@@ -15,6 +15,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxLogger.h"
 #include "cxImageStreamerOpenCV.h"
 #include "cxMHDImageStreamer.h"
+#include "cxAcquisitionReplayStreamer.h"
 #include "cxImageStreamerSonix.h"
 #include "cxConfig.h"
 
@@ -71,6 +72,7 @@ CommandlineImageStreamerFactory::CommandlineImageStreamerFactory()
 	mCommandLineStreamers.push_back(CommandLineStreamerPtr(new ImageStreamerOpenCV()));
 #endif
 	mCommandLineStreamers.push_back(DummyImageStreamerPtr(new DummyImageStreamer()));
+	mCommandLineStreamers.push_back(AcquisitionReplayStreamerPtr(new AcquisitionReplayStreamer()));
 }
 
 QString CommandlineImageStreamerFactory::getDefaultSenderType() const
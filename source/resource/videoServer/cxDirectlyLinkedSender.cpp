@@ -12,11 +12,19 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxDirectlyLinkedSender.h"
 
 #include "cxIGTLinkConversion.h"
+#include "cxVideoStageTelemetry.h"
 #include "cxLogger.h"
 
 namespace cx
 {
 
+DirectlyLinkedSender::DirectlyLinkedSender() :
+	mImageSendTime(0),
+	mImagePopped(true),
+	mTelemetry(VideoStageTelemetry::create("DirectlyLinkedSender"))
+{
+}
+
 bool DirectlyLinkedSender::isReady() const
 {
 	return true;
@@ -27,7 +35,13 @@ void DirectlyLinkedSender::send(ImagePtr msg)
 	if (!this->isReady())
 		return;
 
+	QMutexLocker sentry(&mImageMutex);
+	if (!mImagePopped)
+		mTelemetry->frameDropped();
 	mImage = msg;
+	mImageSendTime = VideoStageTelemetry::now();
+	mImagePopped = false;
+	sentry.unlock();
 
 	emit newImage();
 }
@@ -42,6 +56,10 @@ void DirectlyLinkedSender::send(ProbeDefinitionPtr msg)
 
 ImagePtr DirectlyLinkedSender::popImage()
 {
+	QMutexLocker sentry(&mImageMutex);
+	if (!mImagePopped)
+		mTelemetry->frameReceived(VideoStageTelemetry::now() - mImageSendTime);
+	mImagePopped = true;
 	return mImage;
 }
 ProbeDefinitionPtr DirectlyLinkedSender::popUSStatus()
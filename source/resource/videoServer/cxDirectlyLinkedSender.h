@@ -17,6 +17,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxSenderImpl.h"
 
 #include <QObject>
+#include <QMutex>
 #include <boost/shared_ptr.hpp>
 #include "cxImage.h"
 #include "cxTool.h"
@@ -26,16 +27,21 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 namespace cx
 {
 
+typedef boost::shared_ptr<class VideoStageTelemetry> VideoStageTelemetryPtr;
+
 /**
  * \ingroup cx_resource_videoserver
  *
+ * Hands each image directly to the receiver through newImage().
+ * An image overwritten before it is popped is counted as dropped in
+ * the telemetry, and the time from send to pop as its age.
  */
 class cxGrabber_EXPORT DirectlyLinkedSender : public SenderImpl
 {
 	Q_OBJECT
 
 public:
-	DirectlyLinkedSender() {}
+	DirectlyLinkedSender();
 	virtual ~DirectlyLinkedSender() {}
 
 	bool isReady() const;
@@ -44,14 +50,19 @@ public:
 
 	ImagePtr popImage();
 	ProbeDefinitionPtr popUSStatus();
+	VideoStageTelemetryPtr getTelemetry() { return mTelemetry; }
 
 signals:
 	void newImage();
 	void newUSStatus();
 
 private:
+	QMutex mImageMutex;
 	ImagePtr mImage;
+	double mImageSendTime;
+	bool mImagePopped;
 	ProbeDefinitionPtr mUSStatus;
+	VideoStageTelemetryPtr mTelemetry;
 
 };
 typedef boost::shared_ptr<DirectlyLinkedSender> DirectlyLinkedSenderPtr;
@@ -52,6 +52,16 @@ void GrabberSenderQTcpSocket::send(IGTLinkUSStatusMessage::Pointer msg)
 	mSocket->write(reinterpret_cast<const char*> (msg->GetPackPointer()), msg->GetPackSize());
 }
 
+void GrabberSenderQTcpSocket::send(igtl::TransformMessage::Pointer msg)
+{
+	if (!msg || !this->isReady())
+		return;
+
+	// Pack (serialize) and send
+	msg->Pack();
+	mSocket->write(reinterpret_cast<const char*> (msg->GetPackPointer()), msg->GetPackSize());
+}
+
 void GrabberSenderQTcpSocket::send(ImagePtr msg)
 {
 	if (!this->isReady())
@@ -70,5 +80,14 @@ void GrabberSenderQTcpSocket::send(ProbeDefinitionPtr msg)
 	this->send(converter.encode(msg));
 }
 
+void GrabberSenderQTcpSocket::sendTransform(QString toolUid, Transform3D prMt, QDateTime timestamp)
+{
+	if (!this->isReady())
+		return;
+
+	IGTLinkConversion converter;
+	this->send(converter.encode(toolUid, prMt, timestamp));
+}
+
 
 } /* namespace cx */
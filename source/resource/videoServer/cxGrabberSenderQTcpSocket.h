@@ -20,6 +20,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <boost/shared_ptr.hpp>
 #include <qtcpsocket.h>
 #include "igtlImageMessage.h"
+#include "igtlTransformMessage.h"
 #include "cxIGTLinkImageMessage.h"
 #include "cxIGTLinkUSStatusMessage.h"
 #include "cxImage.h"
@@ -45,8 +46,10 @@ public:
 protected:
 	virtual void send(igtl::ImageMessage::Pointer msg);
 	virtual void send(IGTLinkUSStatusMessage::Pointer msg);
+	virtual void send(igtl::TransformMessage::Pointer msg);
 	virtual void send(ImagePtr msg);
 	virtual void send(ProbeDefinitionPtr msg);
+	virtual void sendTransform(QString toolUid, Transform3D prMt, QDateTime timestamp);
 
 private:
 	QTcpSocket* mSocket;
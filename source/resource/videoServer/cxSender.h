@@ -21,6 +21,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxIGTLinkUSStatusMessage.h"
 #include "cxImage.h"
 #include "cxTool.h"
+#include "cxTransform3D.h"
 
 namespace cx
 {
@@ -31,10 +32,18 @@ namespace cx
 * @{
 */
 
+/** Data sent together. Any part can be empty.
+ *
+ * A tool pose is included when mToolUid is set: m_prMt is the
+ * pose of that tool, acquired at mTransformTime.
+ */
 struct Package
 {
 	ImagePtr mImage;
 	ProbeDefinitionPtr mProbe;
+	QString mToolUid;
+	Transform3D m_prMt;
+	QDateTime mTransformTime;
 };
 
 typedef boost::shared_ptr<Package> PackagePtr;
@@ -22,6 +22,9 @@ void SenderImpl::send(PackagePtr package)
 
 	if(package->mProbe)
 		this->send(package->mProbe);
+
+	if(!package->mToolUid.isEmpty())
+		this->sendTransform(package->mToolUid, package->m_prMt, package->mTransformTime);
 }
 
 
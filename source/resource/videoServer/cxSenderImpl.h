@@ -53,6 +53,9 @@ protected:
 	/** Send an US status message
 	 */
 	virtual void send(ProbeDefinitionPtr msg) = 0;
+	/** Send the pose prMt of a tool. Default ignores it.
+	 */
+	virtual void sendTransform(QString toolUid, Transform3D prMt, QDateTime timestamp) {}
 };
 
 /**
@@ -0,0 +1,194 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <vtkImageData.h>
+#include "cxAcquisitionReplayStreamer.h"
+#include "cxMetaImageIO.h"
+#include "cxMetaImageHeader.h"
+#include "cxDataLocations.h"
+#include "cxImage.h"
+#include "cxtestSender.h"
+#include "cxtestQueuedSignalListener.h"
+
+namespace cxtest
+{
+
+namespace
+{
+const double startTime = 1.5E12;
+const int numberOfFrames = 20;
+const double frameInterval = 20;
+const int numberOfPositions = 40;
+const double positionInterval = 10;
+
+void writeLines(QString filename, QStringList lines)
+{
+	QFile file(filename);
+	REQUIRE(file.open(QIODevice::WriteOnly));
+	QTextStream stream(&file);
+	stream.setRealNumberPrecision(16);
+	for (int i=0; i<lines.size(); ++i)
+		stream << lines[i] << "\n";
+}
+
+/** Write frames, frame timestamps and tracking positions as a US acquisition,
+ *  with the tracking positions translated i mm along x.
+ */
+QString writeAcquisition()
+{
+	QString folder = cx::DataLocations::getTestDataPath() + "/temp/AcquisitionReplayStreamer";
+	QDir(folder).removeRecursively();
+	QDir().mkpath(folder);
+	QString base = folder + "/US-Acq_01_20261019T120000";
+
+	QStringList frameTimes;
+	for (int i=0; i<numberOfFrames; ++i)
+	{
+		vtkImageDataPtr frame = vtkImageDataPtr::New();
+		frame->SetDimensions(16, 16, 1);
+		frame->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+		memset(frame->GetScalarPointer(), i, 16*16);
+		REQUIRE(cx::MetaImageIO().write(frame, QString("%1_%2.mhd").arg(base).arg(i), cx::MetaImageIO::createHeader(frame)));
+		frameTimes << QString::number(startTime + i*frameInterval, 'f', 3);
+	}
+	writeLines(base + ".fts", frameTimes);
+
+	QStringList positions;
+	QStringList positionTimes;
+	for (int i=0; i<numberOfPositions; ++i)
+	{
+		positions << QString("1 0 0 %1").arg(i) << "0 1 0 0" << "0 0 1 0";
+		positionTimes << QString::number(startTime + i*positionInterval, 'f', 3);
+	}
+	writeLines(base + ".tp", positions);
+	writeLines(base + ".tts", positionTimes);
+
+	return folder;
+}
+}
+
+TEST_CASE("AcquisitionReplayStreamer: Replays frames and positions paced by recorded time", "[unit][streaming]")
+{
+	QString folder = writeAcquisition();
+	TestSenderPtr sender(new TestSender());
+
+	cx::AcquisitionReplayStreamerPtr streamer(new cx::AcquisitionReplayStreamer());
+	double speed = 2;
+	streamer->initialize(folder, speed);
+	REQUIRE(streamer->getNumberOfFrames() == numberOfFrames);
+	REQUIRE(streamer->getNumberOfPositions() == numberOfPositions);
+
+	std::vector<cx::ImagePtr> frames;
+	std::vector<cx::PackagePtr> sentPositions;
+	QObject::connect(sender.get(), &TestSender::newPackage, [&]()
+	{
+		cx::PackagePtr package = sender->getSentPackage();
+		if (package->mImage)
+			frames.push_back(package->mImage);
+		if (!package->mToolUid.isEmpty())
+			sentPositions.push_back(package);
+	});
+	std::vector<std::pair<cx::Transform3D, double> > positions;
+	QObject::connect(streamer.get(), &cx::AcquisitionReplayStreamer::trackingPosition, [&](cx::Transform3D prMt, double timestamp)
+	{
+		positions.push_back(std::make_pair(prMt, timestamp));
+	});
+
+	QElapsedTimer timer;
+	timer.start();
+	streamer->startStreaming(sender);
+	REQUIRE(waitForQueuedSignal(streamer.get(), SIGNAL(finished()), 5000));
+
+	// the last position is recorded at 390 ms, thus cannot be sent earlier
+	double duration = (numberOfPositions-1)*positionInterval/speed;
+	CHECK(timer.elapsed() >= duration - 5);
+
+	REQUIRE(frames.size() == numberOfFrames);
+	CHECK(streamer->getSentFrames() == numberOfFrames);
+	CHECK(streamer->getDroppedFrames() == 0);
+	for (int i=0; i<numberOfFrames; ++i)
+	{
+		CHECK(frames[i]->getAcquisitionTime().toMSecsSinceEpoch() == qint64(startTime + i*frameInterval));
+		CHECK(static_cast<unsigned char*>(frames[i]->getBaseVtkImageData()->GetScalarPointer())[0] == i);
+	}
+
+	REQUIRE(positions.size() == numberOfPositions);
+	for (int i=0; i<numberOfPositions; ++i)
+	{
+		CHECK(positions[i].first.matrix()(0,3) == Approx(i));
+		CHECK(positions[i].second == Approx(startTime + i*positionInterval));
+	}
+
+	// no probe data is written, thus positions are sent as the pose of the acquisition
+	REQUIRE(sentPositions.size() == numberOfPositions);
+	for (int i=0; i<numberOfPositions; ++i)
+	{
+		CHECK(sentPositions[i]->mToolUid == "US-Acq_01_20261019T120000");
+		CHECK(sentPositions[i]->m_prMt.matrix()(0,3) == Approx(i));
+		CHECK(sentPositions[i]->mTransformTime.toMSecsSinceEpoch() == qint64(startTime + i*positionInterval));
+	}
+
+	// a second replay hands out the same frame data, not copies
+	vtkImageDataPtr firstFrame = frames[0]->getBaseVtkImageData();
+	frames.clear();
+	streamer->startStreaming(sender);
+	REQUIRE(waitForQueuedSignal(streamer.get(), SIGNAL(finished()), 5000));
+	REQUIRE(frames.size() == numberOfFrames);
+	CHECK(frames[0]->getBaseVtkImageData() == firstFrame);
+}
+
+TEST_CASE("AcquisitionReplayStreamer: Stamps send time when requested", "[integration][streaming]")
+{
+	QString folder = writeAcquisition();
+	TestSenderPtr sender(new TestSender());
+
+	cx::AcquisitionReplayStreamerPtr streamer(new cx::AcquisitionReplayStreamer());
+	streamer->initialize(folder, 10, true);
+	REQUIRE(streamer->isStreaming() == false);
+
+	qint64 maxLatency = 0;
+	QObject::connect(sender.get(), &TestSender::newPackage, [&]()
+	{
+		if (!sender->getSentPackage()->mImage)
+			return;
+		qint64 sent = sender->getSentPackage()->mImage->getAcquisitionTime().toMSecsSinceEpoch();
+		maxLatency = std::max(maxLatency, QDateTime::currentMSecsSinceEpoch() - sent);
+	});
+
+	cx::ImagePtr last;
+	QObject::connect(sender.get(), &TestSender::newPackage, [&]()
+	{
+		if (sender->getSentPackage()->mImage)
+			last = sender->getSentPackage()->mImage;
+	});
+
+	QElapsedTimer timer;
+	timer.start();
+	qint64 start = QDateTime::currentMSecsSinceEpoch();
+	streamer->startStreaming(sender);
+	REQUIRE(waitForQueuedSignal(streamer.get(), SIGNAL(finished()), 5000));
+
+	// the last position is recorded at 390 ms, replayed at speed 10
+	double duration = (numberOfPositions-1)*positionInterval/10;
+	CHECK(timer.elapsed() < duration + 500);
+
+	REQUIRE(last);
+	CHECK(last->getAcquisitionTime().toMSecsSinceEpoch() >= start);
+	CHECK(maxLatency < 50);
+}
+
+} // namespace cxtest
@@ -0,0 +1,106 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxIncrementalPolyline.h"
+
+#include <algorithm>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+
+namespace cx
+{
+
+IncrementalPolylinePtr IncrementalPolyline::create(int pointsPerCell)
+{
+	return IncrementalPolylinePtr(new IncrementalPolyline(pointsPerCell));
+}
+
+IncrementalPolyline::IncrementalPolyline(int pointsPerCell) :
+	mPointsPerCell(std::max(2, pointsPerCell)),
+	mPointsInLastCell(0)
+{
+	mPoints = vtkPointsPtr::New();
+	mLines = vtkCellArrayPtr::New();
+	mPolyData = vtkPolyDataPtr::New();
+	mPolyData->SetPoints(mPoints);
+	mPolyData->SetLines(mLines);
+	mPolyData->SetVerts(mLines);
+}
+
+void IncrementalPolyline::addPoint(const Vector3D& p)
+{
+	vtkIdType id = mPoints->InsertNextPoint(p.begin());
+
+	if (id==0)
+	{
+		// a line needs two points
+	}
+	else if ((mPointsInLastCell==0) || (mPointsInLastCell>=mPointsPerCell))
+	{
+		mLines->InsertNextCell(2);
+		mLines->InsertCellPoint(id-1);
+		mLines->InsertCellPoint(id);
+		mPointsInLastCell = 2;
+	}
+	else
+	{
+		mLines->InsertCellPoint(id);
+		++mPointsInLastCell;
+		mLines->UpdateCellCount(mPointsInLastCell);
+	}
+
+	this->modified();
+}
+
+void IncrementalPolyline::replaceLastPoint(const Vector3D& p)
+{
+	vtkIdType count = mPoints->GetNumberOfPoints();
+	if (count==0)
+	{
+		this->addPoint(p);
+		return;
+	}
+	mPoints->SetPoint(count-1, p.begin());
+	this->modified();
+}
+
+void IncrementalPolyline::clear()
+{
+	mPoints->Reset();
+	mLines->Reset();
+	mPointsInLastCell = 0;
+	this->modified();
+}
+
+vtkIdType IncrementalPolyline::getNumberOfPoints() const
+{
+	return mPoints->GetNumberOfPoints();
+}
+
+Vector3D IncrementalPolyline::getPoint(vtkIdType index) const
+{
+	return Vector3D(mPoints->GetPoint(index));
+}
+
+vtkPolyDataPtr IncrementalPolyline::getPolyData()
+{
+	return mPolyData;
+}
+
+void IncrementalPolyline::modified()
+{
+	mPoints->Modified();
+	mLines->Modified();
+	mPolyData->Modified();
+}
+
+} // namespace cx
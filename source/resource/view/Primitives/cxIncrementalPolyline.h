@@ -0,0 +1,62 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXINCREMENTALPOLYLINE_H
+#define CXINCREMENTALPOLYLINE_H
+
+#include "cxResourceVisualizationExport.h"
+
+#include <boost/shared_ptr.hpp>
+#include <vtkType.h>
+#include "vtkForwardDeclarations.h"
+#include "cxVector3D.h"
+
+namespace cx
+{
+
+typedef boost::shared_ptr<class IncrementalPolyline> IncrementalPolylinePtr;
+
+/** \brief Polyline in a vtkPolyData that can be extended one point at a time.
+ *
+ * The line is stored as a sequence of polyline cells of at most
+ * pointsPerCell points each, consecutive cells sharing their end point.
+ * A new point is appended to the last cell in place, or starts a new cell
+ * when the last one is full, thus adding a point never touches the
+ * existing cells. The points are also drawn as vertices.
+ *
+ * \ingroup cx_resource_view
+ */
+class cxResourceVisualization_EXPORT IncrementalPolyline
+{
+public:
+	static IncrementalPolylinePtr create(int pointsPerCell=1024);
+	explicit IncrementalPolyline(int pointsPerCell);
+
+	void addPoint(const Vector3D& p);
+	void replaceLastPoint(const Vector3D& p); ///< move the last point, keeping the cells
+	void clear();
+	vtkIdType getNumberOfPoints() const;
+	Vector3D getPoint(vtkIdType index) const;
+	vtkPolyDataPtr getPolyData();
+
+private:
+	void modified();
+
+	int mPointsPerCell;
+	int mPointsInLastCell;
+	vtkPolyDataPtr mPolyData;
+	vtkPointsPtr mPoints;
+	vtkCellArrayPtr mLines;
+};
+
+} // namespace cx
+
+#endif // CXINCREMENTALPOLYLINE_H
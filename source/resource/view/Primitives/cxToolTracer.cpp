@@ -12,6 +12,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxToolTracer.h"
 
+#include <algorithm>
 #include "vtkImageData.h"
 #include <vtkPointData.h>
 #include <vtkUnsignedCharArray.h>
@@ -34,6 +35,24 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 namespace cx
 {
 
+namespace
+{
+double distanceToSegment(const Vector3D& p, const Vector3D& a, const Vector3D& b)
+{
+	Vector3D ab = b - a;
+	double length2 = dot(ab, ab);
+	if (length2 == 0.0)
+		return (p - a).length();
+	double t = std::max(0.0, std::min(1.0, dot(p - a, ab) / length2));
+	return (p - (a + t*ab)).length();
+}
+
+/** Max number of samples merged into one segment by decimation,
+ *  keeping the per sample cost bounded.
+ */
+const unsigned MAX_MERGED_POINTS = 64;
+}
+
 ToolTracerPtr ToolTracer::create(SpaceProviderPtr spaceProvider)
 {
 	ToolTracerPtr retval(new ToolTracer(spaceProvider));
@@ -44,11 +63,9 @@ ToolTracer::ToolTracer(SpaceProviderPtr spaceProvider)
 {
 	mSpaceProvider = spaceProvider;
 	mRunning = false;
-	mPolyData = vtkPolyDataPtr::New();
 	mActor = vtkActorPtr::New();
 	mPolyDataMapper = vtkPolyDataMapperPtr::New();
 
-	mPolyDataMapper->SetInputData(mPolyData);
 	mActor->SetMapper(mPolyDataMapper);
 
 	mProperty = vtkPropertyPtr::New();
@@ -57,12 +74,12 @@ ToolTracer::ToolTracer(SpaceProviderPtr spaceProvider)
 
 	this->setColor(QColor("red"));
 
-	mPoints = vtkPointsPtr::New();
-	mLines = vtkCellArrayPtr::New();
-
-	mPolyData->SetPoints(mPoints);
-	mPolyData->SetLines(mLines);
-	mPolyData->SetVerts(mLines);
+	mLevels.push_back(IncrementalPolyline::create());
+	mPolyData = mLevels[0]->getPolyData();
+	mPolyDataMapper->SetInputData(mPolyData);
+	mRenderedLevel = 0;
+	mMaxRenderedPoints = 100000;
+	mDecimationTolerance = -1.0;
 	mFirstPoint = false;
 	mMinDistance = -1.0;
 	mSkippedPoints = 0;
@@ -80,6 +97,7 @@ void ToolTracer::start()
 	mRunning = true;
 	mFirstPoint = true;
 	mSkippedPoints = 0;
+	mMergedPoints.clear();
 	this->connectTool();
 }
 
@@ -93,9 +111,10 @@ void ToolTracer::stop()
 
 void ToolTracer::clear()
 {
-	mPoints->Reset();
-	mLines->Reset();
-	mPolyData->Modified();
+	mLevels.resize(1);
+	mLevels[0]->clear();
+	mMergedPoints.clear();
+	this->updateRenderedLevel();
 }
 
 void ToolTracer::connectTool()
@@ -133,6 +152,17 @@ vtkPolyDataPtr ToolTracer::getPolyData()
 	return mPolyData;
 }
 
+vtkPolyDataPtr ToolTracer::getRenderedPolyData()
+{
+	return mLevels[mRenderedLevel]->getPolyData();
+}
+
+void ToolTracer::setMaxRenderedPoints(vtkIdType count)
+{
+	mMaxRenderedPoints = count;
+	this->updateRenderedLevel();
+}
+
 vtkActorPtr ToolTracer::getActor()
 {
 	return mActor;
@@ -164,23 +194,77 @@ void ToolTracer::receiveTransforms(Transform3D prMt, double timestamp)
 	}
 	mFirstPoint = false;
 	mPreviousPoint = p;
-	mPoints->InsertNextPoint(p.begin());
 
-	if (mPoints->GetNumberOfPoints() > 1)
+	if (this->canExtendLastSegment(p))
+	{
+		vtkIdType last = mLevels[0]->getNumberOfPoints()-1;
+		for (unsigned level=0; level<mLevels.size() && (last%(vtkIdType(1)<<level))==0; ++level)
+			mLevels[level]->replaceLastPoint(p);
+		mMergedPoints.push_back(p);
+	}
+	else
 	{
-		// fill cell points for the entire polydata.
-		// This is very ineffective, but I have no idea how to update mLines incrementally.
-		mLines->Initialize();
-		std::vector<vtkIdType> ids(mPoints->GetNumberOfPoints());
-		for (unsigned i=0; i<ids.size(); ++i)
-			ids[i] = i;
-		mLines->InsertNextCell(ids.size(), &(*ids.begin()));
-		mLines->Modified();
-		
-		mPolyData->Modified();
+		this->addPoint(p);
+		mMergedPoints.assign(1, p);
 	}
 }
 
+/** Append p to the full trace and to all levels of detail containing its index.
+ */
+void ToolTracer::addPoint(const Vector3D& p)
+{
+	vtkIdType index = mLevels[0]->getNumberOfPoints();
+	for (unsigned level=0; level<mLevels.size() && (index%(vtkIdType(1)<<level))==0; ++level)
+		mLevels[level]->addPoint(p);
+	this->updateRenderedLevel();
+}
+
+/** Return true if p can replace the last point, i.e. if all samples merged into
+ *  the last point are within tolerance of the segment from the previous fixed point to p.
+ */
+bool ToolTracer::canExtendLastSegment(const Vector3D& p) const
+{
+	if (mDecimationTolerance <= 0.0)
+		return false;
+	vtkIdType count = mLevels[0]->getNumberOfPoints();
+	if (count < 2 || mMergedPoints.size() >= MAX_MERGED_POINTS)
+		return false;
+
+	Vector3D fixed = mLevels[0]->getPoint(count-2);
+	for (unsigned i=0; i<mMergedPoints.size(); ++i)
+		if (distanceToSegment(mMergedPoints[i], fixed, p) > mDecimationTolerance)
+			return false;
+	return true;
+}
+
+/** Render the finest level of detail with at most mMaxRenderedPoints points,
+ *  creating coarser levels as the trace grows.
+ */
+void ToolTracer::updateRenderedLevel()
+{
+	int level = 0;
+	if (mMaxRenderedPoints > 0)
+	{
+		while (mLevels[level]->getNumberOfPoints() > mMaxRenderedPoints)
+		{
+			++level;
+			if (level == int(mLevels.size()))
+			{
+				IncrementalPolylinePtr finer = mLevels.back();
+				IncrementalPolylinePtr coarser = IncrementalPolyline::create();
+				for (vtkIdType i=0; i<finer->getNumberOfPoints(); i+=2)
+					coarser->addPoint(finer->getPoint(i));
+				mLevels.push_back(coarser);
+			}
+		}
+	}
+
+	if (level == mRenderedLevel)
+		return;
+	mRenderedLevel = level;
+	mPolyDataMapper->SetInputData(mLevels[level]->getPolyData());
+}
+
 void ToolTracer::addManyPositions(TimedTransformMap trackerRecordedData_prMt)
 {
     for(TimedTransformMap::iterator iter=trackerRecordedData_prMt.begin(); iter!=trackerRecordedData_prMt.end(); ++iter)
@@ -26,6 +26,7 @@ typedef vtkSmartPointer<class vtkPolyData> vtkPolyDataPtr;
 #include "vtkForwardDeclarations.h"
 #include "cxForwardDeclarations.h"
 #include "cxTool.h"
+#include "cxIncrementalPolyline.h"
 
 class QColor;
 
@@ -40,6 +41,14 @@ typedef boost::shared_ptr<class SpaceListener> SpaceListenerPtr;
  *
  * ToolTracer is used internally by ToolRep3D as an option.
  *
+ * Each sample is appended to an IncrementalPolyline at constant cost,
+ * making multi-hour traces feasible. Optional decimation merges samples
+ * lying within a tolerance of a straight segment into that segment.
+ * For long traces, the rendered line is a coarser level of detail,
+ * each level keeping every second point of the previous, such that at
+ * most getMaxRenderedPoints() points are drawn. getPolyData() always
+ * returns the full resolution trace.
+ *
  * Used by CustusX.
  *
  * \ingroup cx_resource_view
@@ -61,6 +70,10 @@ public:
 	bool isRunning() const; // true if started and not stopped.
 	void setMinDistance(double distance) { mMinDistance = distance; }
 	int getSkippedPoints() { return mSkippedPoints; }
+	void setDecimationTolerance(double tolerance) { mDecimationTolerance = tolerance; } ///< max distance from merged samples to the line, <=0 disables
+	void setMaxRenderedPoints(vtkIdType count); ///< render a coarser trace above this size, <=0 renders all points
+	vtkIdType getMaxRenderedPoints() const { return mMaxRenderedPoints; }
+	vtkPolyDataPtr getRenderedPolyData(); ///< the level of detail currently rendered
 	void addManyPositions(TimedTransformMap trackerRecordedData_prMt);
 
 private slots:
@@ -70,6 +83,9 @@ private:
 	void connectTool();
 	void disconnectTool();
 	void onSpaceChanged();
+	void addPoint(const Vector3D& p);
+	bool canExtendLastSegment(const Vector3D& p) const;
+	void updateRenderedLevel();
 
 	bool mRunning;
 	vtkPolyDataPtr mPolyData; ///< polydata representation of the probe, in space u
@@ -78,8 +94,11 @@ private:
 	vtkPolyDataMapperPtr mPolyDataMapper;
 	vtkPropertyPtr mProperty;
 
-	vtkPointsPtr mPoints;
-	vtkCellArrayPtr mLines;
+	std::vector<IncrementalPolylinePtr> mLevels; ///< level i contains every 2^i'th point, level 0 is the full trace
+	int mRenderedLevel;
+	vtkIdType mMaxRenderedPoints;
+	double mDecimationTolerance;
+	std::vector<Vector3D> mMergedPoints; ///< samples merged into the last point since the previous fixed point
 
 	bool mFirstPoint;
 	int mSkippedPoints;
@@ -25,6 +25,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkCellArray.h>
 
 #include "cxMesh.h"
+#include "cxMeshPlaneIntersection.h"
 #include "cxView.h"
 
 #include "cxSliceProxy.h"
@@ -73,6 +74,7 @@ void GeometricRep2D::setMesh(MeshPtr mesh)
 		disconnect(mMesh.get(), SIGNAL(transformChanged()), this, SLOT(transformChangedSlot()));
 	}
 	mMesh = mesh;
+	mIntersection.reset();
 	if (mMesh)
 	{
 		connect(mMesh.get(), SIGNAL(meshChanged()), this, SLOT(meshChangedSlot()));
@@ -107,7 +109,11 @@ void GeometricRep2D::setSliceProxy(SliceProxyPtr slicer)
 
 void GeometricRep2D::meshChangedSlot()
 {
-	mMapper->SetInputData(mMesh->getVtkPolyData()); // original - show-all method
+	// shared with the other 2D views of the mesh
+	mIntersection = mMesh->getPlaneIntersection();
+	if (!mIntersection)
+		mMapper->SetInputData(mMesh->getVtkPolyData()); // original - show-all method
+	this->transformChangedSlot();
 	mMapper->ScalarVisibilityOff();//Don't use the LUT from the VtkPolyData
 	//mNormals->SetInputConnection(mMesh->getVtkPolyData()->Get);
 
@@ -146,6 +152,11 @@ void GeometricRep2D::transformChangedSlot()
 	Transform3D dMr = mMesh->get_rMd().inv();
 	Transform3D dMs = dMr * rMs;
 
+	if (mIntersection)
+	{
+		Vector3D normal = dMs.vector(Vector3D(0, 0, 1)).normalized();
+		mMapper->SetInputData(mIntersection->getContour(dMs.coord(Vector3D(0, 0, 0)), normal));
+	}
 	mActor->SetUserMatrix(dMs.inv().getVtkMatrix());
 }
 
@@ -23,6 +23,7 @@ namespace cx
 {
 typedef boost::shared_ptr<class Mesh> MeshPtr;
 typedef boost::shared_ptr<class SliceProxy> SliceProxyPtr;
+typedef boost::shared_ptr<class MeshPlaneIntersection> MeshPlaneIntersectionPtr;
 
 typedef boost::shared_ptr<class GeometricRep2D> GeometricRep2DPtr;
 
@@ -30,6 +31,8 @@ typedef boost::shared_ptr<class GeometricRep2D> GeometricRep2DPtr;
  *
  * Use this to render geometric polydata in a 2D scene
  * as an intersection between the full polydata and the slice plane.
+ * Surfaces are cut by MeshPlaneIntersection, polydata without
+ * polygons (e.g. centerlines) is rendered in full.
  *
  * Used by CustusX.
  *
@@ -62,6 +65,7 @@ protected:
 
 	MeshPtr mMesh;
 	SliceProxyPtr mSlicer;
+	MeshPlaneIntersectionPtr mIntersection;
 
 private slots:
 	void meshChangedSlot();
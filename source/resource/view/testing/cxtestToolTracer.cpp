@@ -0,0 +1,116 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#include "catch.hpp"
+#include <iostream>
+#include <QElapsedTimer>
+#include <vtkPolyData.h>
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include "cxToolTracer.h"
+#include "cxIncrementalPolyline.h"
+#include "cxtestSpaceProviderMock.h"
+
+namespace cxtest
+{
+
+namespace
+{
+cx::TimedTransformMap createLine(int count, cx::Vector3D step)
+{
+	cx::TimedTransformMap retval;
+	for (int i=0; i<count; ++i)
+		retval[i] = cx::createTransformTranslate(i*step);
+	return retval;
+}
+}
+
+TEST_CASE("IncrementalPolyline: Cells are chunked and connected", "[unit][resource][visualization]")
+{
+	int pointsPerCell = 10;
+	cx::IncrementalPolylinePtr line = cx::IncrementalPolyline::create(pointsPerCell);
+	for (int i=0; i<95; ++i)
+		line->addPoint(cx::Vector3D(i, 0, 0));
+
+	vtkPolyDataPtr polyData = line->getPolyData();
+	REQUIRE(polyData->GetNumberOfPoints() == 95);
+	CHECK(polyData->GetNumberOfLines() == 11); // 94 segments, 9 per cell
+
+	// the cells together must visit every point in order
+	vtkIdType expected = 0;
+	vtkIdListPtr ids = vtkIdListPtr::New();
+	vtkCellArray* lines = polyData->GetLines();
+	lines->InitTraversal();
+	while (lines->GetNextCell(ids))
+	{
+		REQUIRE(ids->GetNumberOfIds() <= pointsPerCell);
+		CHECK(ids->GetId(0) == expected);
+		for (vtkIdType i=1; i<ids->GetNumberOfIds(); ++i)
+			CHECK(ids->GetId(i) == ids->GetId(i-1)+1);
+		expected = ids->GetId(ids->GetNumberOfIds()-1);
+	}
+	CHECK(expected == 94);
+}
+
+TEST_CASE("ToolTracer: Decimation merges collinear samples", "[unit][resource][visualization]")
+{
+	cx::ToolTracerPtr tracer = cx::ToolTracer::create(SpaceProviderMock::create());
+	tracer->setDecimationTolerance(0.01);
+
+	// two straight lines with a corner at (50,0,0)
+	cx::TimedTransformMap positions = createLine(51, cx::Vector3D(1, 0, 0));
+	for (int i=1; i<=50; ++i)
+		positions[50+i] = cx::createTransformTranslate(cx::Vector3D(50, i, 0));
+	tracer->addManyPositions(positions);
+
+	vtkPolyDataPtr polyData = tracer->getPolyData();
+	REQUIRE(polyData->GetNumberOfPoints() == 3);
+	CHECK(cx::similar(cx::Vector3D(polyData->GetPoint(1)), cx::Vector3D(50, 0, 0)));
+	CHECK(cx::similar(cx::Vector3D(polyData->GetPoint(2)), cx::Vector3D(50, 50, 0)));
+}
+
+TEST_CASE("ToolTracer: Renders coarser level of detail for long traces", "[unit][resource][visualization]")
+{
+	cx::ToolTracerPtr tracer = cx::ToolTracer::create(SpaceProviderMock::create());
+	tracer->setMaxRenderedPoints(100);
+	tracer->addManyPositions(createLine(1000, cx::Vector3D(0, 0, 1)));
+
+	CHECK(tracer->getPolyData()->GetNumberOfPoints() == 1000);
+	vtkPolyDataPtr rendered = tracer->getRenderedPolyData();
+	CHECK(rendered->GetNumberOfPoints() <= 100);
+	CHECK(rendered->GetNumberOfPoints() > 50);
+	CHECK(cx::similar(cx::Vector3D(rendered->GetPoint(1)), cx::Vector3D(0, 0, 16)));
+
+	tracer->setMaxRenderedPoints(0);
+	CHECK(tracer->getRenderedPolyData() == tracer->getPolyData());
+
+	tracer->clear();
+	CHECK(tracer->getRenderedPolyData()->GetNumberOfPoints() == 0);
+}
+
+TEST_CASE("ToolTracer: Speed of tracing a long session", "[speed][resource][visualization]")
+{
+	int samples = 4*3600*50; // 4 hours at 50Hz
+	cx::TimedTransformMap positions;
+	for (int i=0; i<samples; ++i)
+		positions[i] = cx::createTransformTranslate(cx::Vector3D(std::sin(i*0.001), std::cos(i*0.001), i*0.0001));
+
+	cx::ToolTracerPtr tracer = cx::ToolTracer::create(SpaceProviderMock::create());
+	QElapsedTimer timer;
+	timer.start();
+	tracer->addManyPositions(positions);
+	double seconds = timer.elapsed()/1000.0;
+
+	std::cout << "ToolTracer: " << samples << " samples in " << seconds << "s, "
+			  << 1.0E6*seconds/samples << " us/sample" << std::endl;
+	CHECK(tracer->getPolyData()->GetNumberOfPoints() == samples);
+}
+
+} // namespace cxtest